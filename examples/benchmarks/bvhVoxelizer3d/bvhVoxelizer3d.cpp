@@ -0,0 +1,123 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2012 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+  * Voxelization of a synthetic mesh made of numSpheres^3 disjoint spheres,
+  * with the flood-fill voxelizer based on a triangle hash (voxelize3D)
+  * and with the ray-parity voxelizer based on a BVH (bvhVoxelize3D).
+  * The time of both voxelizations and the number of cells on which they
+  * disagree are printed. With a large number of triangles, the flood-fill
+  * voxelization can be skipped.
+**/
+
+#include "palabos3D.h"
+#include "palabos3D.hh"   // include full template code
+#include <iostream>
+#include <vector>
+
+using namespace plb;
+using namespace std;
+
+typedef double T;
+
+/// Union of numSpheres^3 spheres which fill the domain [0,N-1]^3.
+TriangleSet<T>* constructSpheres(plint N, plint numSpheres, plint numTrianglesPerSphere)
+{
+    T spacing = (T)(N-1) / (T)numSpheres;
+    std::vector<TriangleSet<T>*> spheres;
+    for (plint iX=0; iX<numSpheres; ++iX) {
+        for (plint iY=0; iY<numSpheres; ++iY) {
+            for (plint iZ=0; iZ<numSpheres; ++iZ) {
+                Array<T,3> center( ((T)iX+(T)0.5)*spacing,
+                                   ((T)iY+(T)0.5)*spacing,
+                                   ((T)iZ+(T)0.5)*spacing );
+                spheres.push_back (
+                        constructSphere<T>(center, (T)0.4*spacing, numTrianglesPerSphere) );
+            }
+        }
+    }
+    TriangleSet<T>* triangleSet = new TriangleSet<T>(DBL);
+    triangleSet->merge(spheres);
+    for (pluint iSphere=0; iSphere<spheres.size(); ++iSphere) {
+        delete spheres[iSphere];
+    }
+    return triangleSet;
+}
+
+/// Number of cells which are inside (inside or innerBorder).
+plint countInside(MultiScalarField3D<int>& flags)
+{
+    return computeSum(*greaterThan(flags, voxelFlag::outerBorder));
+}
+
+int main(int argc, char* argv[]) {
+
+    plbInit(&argc, &argv);
+
+    plint N, numSpheres, numTrianglesPerSphere, compare;
+    try {
+        global::argv(1).read(N);
+        global::argv(2).read(numSpheres);
+        global::argv(3).read(numTrianglesPerSphere);
+        global::argv(4).read(compare);
+    }
+    catch(...)
+    {
+        pcout << "Wrong parameters. The syntax is " << std::endl;
+        pcout << argv[0] << " N numSpheres numTrianglesPerSphere compare" << std::endl;
+        pcout << "where N is the resolution of the domain, numSpheres the number" << std::endl;
+        pcout << "of spheres per direction, numTrianglesPerSphere the minimum number" << std::endl;
+        pcout << "of triangles of each sphere, and compare (0 or 1) states whether" << std::endl;
+        pcout << "the flood-fill voxelizer is executed as a reference." << std::endl;
+        exit(1);
+    }
+
+    const plint borderWidth = 1;
+    Box3D domain(0,N-1, 0,N-1, 0,N-1);
+
+    global::timer("mesh").start();
+    std::auto_ptr<TriangleSet<T> > triangleSet(constructSpheres(N, numSpheres, numTrianglesPerSphere));
+    DEFscaledMesh<T> defMesh(*triangleSet);
+    TriangularSurfaceMesh<T> const& mesh = defMesh.getMesh();
+    pcout << "Mesh with " << mesh.getNumTriangles() << " triangles constructed in "
+          << global::timer("mesh").stop() << " s" << std::endl;
+
+    global::timer("bvh").start();
+    std::auto_ptr<MultiScalarField3D<int> > bvhFlags = bvhVoxelize3D(mesh, domain, borderWidth);
+    T bvhTime = global::timer("bvh").stop();
+    pcout << "BVH voxelizer:        " << bvhTime << " s, "
+          << countInside(*bvhFlags) << " inside cells" << std::endl;
+
+    if (compare) {
+        global::timer("hash").start();
+        std::auto_ptr<MultiScalarField3D<int> > hashFlags = voxelize3D(mesh, domain, borderWidth);
+        T hashTime = global::timer("hash").stop();
+        plint numDifferent = computeSum(*lessThan(*bvhFlags, *hashFlags))
+                           + computeSum(*greaterThan(*bvhFlags, *hashFlags));
+        pcout << "Flood-fill voxelizer: " << hashTime << " s, "
+              << countInside(*hashFlags) << " inside cells" << std::endl;
+        pcout << "Speedup " << hashTime/bvhTime << ", "
+              << numDifferent << " cells with different flags" << std::endl;
+    }
+}
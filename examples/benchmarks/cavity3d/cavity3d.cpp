@@ -63,17 +63,26 @@ int main(int argc, char* argv[]) {
     //defaultMultiBlockPolicy3D().toggleBlockingCommunication(true);
 
     plint N;
+    plint numThreads = 1;
     try {
         global::argv(1).read(N);
+        if (global::argc() > 2) {
+            global::argv(2).read(numThreads);
+        }
     }
     catch(...)
     {
         pcout << "Wrong parameters. The syntax is " << std::endl;
-        pcout << argv[0] << " N" << std::endl;
+        pcout << argv[0] << " N [numThreads]" << std::endl;
         pcout << "where N is the resolution. The benchmark cases published " << std::endl;
         pcout << "on the Palabos Wiki use N=100, N=400, N=1000, or N=4000." << std::endl;
+        pcout << "numThreads is the number of shared-memory threads per MPI process" << std::endl;
+        pcout << "(default 1); it has an effect only with SMPparallel = true." << std::endl;
         exit(1);
     }
+    // Must be set before the lattice is created, so that the memory of the
+    //   atomic blocks is first touched by the thread which processes them.
+    global::smpThreadPool().setNumThreads((int)numThreads);
 
     pcout << "Starting benchmark with " << N+1 << "x" << N+1 << "x" << N+1 << " grid points "
           << "(approx. 2 minutes on modern processors)." << std::endl;
@@ -95,6 +104,8 @@ int main(int argc, char* argv[]) {
 
     plint numCores = global::mpi().getSize();
     pcout << "Number of MPI threads: " << numCores << std::endl;
+    pcout << "Number of shared-memory threads per MPI thread: "
+          << global::smpThreadPool().getNumThreads() << std::endl;
     // Current cores run approximately at 5 Mega Sus.
     T estimateSus= 5.e6*numCores;
     // The benchmark should run for approximately two minutes
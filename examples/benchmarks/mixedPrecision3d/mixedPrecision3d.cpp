@@ -0,0 +1,136 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2012 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+  * Flow in a lid-driven 3D cavity, as in the cavity3d benchmark, with the
+  * populations stored in double precision (array of structures and
+  * structure of arrays) and in single precision (structure of arrays).
+  * The velocity of the single-precision run is compared with the
+  * double-precision reference, and the performance of the three runs
+  * is measured.
+**/
+
+#include "palabos3D.h"
+#include "palabos3D.hh"   // include full template code
+#include <iostream>
+#include <cmath>
+
+using namespace plb;
+using namespace std;
+
+typedef double T;
+#define DESCRIPTOR descriptors::D3Q19Descriptor
+
+enum Storage { arrayOfStructures, structureOfArrays, singlePrecision };
+
+/// Run the cavity and return the velocity norm; the performance is
+///   written into mlups.
+std::auto_ptr<MultiScalarField3D<T> > runCavity (
+        IncomprFlowParam<T> const& parameters, plint numIter, Storage storage, T& mlups )
+{
+    const plint nx = parameters.getNx();
+    const plint ny = parameters.getNy();
+    const plint nz = parameters.getNz();
+    MultiBlockLattice3D<T, DESCRIPTOR> lattice (
+            nx, ny, nz, new BGKdynamics<T,DESCRIPTOR>(parameters.getOmega()) );
+    OnLatticeBoundaryCondition3D<T,DESCRIPTOR>* boundaryCondition
+        = createLocalBoundaryCondition3D<T,DESCRIPTOR>();
+
+    Box3D topLid = Box3D(0, nx-1, ny-1, ny-1, 0, nz-1);
+    Box3D everythingButTopLid = Box3D(0, nx-1, 0, ny-2, 0, nz-1);
+    boundaryCondition->setVelocityConditionOnBlockBoundaries(lattice);
+    T u = sqrt((T)2)/(T)2 * parameters.getLatticeU();
+    initializeAtEquilibrium(lattice, everythingButTopLid, 1., Array<T,3>(0.,0.,0.) );
+    initializeAtEquilibrium(lattice, topLid, 1., Array<T,3>(u,0.,u) );
+    setBoundaryVelocity(lattice, topLid, Array<T,3>(u,0.,u) );
+    lattice.initialize();
+
+    lattice.toggleSinglePrecisionStorage(storage==singlePrecision);
+    lattice.toggleStructureOfArrays(storage!=arrayOfStructures);
+
+    global::timer("mixedPrecision").restart();
+    for (plint iT=0; iT<numIter; ++iT) {
+        lattice.collideAndStream();
+    }
+    T time = global::timer("mixedPrecision").stop();
+    global::timer("mixedPrecision").reset();
+    mlups = (T)lattice.getBoundingBox().nCells()*(T)numIter/time/1.e6;
+
+    delete boundaryCondition;
+    return computeVelocityNorm(lattice);
+}
+
+/// Relative L2-norm of the difference between two fields.
+T relativeDifference(MultiScalarField3D<T>& field, MultiScalarField3D<T>& reference)
+{
+    std::auto_ptr<MultiScalarField3D<T> > difference = subtract(field, reference);
+    T norm = computeAverage(*multiply(*difference, *difference));
+    T referenceNorm = computeAverage(*multiply(reference, reference));
+    return std::sqrt(norm/referenceNorm);
+}
+
+int main(int argc, char* argv[]) {
+
+    plbInit(&argc, &argv);
+
+    plint N, numIter;
+    try {
+        global::argv(1).read(N);
+        global::argv(2).read(numIter);
+    }
+    catch(...)
+    {
+        pcout << "Wrong parameters. The syntax is " << std::endl;
+        pcout << argv[0] << " N numIter" << std::endl;
+        pcout << "where N is the resolution of the cavity, and numIter the" << std::endl;
+        pcout << "number of time steps of each run." << std::endl;
+        exit(1);
+    }
+
+    IncomprFlowParam<T> parameters(
+            (T) 1e-2,  // uMax
+            (T) 100.,  // Re
+            N,         // N
+            1.,        // lx
+            1.,        // ly
+            1.         // lz
+    );
+
+    T mlupsReference, mlupsSoA, mlupsSingle;
+    std::auto_ptr<MultiScalarField3D<T> > reference =
+        runCavity(parameters, numIter, arrayOfStructures, mlupsReference);
+    std::auto_ptr<MultiScalarField3D<T> > soa =
+        runCavity(parameters, numIter, structureOfArrays, mlupsSoA);
+    std::auto_ptr<MultiScalarField3D<T> > single =
+        runCavity(parameters, numIter, singlePrecision, mlupsSingle);
+
+    pcout << "Double precision, array of structures: "
+          << mlupsReference << " MLUPS" << std::endl;
+    pcout << "Double precision, structure of arrays: "
+          << mlupsSoA << " MLUPS, relative difference of the velocity "
+          << relativeDifference(*soa, *reference) << std::endl;
+    pcout << "Single precision, structure of arrays: "
+          << mlupsSingle << " MLUPS, relative difference of the velocity "
+          << relativeDifference(*single, *reference) << std::endl;
+}
@@ -0,0 +1,160 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+  * Vectorized collision kernels (BGK D3Q19, BGK D3Q27, MRT D3Q19).
+  * For each instruction set supported by the processor, the kernels are
+  * first compared with the scalar collision templates, and then timed in
+  * a periodic box with structure-of-arrays storage.
+**/
+
+#include "palabos3D.h"
+#include "palabos3D.hh"   // include full template code
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+using namespace plb;
+using namespace std;
+
+typedef double T;
+
+/// Populations of numCells cells, close to equilibrium, in structure-of-arrays order.
+template<class D>
+std::vector<T> randomPopulations(plint numCells) {
+    std::vector<T> f(D::q*numCells);
+    srand(42);
+    for (plint iCell=0; iCell<numCells; ++iCell) {
+        for (plint iPop=0; iPop<D::q; ++iPop) {
+            T noise = (T)rand()/(T)RAND_MAX - (T)0.5;
+            f[iPop*numCells+iCell] = D::t[iPop]*((T)1+(T)0.1*noise) - D::t[iPop];
+        }
+    }
+    return f;
+}
+
+/// Largest difference between the vectorized kernel, applied through the
+///   dynamics object, and the scalar collision templates.
+template<template<typename U> class Descriptor>
+T compareWithScalarTemplates(Dynamics<T,Descriptor>& dynamics, plint numCells)
+{
+    typedef typename Descriptor<T>::BaseDescriptor D;
+    std::vector<T> f = randomPopulations<D>(numCells);
+    std::vector<T> fRef(f);
+
+    BlockStatistics statistics;
+    dynamics.collideStructureOfArrays(&f[0], numCells, numCells, false, statistics);
+
+    Cell<T,Descriptor> cell(&dynamics);
+    for (plint iCell=0; iCell<numCells; ++iCell) {
+        for (plint iPop=0; iPop<D::q; ++iPop) {
+            cell[iPop] = fRef[iPop*numCells+iCell];
+        }
+        cell.specifyStatisticsStatus(false);
+        dynamics.collide(cell, statistics);
+        for (plint iPop=0; iPop<D::q; ++iPop) {
+            fRef[iPop*numCells+iCell] = cell[iPop];
+        }
+    }
+    T maxDiff = T();
+    for (pluint i=0; i<f.size(); ++i) {
+        maxDiff = std::max(maxDiff, std::fabs(f[i]-fRef[i]));
+    }
+    return maxDiff;
+}
+
+template<template<typename U> class Descriptor>
+T measureMlups(Dynamics<T,Descriptor>* dynamics, plint N, plint numIter, bool structureOfArrays)
+{
+    MultiBlockLattice3D<T,Descriptor> lattice(N, N, N, dynamics);
+    lattice.periodicity().toggleAll(true);
+    initializeAtEquilibrium(lattice, lattice.getBoundingBox(), (T)1., Array<T,3>((T)0.01,(T)0.,(T)0.));
+    lattice.initialize();
+    lattice.toggleStructureOfArrays(structureOfArrays);
+    // Warm-up.
+    lattice.collideAndStream();
+
+    global::timer("simd").restart();
+    for (plint iT=0; iT<numIter; ++iT) {
+        lattice.collideAndStream();
+    }
+    T time = global::timer("simd").stop();
+    return (T)(N*N*N)*(T)numIter/time/1.e6;
+}
+
+template<template<typename U> class Descriptor>
+bool runKernel(std::string name, Dynamics<T,Descriptor> const& dynamics, plint N, plint numIter)
+{
+    bool passed = true;
+    pcout << name << std::endl;
+    pcout << "    scalar templates, array-of-structures: "
+          << measureMlups(dynamics.clone(), N, numIter, false) << " MLUPS" << std::endl;
+    simd::InstructionSet detected = simd::detectInstructionSet();
+    for (int iSet=simd::scalarInstructions; iSet<=detected; ++iSet) {
+        simd::setInstructionSet((simd::InstructionSet)iSet);
+        std::auto_ptr<Dynamics<T,Descriptor> > testDynamics(dynamics.clone());
+        // An odd number of cells exercises the remainder loop.
+        T maxDiff = compareWithScalarTemplates(*testDynamics, 101);
+        bool ok = maxDiff < (T)1.e-13;
+        passed = passed && ok;
+        pcout << "    " << simd::instructionSetName((simd::InstructionSet)iSet)
+              << ", structure-of-arrays: max. difference to scalar templates "
+              << maxDiff << (ok ? " (passed), " : " (FAILED), ")
+              << measureMlups(dynamics.clone(), N, numIter, true) << " MLUPS" << std::endl;
+    }
+    simd::setInstructionSet(detected);
+    return passed;
+}
+
+int main(int argc, char* argv[]) {
+
+    plbInit(&argc, &argv);
+
+    plint N, numIter;
+    try {
+        global::argv(1).read(N);
+        global::argv(2).read(numIter);
+    }
+    catch(...)
+    {
+        pcout << "Wrong parameters. The syntax is " << std::endl;
+        pcout << argv[0] << " N numIter" << std::endl;
+        pcout << "where N is the resolution of the periodic box, and numIter the" << std::endl;
+        pcout << "number of time steps per measurement." << std::endl;
+        exit(1);
+    }
+
+    pcout << "Detected instruction set: "
+          << simd::instructionSetName(simd::detectInstructionSet()) << std::endl;
+    T omega = (T)1.6;
+    bool passed = true;
+    passed = runKernel("BGK, D3Q19", BGKdynamics<T,descriptors::D3Q19Descriptor>(omega), N, numIter) && passed;
+    passed = runKernel("BGK, D3Q27", BGKdynamics<T,descriptors::D3Q27Descriptor>(omega), N, numIter) && passed;
+    passed = runKernel("MRT, D3Q19",
+                       MRTdynamics<T,descriptors::MRTD3Q19Descriptor>(new MRTparam<T,descriptors::MRTD3Q19Descriptor>(omega)),
+                       N, numIter) && passed;
+
+    pcout << (passed ? "All kernels agree with the scalar templates." : "Some kernels FAILED.") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -27,6 +27,8 @@
  */
 #include "atomicBlock/atomicBlock3D.h"
 #include "atomicBlock/atomicBlockSerializer3D.h"
+#include "core/plbDebug.h"
+#include <cstring>
 
 namespace plb {
 
@@ -53,6 +55,23 @@ plint StatSubscriber3D::subscribeIntSum() {
 }
 
 
+/* *************** Class BlockDataTransfer3D ******************************** */
+
+void BlockDataTransfer3D::sendStatic(Box3D domain, char* buffer) const {
+    std::vector<char> message;
+    send(domain, message, modif::staticVariables);
+    PLB_ASSERT( (plint)message.size() == domain.nCells()*staticCellSize() );
+    if (!message.empty()) {
+        memcpy(buffer, &message[0], message.size());
+    }
+}
+
+void BlockDataTransfer3D::receiveStatic(Box3D domain, char const* buffer, Dot3D absoluteOffset) {
+    std::vector<char> message(buffer, buffer+domain.nCells()*staticCellSize());
+    receive(domain, message, modif::staticVariables, absoluteOffset);
+}
+
+
 /* *************** Class AtomicBlock3D ************************************** */
 
 AtomicBlock3D::AtomicBlock3D(plint nx_, plint ny_, plint nz_)
@@ -214,7 +233,7 @@ void AtomicBlock3D::executeInternalProcessors(plint level, DataProcessorVector&
 {
     if (level<(plint)processors.size()) {
         for (pluint iProc=0; iProc<processors[level].size(); ++iProc) {
-            processors[level][iProc] -> process();
+            processWithTiming(*processors[level][iProc]);
         }
     }
 }
@@ -88,6 +88,37 @@ struct BlockDataTransfer3D {
     {
         attribute(toDomain, deltaX, deltaY, deltaZ, from, kind);
     }
+    /// Write the static data of domain in place, into a buffer of
+    ///   domain.nCells()*staticCellSize() bytes.
+    /** This is used by the communicators to pack the data directly into the
+     *  message which is sent. By default, the data is obtained through send()
+     *  and copied into the buffer.
+     **/
+    virtual void sendStatic(Box3D domain, char* buffer) const;
+    /// Read the static data written by sendStatic().
+    virtual void receiveStatic(Box3D domain, char const* buffer, Dot3D absoluteOffset);
+    /// Number of bytes per cell sent by sendDirectional().
+    virtual plint directionalCellSize(Dot3D bulkDirection) const {
+        return staticCellSize();
+    }
+    /// Write the part of the static data which a neighboring block needs to
+    ///   complete a streaming step, when its bulk lies in direction bulkDirection
+    ///   of domain (see SmartBulk3D::directionOfBulk()), into a buffer of
+    ///   domain.nCells()*directionalCellSize() bytes. By default, all static
+    ///   data is sent.
+    virtual void sendDirectional(Box3D domain, char* buffer, Dot3D bulkDirection) const {
+        sendStatic(domain, buffer);
+    }
+    /// Read the data written by sendDirectional().
+    virtual void receiveDirectional(Box3D domain, char const* buffer, Dot3D bulkDirection) {
+        receiveStatic(domain, buffer, Dot3D());
+    }
+    /// Attribute the data sent by sendDirectional() between two blocks.
+    virtual void attributeDirectional(Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+                                      AtomicBlock3D const& from, Dot3D bulkDirection)
+    {
+        attribute(toDomain, deltaX, deltaY, deltaZ, from, modif::staticVariables);
+    }
 };
 
 class AtomicBlock3D : public Block3D {
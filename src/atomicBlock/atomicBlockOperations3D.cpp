@@ -35,7 +35,7 @@ void executeDataProcessor( DataProcessorGenerator3D const& generator,
                            std::vector<AtomicBlock3D*> objects )
 {
     DataProcessor3D* processor = generator.generate(objects);
-    processor -> process();
+    processWithTiming(*processor);
     delete processor;
 }
 
@@ -61,7 +61,7 @@ void executeDataProcessor( ReductiveDataProcessorGenerator3D& generator,
                            std::vector<AtomicBlock3D*> objects )
 {
     DataProcessor3D* processor = generator.generate(objects);
-    processor -> process();
+    processWithTiming(*processor);
     delete processor;
 }
 
@@ -243,7 +243,7 @@ void BlockLattice2D<T,Descriptor>::collideAndStream(Box2D domain)
     // Make sure domain is contained within current lattice
     PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
 
-    global::profiler().start("collStream");
+    global::profiler().start(global::ProfilerTimer::collStream);
     global::profiler().increment("collStreamCells", domain.nCells());
 
     static const plint vicinity = Descriptor<T>::vicinity;
@@ -272,7 +272,7 @@ void BlockLattice2D<T,Descriptor>::collideAndStream(Box2D domain)
                                  domain.y0,domain.y0+vicinity-1));
     boundaryStream(domain, Box2D(domain.x0+vicinity,domain.x1-vicinity,
                                  domain.y1-vicinity+1,domain.y1));
-    global::profiler().stop("collStream");
+    global::profiler().stop(global::ProfilerTimer::collStream);
 }
 
 /** At the end of this method, the methods finalizeIteration() and
@@ -37,6 +37,7 @@
 #include "core/blockIdentifiers.h"
 #include <vector>
 #include <map>
+#include <set>
 
 /// All Palabos code is contained in this namespace.
 namespace plb {
@@ -68,7 +69,24 @@ public:
     {
         attribute(toDomain, deltaX, deltaY, deltaZ, from, kind);
     }
+    virtual void sendStatic(Box3D domain, char* buffer) const;
+    virtual void receiveStatic(Box3D domain, char const* buffer, Dot3D absoluteOffset);
+    virtual plint directionalCellSize(Dot3D bulkDirection) const;
+    /// Send the populations which are streamed into the bulk of a neighbor.
+    /** The lattice must be in the state left by a collision step, in which
+     *  the populations of a cell are reverted: the population leaving the cell
+     *  in direction iPop is stored at the position opposite(iPop). Only the
+     *  populations with a velocity component of the same sign as every
+     *  non-zero component of bulkDirection are sent.
+     **/
+    virtual void sendDirectional(Box3D domain, char* buffer, Dot3D bulkDirection) const;
+    virtual void receiveDirectional(Box3D domain, char const* buffer, Dot3D bulkDirection);
+    virtual void attributeDirectional(Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+                                      AtomicBlock3D const& from, Dot3D bulkDirection);
 private:
+    /// Positions, in a reverted cell, of the populations which are streamed
+    ///   in the given direction.
+    static void directionalPopulations(Dot3D bulkDirection, std::vector<plint>& populations);
     void send_static(Box3D domain, std::vector<char>& buffer) const;
     void send_dynamic(Box3D domain, std::vector<char>& buffer) const;
     void send_all(Box3D domain, std::vector<char>& buffer) const;
@@ -123,6 +141,9 @@ public:
         PLB_PRECONDITION(iX<this->getNx());
         PLB_PRECONDITION(iY<this->getNy());
         PLB_PRECONDITION(iZ<this->getNz());
+        if (soaFlag) {
+            cacheCell(iX,iY,iZ);
+        }
         return grid[iX][iY][iZ];
     }
     /// Read only access to lattice cells
@@ -130,6 +151,9 @@ public:
         PLB_PRECONDITION(iX<this->getNx());
         PLB_PRECONDITION(iY<this->getNy());
         PLB_PRECONDITION(iZ<this->getNz());
+        if (soaFlag) {
+            cacheCell(iX,iY,iZ);
+        }
         return grid[iX][iY][iZ];
     }
     /// Specify wheter statistics measurements are done on a rect. domain
@@ -147,15 +171,123 @@ public:
     virtual void collideAndStream(Box3D domain);
     /// Apply first collision, then streaming step to the whole domain
     virtual void collideAndStream();
+    /// Conclude collideAndStream(domain) after it has been applied to core only.
+    /** The cells of domain outside of core are collided, and the populations
+     *  are streamed across the boundary of core. Together with a previous
+     *  call to collideAndStream(core), this is equivalent to collideAndStream(domain).
+     */
+    void completeCollideAndStream(Box3D domain, Box3D core);
+    /// Conclude collideAndStream(domain) after it has been applied to core only,
+    ///   when the cells of domain outside of core need not be collided.
+    /** This is the case when the populations which these cells stream into core
+     *  have been received from a neighboring block, as with
+     *  BlockLatticeDataTransfer3D::receiveDirectional(). Only the populations
+     *  which cross the boundary of core are streamed.
+     */
+    void completeStream(Box3D domain, Box3D core);
     /// Increment time counter
     virtual void incrementTime();
     /// Get access to data transfer between blocks
     virtual BlockLatticeDataTransfer3D<T,Descriptor>& getDataTransfer();
     /// Get access to data transfer between blocks (const version)
     virtual BlockLatticeDataTransfer3D<T,Descriptor> const& getDataTransfer() const;
+    /// Store the populations as structure of arrays, i.e. one contiguous
+    ///   array per direction, instead of inside the Cell objects.
+    /** Cells remain accessible through get(): the populations of a cell are
+     *  copied into the Cell object on its first access, and copied back at
+     *  the beginning of the next collision-streaming step. References
+     *  to cells must therefore not be kept across collision-streaming steps
+     *  in this mode. Dynamics, external scalars and statistics flags always
+     *  reside in the Cell objects. Turning this mode off also turns off the
+     *  single-precision storage.
+     *  The Cell objects stay allocated, so that the populations are stored
+     *  twice: the memory of the block is about doubled (for D3Q19 in double
+     *  precision, 152 bytes of arrays per cell come on top of the Cell
+     *  objects). The const version of get() also caches the cell, through
+     *  mutable state; a block must therefore not be read by several
+     *  threads at the same time in this mode.
+     */
+    void toggleStructureOfArrays(bool soaFlag_);
+    bool isStructureOfArraysOn() const;
+    /// In structure-of-arrays mode, store the populations in single precision.
+    /** Palabos stores the populations as the deviation f_i-t_i from the lattice
+     *  weights, which can be rounded to float with a relative error of about
+     *  1e-7 of the deviation, instead of the absolute value. The collision, the
+     *  moments and the Cell objects remain in precision T: the populations of
+     *  each line of cells are converted to precision T for the collision, and
+     *  back after it. This halves the size of the population arrays, which
+     *  are streamed at each step, but not the Cell objects, which remain
+     *  allocated in precision T: for D3Q19 in double precision, a cell takes
+     *  about 1.5 times the memory of the default layout, instead of twice
+     *  with the double-precision structure of arrays. Due to the conversion,
+     *  this mode is in general slower unless the memory bandwidth is the
+     *  bottleneck. Turning this setting on also turns on the
+     *  structure-of-arrays mode, which it requires.
+     */
+    void toggleSinglePrecisionStorage(bool singlePrecisionFlag_);
+    bool isSinglePrecisionStorageOn() const;
+    /// Restrict the collision-streaming step to the active cells, i.e. the
+    ///   cells whose dynamics is not NoDynamics, through a list of these
+    ///   cells and a precomputed table of their active neighbors.
+    /** The cost of collideAndStream() is then proportional to the number of
+     *  active cells instead of the volume of the block, which pays off in
+     *  porous or vascular geometries. Populations are never streamed from or
+     *  into inactive cells: the populations of an active cell which point to
+     *  an inactive neighbor are only reverted, as at the boundary of the
+     *  domain. This yields the same result as the full lattice for the fluid
+     *  cells, provided that the fluid is separated from the NoDynamics cells
+     *  by a layer of active wall cells such as BounceBack. The Cell objects
+     *  of all cells are kept, so that cell access and data processors are
+     *  unaffected. The list of active cells is updated lazily after dynamics
+     *  are changed through attributeDynamics(). The memory of the block is
+     *  not reduced: the index tables, of about 1+q/2 integers per active
+     *  cell, come on top of the Cell objects. This mode cannot be combined
+     *  with the structure-of-arrays mode (checked in debug mode).
+     */
+    void toggleIndirectAddressing(bool indirectFlag_);
+    bool isIndirectAddressingOn() const;
+    /// Number of cells whose dynamics is not NoDynamics.
+    plint getNumActiveCells();
 public:
-    /// Attribute dynamics to a cell.
+    /// Attribute dynamics to a cell. The lattice takes ownership of the
+    ///   dynamics object. Shareable dynamics (see Dynamics::isShareable())
+    ///   are deduplicated: if the lattice already holds an identical
+    ///   instance, this instance is attributed to the cell, and the
+    ///   argument is deleted.
     void attributeDynamics(plint iX, plint iY, plint iZ, Dynamics<T,Descriptor>* dynamics);
+    /// Get the instance of the lattice, shared by all cells with identical
+    ///   dynamics, which is identical to the argument, or 0 if the dynamics
+    ///   is not shareable. The result can be attributed to any number of
+    ///   cells without being cloned.
+    Dynamics<T,Descriptor>* getSharedDynamics(Dynamics<T,Descriptor> const& dynamics);
+    /// Number of distinct shared dynamics instances.
+    plint getNumSharedDynamics() const;
+    /// Set the relaxation frequency of the dynamics of a cell. If the cell
+    ///   references a shared instance, it gets a modified copy (which is
+    ///   shared in turn), and the other cells are not affected.
+    void setOmega(plint iX, plint iY, plint iZ, T omega);
+    /// Set a parameter of the dynamics of a cell, as setOmega().
+    void setParameter(plint iX, plint iY, plint iZ, plint whichParameter, T value);
+    /// Share all identical compactable dynamics, and not only the dynamics
+    ///   which are declared shareable, between the cells of the lattice.
+    /** In this mode, the cells reference a per-block table of distinct
+     *  dynamics instances, indexed by their class id and parameters, instead
+     *  of owning one instance each. Only the dynamics whose collision leaves
+     *  the object unchanged, and which declare it through
+     *  Dynamics::isCompactable() (e.g. BGK and regularized BGK), are shared;
+     *  all others, such as the Smagorinsky dynamics which adapt their omega
+     *  in every cell, keep one instance per cell. This removes the per-cell
+     *  dynamics objects, and lets collideAndStream() collide long runs of
+     *  cells with a single call to Dynamics::collideCells().
+     *  Cell::getDynamics() remains valid, but a
+     *  parameter changed through it applies to all cells which share the
+     *  instance; per-cell parameters must be set through the lattice, with
+     *  setOmega() and setParameter() (as the setOmega() data processors do),
+     *  or by attributing new dynamics. Turning the mode off gives every cell
+     *  its own copy again.
+     */
+    void toggleCompactDynamics(bool compactDynamicsFlag_);
+    bool isCompactDynamicsOn() const;
     /// Get a reference to the background dynamics
     Dynamics<T,Descriptor>& getBackgroundDynamics();
     /// Get a const reference to the background dynamics
@@ -164,6 +296,9 @@ public:
     void bulkStream(Box3D domain);
     /// Apply streaming step to boundary cells
     void boundaryStream(Box3D bound, Box3D domain);
+    /// Apply streaming step to the cells of core which are adjacent to
+    ///   bound, but only for populations leaving core.
+    void crossStream(Box3D bound, Box3D core);
     /// Apply collision and streaming step to bulk (non-boundary) cells
     void bulkCollideAndStream(Box3D domain);
 private:
@@ -172,18 +307,148 @@ private:
     /// Cache-efficient implementation of bulkCollideAndStream(domain)for
     ///   nearest-neighbor lattices.
     void blockwiseBulkCollideAndStream(Box3D domain);
+    /// Collide the cells (iX,iY,z0) to (iX,iY,z1), with one call to
+    ///   Dynamics::collideCells per run of cells sharing a dynamics object.
+    void collideLine(plint iX, plint iY, plint z0, plint z1);
+    /// Collision and streaming on structure-of-arrays storage. Populations
+    ///   are streamed to neighbors inside bound only; the cells of bound
+    ///   outside domain must already have been collided.
+    void soaCollideAndStream(Box3D bound, Box3D domain);
+    /// Collision and streaming on the active cells only. Populations are
+    ///   streamed to active neighbors inside bound only; the cells of bound
+    ///   outside domain must already have been collided.
+    void indirectCollideAndStream(Box3D bound, Box3D domain);
+    /// Recompute the list of active cells and their neighbor table.
+    void computeActiveCells();
+    /// Decompose the region between domain and core into six non-overlapping
+    ///   slabs, some of which may be empty.
+    static void computeShell(Box3D domain, Box3D core, std::vector<Box3D>& shell);
+    /// Streaming step across the boundary of core, for populations leaving
+    ///   the shell and populations leaving core towards the shell.
+    void streamAcrossCore(Box3D domain, Box3D core, std::vector<Box3D> const& shell);
+private:
+    /// Access to a population, in the Cell object if the cell is cached
+    ///   or if the lattice is not in structure-of-arrays mode, and in the
+    ///   structure of arrays otherwise.
+    T& population(plint iX, plint iY, plint iZ, plint iPop) {
+        plint iCell = iZ + this->getNz()*(iY + this->getNy()*iX);
+        if (soaFlag && !cellIsCached[iCell]) {
+            if (!singlePrecisionFlag) {
+                return soaPopulations[iPop*(plint)cellIsCached.size()+iCell];
+            }
+            cacheCell(iX,iY,iZ);
+        }
+        return rawData[iCell][iPop];
+    }
+    T const& population(plint iX, plint iY, plint iZ, plint iPop) const {
+        plint iCell = iZ + this->getNz()*(iY + this->getNy()*iX);
+        if (soaFlag && !cellIsCached[iCell]) {
+            if (!singlePrecisionFlag) {
+                return soaPopulations[iPop*(plint)cellIsCached.size()+iCell];
+            }
+            cacheCell(iX,iY,iZ);
+        }
+        return rawData[iCell][iPop];
+    }
+    /// Population of a cell in the structure of arrays, in single or
+    ///   double precision.
+    T soaPopulation(plint iPop, plint iCell) const {
+        plint numCells = (plint)cellIsCached.size();
+        if (singlePrecisionFlag) {
+            return (T)soaSinglePopulations[iPop*numCells+iCell];
+        }
+        return soaPopulations[iPop*numCells+iCell];
+    }
+    void setSoaPopulation(plint iPop, plint iCell, T value) {
+        plint numCells = (plint)cellIsCached.size();
+        if (singlePrecisionFlag) {
+            soaSinglePopulations[iPop*numCells+iCell] = (float)value;
+        }
+        else {
+            soaPopulations[iPop*numCells+iCell] = value;
+        }
+    }
+    /// Streaming of the populations iPop and opposite(iPop) on a line of
+    ///   the structure of arrays; see soaCollideAndStream().
+    template<typename S>
+    static void soaStreamLine(S* f, S* fOpp, plint offset, plint lineStart,
+                              plint streamStart, plint streamEnd, plint lineEnd);
+    /// Equivalent of Cell::serialize which does not cache the cell.
+    void serializeCell(plint iX, plint iY, plint iZ, char* data) const;
+    /// Equivalent of Cell::unSerialize which does not cache the cell.
+    void unSerializeCell(plint iX, plint iY, plint iZ, char const* data);
+    /// In structure-of-arrays mode, copy the populations of a cell into
+    ///   the Cell object, unless this has already been done.
+    void cacheCell(plint iX, plint iY, plint iZ) const {
+        plint iCell = iZ + this->getNz()*(iY + this->getNy()*iX);
+        if (!cellIsCached[iCell]) {
+            Cell<T,Descriptor>& cell = rawData[iCell];
+            for (plint iPop=0; iPop<Descriptor<T>::q; ++iPop) {
+                cell[iPop] = soaPopulation(iPop, iCell);
+            }
+            cellIsCached[iCell] = true;
+            cachedCells.push_back(iCell);
+        }
+    }
+    /// Apply cacheCell to all cells of a domain.
+    void cacheDomain(Box3D domain) const;
+    /// Copy the populations, dynamics and statistics flag of all cached
+    ///   cells back into the structure of arrays.
+    void flushCellCache();
 private:
     /// Helper method for memory allocation
     void allocateAndInitialize();
     /// Helper method for memory de-allocation
     void releaseMemory();
+    /// Replace a shareable dynamics object by the identical shared instance,
+    ///   which is created if needed, and take ownership of the argument.
+    Dynamics<T,Descriptor>* shareDynamics(Dynamics<T,Descriptor>* dynamics);
+    /// Unserialize the content of the dynamics of a cell, starting at position
+    ///   pos of buffer, and return the position after it. As with setOmega(),
+    ///   a shared instance is not modified: the cell gets a modified copy.
+    pluint unserializeDynamics( plint iX, plint iY, plint iZ,
+                                std::vector<char> const& buffer, pluint pos );
+    /// Tell whether a dynamics object can be replaced by a shared instance.
+    bool canShare(Dynamics<T,Descriptor> const& dynamics) const {
+        return dynamics.isShareable() || (compactDynamicsFlag && dynamics.isCompactable());
+    }
+    /// Tell whether a dynamics object is owned by the cells, as opposed to
+    ///   the background dynamics and the shared instances.
+    bool ownedByCell(Dynamics<T,Descriptor> const* dynamics) const {
+        return dynamics != backgroundDynamics &&
+               (sharedDynamics.empty() || sharedDynamics.find(dynamics)==sharedDynamics.end());
+    }
     void implementPeriodicity();
 private:
     void periodicDomain(Box3D domain);
 private:
     Dynamics<T,Descriptor>* backgroundDynamics;
+    /// Shared instances of shareable dynamics, indexed by their serialized
+    ///   content at the time of their registration, and the set of these
+    ///   instances, which owns them.
+    std::map<std::vector<char>, Dynamics<T,Descriptor>*> sharedDynamicsByContent;
+    std::set<Dynamics<T,Descriptor> const*> sharedDynamics;
+    bool compactDynamicsFlag;
     Cell<T,Descriptor>     *rawData;
     Cell<T,Descriptor>   ***grid;
+    /// Structure-of-arrays storage.
+    bool soaFlag;
+    T* soaPopulations;
+    bool singlePrecisionFlag;
+    float* soaSinglePopulations;
+    std::vector<Dynamics<T,Descriptor>*> soaDynamics;
+    std::vector<bool> soaStatistics;
+    mutable std::vector<bool> cellIsCached;
+    mutable std::vector<plint> cachedCells;
+    /// Indirect addressing: indices of the active cells in rawData, in
+    ///   increasing order, position of the first active cell of each
+    ///   z-line in this list, and, for each active cell, the index of the
+    ///   neighbor in direction iPop=1..q/2, or -1 if it is not active.
+    bool indirectFlag;
+    bool activeCellsAreValid;
+    std::vector<plint> activeCells;
+    std::vector<plint> activeLineStart;
+    std::vector<plint> activeNeighbors;
     BlockLatticeDataTransfer3D<T,Descriptor> dataTransfer;
 public:
     static CachePolicy3D& cachePolicy();
@@ -193,6 +458,7 @@ template<typename T_, template<typename U_> class Descriptor_>
     friend class PackedExternalRhoJcollideAndStream3D;
 template<typename T_, template<typename U_> class Descriptor_>
     friend class OnLinkExternalRhoJcollideAndStream3D;
+    friend class BlockLatticeDataTransfer3D<T,Descriptor>;
 };
 
 template<typename T, template<typename U> class Descriptor>
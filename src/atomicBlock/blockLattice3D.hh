@@ -37,9 +37,11 @@
 #include "core/latticeStatistics.h"
 #include "core/dynamicsIdentifiers.h"
 #include "core/plbProfiler.h"
+#include "core/memoryPolicy.h"
 #include <algorithm>
 #include <typeinfo>
 #include <cmath>
+#include <cstring>
 
 namespace plb {
 
@@ -55,6 +57,13 @@ BlockLattice3D<T,Descriptor>::BlockLattice3D (
         Dynamics<T,Descriptor>* backgroundDynamics_ )
     : AtomicBlock3D(nx_, ny_, nz_),
       backgroundDynamics(backgroundDynamics_),
+      compactDynamicsFlag(false),
+      soaFlag(false),
+      soaPopulations(0),
+      singlePrecisionFlag(false),
+      soaSinglePopulations(0),
+      indirectFlag(false),
+      activeCellsAreValid(false),
       dataTransfer(*this)
 {
     plint nx = this->getNx();
@@ -103,12 +112,35 @@ BlockLattice3D<T,Descriptor>::BlockLattice3D(BlockLattice3D<T,Descriptor> const&
     : BlockLatticeBase3D<T,Descriptor>(rhs),
       AtomicBlock3D(rhs),
       backgroundDynamics(rhs.backgroundDynamics->clone()),
+      compactDynamicsFlag(rhs.compactDynamicsFlag),
+      soaFlag(false),
+      soaPopulations(0),
+      singlePrecisionFlag(false),
+      soaSinglePopulations(0),
+      indirectFlag(false),
+      activeCellsAreValid(false),
       dataTransfer(*this)
 {
     plint nx = this->getNx();
     plint ny = this->getNy();
     plint nz = this->getNz();
     allocateAndInitialize();
+    // Shared dynamics are cloned once, and remain shared.
+    std::map<Dynamics<T,Descriptor> const*, Dynamics<T,Descriptor>*> sharedClones;
+    typename std::set<Dynamics<T,Descriptor> const*>::const_iterator itShared
+        = rhs.sharedDynamics.begin();
+    for (; itShared != rhs.sharedDynamics.end(); ++itShared) {
+        Dynamics<T,Descriptor>* clone = (*itShared)->clone();
+        sharedDynamics.insert(clone);
+        sharedClones[*itShared] = clone;
+    }
+    typename std::map<std::vector<char>, Dynamics<T,Descriptor>*>::const_iterator it
+        = rhs.sharedDynamicsByContent.begin();
+    for (; it != rhs.sharedDynamicsByContent.end(); ++it) {
+        sharedDynamicsByContent[it->first] = sharedClones[it->second];
+    }
+    // Make sure the populations of rhs are up-to-date in its Cell objects.
+    rhs.cacheDomain(rhs.getBoundingBox());
     for (plint iX=0; iX<nx; ++iX) {
         for (plint iY=0; iY<ny; ++iY) {
             for (plint iZ=0; iZ<nz; ++iZ) {
@@ -116,16 +148,22 @@ BlockLattice3D<T,Descriptor>::BlockLattice3D(BlockLattice3D<T,Descriptor> const&
                 // Assign cell from rhs
                 cell = rhs.grid[iX][iY][iZ];
                 // Get an independent clone of the dynamics,
-                //   or assign backgroundDynamics
+                //   or assign backgroundDynamics or a shared instance
                 if (&cell.getDynamics()==rhs.backgroundDynamics) {
                     cell.attributeDynamics(backgroundDynamics);
                 }
+                else if (!rhs.ownedByCell(&cell.getDynamics())) {
+                    cell.attributeDynamics(sharedClones[&cell.getDynamics()]);
+                }
                 else {
                     cell.attributeDynamics(cell.getDynamics().clone());
                 }
             }
         }
     }
+    toggleSinglePrecisionStorage(rhs.singlePrecisionFlag);
+    toggleStructureOfArrays(rhs.soaFlag);
+    toggleIndirectAddressing(rhs.indirectFlag);
 }
 
 /** The current lattice is deallocated, then the lattice from the rhs
@@ -151,8 +189,24 @@ void BlockLattice3D<T,Descriptor>::swap(BlockLattice3D& rhs) {
     BlockLatticeBase3D<T,Descriptor>::swap(rhs);
     AtomicBlock3D::swap(rhs);
     std::swap(backgroundDynamics, rhs.backgroundDynamics);
+    sharedDynamicsByContent.swap(rhs.sharedDynamicsByContent);
+    sharedDynamics.swap(rhs.sharedDynamics);
+    std::swap(compactDynamicsFlag, rhs.compactDynamicsFlag);
     std::swap(rawData, rhs.rawData);
     std::swap(grid, rhs.grid);
+    std::swap(soaFlag, rhs.soaFlag);
+    std::swap(soaPopulations, rhs.soaPopulations);
+    std::swap(singlePrecisionFlag, rhs.singlePrecisionFlag);
+    std::swap(soaSinglePopulations, rhs.soaSinglePopulations);
+    soaDynamics.swap(rhs.soaDynamics);
+    soaStatistics.swap(rhs.soaStatistics);
+    cellIsCached.swap(rhs.cellIsCached);
+    cachedCells.swap(rhs.cachedCells);
+    std::swap(indirectFlag, rhs.indirectFlag);
+    std::swap(activeCellsAreValid, rhs.activeCellsAreValid);
+    activeCells.swap(rhs.activeCells);
+    activeLineStart.swap(rhs.activeLineStart);
+    activeNeighbors.swap(rhs.activeNeighbors);
 }
 
 template<typename T, template<typename U> class Descriptor>
@@ -160,6 +214,7 @@ void BlockLattice3D<T,Descriptor>::specifyStatisticsStatus(Box3D domain, bool st
     // Make sure domain is contained within current lattice
     PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
 
+    cacheDomain(domain);
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
@@ -174,6 +229,7 @@ void BlockLattice3D<T,Descriptor>::collide(Box3D domain) {
     // Make sure domain is contained within current lattice
     PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
 
+    cacheDomain(domain);
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
@@ -206,6 +262,7 @@ void BlockLattice3D<T,Descriptor>::stream(Box3D domain) {
 
     static const plint vicinity = Descriptor<T>::vicinity;
 
+    cacheDomain(domain);
     bulkStream(Box3D(domain.x0+vicinity,domain.x1-vicinity,
                      domain.y0+vicinity,domain.y1-vicinity,
                      domain.z0+vicinity,domain.z1-vicinity) );
@@ -254,11 +311,25 @@ void BlockLattice3D<T,Descriptor>::collideAndStream(Box3D domain) {
     // Make sure domain is contained within current lattice
     PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
 
-    global::profiler().start("collStream");
+    global::profiler().start(global::ProfilerTimer::collStream);
     global::profiler().increment("collStreamCells", domain.nCells());
 
     static const plint vicinity = Descriptor<T>::vicinity;
 
+    if (soaFlag) {
+        // The structure-of-arrays implementation treats the boundary
+        //   envelope together with the bulk.
+        flushCellCache();
+        soaCollideAndStream(domain, domain);
+        global::profiler().stop(global::ProfilerTimer::collStream);
+        return;
+    }
+    if (indirectFlag) {
+        indirectCollideAndStream(domain, domain);
+        global::profiler().stop(global::ProfilerTimer::collStream);
+        return;
+    }
+
     // First, do the collision on cells within a boundary envelope of width
     // equal to the range of the lattice vectors (e.g. 1 for D3Q19)
     collide(Box3D(domain.x0,domain.x0+vicinity-1,
@@ -308,7 +379,7 @@ void BlockLattice3D<T,Descriptor>::collideAndStream(Box3D domain) {
     boundaryStream(domain, Box3D(domain.x0+vicinity,domain.x1-vicinity,
                                  domain.y0+vicinity,domain.y1-vicinity,
                                  domain.z1-vicinity+1,domain.z1) );
-    global::profiler().stop("collStream");
+    global::profiler().stop(global::ProfilerTimer::collStream);
 }
 
 /** At the end of this method, finalizeIteration() and
@@ -325,6 +396,69 @@ void BlockLattice3D<T,Descriptor>::collideAndStream() {
     this->incrementTime();
 }
 
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::completeCollideAndStream(Box3D domain, Box3D core) {
+    // Make sure domain is contained within current lattice
+    PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
+    // Make sure core is contained within domain
+    PLB_PRECONDITION( contained(core, domain) );
+
+    global::profiler().start(global::ProfilerTimer::collStream);
+    global::profiler().increment("collStreamCells", domain.nCells()-core.nCells());
+
+    std::vector<Box3D> shell;
+    computeShell(domain, core, shell);
+    // The collision must be completed everywhere before the populations are swapped.
+    for (pluint iSlab=0; iSlab<shell.size(); ++iSlab) {
+        if (shell[iSlab].nCells()>0) {
+            collide(shell[iSlab]);
+        }
+    }
+    streamAcrossCore(domain, core, shell);
+    global::profiler().stop(global::ProfilerTimer::collStream);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::completeStream(Box3D domain, Box3D core) {
+    // Make sure domain is contained within current lattice
+    PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
+    // Make sure core is contained within domain
+    PLB_PRECONDITION( contained(core, domain) );
+
+    global::profiler().start(global::ProfilerTimer::collStream);
+    std::vector<Box3D> shell;
+    computeShell(domain, core, shell);
+    streamAcrossCore(domain, core, shell);
+    global::profiler().stop(global::ProfilerTimer::collStream);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::computeShell (
+        Box3D domain, Box3D core, std::vector<Box3D>& shell )
+{
+    // Decompose the region between domain and core into non-overlapping slabs.
+    shell.push_back(Box3D(domain.x0,core.x0-1, domain.y0,domain.y1, domain.z0,domain.z1));
+    shell.push_back(Box3D(core.x1+1,domain.x1, domain.y0,domain.y1, domain.z0,domain.z1));
+    shell.push_back(Box3D(core.x0,core.x1, domain.y0,core.y0-1, domain.z0,domain.z1));
+    shell.push_back(Box3D(core.x0,core.x1, core.y1+1,domain.y1, domain.z0,domain.z1));
+    shell.push_back(Box3D(core.x0,core.x1, core.y0,core.y1, domain.z0,core.z0-1));
+    shell.push_back(Box3D(core.x0,core.x1, core.y0,core.y1, core.z1+1,domain.z1));
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::streamAcrossCore (
+        Box3D domain, Box3D core, std::vector<Box3D> const& shell )
+{
+    // Populations leaving the shell.
+    for (pluint iSlab=0; iSlab<shell.size(); ++iSlab) {
+        if (shell[iSlab].nCells()>0) {
+            boundaryStream(domain, shell[iSlab]);
+        }
+    }
+    // Populations leaving the core towards the shell.
+    crossStream(domain, core);
+}
+
 template<typename T, template<typename U> class Descriptor>
 void BlockLattice3D<T,Descriptor>::incrementTime() {
     this->getTimeCounter().incrementTime();
@@ -339,7 +473,7 @@ void BlockLattice3D<T,Descriptor>::allocateAndInitialize() {
     plint nx = this->getNx();
     plint ny = this->getNy();
     plint nz = this->getNz();
-    rawData = new Cell<T,Descriptor> [nx*ny*nz];
+    rawData = allocateArray<Cell<T,Descriptor> >(nx*ny*nz);
     grid    = new Cell<T,Descriptor>** [nx];
     for (plint iX=0; iX<nx; ++iX) {
         grid[iX] = new Cell<T,Descriptor>* [ny];
@@ -358,14 +492,22 @@ void BlockLattice3D<T,Descriptor>::releaseMemory() {
         for (plint iY=0; iY<ny; ++iY) {
             for (plint iZ=0; iZ<nz; ++iZ) {
                 Dynamics<T,Descriptor>* dynamics = &grid[iX][iY][iZ].getDynamics();
-                if (dynamics != backgroundDynamics) {
+                if (ownedByCell(dynamics)) {
                     delete dynamics;
                 }
             }
         }
     }
+    typename std::set<Dynamics<T,Descriptor> const*>::iterator it = sharedDynamics.begin();
+    for (; it != sharedDynamics.end(); ++it) {
+        delete *it;
+    }
+    sharedDynamicsByContent.clear();
+    sharedDynamics.clear();
     delete backgroundDynamics;
-    delete [] rawData;
+    releaseArray(rawData, nx*ny*nz);
+    releaseArray(soaPopulations, Descriptor<T>::q*nx*ny*nz);
+    releaseArray(soaSinglePopulations, Descriptor<T>::q*nx*ny*nz);
     for (plint iX=0; iX<nx; ++iX) {
         delete [] grid[iX];
     }
@@ -376,11 +518,174 @@ template<typename T, template<typename U> class Descriptor>
 void BlockLattice3D<T,Descriptor>::attributeDynamics (
         plint iX, plint iY, plint iZ, Dynamics<T,Descriptor>* dynamics )
 {
+    if (soaFlag) {
+        cacheCell(iX,iY,iZ);
+    }
     Dynamics<T,Descriptor>* previousDynamics = &grid[iX][iY][iZ].getDynamics();
-    if (previousDynamics != backgroundDynamics) {
+    if (previousDynamics != dynamics && ownedByCell(previousDynamics)) {
         delete previousDynamics;
     }
-    grid[iX][iY][iZ].attributeDynamics(dynamics);
+    activeCellsAreValid = false;
+    grid[iX][iY][iZ].attributeDynamics(shareDynamics(dynamics));
+}
+
+template<typename T, template<typename U> class Descriptor>
+Dynamics<T,Descriptor>* BlockLattice3D<T,Descriptor>::shareDynamics(Dynamics<T,Descriptor>* dynamics)
+{
+    if ( dynamics==backgroundDynamics || !canShare(*dynamics) ||
+         sharedDynamics.find(dynamics) != sharedDynamics.end() )
+    {
+        return dynamics;
+    }
+    std::vector<char> content;
+    serialize(*dynamics, content);
+    typename std::map<std::vector<char>, Dynamics<T,Descriptor>*>::iterator it
+        = sharedDynamicsByContent.find(content);
+    if (it != sharedDynamicsByContent.end()) {
+        std::vector<char> currentContent;
+        serialize(*it->second, currentContent);
+        if (currentContent==content) {
+            delete dynamics;
+            return it->second;
+        }
+        // The shared instance was modified after its registration, for
+        //   example through Cell::getDynamics(). It is indexed again under
+        //   its current content, unless an identical instance exists.
+        Dynamics<T,Descriptor>* modifiedDynamics = it->second;
+        sharedDynamicsByContent.erase(it);
+        sharedDynamicsByContent.insert(std::make_pair(currentContent, modifiedDynamics));
+    }
+    sharedDynamicsByContent[content] = dynamics;
+    sharedDynamics.insert(dynamics);
+    return dynamics;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::setOmega(plint iX, plint iY, plint iZ, T omega)
+{
+    Dynamics<T,Descriptor>* dynamics = &get(iX,iY,iZ).getDynamics();
+    if (sharedDynamics.find(dynamics)==sharedDynamics.end()) {
+        dynamics->setOmega(omega);
+    }
+    else if (dynamics->getOmega()!=omega) {
+        Dynamics<T,Descriptor>* modifiedDynamics = dynamics->clone();
+        modifiedDynamics->setOmega(omega);
+        attributeDynamics(iX,iY,iZ, modifiedDynamics);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::setParameter (
+        plint iX, plint iY, plint iZ, plint whichParameter, T value )
+{
+    Dynamics<T,Descriptor>* dynamics = &get(iX,iY,iZ).getDynamics();
+    if (sharedDynamics.find(dynamics)==sharedDynamics.end()) {
+        dynamics->setParameter(whichParameter, value);
+    }
+    else if (dynamics->getParameter(whichParameter)!=value) {
+        Dynamics<T,Descriptor>* modifiedDynamics = dynamics->clone();
+        modifiedDynamics->setParameter(whichParameter, value);
+        attributeDynamics(iX,iY,iZ, modifiedDynamics);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+pluint BlockLattice3D<T,Descriptor>::unserializeDynamics (
+        plint iX, plint iY, plint iZ, std::vector<char> const& buffer, pluint pos )
+{
+    Dynamics<T,Descriptor>* dynamics = &get(iX,iY,iZ).getDynamics();
+    if (sharedDynamics.find(dynamics)==sharedDynamics.end()) {
+        return unserialize(*dynamics, buffer, pos);
+    }
+    Dynamics<T,Descriptor>* modifiedDynamics = dynamics->clone();
+    pos = unserialize(*modifiedDynamics, buffer, pos);
+    attributeDynamics(iX,iY,iZ, modifiedDynamics);
+    return pos;
+}
+
+template<typename T, template<typename U> class Descriptor>
+Dynamics<T,Descriptor>* BlockLattice3D<T,Descriptor>::getSharedDynamics (
+        Dynamics<T,Descriptor> const& dynamics )
+{
+    if (!canShare(dynamics)) {
+        return 0;
+    }
+    return shareDynamics(dynamics.clone());
+}
+
+template<typename T, template<typename U> class Descriptor>
+plint BlockLattice3D<T,Descriptor>::getNumSharedDynamics() const {
+    return (plint) sharedDynamics.size();
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::toggleCompactDynamics(bool compactDynamicsFlag_) {
+    if (compactDynamicsFlag_==compactDynamicsFlag) {
+        return;
+    }
+    plint nx = this->getNx();
+    plint ny = this->getNy();
+    plint nz = this->getNz();
+    // The dynamics of the structure of arrays are updated from the cells.
+    cacheDomain(this->getBoundingBox());
+    compactDynamicsFlag = compactDynamicsFlag_;
+    if (compactDynamicsFlag) {
+        // Replace the dynamics owned by the cells by shared instances.
+        for (plint iX=0; iX<nx; ++iX) {
+            for (plint iY=0; iY<ny; ++iY) {
+                for (plint iZ=0; iZ<nz; ++iZ) {
+                    Cell<T,Descriptor>& cell = grid[iX][iY][iZ];
+                    Dynamics<T,Descriptor>* dynamics = &cell.getDynamics();
+                    if (ownedByCell(dynamics)) {
+                        cell.attributeDynamics(shareDynamics(dynamics));
+                    }
+                }
+            }
+        }
+    }
+    else {
+        // Give an own copy to the cells which reference a shared instance
+        //   which is not shareable by itself, and delete this instance.
+        for (plint iX=0; iX<nx; ++iX) {
+            for (plint iY=0; iY<ny; ++iY) {
+                for (plint iZ=0; iZ<nz; ++iZ) {
+                    Cell<T,Descriptor>& cell = grid[iX][iY][iZ];
+                    Dynamics<T,Descriptor>& dynamics = cell.getDynamics();
+                    if (!ownedByCell(&dynamics) && &dynamics!=backgroundDynamics &&
+                        !dynamics.isShareable())
+                    {
+                        cell.attributeDynamics(dynamics.clone());
+                    }
+                }
+            }
+        }
+        typename std::map<std::vector<char>, Dynamics<T,Descriptor>*>::iterator it
+            = sharedDynamicsByContent.begin();
+        while (it != sharedDynamicsByContent.end()) {
+            if (it->second->isShareable()) {
+                ++it;
+            }
+            else {
+                sharedDynamicsByContent.erase(it++);
+            }
+        }
+        typename std::set<Dynamics<T,Descriptor> const*>::iterator itShared
+            = sharedDynamics.begin();
+        while (itShared != sharedDynamics.end()) {
+            if ((*itShared)->isShareable()) {
+                ++itShared;
+            }
+            else {
+                delete *itShared;
+                sharedDynamics.erase(itShared++);
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+bool BlockLattice3D<T,Descriptor>::isCompactDynamicsOn() const {
+    return compactDynamicsFlag;
 }
 
 template<typename T, template<typename U> class Descriptor>
@@ -417,8 +722,49 @@ void BlockLattice3D<T,Descriptor>::boundaryStream(Box3D bound, Box3D domain) {
                          nextY>=bound.y0 && nextY<=bound.y1 &&
                          nextZ>=bound.z0 && nextZ<=bound.z1 )
                     {
-                        std::swap(grid[iX][iY][iZ][iPop+Descriptor<T>::q/2],
-                                  grid[nextX][nextY][nextZ][iPop]);
+                        std::swap(population(iX,iY,iZ,iPop+Descriptor<T>::q/2),
+                                  population(nextX,nextY,nextZ,iPop));
+                    }
+                }
+            }
+        }
+    }
+}
+
+/** Only the links between a cell of core and a cell which is inside bound, but
+ * outside core, are treated. Every cell of core is visited at most once: the loops
+ * run over the outer layer of core, of width equal to the vicinity.
+ */
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::crossStream(Box3D bound, Box3D core) {
+    // Make sure bound is contained within current lattice
+    PLB_PRECONDITION( contained(bound, this->getBoundingBox()) );
+    // Make sure core is contained within bound
+    PLB_PRECONDITION( contained(core, bound) );
+
+    static const plint vicinity = Descriptor<T>::vicinity;
+    for (plint iX=core.x0; iX<=core.x1; ++iX) {
+        bool xShell = iX<core.x0+vicinity || iX>core.x1-vicinity;
+        for (plint iY=core.y0; iY<=core.y1; ++iY) {
+            bool yShell = xShell || iY<core.y0+vicinity || iY>core.y1-vicinity;
+            for (plint iZ=core.z0; iZ<=core.z1; ++iZ) {
+                // In the interior of core, jump directly to the upper z-layer.
+                if (!yShell && iZ==core.z0+vicinity && core.z1-vicinity+1>iZ) {
+                    iZ = core.z1-vicinity+1;
+                }
+                for (plint iPop=1; iPop<=Descriptor<T>::q/2; ++iPop) {
+                    plint nextX = iX + Descriptor<T>::c[iPop][0];
+                    plint nextY = iY + Descriptor<T>::c[iPop][1];
+                    plint nextZ = iZ + Descriptor<T>::c[iPop][2];
+                    bool inBound = nextX>=bound.x0 && nextX<=bound.x1 &&
+                                   nextY>=bound.y0 && nextY<=bound.y1 &&
+                                   nextZ>=bound.z0 && nextZ<=bound.z1;
+                    bool inCore  = nextX>=core.x0 && nextX<=core.x1 &&
+                                   nextY>=core.y0 && nextY<=core.y1 &&
+                                   nextZ>=core.z0 && nextZ<=core.z1;
+                    if (inBound && !inCore) {
+                        std::swap(population(iX,iY,iZ,iPop+Descriptor<T>::q/2),
+                                  population(nextX,nextY,nextZ,iPop));
                     }
                 }
             }
@@ -436,6 +782,11 @@ void BlockLattice3D<T,Descriptor>::bulkStream(Box3D domain) {
     // Make sure domain is contained within current lattice
     PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
 
+    if (soaFlag) {
+        Box3D touched;
+        intersect(domain.enlarge(Descriptor<T>::vicinity), this->getBoundingBox(), touched);
+        cacheDomain(touched);
+    }
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
@@ -461,7 +812,16 @@ void BlockLattice3D<T,Descriptor>::bulkCollideAndStream(Box3D domain) {
     // Make sure domain is contained within current lattice
     PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
 
-    if (Descriptor<T>::vicinity==1) {
+    if (soaFlag) {
+        // Populations which have been accessed through the Cell objects
+        //   must be written back before the structure of arrays is used.
+        flushCellCache();
+        soaCollideAndStream(domain.enlarge(Descriptor<T>::vicinity), domain);
+    }
+    else if (indirectFlag) {
+        indirectCollideAndStream(domain.enlarge(Descriptor<T>::vicinity), domain);
+    }
+    else if (Descriptor<T>::vicinity==1) {
         // On nearest-neighbor lattice, use the cache-efficient
         //   version of collidAndStream.
         blockwiseBulkCollideAndStream(domain);
@@ -485,8 +845,8 @@ void BlockLattice3D<T,Descriptor>::linearBulkCollideAndStream(Box3D domain) {
 
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            collideLine(iX, iY, domain.z0, domain.z1);
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                grid[iX][iY][iZ].collide(this->getInternalStatistics());
                 latticeTemplates<T,Descriptor>::swapAndStream3D(grid, iX, iY, iZ);
             }
         }
@@ -531,13 +891,13 @@ void BlockLattice3D<T,Descriptor>::blockwiseBulkCollideAndStream(Box3D domain) {
                         //    the swap-operation of the streaming.
                         plint minZ = outerZ-dx-dy;
                         plint maxZ = minZ+blockSize-1;
-                        for (plint innerZ=std::max(minZ,domain.z0);
-                             innerZ <= std::min(maxZ, domain.z1);
-                             ++innerZ)
-                        {
-                            // Collide the cell.
-                            grid[innerX][innerY][innerZ].collide (
-                                    this->getInternalStatistics() );
+                        plint z0 = std::max(minZ,domain.z0);
+                        plint z1 = std::min(maxZ, domain.z1);
+                        // Collide the cells. The streaming of a cell never accesses
+                        //   the following cells on the z-line, which can therefore
+                        //   be collided in advance.
+                        collideLine(innerX, innerY, z0, z1);
+                        for (plint innerZ=z0; innerZ<=z1; ++innerZ) {
                             // Swap the populations on the cell, and then with post-collision
                             //   neighboring cell, to perform the streaming step.
                             latticeTemplates<T,Descriptor>::swapAndStream3D (
@@ -550,6 +910,441 @@ void BlockLattice3D<T,Descriptor>::blockwiseBulkCollideAndStream(Box3D domain) {
     }
 }
 
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::collideLine(plint iX, plint iY, plint z0, plint z1) {
+    Cell<T,Descriptor>* cells = grid[iX][iY];
+    BlockStatistics& statistics = this->getInternalStatistics();
+    plint iZ = z0;
+    while (iZ<=z1) {
+        Dynamics<T,Descriptor>* dynamics = &cells[iZ].getDynamics();
+        plint runEnd = iZ+1;
+        while (runEnd<=z1 && &cells[runEnd].getDynamics()==dynamics) {
+            ++runEnd;
+        }
+        dynamics->collideCells(cells+iZ, runEnd-iZ, statistics);
+        iZ = runEnd;
+    }
+}
+
+/** The collision is executed line by line along z, on runs of cells which
+ *  share the same dynamics object, through Dynamics::collideStructureOfArrays
+ *  if available. The streaming is then executed on the line by swapping
+ *  populations with the post-collision neighbors of lower index, as in
+ *  latticeTemplates::swapAndStream3D, which keeps the populations at their
+ *  natural location after each step. Populations pointing outside bound
+ *  are only reverted, as in boundaryStream().
+ */
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::soaCollideAndStream(Box3D bound, Box3D domain) {
+    // Make sure domain is contained within bound, and bound within current lattice
+    PLB_PRECONDITION( contained(domain, bound) );
+    PLB_PRECONDITION( contained(bound, this->getBoundingBox()) );
+    PLB_PRECONDITION( soaFlag && cachedCells.empty() );
+
+    static const plint q = Descriptor<T>::q;
+    static const plint half = Descriptor<T>::q/2;
+    plint ny = this->getNy();
+    plint nz = this->getNz();
+    plint numCells = (plint)cellIsCached.size();
+    BlockStatistics& statistics = this->getInternalStatistics();
+    plint lineLength = domain.getNz();
+    // Populations of one line in precision T, with single-precision storage.
+    std::vector<T> lineBuffer(singlePrecisionFlag ? q*lineLength : 0);
+
+    plint neighborOffset[q];
+    for (plint iPop=1; iPop<=half; ++iPop) {
+        neighborOffset[iPop] = Descriptor<T>::c[iPop][2] +
+                               nz*(Descriptor<T>::c[iPop][1] + ny*Descriptor<T>::c[iPop][0]);
+    }
+
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint lineStart = domain.z0 + nz*(iY+ny*iX);
+            plint lineEnd   = lineStart + domain.getNz();
+            // With single-precision storage, the line is converted into a
+            //   structure of arrays in precision T, which is collided in place
+            //   of the storage and converted back.
+            T* f = soaPopulations+lineStart;
+            plint stride = numCells;
+            if (singlePrecisionFlag) {
+                f = &lineBuffer[0];
+                stride = lineLength;
+                for (plint iPop=0; iPop<q; ++iPop) {
+                    float const* fSingle = soaSinglePopulations + iPop*numCells + lineStart;
+                    for (plint iLine=0; iLine<lineLength; ++iLine) {
+                        f[iPop*stride+iLine] = (T)fSingle[iLine];
+                    }
+                }
+            }
+            // Collide all cells of the line.
+            plint iCell = lineStart;
+            while (iCell<lineEnd) {
+                Dynamics<T,Descriptor>* dynamics = soaDynamics[iCell];
+                bool takesStatistics = soaStatistics[iCell];
+                plint runEnd = iCell+1;
+                while ( runEnd<lineEnd && soaDynamics[runEnd]==dynamics &&
+                        soaStatistics[runEnd]==takesStatistics )
+                {
+                    ++runEnd;
+                }
+                T* fRun = f + (iCell-lineStart);
+                if (!dynamics->collideStructureOfArrays ( fRun, stride, runEnd-iCell,
+                                                          takesStatistics, statistics ))
+                {
+                    for (plint iRun=iCell; iRun<runEnd; ++iRun) {
+                        for (plint iPop=0; iPop<q; ++iPop) {
+                            rawData[iRun][iPop] = fRun[iPop*stride+iRun-iCell];
+                        }
+                    }
+                    dynamics->collideCells(rawData+iCell, runEnd-iCell, statistics);
+                    for (plint iRun=iCell; iRun<runEnd; ++iRun) {
+                        for (plint iPop=0; iPop<q; ++iPop) {
+                            fRun[iPop*stride+iRun-iCell] = rawData[iRun][iPop];
+                        }
+                    }
+                }
+                iCell = runEnd;
+            }
+            if (singlePrecisionFlag) {
+                for (plint iPop=0; iPop<q; ++iPop) {
+                    float* fSingle = soaSinglePopulations + iPop*numCells + lineStart;
+                    for (plint iLine=0; iLine<lineLength; ++iLine) {
+                        fSingle[iLine] = (float)f[iPop*stride+iLine];
+                    }
+                }
+            }
+            // Swap the populations on the cells, and then with the
+            //   post-collision neighbors, to perform the streaming step.
+            for (plint iPop=1; iPop<=half; ++iPop) {
+                plint offset = neighborOffset[iPop];
+                // Range of cells on the line, whose neighbor is inside bound.
+                plint nextX = iX + Descriptor<T>::c[iPop][0];
+                plint nextY = iY + Descriptor<T>::c[iPop][1];
+                plint streamStart = lineEnd;
+                plint streamEnd   = lineEnd;
+                if ( nextX>=bound.x0 && nextX<=bound.x1 && nextY>=bound.y0 && nextY<=bound.y1 ) {
+                    plint z0 = std::max(domain.z0, bound.z0-Descriptor<T>::c[iPop][2]);
+                    plint z1 = std::min(domain.z1, bound.z1-Descriptor<T>::c[iPop][2]);
+                    if (z0<=z1) {
+                        streamStart = lineStart + z0-domain.z0;
+                        streamEnd   = lineStart + z1-domain.z0 + 1;
+                    }
+                }
+                if (singlePrecisionFlag) {
+                    soaStreamLine(soaSinglePopulations + iPop*numCells,
+                                  soaSinglePopulations + (iPop+half)*numCells,
+                                  offset, lineStart, streamStart, streamEnd, lineEnd);
+                }
+                else {
+                    soaStreamLine(soaPopulations + iPop*numCells,
+                                  soaPopulations + (iPop+half)*numCells,
+                                  offset, lineStart, streamStart, streamEnd, lineEnd);
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+template<typename S>
+void BlockLattice3D<T,Descriptor>::soaStreamLine (
+        S* f, S* fOpp, plint offset, plint lineStart,
+        plint streamStart, plint streamEnd, plint lineEnd )
+{
+    for (plint iCell=lineStart; iCell<streamStart; ++iCell) {
+        std::swap(f[iCell], fOpp[iCell]);
+    }
+    for (plint iCell=streamStart; iCell<streamEnd; ++iCell) {
+        S fTmp          = f[iCell];
+        f[iCell]        = fOpp[iCell];
+        fOpp[iCell]     = f[iCell+offset];
+        f[iCell+offset] = fTmp;
+    }
+    for (plint iCell=streamEnd; iCell<lineEnd; ++iCell) {
+        std::swap(f[iCell], fOpp[iCell]);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::toggleStructureOfArrays(bool soaFlag_) {
+    PLB_PRECONDITION( !(soaFlag_ && indirectFlag) );
+    if (soaFlag_==soaFlag) {
+        return;
+    }
+    plint numCells = this->getNx()*this->getNy()*this->getNz();
+    if (soaFlag_) {
+        if (singlePrecisionFlag) {
+            soaSinglePopulations = allocateArray<float>(Descriptor<T>::q*numCells);
+        }
+        else {
+            soaPopulations = allocateArray<T>(Descriptor<T>::q*numCells);
+        }
+        soaDynamics.resize(numCells);
+        soaStatistics.resize(numCells);
+        cellIsCached.assign(numCells, true);
+        cachedCells.resize(numCells);
+        for (plint iCell=0; iCell<numCells; ++iCell) {
+            cachedCells[iCell] = iCell;
+        }
+        soaFlag = true;
+        flushCellCache();
+    }
+    else {
+        cacheDomain(this->getBoundingBox());
+        releaseArray(soaPopulations, Descriptor<T>::q*numCells);
+        soaPopulations = 0;
+        releaseArray(soaSinglePopulations, Descriptor<T>::q*numCells);
+        soaSinglePopulations = 0;
+        soaDynamics.clear();
+        soaStatistics.clear();
+        cellIsCached.clear();
+        cachedCells.clear();
+        soaFlag = false;
+        singlePrecisionFlag = false;
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+bool BlockLattice3D<T,Descriptor>::isStructureOfArraysOn() const {
+    return soaFlag;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::toggleSinglePrecisionStorage(bool singlePrecisionFlag_) {
+    if (singlePrecisionFlag_==singlePrecisionFlag) {
+        return;
+    }
+    // The structure of arrays is re-created with the new precision. The
+    //   single-precision storage exists only in this mode, which is turned
+    //   on if needed.
+    bool soaWasOn = soaFlag;
+    toggleStructureOfArrays(false);
+    singlePrecisionFlag = singlePrecisionFlag_;
+    toggleStructureOfArrays(soaWasOn || singlePrecisionFlag);
+}
+
+template<typename T, template<typename U> class Descriptor>
+bool BlockLattice3D<T,Descriptor>::isSinglePrecisionStorageOn() const {
+    return singlePrecisionFlag;
+}
+
+/** The collision is executed on runs of consecutive active cells which
+ *  share the same dynamics object. The streaming is executed as in
+ *  latticeTemplates::swapAndStream3D, through the neighbor table; populations
+ *  pointing to an inactive neighbor or outside bound are only reverted.
+ */
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::indirectCollideAndStream(Box3D bound, Box3D domain) {
+    // Make sure domain is contained within bound, and bound within current lattice
+    PLB_PRECONDITION( contained(domain, bound) );
+    PLB_PRECONDITION( contained(bound, this->getBoundingBox()) );
+
+    if (!activeCellsAreValid) {
+        computeActiveCells();
+    }
+    static const plint half = Descriptor<T>::q/2;
+    plint ny = this->getNy();
+    plint nz = this->getNz();
+    BlockStatistics& statistics = this->getInternalStatistics();
+
+    bool lineInBound[half+1];
+    plint zMin[half+1], zMax[half+1];
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint lineStart = nz*(iY+ny*iX);
+            std::vector<plint>::const_iterator lineBegin =
+                activeCells.begin()+activeLineStart[iY+ny*iX];
+            std::vector<plint>::const_iterator lineEnd =
+                activeCells.begin()+activeLineStart[iY+ny*iX+1];
+            plint first = std::lower_bound(lineBegin, lineEnd, lineStart+domain.z0) - activeCells.begin();
+            plint last  = std::upper_bound(lineBegin, lineEnd, lineStart+domain.z1) - activeCells.begin();
+            // Collide the active cells of the line.
+            plint iActive = first;
+            while (iActive<last) {
+                plint iCell = activeCells[iActive];
+                Dynamics<T,Descriptor>* dynamics = &rawData[iCell].getDynamics();
+                plint runEnd = iActive+1;
+                while ( runEnd<last && activeCells[runEnd]==iCell+(runEnd-iActive) &&
+                        &rawData[activeCells[runEnd]].getDynamics()==dynamics )
+                {
+                    ++runEnd;
+                }
+                dynamics->collideCells(rawData+iCell, runEnd-iActive, statistics);
+                iActive = runEnd;
+            }
+            // Range of z-coordinates on the line, whose neighbor is inside bound.
+            for (plint iPop=1; iPop<=half; ++iPop) {
+                plint nextX = iX + Descriptor<T>::c[iPop][0];
+                plint nextY = iY + Descriptor<T>::c[iPop][1];
+                lineInBound[iPop] = nextX>=bound.x0 && nextX<=bound.x1 &&
+                                    nextY>=bound.y0 && nextY<=bound.y1;
+                zMin[iPop] = bound.z0-Descriptor<T>::c[iPop][2];
+                zMax[iPop] = bound.z1-Descriptor<T>::c[iPop][2];
+            }
+            // Swap the populations on the cells, and then with the
+            //   post-collision neighbors, to perform the streaming step.
+            for (iActive=first; iActive<last; ++iActive) {
+                plint iCell = activeCells[iActive];
+                plint iZ = iCell-lineStart;
+                Cell<T,Descriptor>& cell = rawData[iCell];
+                plint const* neighbors = &activeNeighbors[half*iActive];
+                for (plint iPop=1; iPop<=half; ++iPop) {
+                    plint next = neighbors[iPop-1];
+                    if (next>=0 && lineInBound[iPop] && iZ>=zMin[iPop] && iZ<=zMax[iPop]) {
+                        T fTmp               = cell[iPop];
+                        cell[iPop]           = cell[iPop+half];
+                        cell[iPop+half]      = rawData[next][iPop];
+                        rawData[next][iPop]  = fTmp;
+                    }
+                    else {
+                        std::swap(cell[iPop], cell[iPop+half]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::computeActiveCells() {
+    static const plint half = Descriptor<T>::q/2;
+    plint nx = this->getNx();
+    plint ny = this->getNy();
+    plint nz = this->getNz();
+    int noDynId = NoDynamics<T,Descriptor>().getId();
+
+    std::vector<bool> isActive(nx*ny*nz, false);
+    activeCells.clear();
+    activeLineStart.resize(nx*ny+1);
+    for (plint iX=0; iX<nx; ++iX) {
+        for (plint iY=0; iY<ny; ++iY) {
+            activeLineStart[iY+ny*iX] = (plint)activeCells.size();
+            for (plint iZ=0; iZ<nz; ++iZ) {
+                plint iCell = iZ + nz*(iY+ny*iX);
+                if (rawData[iCell].getDynamics().getId() != noDynId) {
+                    isActive[iCell] = true;
+                    activeCells.push_back(iCell);
+                }
+            }
+        }
+    }
+    activeLineStart[nx*ny] = (plint)activeCells.size();
+
+    activeNeighbors.resize(half*activeCells.size());
+    for (pluint iActive=0; iActive<activeCells.size(); ++iActive) {
+        plint iCell = activeCells[iActive];
+        plint iX = iCell / (ny*nz);
+        plint iY = (iCell / nz) % ny;
+        plint iZ = iCell % nz;
+        for (plint iPop=1; iPop<=half; ++iPop) {
+            plint nextX = iX + Descriptor<T>::c[iPop][0];
+            plint nextY = iY + Descriptor<T>::c[iPop][1];
+            plint nextZ = iZ + Descriptor<T>::c[iPop][2];
+            plint next = -1;
+            if ( nextX>=0 && nextX<nx && nextY>=0 && nextY<ny && nextZ>=0 && nextZ<nz ) {
+                plint nextCell = nextZ + nz*(nextY+ny*nextX);
+                if (isActive[nextCell]) {
+                    next = nextCell;
+                }
+            }
+            activeNeighbors[half*iActive+iPop-1] = next;
+        }
+    }
+    activeCellsAreValid = true;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::toggleIndirectAddressing(bool indirectFlag_) {
+    PLB_PRECONDITION( !(indirectFlag_ && soaFlag) );
+    indirectFlag = indirectFlag_;
+    if (!indirectFlag) {
+        activeCellsAreValid = false;
+        std::vector<plint>().swap(activeCells);
+        std::vector<plint>().swap(activeLineStart);
+        std::vector<plint>().swap(activeNeighbors);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+bool BlockLattice3D<T,Descriptor>::isIndirectAddressingOn() const {
+    return indirectFlag;
+}
+
+template<typename T, template<typename U> class Descriptor>
+plint BlockLattice3D<T,Descriptor>::getNumActiveCells() {
+    if (!activeCellsAreValid) {
+        computeActiveCells();
+    }
+    return (plint)activeCells.size();
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::cacheDomain(Box3D domain) const {
+    if (!soaFlag) {
+        return;
+    }
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                cacheCell(iX,iY,iZ);
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::flushCellCache() {
+    for (pluint iCached=0; iCached<cachedCells.size(); ++iCached) {
+        plint iCell = cachedCells[iCached];
+        Cell<T,Descriptor> const& cell = rawData[iCell];
+        for (plint iPop=0; iPop<Descriptor<T>::q; ++iPop) {
+            setSoaPopulation(iPop, iCell, cell[iPop]);
+        }
+        soaDynamics[iCell] = const_cast<Dynamics<T,Descriptor>*>(&cell.getDynamics());
+        soaStatistics[iCell] = cell.takesStatistics();
+        cellIsCached[iCell] = false;
+    }
+    cachedCells.clear();
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::serializeCell(plint iX, plint iY, plint iZ, char* data) const {
+    Cell<T,Descriptor> const& cell = grid[iX][iY][iZ];
+    plint iCell = iZ + this->getNz()*(iY + this->getNy()*iX);
+    if (!soaFlag || cellIsCached[iCell]) {
+        cell.serialize(data);
+        return;
+    }
+    const plint numPop = Descriptor<T>::numPop;
+    const plint numExt = Descriptor<T>::ExternalField::numScalars;
+    T* f = (T*)data;
+    for (plint iPop=0; iPop<numPop; ++iPop) {
+        f[iPop] = soaPopulation(iPop, iCell);
+    }
+    if (numExt>0) {
+        memcpy((void*)(data+numPop*sizeof(T)), (const void*)(cell.getExternal(0)), numExt*sizeof(T));
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::unSerializeCell(plint iX, plint iY, plint iZ, char const* data) {
+    Cell<T,Descriptor>& cell = grid[iX][iY][iZ];
+    plint iCell = iZ + this->getNz()*(iY + this->getNy()*iX);
+    if (!soaFlag || cellIsCached[iCell]) {
+        cell.unSerialize(data);
+        return;
+    }
+    const plint numPop = Descriptor<T>::numPop;
+    const plint numExt = Descriptor<T>::ExternalField::numScalars;
+    T const* f = (T const*)data;
+    for (plint iPop=0; iPop<numPop; ++iPop) {
+        setSoaPopulation(iPop, iCell, f[iPop]);
+    }
+    if (numExt>0) {
+        memcpy((void*)(cell.getExternal(0)), (const void*)(data+numPop*sizeof(T)), numExt*sizeof(T));
+    }
+}
+
 template<typename T, template<typename U> class Descriptor>
 void BlockLattice3D<T,Descriptor>::implementPeriodicity() {
     static const plint vicinity = Descriptor<T>::vicinity;
@@ -613,8 +1408,8 @@ void BlockLattice3D<T,Descriptor>::periodicDomain(Box3D domain) {
                         plint nextY = (iY+ny)%ny;
                         plint nextZ = (iZ+nz)%nz;
                         std::swap (
-                            grid[prevX][prevY][prevZ][indexTemplates::opposite<Descriptor<T> >(iPop)],
-                            grid[nextX][nextY][nextZ][iPop] );
+                            population(prevX,prevY,prevZ,indexTemplates::opposite<Descriptor<T> >(iPop)),
+                            population(nextX,nextY,nextZ,iPop) );
                     }
                 }
             }
@@ -645,6 +1440,102 @@ plint BlockLatticeDataTransfer3D<T,Descriptor>::staticCellSize() const {
     return sizeof(T)* (Descriptor<T>::numPop + Descriptor<T>::ExternalField::numScalars);
 }
 
+template<typename T, template<typename U> class Descriptor>
+void BlockLatticeDataTransfer3D<T,Descriptor>::directionalPopulations (
+        Dot3D bulkDirection, std::vector<plint>& populations )
+{
+    populations.clear();
+    for (plint iPop=1; iPop<Descriptor<T>::q; ++iPop) {
+        // After a collision, the population streamed in direction opposite(iPop)
+        //   is stored at position iPop.
+        plint cX = -Descriptor<T>::c[iPop][0];
+        plint cY = -Descriptor<T>::c[iPop][1];
+        plint cZ = -Descriptor<T>::c[iPop][2];
+        if ( (bulkDirection.x==0 || cX*bulkDirection.x>0) &&
+             (bulkDirection.y==0 || cY*bulkDirection.y>0) &&
+             (bulkDirection.z==0 || cZ*bulkDirection.z>0) )
+        {
+            populations.push_back(iPop);
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+plint BlockLatticeDataTransfer3D<T,Descriptor>::directionalCellSize(Dot3D bulkDirection) const {
+    std::vector<plint> populations;
+    directionalPopulations(bulkDirection, populations);
+    return sizeof(T) * (plint)populations.size();
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLatticeDataTransfer3D<T,Descriptor>::sendDirectional (
+        Box3D domain, char* buffer, Dot3D bulkDirection ) const
+{
+    PLB_PRECONDITION(contained(domain, lattice.getBoundingBox()));
+    std::vector<plint> populations;
+    directionalPopulations(bulkDirection, populations);
+    plint numPop = (plint)populations.size();
+    if (numPop==0) return;
+
+    T* f = (T*)buffer;
+    plint iData=0;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                for (plint i=0; i<numPop; ++i) {
+                    f[iData++] = lattice.population(iX,iY,iZ,populations[i]);
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLatticeDataTransfer3D<T,Descriptor>::receiveDirectional (
+        Box3D domain, char const* buffer, Dot3D bulkDirection )
+{
+    PLB_PRECONDITION(contained(domain, lattice.getBoundingBox()));
+    std::vector<plint> populations;
+    directionalPopulations(bulkDirection, populations);
+    plint numPop = (plint)populations.size();
+    if (numPop==0) return;
+
+    T const* f = (T const*)buffer;
+    plint iData=0;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                for (plint i=0; i<numPop; ++i) {
+                    lattice.population(iX,iY,iZ,populations[i]) = f[iData++];
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLatticeDataTransfer3D<T,Descriptor>::attributeDirectional (
+        Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+        AtomicBlock3D const& from, Dot3D bulkDirection )
+{
+    PLB_PRECONDITION (typeid(from) == typeid(BlockLattice3D<T,Descriptor> const&));
+    PLB_PRECONDITION(contained(toDomain, lattice.getBoundingBox()));
+    BlockLattice3D<T,Descriptor> const& fromLattice = (BlockLattice3D<T,Descriptor> const&) from;
+    std::vector<plint> populations;
+    directionalPopulations(bulkDirection, populations);
+    plint numPop = (plint)populations.size();
+    for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
+        for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
+            for (plint iZ=toDomain.z0; iZ<=toDomain.z1; ++iZ) {
+                for (plint i=0; i<numPop; ++i) {
+                    lattice.population(iX,iY,iZ,populations[i]) =
+                        fromLattice.population(iX+deltaX,iY+deltaY,iZ+deltaZ,populations[i]);
+                }
+            }
+        }
+    }
+}
+
 template<typename T, template<typename U> class Descriptor>
 void BlockLatticeDataTransfer3D<T,Descriptor>::send (
         Box3D domain, std::vector<char>& buffer, modif::ModifT kind ) const
@@ -671,18 +1562,24 @@ template<typename T, template<typename U> class Descriptor>
 void BlockLatticeDataTransfer3D<T,Descriptor>::send_static (
         Box3D domain, std::vector<char>& buffer ) const
 {
-    plint cellSize = staticCellSize();
-    pluint numBytes = domain.nCells()*cellSize;
+    pluint numBytes = domain.nCells()*staticCellSize();
     // Avoid dereferencing uninitialized pointer.
     if (numBytes==0) return;
     buffer.resize(numBytes);
+    sendStatic(domain, &buffer[0]);
+}
 
-    plint iData=0;
+template<typename T, template<typename U> class Descriptor>
+void BlockLatticeDataTransfer3D<T,Descriptor>::sendStatic (
+        Box3D domain, char* buffer ) const
+{
+    PLB_PRECONDITION(contained(domain, lattice.getBoundingBox()));
+    plint cellSize = staticCellSize();
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                lattice.get(iX,iY,iZ).serialize(&buffer[iData]);
-                iData += cellSize;
+                lattice.serializeCell(iX,iY,iZ, buffer);
+                buffer += cellSize;
             }
         }
     }
@@ -763,14 +1660,20 @@ void BlockLatticeDataTransfer3D<T,Descriptor>::receive_static (
     PLB_PRECONDITION( (plint) buffer.size() == domain.nCells()*staticCellSize() );
     // Avoid dereferencing uninitialized pointer.
     if (buffer.empty()) return;
-    plint cellSize = staticCellSize();
+    receiveStatic(domain, &buffer[0], Dot3D());
+}
 
-    plint iData=0;
+template<typename T, template<typename U> class Descriptor>
+void BlockLatticeDataTransfer3D<T,Descriptor>::receiveStatic (
+        Box3D domain, char const* buffer, Dot3D absoluteOffset )
+{
+    PLB_PRECONDITION(contained(domain, lattice.getBoundingBox()));
+    plint cellSize = staticCellSize();
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                lattice.get(iX,iY,iZ).unSerialize(&buffer[iData]);
-                iData += cellSize;
+                lattice.unSerializeCell(iX,iY,iZ, buffer);
+                buffer += cellSize;
             }
         }
     }
@@ -786,9 +1689,8 @@ void BlockLatticeDataTransfer3D<T,Descriptor>::receive_dynamic (
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
                 // No assert is included here, because incompatible types of
                 //   dynamics are detected by asserts inside HierarchicUnserializer.
-                serializerPos = 
-                    unserialize (
-                        lattice.get(iX,iY,iZ).getDynamics(), buffer, serializerPos );
+                serializerPos =
+                    lattice.unserializeDynamics(iX,iY,iZ, buffer, serializerPos);
             }
         }
     }
@@ -804,9 +1706,8 @@ void BlockLatticeDataTransfer3D<T,Descriptor>::receive_all (
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
                 // 1. Unserialize dynamic data.
-                posInBuffer = 
-                    unserialize (
-                        lattice.get(iX,iY,iZ).getDynamics(), buffer, posInBuffer );
+                posInBuffer =
+                    lattice.unserializeDynamics(iX,iY,iZ, buffer, posInBuffer);
                 // 2. Unserialize static data.
                 if (staticCellSize()>0) {
                     lattice.get(iX,iY,iZ).unSerialize(&buffer[posInBuffer]);
@@ -873,6 +1774,19 @@ void BlockLatticeDataTransfer3D<T,Descriptor>::attribute_static (
         Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
         BlockLattice3D<T,Descriptor> const& from )
 {
+    if (lattice.isStructureOfArraysOn() || from.isStructureOfArraysOn()) {
+        // Copy through a buffer, to avoid caching the cells.
+        std::vector<char> cellData(staticCellSize());
+        for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
+            for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
+                for (plint iZ=toDomain.z0; iZ<=toDomain.z1; ++iZ) {
+                    from.serializeCell(iX+deltaX,iY+deltaY,iZ+deltaZ, &cellData[0]);
+                    lattice.unSerializeCell(iX,iY,iZ, &cellData[0]);
+                }
+            }
+        }
+        return;
+    }
     for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
         for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
             for (plint iZ=toDomain.z0; iZ<=toDomain.z1; ++iZ) {
@@ -896,9 +1810,7 @@ void BlockLatticeDataTransfer3D<T,Descriptor>::attribute_dynamic (
                 serialize (
                     from.get(iX+deltaX,iY+deltaY,iZ+deltaZ).getDynamics(),
                     serializedData );
-                unserialize (
-                    lattice.get(iX,iY,iZ).getDynamics(),
-                    serializedData );
+                lattice.unserializeDynamics(iX,iY,iZ, serializedData, 0);
             }
         }
     }
@@ -918,9 +1830,7 @@ void BlockLatticeDataTransfer3D<T,Descriptor>::attribute_all (
                 serialize (
                     from.get(iX+deltaX,iY+deltaY,iZ+deltaZ).getDynamics(),
                     serializedData );
-                unserialize (
-                    lattice.get(iX,iY,iZ).getDynamics(),
-                    serializedData );
+                lattice.unserializeDynamics(iX,iY,iZ, serializedData, 0);
 
                 // 2. Attribute static content.
                 lattice.get(iX,iY,iZ).attributeValues (
@@ -48,8 +48,10 @@ public:
     virtual plint staticCellSize() const;
     /// Send data from the block into a byte-stream.
     virtual void send(Box3D domain, std::vector<char>& buffer, modif::ModifT kind) const;
+    virtual void sendStatic(Box3D domain, char* buffer) const;
     /// Receive data from a byte-stream into the block.
     virtual void receive(Box3D domain, std::vector<char> const& buffer, modif::ModifT kind );
+    virtual void receiveStatic(Box3D domain, char const* buffer, Dot3D absoluteOffset);
     virtual void receive(Box3D domain, std::vector<char> const& buffer, modif::ModifT kind, Dot3D absoluteOffset) {
         receive(domain, buffer, kind);
     }
@@ -124,8 +126,10 @@ public:
     virtual plint staticCellSize() const;
     /// Send data from the block into a byte-stream.
     virtual void send(Box3D domain, std::vector<char>& buffer, modif::ModifT kind) const;
+    virtual void sendStatic(Box3D domain, char* buffer) const;
     /// Receive data from a byte-stream into the block.
     virtual void receive(Box3D domain, std::vector<char> const& buffer, modif::ModifT kind);
+    virtual void receiveStatic(Box3D domain, char const* buffer, Dot3D absoluteOffset);
     virtual void receive(Box3D domain, std::vector<char> const& buffer, modif::ModifT kind, Dot3D absoluteOffset) {
         receive(domain, buffer, kind);
     }
@@ -201,8 +205,10 @@ public:
     virtual plint staticCellSize() const;
     /// Send data from the block into a byte-stream.
     virtual void send(Box3D domain, std::vector<char>& buffer, modif::ModifT kind) const;
+    virtual void sendStatic(Box3D domain, char* buffer) const;
     /// Receive data from a byte-stream into the block.
     virtual void receive(Box3D domain, std::vector<char> const& buffer, modif::ModifT kind);
+    virtual void receiveStatic(Box3D domain, char const* buffer, Dot3D absoluteOffset);
     virtual void receive(Box3D domain, std::vector<char> const& buffer, modif::ModifT kind, Dot3D absoluteOffset) {
         receive(domain, buffer, kind);
     }
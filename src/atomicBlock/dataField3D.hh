@@ -30,6 +30,8 @@
 
 #include "atomicBlock/dataField3D.h"
 #include "atomicBlock/atomicBlock3D.h"
+#include "core/memoryPolicy.h"
+#include "core/util.h"
 #include <algorithm>
 #include <typeinfo>
 #include <cstring>
@@ -98,7 +100,7 @@ ScalarFieldDataTransfer3D<T> const& ScalarField3D<T>::getDataTransfer() const {
 
 template<typename T>
 void ScalarField3D<T>::allocateMemory() {
-    rawData = new T [(pluint)this->getNx()*(pluint)this->getNy()*(pluint)this->getNz()];
+    rawData = allocateArray<T>((pluint)this->getNx()*(pluint)this->getNy()*(pluint)this->getNz());
     field   = new T** [(pluint)this->getNx()];
     for (plint iX=0; iX<this->getNx(); ++iX) {
         field[iX] = new T* [(pluint)this->getNy()];
@@ -114,7 +116,8 @@ void ScalarField3D<T>::releaseMemory() {
       delete [] field[iX];
     }
     delete [] field;
-    delete [] rawData; rawData = 0;
+    releaseArray(rawData, (pluint)this->getNx()*(pluint)this->getNy()*(pluint)this->getNz());
+    rawData = 0;
 }
 
 ////////////////////// Class ScalarFieldDataTransfer3D /////////////////////////
@@ -132,20 +135,35 @@ plint ScalarFieldDataTransfer3D<T>::staticCellSize() const {
 template<typename T>
 void ScalarFieldDataTransfer3D<T>::send(Box3D domain, std::vector<char>& buffer, modif::ModifT kind) const
 {
-    PLB_PRECONDITION( contained(domain, field.getBoundingBox()) );
-    plint cellSize = staticCellSize();
-    pluint numBytes = domain.nCells()*cellSize;
+    pluint numBytes = domain.nCells()*staticCellSize();
     // Avoid dereferencing uninitialized pointer.
     if (numBytes==0) return;
     buffer.resize(numBytes);
+    sendStatic(domain, &buffer[0]);
+}
 
-    plint iData=0;
+template<typename T>
+void ScalarFieldDataTransfer3D<T>::sendStatic(Box3D domain, char* buffer) const
+{
+    PLB_PRECONDITION( contained(domain, field.getBoundingBox()) );
+    if (!util::IsTriviallyCopyable<T>::value) {
+        for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+            for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+                for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                    memcpy((void*)buffer, (const void*)(&field.get(iX,iY,iZ)), sizeof(T));
+                    buffer += sizeof(T);
+                }
+            }
+        }
+        return;
+    }
+    // The cells are contiguous in z-direction: they are copied one z-run at a time.
+    pluint runSize = (pluint)(domain.getNz()*staticCellSize());
+    if (runSize==0) return;
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
-            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                memcpy((void*)(&buffer[iData]), (const void*)(&field.get(iX,iY,iZ)), sizeof(T));
-                iData += sizeof(T);
-            }
+            memcpy((void*)buffer, (const void*)(&field.get(iX,iY,domain.z0)), runSize);
+            buffer += runSize;
         }
     }
 }
@@ -154,18 +172,34 @@ template<typename T>
 void ScalarFieldDataTransfer3D<T>::receive (
         Box3D domain, std::vector<char> const& buffer, modif::ModifT kind )
 {
-    PLB_PRECONDITION( contained(domain, field.getBoundingBox()) );
     PLB_PRECONDITION( domain.nCells()*staticCellSize() == (plint)buffer.size() );
-
     // Avoid dereferencing uninitialized pointer.
     if (buffer.empty()) return;
-    plint iData=0;
+    receiveStatic(domain, &buffer[0], Dot3D());
+}
+
+template<typename T>
+void ScalarFieldDataTransfer3D<T>::receiveStatic (
+        Box3D domain, char const* buffer, Dot3D absoluteOffset )
+{
+    PLB_PRECONDITION( contained(domain, field.getBoundingBox()) );
+    if (!util::IsTriviallyCopyable<T>::value) {
+        for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+            for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+                for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                    memcpy((void*)(&field.get(iX,iY,iZ)), (const void*)buffer, sizeof(T));
+                    buffer += sizeof(T);
+                }
+            }
+        }
+        return;
+    }
+    pluint runSize = (pluint)(domain.getNz()*staticCellSize());
+    if (runSize==0) return;
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
-            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                memcpy((void*)(&field.get(iX,iY,iZ)), (const void*)(&buffer[iData]), sizeof(T));
-                iData += sizeof(T);
-            }
+            memcpy((void*)(&field.get(iX,iY,domain.z0)), (const void*)buffer, runSize);
+            buffer += runSize;
         }
     }
 }
@@ -178,11 +212,24 @@ void ScalarFieldDataTransfer3D<T>::attribute (
     PLB_PRECONDITION (typeid(from) == typeid(ScalarField3D<T> const&));
     PLB_PRECONDITION( contained(toDomain, field.getBoundingBox()) );
     ScalarField3D<T> const& fromField = (ScalarField3D<T> const&) from;
+    if (!util::IsTriviallyCopyable<T>::value) {
+        for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
+            for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
+                for (plint iZ=toDomain.z0; iZ<=toDomain.z1; ++iZ) {
+                    field.get(iX,iY,iZ) = fromField.get(iX+deltaX,iY+deltaY,iZ+deltaZ);
+                }
+            }
+        }
+        return;
+    }
+    pluint runSize = (pluint)(toDomain.getNz()*staticCellSize());
+    if (runSize==0) return;
     for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
         for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
-            for (plint iZ=toDomain.z0; iZ<=toDomain.z1; ++iZ) {
-                field.get(iX,iY,iZ) = fromField.get(iX+deltaX,iY+deltaY,iZ+deltaZ);
-            }
+            // The source and destination may be located in the same field.
+            memmove((void*)(&field.get(iX,iY,toDomain.z0)),
+                    (const void*)(&fromField.get(iX+deltaX,iY+deltaY,toDomain.z0+deltaZ)),
+                    runSize);
         }
     }
 }
@@ -270,7 +317,7 @@ TensorFieldDataTransfer3D<T,nDim> const& TensorField3D<T,nDim>::getDataTransfer(
 
 template<typename T, int nDim>
 void TensorField3D<T,nDim>::allocateMemory() {
-    rawData = new Array<T,nDim>   [(pluint)this->getNx()*(pluint)this->getNy()*(pluint)this->getNz()];
+    rawData = allocateArray<Array<T,nDim> >((pluint)this->getNx()*(pluint)this->getNy()*(pluint)this->getNz());
     field   = new Array<T,nDim>** [(pluint)this->getNx()];
     for (plint iX=0; iX<this->getNx(); ++iX) {
         field[iX] = new Array<T,nDim>* [(pluint)this->getNy()];
@@ -286,7 +333,8 @@ void TensorField3D<T,nDim>::releaseMemory() {
         delete [] field[iX];
     }
     delete [] field;
-    delete [] rawData; rawData = 0;
+    releaseArray(rawData, (pluint)this->getNx()*(pluint)this->getNy()*(pluint)this->getNz());
+    rawData = 0;
 }
 
 
@@ -305,20 +353,35 @@ plint TensorFieldDataTransfer3D<T,nDim>::staticCellSize() const {
 template<typename T, int nDim>
 void TensorFieldDataTransfer3D<T,nDim>::send(Box3D domain, std::vector<char>& buffer, modif::ModifT kind) const
 {
-    PLB_PRECONDITION( contained(domain, field.getBoundingBox()) );
-    plint cellSize = staticCellSize();
-    pluint numBytes = domain.nCells()*cellSize;
+    pluint numBytes = domain.nCells()*staticCellSize();
     // Avoid dereferencing uninitialized pointer.
     if (numBytes==0) return;
     buffer.resize(numBytes);
+    sendStatic(domain, &buffer[0]);
+}
 
-    plint iData=0;
+template<typename T, int nDim>
+void TensorFieldDataTransfer3D<T,nDim>::sendStatic(Box3D domain, char* buffer) const
+{
+    PLB_PRECONDITION( contained(domain, field.getBoundingBox()) );
+    if (!util::IsTriviallyCopyable<T>::value) {
+        for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+            for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+                for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                    memcpy((void*)buffer, (const void*)(&field.get(iX,iY,iZ)[0]), nDim*sizeof(T));
+                    buffer += nDim*sizeof(T);
+                }
+            }
+        }
+        return;
+    }
+    // The cells are contiguous in z-direction: they are copied one z-run at a time.
+    pluint runSize = (pluint)(domain.getNz()*staticCellSize());
+    if (runSize==0) return;
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
-            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                memcpy((void*)(&buffer[iData]), (const void*)(&field.get(iX,iY,iZ)[0]), nDim*sizeof(T));
-                iData += nDim*sizeof(T);
-            }
+            memcpy((void*)buffer, (const void*)(&field.get(iX,iY,domain.z0)[0]), runSize);
+            buffer += runSize;
         }
     }
 }
@@ -327,18 +390,34 @@ template<typename T, int nDim>
 void TensorFieldDataTransfer3D<T,nDim>::receive (
         Box3D domain, std::vector<char> const& buffer, modif::ModifT kind )
 {
-    PLB_PRECONDITION( contained(domain, field.getBoundingBox()) );
     PLB_PRECONDITION( domain.nCells()*staticCellSize() == (plint)buffer.size() );
-
     // Avoid dereferencing uninitialized pointer.
     if (buffer.empty()) return;
-    plint iData=0;
+    receiveStatic(domain, &buffer[0], Dot3D());
+}
+
+template<typename T, int nDim>
+void TensorFieldDataTransfer3D<T,nDim>::receiveStatic (
+        Box3D domain, char const* buffer, Dot3D absoluteOffset )
+{
+    PLB_PRECONDITION( contained(domain, field.getBoundingBox()) );
+    if (!util::IsTriviallyCopyable<T>::value) {
+        for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+            for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+                for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                    memcpy((void*)(&field.get(iX,iY,iZ)[0]), (const void*)buffer, nDim*sizeof(T));
+                    buffer += nDim*sizeof(T);
+                }
+            }
+        }
+        return;
+    }
+    pluint runSize = (pluint)(domain.getNz()*staticCellSize());
+    if (runSize==0) return;
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
-            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                memcpy((void*)(&field.get(iX,iY,iZ)[0]), (const void*)(&buffer[iData]), nDim*sizeof(T));
-                iData += nDim*sizeof(T);
-            }
+            memcpy((void*)(&field.get(iX,iY,domain.z0)[0]), (const void*)buffer, runSize);
+            buffer += runSize;
         }
     }
 }
@@ -351,14 +430,27 @@ void TensorFieldDataTransfer3D<T,nDim>::attribute (
     PLB_PRECONDITION (typeid(from) == typeid(TensorField3D<T,nDim> const&));
     PLB_PRECONDITION( contained(toDomain, field.getBoundingBox()) );
     TensorField3D<T,nDim> const& fromField = (TensorField3D<T,nDim> const&) from;
-    for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
-        for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
-            for (plint iZ=toDomain.z0; iZ<=toDomain.z1; ++iZ) {
-                for (int iDim=0; iDim<nDim; ++iDim) {
-                    field.get(iX,iY,iZ)[iDim] = fromField.get(iX+deltaX,iY+deltaY,iZ+deltaZ)[iDim];
+    if (!util::IsTriviallyCopyable<T>::value) {
+        for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
+            for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
+                for (plint iZ=toDomain.z0; iZ<=toDomain.z1; ++iZ) {
+                    for (int iDim=0; iDim<nDim; ++iDim) {
+                        field.get(iX,iY,iZ)[iDim] = fromField.get(iX+deltaX,iY+deltaY,iZ+deltaZ)[iDim];
+                    }
                 }
             }
         }
+        return;
+    }
+    pluint runSize = (pluint)(toDomain.getNz()*staticCellSize());
+    if (runSize==0) return;
+    for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
+        for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
+            // The source and destination may be located in the same field.
+            memmove((void*)(&field.get(iX,iY,toDomain.z0)[0]),
+                    (const void*)(&fromField.get(iX+deltaX,iY+deltaY,toDomain.z0+deltaZ)[0]),
+                    runSize);
+        }
     }
 }
 
@@ -443,8 +535,8 @@ NTensorFieldDataTransfer3D<T> const& NTensorField3D<T>::getDataTransfer() const
 
 template<typename T>
 void NTensorField3D<T>::allocateMemory() {
-    rawData = new T [(pluint)this->getNx()*(pluint)this->getNy()*
-                     (pluint)this->getNz()*(pluint)this->getNdim()];
+    rawData = allocateArray<T>((pluint)this->getNx()*(pluint)this->getNy()*
+                               (pluint)this->getNz()*(pluint)this->getNdim());
     field   = new T*** [(pluint)this->getNx()];
     for (plint iX=0; iX<this->getNx(); ++iX) {
         field[iX] = new T** [(pluint)this->getNy()];
@@ -469,7 +561,9 @@ void NTensorField3D<T>::releaseMemory() {
         delete [] field[iX];
     }
     delete [] field;
-    delete [] rawData; rawData = 0;
+    releaseArray(rawData, (pluint)this->getNx()*(pluint)this->getNy()*
+                          (pluint)this->getNz()*(pluint)this->getNdim());
+    rawData = 0;
 }
 
 
@@ -488,19 +582,36 @@ plint NTensorFieldDataTransfer3D<T>::staticCellSize() const {
 template<typename T>
 void NTensorFieldDataTransfer3D<T>::send(Box3D domain, std::vector<char>& buffer, modif::ModifT kind) const
 {
-
-    PLB_PRECONDITION( contained(domain, field.getBoundingBox()) );
-    plint cellSize = staticCellSize();
-    pluint numBytes = domain.nCells()*cellSize;
+    pluint numBytes = domain.nCells()*staticCellSize();
+    // Avoid dereferencing uninitialized pointer.
+    if (numBytes==0) return;
     buffer.resize(numBytes);
+    sendStatic(domain, &buffer[0]);
+}
 
-    plint iData=0;
+template<typename T>
+void NTensorFieldDataTransfer3D<T>::sendStatic(Box3D domain, char* buffer) const
+{
+    PLB_PRECONDITION( contained(domain, field.getBoundingBox()) );
+    if (!util::IsTriviallyCopyable<T>::value) {
+        plint cellSize = staticCellSize();
+        for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+            for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+                for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                    memcpy((void*)buffer, (const void*)(&field.get(iX,iY,iZ)[0]), cellSize);
+                    buffer += cellSize;
+                }
+            }
+        }
+        return;
+    }
+    // The cells are contiguous in z-direction: they are copied one z-run at a time.
+    pluint runSize = (pluint)(domain.getNz()*staticCellSize());
+    if (runSize==0) return;
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
-            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                memcpy((void*)(&buffer[iData]), (const void*)(&field.get(iX,iY,iZ)[0]), cellSize);
-                iData += cellSize;
-            }
+            memcpy((void*)buffer, (const void*)(field.get(iX,iY,domain.z0)), runSize);
+            buffer += runSize;
         }
     }
 }
@@ -509,17 +620,35 @@ template<typename T>
 void NTensorFieldDataTransfer3D<T>::receive (
         Box3D domain, std::vector<char> const& buffer, modif::ModifT kind )
 {
-    PLB_PRECONDITION( contained(domain, field.getBoundingBox()) );
-    PLB_PRECONDITION( (pluint) domain.nCells()*staticCellSize() == buffer.size() );
-    plint cellSize = staticCellSize();
+    PLB_PRECONDITION( domain.nCells()*staticCellSize() == (plint)buffer.size() );
+    // Avoid dereferencing uninitialized pointer.
+    if (buffer.empty()) return;
+    receiveStatic(domain, &buffer[0], Dot3D());
+}
 
-    plint iData=0;
+template<typename T>
+void NTensorFieldDataTransfer3D<T>::receiveStatic (
+        Box3D domain, char const* buffer, Dot3D absoluteOffset )
+{
+    PLB_PRECONDITION( contained(domain, field.getBoundingBox()) );
+    if (!util::IsTriviallyCopyable<T>::value) {
+        plint cellSize = staticCellSize();
+        for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+            for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+                for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                    memcpy((void*)(&field.get(iX,iY,iZ)[0]), (const void*)buffer, cellSize);
+                    buffer += cellSize;
+                }
+            }
+        }
+        return;
+    }
+    pluint runSize = (pluint)(domain.getNz()*staticCellSize());
+    if (runSize==0) return;
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
-            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                memcpy((void*)(&field.get(iX,iY,iZ)[0]), (const void*)(&buffer[iData]), cellSize);
-                iData += cellSize;
-            }
+            memcpy((void*)(field.get(iX,iY,domain.z0)), (const void*)buffer, runSize);
+            buffer += runSize;
         }
     }
 }
@@ -532,14 +661,27 @@ void NTensorFieldDataTransfer3D<T>::attribute (
     PLB_PRECONDITION (typeid(from) == typeid(NTensorField3D<T> const&));
     PLB_PRECONDITION( contained(toDomain, field.getBoundingBox()) );
     NTensorField3D<T> const& fromField = (NTensorField3D<T> const&) from;
-    for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
-        for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
-            for (plint iZ=toDomain.z0; iZ<=toDomain.z1; ++iZ) {
-                for (int iDim=0; iDim<field.getNdim(); ++iDim) {
-                    field.get(iX,iY,iZ)[iDim] = fromField.get(iX+deltaX,iY+deltaY,iZ+deltaZ)[iDim];
+    if (!util::IsTriviallyCopyable<T>::value) {
+        for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
+            for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
+                for (plint iZ=toDomain.z0; iZ<=toDomain.z1; ++iZ) {
+                    for (int iDim=0; iDim<field.getNdim(); ++iDim) {
+                        field.get(iX,iY,iZ)[iDim] = fromField.get(iX+deltaX,iY+deltaY,iZ+deltaZ)[iDim];
+                    }
                 }
             }
         }
+        return;
+    }
+    pluint runSize = (pluint)(toDomain.getNz()*staticCellSize());
+    if (runSize==0) return;
+    for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
+        for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
+            // The source and destination may be located in the same field.
+            memmove((void*)(field.get(iX,iY,toDomain.z0)),
+                    (const void*)(fromField.get(iX+deltaX,iY+deltaY,toDomain.z0+deltaZ)),
+                    runSize);
+        }
     }
 }
 
@@ -123,6 +123,10 @@ int BoxProcessor3D::getStaticId() const {
     return functional->getStaticId();
 }
 
+std::type_info const& BoxProcessor3D::getWorkerType() const {
+    return typeid(*functional);
+}
+
 
 /* *************** Class BoxProcessorGenerator3D *************************** */
 
@@ -240,6 +244,10 @@ DotProcessor3D* DotProcessor3D::clone() const {
     return new DotProcessor3D(*this);
 }
 
+std::type_info const& DotProcessor3D::getWorkerType() const {
+    return typeid(*functional);
+}
+
 DotList3D const& DotProcessor3D::getDotList() const {
     return dotList;
 }
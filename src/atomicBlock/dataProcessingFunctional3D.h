@@ -86,6 +86,7 @@ public:
     virtual void process();
     virtual BoxProcessor3D* clone() const;
     virtual int getStaticId() const;
+    virtual std::type_info const& getWorkerType() const;
 private:
     BoxProcessingFunctional3D* functional;
     Box3D domain;
@@ -342,6 +343,7 @@ public:
     ~DotProcessor3D();
     virtual void process();
     virtual DotProcessor3D* clone() const;
+    virtual std::type_info const& getWorkerType() const;
     DotList3D const& getDotList() const;
 private:
     DotProcessingFunctional3D* functional;
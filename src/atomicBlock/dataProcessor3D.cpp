@@ -30,6 +30,8 @@
 
 #include "atomicBlock/dataProcessor3D.h"
 #include "core/util.h"
+#include "core/hierarchicalProfiler.h"
+#include "parallelism/smpThreadPool.h"
 
 namespace plb {
 
@@ -68,6 +70,23 @@ int DataProcessor3D::getStaticId() const {
     return -1;
 }
 
+std::type_info const& DataProcessor3D::getWorkerType() const {
+    return typeid(*this);
+}
+
+void processWithTiming(DataProcessor3D& processor) {
+    global::HierarchicalProfiler& profiler = global::hierarchicalProfiler();
+    if (profiler.isDetailedTimingOn()) {
+        double start = profiler.getTime();
+        processor.process();
+        profiler.addProcessorTime( processor.getWorkerType(), global::smpThreadPool().getThreadId(),
+                                   start, profiler.getTime()-start );
+    }
+    else {
+        processor.process();
+    }
+}
+
 
 ////////////////////// Class DataProcessorGenerator3D /////////////////
 
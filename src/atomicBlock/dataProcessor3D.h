@@ -33,6 +33,7 @@
 #include "core/blockStatistics.h"
 #include <vector>
 #include <algorithm>
+#include <typeinfo>
 
 namespace plb {
 
@@ -53,8 +54,16 @@ struct DataProcessor3D {
     /// Unique identifier for a given DataProcessor class. Produces the same ID as
     ///   the corresponding processor generator.
     virtual int getStaticId() const;
+    /// Type of the class which does the actual work, used by the profiler
+    ///   to time the data processors class by class. Processors which wrap
+    ///   a functional return the type of the functional.
+    virtual std::type_info const& getWorkerType() const;
 };
 
+/// Execute a data processor. Its execution time is reported to the
+///   hierarchical profiler if detailed timing is on.
+void processWithTiming(DataProcessor3D& processor);
+
 /// This is a factory class generating LatticeProcessors
 /** The LatticeProcessorGenerator can be tailored (shifted/reduced) to
  *  a sublattice, after which the LatticeProcessor is generated. The
@@ -109,6 +109,10 @@ int ReductiveBoxProcessor3D::getStaticId() const {
     return functional->getStaticId();
 }
 
+std::type_info const& ReductiveBoxProcessor3D::getWorkerType() const {
+    return typeid(*functional);
+}
+
 
 /* *************** Class ReductiveBoxProcessorGenerator3D *************************** */
 
@@ -265,6 +269,10 @@ ReductiveDotProcessor3D* ReductiveDotProcessor3D::clone() const {
     return new ReductiveDotProcessor3D(*this);
 }
 
+std::type_info const& ReductiveDotProcessor3D::getWorkerType() const {
+    return typeid(*functional);
+}
+
 
 /* *************** Class ReductiveDotProcessorGenerator3D *************************** */
 
@@ -94,6 +94,7 @@ public:
     virtual void process();
     virtual ReductiveBoxProcessor3D* clone() const;
     virtual int getStaticId() const;
+    virtual std::type_info const& getWorkerType() const;
 private:
     ReductiveBoxProcessingFunctional3D* functional;
     Box3D domain;
@@ -348,6 +349,7 @@ public:
     DotList3D const& getDotList() const;
     virtual void process();
     virtual ReductiveDotProcessor3D* clone() const;
+    virtual std::type_info const& getWorkerType() const;
 private:
     ReductiveDotProcessingFunctional3D* functional;
     DotList3D dotList;
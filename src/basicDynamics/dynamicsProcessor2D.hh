@@ -118,7 +118,7 @@ void ExternalRhoJcollideAndStream2D<T,Descriptor>::processGenericBlocks (
     Dot2D offset1 = computeRelativeDisplacement(lattice, rhoBarField);
     Dot2D offset2 = computeRelativeDisplacement(lattice, jField);
 
-    global::profiler().start("collStream");
+    global::profiler().start(global::ProfilerTimer::collStream);
     global::profiler().increment("collStreamCells", extDomain.nCells());
 
     // First, do the collision on cells within a boundary envelope of width
@@ -151,7 +151,7 @@ void ExternalRhoJcollideAndStream2D<T,Descriptor>::processGenericBlocks (
     boundaryStream(lattice, extDomain, Box2D(extDomain.x0+vicinity,extDomain.x1-vicinity,
                                              extDomain.y1-vicinity+1,extDomain.y1));
 
-    global::profiler().stop("collStream");
+    global::profiler().stop(global::ProfilerTimer::collStream);
 }
 
 template<typename T, template<typename U> class Descriptor>
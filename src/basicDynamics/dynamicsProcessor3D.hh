@@ -65,6 +65,11 @@ void ExternalRhoJcollideAndStream3D<T,Descriptor>::bulkCollideAndStream (
         ScalarField3D<T> const& rhoBarField, Dot3D const& offset1,
         TensorField3D<T,3> const& jField, Dot3D const& offset2, BlockStatistics& stat )
 {
+    if (lattice.isStructureOfArraysOn()) {
+        Box3D touched;
+        intersect(domain.enlarge(Descriptor<T>::vicinity), lattice.getBoundingBox(), touched);
+        lattice.cacheDomain(touched);
+    }
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
@@ -87,6 +92,12 @@ void ExternalRhoJcollideAndStream3D<T,Descriptor>::boundaryStream (
     // Make sure domain is contained within bound
     PLB_PRECONDITION( contained(domain, bound) );
 
+    if (lattice.isStructureOfArraysOn()) {
+        Box3D touched;
+        intersect(domain.enlarge(Descriptor<T>::vicinity), bound, touched);
+        lattice.cacheDomain(touched);
+    }
+
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
@@ -129,7 +140,7 @@ void ExternalRhoJcollideAndStream3D<T,Descriptor>::processGenericBlocks (
     Dot3D offset1 = computeRelativeDisplacement(lattice, rhoBarField);
     Dot3D offset2 = computeRelativeDisplacement(lattice, jField);
 
-    global::profiler().start("collStream");
+    global::profiler().start(global::ProfilerTimer::collStream);
     global::profiler().increment("collStreamCells", extDomain.nCells());
 
     // First, do the collision on cells within a boundary envelope of width
@@ -195,7 +206,7 @@ void ExternalRhoJcollideAndStream3D<T,Descriptor>::processGenericBlocks (
     boundaryStream(lattice, extDomain, Box3D(extDomain.x0+vicinity,extDomain.x1-vicinity,
                                              extDomain.y0+vicinity,extDomain.y1-vicinity,
                                              extDomain.z1-vicinity+1,extDomain.z1) );
-    global::profiler().stop("collStream");
+    global::profiler().stop(global::ProfilerTimer::collStream);
     global::timer("collideAndStream").stop();
 }
 
@@ -245,6 +256,11 @@ void PackedExternalRhoJcollideAndStream3D<T,Descriptor>::bulkCollideAndStream (
         BlockLattice3D<T,Descriptor>& lattice, Box3D const& domain,
         NTensorField3D<T> const& rhoBarJfield, Dot3D const& offset, BlockStatistics& stat )
 {
+    if (lattice.isStructureOfArraysOn()) {
+        Box3D touched;
+        intersect(domain.enlarge(Descriptor<T>::vicinity), lattice.getBoundingBox(), touched);
+        lattice.cacheDomain(touched);
+    }
     Array<T,3> j;
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
@@ -270,6 +286,12 @@ void PackedExternalRhoJcollideAndStream3D<T,Descriptor>::boundaryStream (
     // Make sure domain is contained within bound
     PLB_PRECONDITION( contained(domain, bound) );
 
+    if (lattice.isStructureOfArraysOn()) {
+        Box3D touched;
+        intersect(domain.enlarge(Descriptor<T>::vicinity), bound, touched);
+        lattice.cacheDomain(touched);
+    }
+
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
@@ -308,7 +330,7 @@ void PackedExternalRhoJcollideAndStream3D<T,Descriptor>::process (
 
     Dot3D offset = computeRelativeDisplacement(lattice, rhoBarJfield);
 
-    global::profiler().start("collStream");
+    global::profiler().start(global::ProfilerTimer::collStream);
     global::profiler().increment("collStreamCells", extDomain.nCells());
 
     // First, do the collision on cells within a boundary envelope of width
@@ -374,7 +396,7 @@ void PackedExternalRhoJcollideAndStream3D<T,Descriptor>::process (
     boundaryStream(lattice, extDomain, Box3D(extDomain.x0+vicinity,extDomain.x1-vicinity,
                                              extDomain.y0+vicinity,extDomain.y1-vicinity,
                                              extDomain.z1-vicinity+1,extDomain.z1) );
-    global::profiler().stop("collStream");
+    global::profiler().stop(global::ProfilerTimer::collStream);
     global::timer("collideAndStream").stop();
 }
 
@@ -446,6 +468,11 @@ void OnLinkExternalRhoJcollideAndStream3D<T,Descriptor>::bulkCollideAndStream (
         ScalarField3D<T> const& rhoBarField, Dot3D const& offset1,
         TensorField3D<T,3> const& jField, Dot3D const& offset2, BlockStatistics& stat )
 {
+    if (lattice.isStructureOfArraysOn()) {
+        Box3D touched;
+        intersect(domain.enlarge(Descriptor<T>::vicinity), lattice.getBoundingBox(), touched);
+        lattice.cacheDomain(touched);
+    }
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
@@ -467,6 +494,12 @@ void OnLinkExternalRhoJcollideAndStream3D<T,Descriptor>::boundaryStream (
     // Make sure domain is contained within bound
     PLB_PRECONDITION( contained(domain, bound) );
 
+    if (lattice.isStructureOfArraysOn()) {
+        Box3D touched;
+        intersect(domain.enlarge(Descriptor<T>::vicinity), bound, touched);
+        lattice.cacheDomain(touched);
+    }
+
     int bbId = BounceBack<T,Descriptor>().getId();
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
@@ -514,7 +547,7 @@ void OnLinkExternalRhoJcollideAndStream3D<T,Descriptor>::processGenericBlocks (
     Dot3D offset1 = computeRelativeDisplacement(lattice, rhoBarField);
     Dot3D offset2 = computeRelativeDisplacement(lattice, jField);
 
-    global::profiler().start("collStream");
+    global::profiler().start(global::ProfilerTimer::collStream);
     global::profiler().increment("collStreamCells", extDomain.nCells());
 
     // First, do the collision on cells within a boundary envelope of width
@@ -580,7 +613,7 @@ void OnLinkExternalRhoJcollideAndStream3D<T,Descriptor>::processGenericBlocks (
     boundaryStream(lattice, extDomain, Box3D(extDomain.x0+vicinity,extDomain.x1-vicinity,
                                              extDomain.y0+vicinity,extDomain.y1-vicinity,
                                              extDomain.z1-vicinity+1,extDomain.z1) );
-    global::profiler().stop("collStream");
+    global::profiler().stop(global::ProfilerTimer::collStream);
     global::timer("collideAndStream").stop();
 }
 
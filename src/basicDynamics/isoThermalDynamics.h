@@ -125,6 +125,9 @@ public:
     /// Return a unique ID for this class.
     virtual int getId() const;
 
+    /// The collision does not modify the object.
+    virtual bool isCompactable() const;
+
 /* *************** Collision and Equilibrium ************************* */
 
     /// Implementation of the collision step
@@ -135,6 +138,14 @@ public:
     virtual void collideExternal(Cell<T,Descriptor>& cell, T rhoBar,
                          Array<T,Descriptor<T>::d> const& j, T thetaBar, BlockStatistics& stat);
 
+    /// Collision step on consecutive cells, without virtual function call per cell
+    virtual void collideCells(Cell<T,Descriptor>* cells, plint numCells,
+                              BlockStatistics& statistics);
+
+    /// Implementation of the collision step on structure-of-arrays storage
+    virtual bool collideStructureOfArrays(T* f, plint stride, plint numCells,
+                                          bool takesStatistics, BlockStatistics& statistics);
+
     /// Compute equilibrium distribution function
     virtual T computeEquilibrium(plint iPop, T rhoBar, Array<T,Descriptor<T>::d> const& j,
                                  T jSqr, T thetaBar=T()) const;
@@ -325,6 +336,9 @@ public:
     /// Return a unique ID for this class.
     virtual int getId() const;
 
+    /// The collision does not modify the object.
+    virtual bool isCompactable() const;
+
     /// Serialize the dynamics object.
     virtual void serialize(HierarchicSerializer& serializer) const;
 
@@ -384,6 +398,9 @@ public:
     /// Return a unique ID for this class.
     virtual int getId() const;
 
+    /// The collision does not modify the object.
+    virtual bool isCompactable() const;
+
 /* *************** Collision and Equilibrium ************************* */
 
     /// Implementation of the collision step
@@ -439,6 +456,9 @@ public:
     /// Return a unique ID for this class.
     virtual int getId() const;
 
+    /// The collision does not modify the object.
+    virtual bool isCompactable() const;
+
 /* *************** Collision and Equilibrium ************************* */
 
     /// Implementation of the collision step
@@ -449,6 +469,10 @@ public:
     virtual void collideExternal(Cell<T,Descriptor>& cell, T rhoBar,
                          Array<T,Descriptor<T>::d> const& j, T thetaBar, BlockStatistics& stat);
 
+    /// Collision step on consecutive cells, without virtual function call per cell
+    virtual void collideCells(Cell<T,Descriptor>* cells, plint numCells,
+                              BlockStatistics& statistics);
+
     /// Compute equilibrium distribution function
     virtual T computeEquilibrium(plint iPop, T rhoBar, Array<T,Descriptor<T>::d> const& j,
                                  T jSqr, T thetaBar=T()) const;
@@ -501,6 +525,9 @@ public:
     /// Return a unique ID for this class.
     virtual int getId() const;
 
+    /// The collision does not modify the object.
+    virtual bool isCompactable() const;
+
 /* *************** Collision and Equilibrium ************************* */
 
     /// Velocity is equal to j, not u.
@@ -38,6 +38,7 @@
 #include "latticeBoltzmann/offEquilibriumTemplates.h"
 #include "latticeBoltzmann/d3q13Templates.h"
 #include "latticeBoltzmann/geometricOperationTemplates.h"
+#include "latticeBoltzmann/simdKernels3D.h"
 #include "core/latticeStatistics.h"
 #include <algorithm>
 #include <limits>
@@ -325,6 +326,11 @@ int BGKdynamics<T,Descriptor>::getId() const {
     return id;
 }
 
+template<typename T, template<typename U> class Descriptor>
+bool BGKdynamics<T,Descriptor>::isCompactable() const {
+    return true;
+}
+
 template<typename T, template<typename U> class Descriptor>
 void BGKdynamics<T,Descriptor>::collide (
         Cell<T,Descriptor>& cell,
@@ -347,6 +353,138 @@ void BGKdynamics<T,Descriptor>::collideExternal (
     dynamicsTemplates<T,Descriptor>::bgk_ma2_collision(cell, rhoBar, j, this->getOmega());
 }
 
+/** The collision of collide() is inlined into the loop over the cells.
+ *  Derived classes which override collide() use the generic loop.
+ */
+template<typename T, template<typename U> class Descriptor>
+void BGKdynamics<T,Descriptor>::collideCells (
+        Cell<T,Descriptor>* cells, plint numCells, BlockStatistics& statistics )
+{
+    if (this->getId() != id) {
+        Dynamics<T,Descriptor>::collideCells(cells, numCells, statistics);
+        return;
+    }
+    T omega = this->getOmega();
+    T rhoBar;
+    Array<T,Descriptor<T>::d> j;
+    for (plint iCell=0; iCell<numCells; ++iCell) {
+        Cell<T,Descriptor>& cell = cells[iCell];
+        momentTemplates<T,Descriptor>::get_rhoBar_j(cell, rhoBar, j);
+        T uSqr = dynamicsTemplates<T,Descriptor>::bgk_ma2_collision(cell, rhoBar, j, omega);
+        if (cell.takesStatistics()) {
+            gatherStatistics(statistics, rhoBar, uSqr);
+        }
+    }
+}
+
+/** The cells are treated in chunks, with loops over the cells of a chunk
+ *  in the innermost position, so that the compiler can vectorize them.
+ *  The generic form of the equilibrium is used, which differs from the
+ *  lattice-specific templates of collide() by round-off errors only.
+ *  Short runs, for which the chunks would not pay off, are treated cell
+ *  by cell with the lattice-specific templates. Derived classes which
+ *  override collide() use the generic cell-by-cell path of the lattice.
+ */
+template<typename T, template<typename U> class Descriptor>
+bool BGKdynamics<T,Descriptor>::collideStructureOfArrays (
+        T* f, plint stride, plint numCells, bool takesStatistics, BlockStatistics& statistics )
+{
+    if (this->getId() != id) {
+        return false;
+    }
+    typedef typename Descriptor<T>::BaseDescriptor D;
+    static const plint chunkSize = 32;
+    static const plint minRunLength = 4;
+    T omega = this->getOmega();
+    if (numCells<minRunLength) {
+        Array<T,D::q> fCell;
+        Array<T,D::d> jCell;
+        T rhoBarCell;
+        for (plint iCell=0; iCell<numCells; ++iCell) {
+            for (plint iPop=0; iPop<D::q; ++iPop) {
+                fCell[iPop] = f[iPop*stride+iCell];
+            }
+            momentTemplatesImpl<T,D>::get_rhoBar_j(fCell, rhoBarCell, jCell);
+            T uSqr = dynamicsTemplatesImpl<T,D>::bgk_ma2_collision(fCell, rhoBarCell, jCell, omega);
+            for (plint iPop=0; iPop<D::q; ++iPop) {
+                f[iPop*stride+iCell] = fCell[iPop];
+            }
+            if (takesStatistics) {
+                gatherStatistics(statistics, rhoBarCell, uSqr);
+            }
+        }
+        return true;
+    }
+    T rhoBar[chunkSize], invRho[chunkSize], jSqr[chunkSize];
+    T j[D::d][chunkSize];
+    for (plint start=0; start<numCells; start+=chunkSize) {
+        T* fChunk = f+start;
+        plint size = std::min(chunkSize, numCells-start);
+        // Explicitly vectorized kernel, if one exists for this lattice.
+        //   On output, jSqr contains uSqr.
+        if (SimdBgkKernel<T,D>::collide(fChunk, stride, size, omega, rhoBar, jSqr)) {
+            if (takesStatistics) {
+                for (plint iCell=0; iCell<size; ++iCell) {
+                    gatherStatistics(statistics, rhoBar[iCell], jSqr[iCell]);
+                }
+            }
+            continue;
+        }
+        // Moments.
+        for (plint iCell=0; iCell<size; ++iCell) {
+            rhoBar[iCell] = fChunk[iCell];
+        }
+        for (plint iD=0; iD<D::d; ++iD) {
+            for (plint iCell=0; iCell<size; ++iCell) {
+                j[iD][iCell] = T();
+            }
+        }
+        for (plint iPop=1; iPop<D::q; ++iPop) {
+            T const* fPop = fChunk+iPop*stride;
+            for (plint iCell=0; iCell<size; ++iCell) {
+                rhoBar[iCell] += fPop[iCell];
+            }
+            for (plint iD=0; iD<D::d; ++iD) {
+                T c = (T)D::c[iPop][iD];
+                if (c!=T()) {
+                    for (plint iCell=0; iCell<size; ++iCell) {
+                        j[iD][iCell] += c*fPop[iCell];
+                    }
+                }
+            }
+        }
+        for (plint iCell=0; iCell<size; ++iCell) {
+            invRho[iCell] = D::invRho(rhoBar[iCell]);
+            jSqr[iCell] = T();
+        }
+        for (plint iD=0; iD<D::d; ++iD) {
+            for (plint iCell=0; iCell<size; ++iCell) {
+                jSqr[iCell] += j[iD][iCell]*j[iD][iCell];
+            }
+        }
+        // BGK relaxation toward the second-order equilibrium.
+        for (plint iPop=0; iPop<D::q; ++iPop) {
+            T* fPop = fChunk+iPop*stride;
+            T t = D::t[iPop];
+            for (plint iCell=0; iCell<size; ++iCell) {
+                T c_j = T();
+                for (plint iD=0; iD<D::d; ++iD) {
+                    c_j += (T)D::c[iPop][iD]*j[iD][iCell];
+                }
+                T fEq = t * ( rhoBar[iCell] + D::invCs2*c_j +
+                              D::invCs2/(T)2*invRho[iCell]*(D::invCs2*c_j*c_j - jSqr[iCell]) );
+                fPop[iCell] = fPop[iCell]*((T)1-omega) + omega*fEq;
+            }
+        }
+        if (takesStatistics) {
+            for (plint iCell=0; iCell<size; ++iCell) {
+                gatherStatistics(statistics, rhoBar[iCell], jSqr[iCell]*invRho[iCell]*invRho[iCell]);
+            }
+        }
+    }
+    return true;
+}
+
 template<typename T, template<typename U> class Descriptor>
 T BGKdynamics<T,Descriptor>::computeEquilibrium(plint iPop, T rhoBar, Array<T,Descriptor<T>::d> const& j,
                                                 T jSqr, T thetaBar) const
@@ -669,6 +807,11 @@ int IncBGKdynamics<T,Descriptor>::getId() const {
     return id;
 }
 
+template<typename T, template<typename U> class Descriptor>
+bool IncBGKdynamics<T,Descriptor>::isCompactable() const {
+    return true;
+}
+
 template<typename T, template<typename U> class Descriptor>
 void IncBGKdynamics<T,Descriptor>::computeVelocity (
         Cell<T,Descriptor> const& cell, Array<T,Descriptor<T>::d>& u ) const
@@ -772,6 +915,11 @@ int ConstRhoBGKdynamics<T,Descriptor>::getId() const {
     return id;
 }
 
+template<typename T, template<typename U> class Descriptor>
+bool ConstRhoBGKdynamics<T,Descriptor>::isCompactable() const {
+    return true;
+}
+
 template<typename T, template<typename U> class Descriptor>
 void ConstRhoBGKdynamics<T,Descriptor>::collide (
         Cell<T,Descriptor>& cell,
@@ -867,6 +1015,11 @@ int RegularizedBGKdynamics<T,Descriptor>::getId() const {
     return id;
 }
 
+template<typename T, template<typename U> class Descriptor>
+bool RegularizedBGKdynamics<T,Descriptor>::isCompactable() const {
+    return true;
+}
+
 template<typename T, template<typename U> class Descriptor>
 void RegularizedBGKdynamics<T,Descriptor>::collide (
         Cell<T,Descriptor>& cell,
@@ -884,6 +1037,33 @@ void RegularizedBGKdynamics<T,Descriptor>::collide (
     }
 }
 
+/** The collision of collide() is inlined into the loop over the cells.
+ *  Derived classes which override collide() use the generic loop.
+ */
+template<typename T, template<typename U> class Descriptor>
+void RegularizedBGKdynamics<T,Descriptor>::collideCells (
+        Cell<T,Descriptor>* cells, plint numCells, BlockStatistics& statistics )
+{
+    if (this->getId() != id) {
+        Dynamics<T,Descriptor>::collideCells(cells, numCells, statistics);
+        return;
+    }
+    T omega = this->getOmega();
+    T rhoBar;
+    Array<T,Descriptor<T>::d> j;
+    Array<T,SymmetricTensor<T,Descriptor>::n> PiNeq;
+    for (plint iCell=0; iCell<numCells; ++iCell) {
+        Cell<T,Descriptor>& cell = cells[iCell];
+        momentTemplates<T,Descriptor>::compute_rhoBar_j_PiNeq(cell, rhoBar, j, PiNeq);
+        T invRho = Descriptor<T>::invRho(rhoBar);
+        T uSqr = dynamicsTemplates<T,Descriptor>::rlb_collision (
+                     cell, rhoBar, invRho, j, PiNeq, omega );
+        if (cell.takesStatistics()) {
+            gatherStatistics(statistics, rhoBar, uSqr);
+        }
+    }
+}
+
 template<typename T, template<typename U> class Descriptor>
 void RegularizedBGKdynamics<T,Descriptor>::collideExternal (
         Cell<T,Descriptor>& cell, T rhoBar,
@@ -1020,6 +1200,11 @@ int IncRegularizedBGKdynamics<T,Descriptor>::getId() const {
     return id;
 }
 
+template<typename T, template<typename U> class Descriptor>
+bool IncRegularizedBGKdynamics<T,Descriptor>::isCompactable() const {
+    return true;
+}
+
 template<typename T, template<typename U> class Descriptor>
 void IncRegularizedBGKdynamics<T,Descriptor>::computeVelocity (
         Cell<T,Descriptor> const& cell, Array<T,Descriptor<T>::d>& u ) const
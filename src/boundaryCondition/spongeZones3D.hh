@@ -142,7 +142,7 @@ void ViscositySpongeZone<T,Descriptor>::processGenericBlocks(Box3D domain, std::
                     if (modifyOmega) {
                         spongeFunction = (1.0 - alpha) * spongeFunction + alpha;
                         T localOmega = bulkOmega * spongeFunction;
-                        lattice->get(iX, iY, iZ).getDynamics().setOmega(localOmega);
+                        lattice->setOmega(iX, iY, iZ, localOmega);
                     }
                 }
             }
@@ -189,7 +189,7 @@ void ViscositySpongeZone<T,Descriptor>::processGenericBlocks(Box3D domain, std::
                     if (modifyOmega) {
                         spongeFunction = (1.0 - alpha) * spongeFunction + alpha;
                         T localOmega = bulkOmega * spongeFunction;
-                        lattice->get(iX, iY, iZ).getDynamics().setOmega(localOmega);
+                        lattice->setOmega(iX, iY, iZ, localOmega);
                     }
                 }
             }
@@ -308,7 +308,7 @@ void SmagorinskySpongeZone<T,Descriptor>::processGenericBlocks(Box3D domain, std
                     if (modifyCSmago) {
                         spongeFunction = (1.0 - alpha) * spongeFunction + alpha;
                         T localCSmago = bulkCSmago * spongeFunction;
-                        lattice->get(iX, iY, iZ).getDynamics().setParameter(whichParameter, localCSmago);
+                        lattice->setParameter(iX, iY, iZ, whichParameter, localCSmago);
                     }
                 }
             }
@@ -356,7 +356,7 @@ void SmagorinskySpongeZone<T,Descriptor>::processGenericBlocks(Box3D domain, std
                     if (modifyCSmago) {
                         spongeFunction = (1.0 - alpha) * spongeFunction + alpha;
                         T localCSmago = bulkCSmago * spongeFunction;
-                        lattice->get(iX, iY, iZ).getDynamics().setParameter(whichParameter, localCSmago);
+                        lattice->setParameter(iX, iY, iZ, whichParameter, localCSmago);
                     }
                 }
             }
@@ -135,6 +135,10 @@ public:
             Cell<T,Descriptor>& cell, T rhoBar, Array<T,Descriptor<T>::d> const& j,
             T thetaBar, BlockStatistics& stat );
 
+    /// Implementation of the collision step on structure-of-arrays storage
+    virtual bool collideStructureOfArrays(T* f, plint stride, plint numCells,
+                                          bool takesStatistics, BlockStatistics& statistics);
+
     /// Compute equilibrium distribution function
     virtual T computeEquilibrium(plint iPop, T rhoBar, Array<T,Descriptor<T>::d> const& j,
                                  T jSqr, T thetaBar=T()) const;
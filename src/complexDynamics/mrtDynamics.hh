@@ -33,6 +33,7 @@
 #include "latticeBoltzmann/mrtTemplates.h"
 #include "latticeBoltzmann/dynamicsTemplates.h"
 #include "latticeBoltzmann/momentTemplates.h"
+#include "latticeBoltzmann/simdKernels3D.h"
 #include "core/latticeStatistics.h"
 #include "complexDynamics/mrtDynamics.h"
 #include <algorithm>
@@ -392,6 +393,50 @@ void MRTdynamics<T,Descriptor>::collideExternal (
     }
 }
 
+template<typename T, template<typename U> class Descriptor>
+bool MRTdynamics<T,Descriptor>::collideStructureOfArrays (
+        T* f, plint stride, plint numCells, bool takesStatistics, BlockStatistics& statistics )
+{
+    if (this->getId() != id) {
+        return false;
+    }
+    typedef typename Descriptor<T>::SecondBaseDescriptor D;
+    typedef mrtTemplatesImpl<T,D> mrtTemp;
+    static const plint chunkSize = 32;
+    MRTparam<T,Descriptor>* parameter = param ? param : &(mrtParam<T,Descriptor>().get(externalParam));
+    T rhoBar[chunkSize], uSqr[chunkSize];
+    Array<T,D::q> fCell;
+    Array<T,D::d> j;
+    for (plint start=0; start<numCells; start+=chunkSize) {
+        T* fChunk = f+start;
+        plint size = std::min(chunkSize, numCells-start);
+        // Explicitly vectorized kernel, if one exists for this lattice.
+        if (SimdMrtKernel<T,D>::collide(fChunk, stride, size, &parameter->getInvM()[0][0], rhoBar, uSqr)) {
+            if (takesStatistics) {
+                for (plint iCell=0; iCell<size; ++iCell) {
+                    gatherStatistics(statistics, rhoBar[iCell], uSqr[iCell]);
+                }
+            }
+            continue;
+        }
+        for (plint iCell=0; iCell<size; ++iCell) {
+            for (plint iPop=0; iPop<D::q; ++iPop) {
+                fCell[iPop] = fChunk[iPop*stride+iCell];
+            }
+            momentTemplatesImpl<T,D>::get_rhoBar_j(fCell, rhoBar[iCell], j);
+            T jSqr = mrtTemp::mrtCollision(fCell, rhoBar[iCell], j, parameter->getInvM());
+            for (plint iPop=0; iPop<D::q; ++iPop) {
+                fChunk[iPop*stride+iCell] = fCell[iPop];
+            }
+            if (takesStatistics) {
+                T invRho = D::invRho(rhoBar[iCell]);
+                gatherStatistics(statistics, rhoBar[iCell], jSqr*invRho*invRho);
+            }
+        }
+    }
+    return true;
+}
+
 template<typename T, template<typename U> class Descriptor>
 T MRTdynamics<T,Descriptor>::computeEquilibrium(plint iPop, T rhoBar, Array<T,Descriptor<T>::d> const& j,
                                                 T jSqr, T thetaBar) const
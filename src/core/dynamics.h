@@ -88,6 +88,17 @@ struct Dynamics {
     // Say if the dynamics has non-local components.
     virtual bool isNonLocal() const;
 
+    /// Say if the dynamics has no state which is modified cell by cell, so
+    ///   that all cells with identical dynamics can share a single instance.
+    virtual bool isShareable() const;
+
+    /// Say if the collision leaves the dynamics object unchanged, so that the
+    ///   cells with identical dynamics can share a single instance in the
+    ///   compact-dynamics mode of a lattice. Dynamics which adapt their own
+    ///   parameters during the collision, such as the Smagorinsky dynamics
+    ///   which set their omega cell by cell, must not declare it.
+    virtual bool isCompactable() const;
+
     /// Serialize the dynamics object.
     virtual void serialize(HierarchicSerializer& serializer) const;
     /// Un-Serialize the dynamics object.
@@ -103,6 +114,19 @@ struct Dynamics {
     virtual void collideExternal(Cell<T,Descriptor>& cell, T rhoBar,
                          Array<T,Descriptor<T>::d> const& j, T thetaBar, BlockStatistics& stat);
 
+    /// Collision step on numCells consecutive Cell objects which all refer to
+    ///   this dynamics object. Dynamics with a cheap collision step override
+    ///   this method to avoid a virtual function call per cell.
+    virtual void collideCells(Cell<T,Descriptor>* cells, plint numCells,
+                              BlockStatistics& statistics);
+
+    /// Collision step on a run of numCells consecutive cells whose populations
+    ///   are stored as structure of arrays: population iPop of cell iCell is
+    ///   f[iPop*stride+iCell]. Returns false if the dynamics does not implement
+    ///   this kernel, in which case collide() must be applied cell by cell.
+    virtual bool collideStructureOfArrays(T* f, plint stride, plint numCells,
+                                          bool takesStatistics, BlockStatistics& statistics);
+
     /// Compute equilibrium distribution function
     virtual T computeEquilibrium(plint iPop, T rhoBar, Array<T,Descriptor<T>::d> const& j,
                                  T jSqr, T thetaBar=T()) const =0;
@@ -641,6 +665,9 @@ public:
     /// BounceBack is a boundary.
     virtual bool isBoundary() const;
 
+    /// BounceBack has no state besides the constant fictitious density.
+    virtual bool isShareable() const;
+
 /* *************** Additional moments, intended for internal use ************ */
 
     /// Yields fictitious density
@@ -747,6 +774,9 @@ public:
         Dynamics<T,Descriptor>::rescale(dxScale, dtScale);
     }
 
+    /// NoDynamics has no state besides the constant density.
+    virtual bool isShareable() const;
+
 /* *************** Additional moments, intended for internal use ************ */
 
     /// Yields rho=1
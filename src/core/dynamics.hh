@@ -80,6 +80,18 @@ bool Dynamics<T,Descriptor>::isNonLocal() const {
     return false;
 }
 
+/** By default, this method yields false.  */
+template<typename T, template<typename U> class Descriptor>
+bool Dynamics<T,Descriptor>::isShareable() const {
+    return false;
+}
+
+/** By default, this method yields false.  */
+template<typename T, template<typename U> class Descriptor>
+bool Dynamics<T,Descriptor>::isCompactable() const {
+    return false;
+}
+
 template<typename T, template<typename U> class Descriptor>
 T Dynamics<T,Descriptor>::getParameter(plint whichParameter) const {
     if (whichParameter == dynamicParams::omega_shear) {
@@ -125,6 +137,22 @@ void Dynamics<T,Descriptor>::collideExternal (
     collide(cell, stat);
 }
 
+template<typename T, template<typename U> class Descriptor>
+void Dynamics<T,Descriptor>::collideCells (
+        Cell<T,Descriptor>* cells, plint numCells, BlockStatistics& statistics )
+{
+    for (plint iCell=0; iCell<numCells; ++iCell) {
+        collide(cells[iCell], statistics);
+    }
+}
+
+/** By default, this method yields false: the cells are collided one by one. */
+template<typename T, template<typename U> class Descriptor>
+bool Dynamics<T,Descriptor>::collideStructureOfArrays (
+        T* f, plint stride, plint numCells, bool takesStatistics, BlockStatistics& statistics )
+{
+    return false;
+}
 
 template<typename T, template<typename U> class Descriptor>
 void Dynamics<T,Descriptor>::computeEquilibria (
@@ -902,6 +930,11 @@ bool BounceBack<T,Descriptor>::isBoundary() const {
     return true;
 }
 
+template<typename T, template<typename U> class Descriptor>
+bool BounceBack<T,Descriptor>::isShareable() const {
+    return true;
+}
+
 /* *************** Class NoDynamics ********************************** */
 
 template<typename T, template<typename U> class Descriptor>
@@ -1072,6 +1105,11 @@ void NoDynamics<T,Descriptor>::rescale (
         std::vector<T>& rawData, T xDxInv, T xDt, plint order ) const
 { }
 
+template<typename T, template<typename U> class Descriptor>
+bool NoDynamics<T,Descriptor>::isShareable() const {
+    return true;
+}
+
 template<typename T, template<typename U> class Descriptor>
 void constructIdChain(Dynamics<T,Descriptor> const& dynamics, std::vector<int>& chain)
 {
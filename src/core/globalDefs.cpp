@@ -34,7 +34,8 @@ IOpolicyClass::IOpolicyClass()
       endianSwitchOnBase64in(false),
       stlLowerBoundFlag(false),
       stlLowerBound(-1.),
-      parallelIOflag(true)
+      parallelIOflag(true),
+      checkpointCodec(CheckpointCompression::none)
 { }
 
 void IOpolicyClass::setIndexOrderingForStreams(IndexOrdering::OrderingT streamOrdering_) {
@@ -85,6 +86,14 @@ bool IOpolicyClass::useParallelIO() const {
     return parallelIOflag;
 }
 
+void IOpolicyClass::setCheckpointCompression(CheckpointCompression::CodecT codec) {
+    checkpointCodec = codec;
+}
+
+CheckpointCompression::CodecT IOpolicyClass::getCheckpointCompression() const {
+    return checkpointCodec;
+}
+
 /** Directories are default initialized to working directory.
  */
 Directories::Directories()
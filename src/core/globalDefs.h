@@ -121,6 +121,20 @@ namespace IndexOrdering {
     enum OrderingT {forward, backward, memorySaving};
 }
 
+/// Encoding of the data of the checkpoints written by parallelIO::save.
+/** Signification of constants:
+ *    - none:       The serialized data of the atomic-blocks is written as is.
+ *    - floatDelta: Lossless encoding, in which every atomic-block is compressed
+ *                  independently. The bytes of a cell are XOR-ed with the bytes
+ *                  of the previous cell and regrouped by byte position, so that
+ *                  the sign, exponent and leading mantissa bytes of slowly
+ *                  varying floating-point values produce runs of zeros, which
+ *                  are then run-length encoded.
+ **/
+namespace CheckpointCompression {
+    enum CodecT {none, floatDelta};
+}
+
 /// Sub-domain of an atomic-block, on which for example a data processor is executed.
 /** Signification of constants:
  *      - bulk: Refers to bulk-nodes, without envelope.
@@ -186,6 +200,9 @@ public:
 
     void activateParallelIO(bool activate);
     bool useParallelIO() const;
+
+    void setCheckpointCompression(CheckpointCompression::CodecT codec);
+    CheckpointCompression::CodecT getCheckpointCompression() const;
 private:
     IOpolicyClass();
 private:
@@ -195,6 +212,7 @@ private:
     bool stlLowerBoundFlag;
     double stlLowerBound;
     bool parallelIOflag;
+    CheckpointCompression::CodecT checkpointCodec;
     friend IOpolicyClass& IOpolicy();
 };
     
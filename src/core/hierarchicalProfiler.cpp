@@ -0,0 +1,459 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Profiler which measures the time spent in nested scopes, atomic-blocks
+ * and data-processor classes -- implementation file.
+ */
+
+#include "core/hierarchicalProfiler.h"
+#include "core/plbDebug.h"
+#include "core/runTimeDiagnostics.h"
+#include "core/util.h"
+#include "parallelism/mpiManager.h"
+#include "parallelism/smpThreadPool.h"
+#include "io/mpiParallelIO.h"
+#include "io/parallelIO.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+#ifdef PLB_USE_POSIX
+#include <time.h>
+#endif
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+namespace plb {
+
+namespace global {
+
+HierarchicalProfiler::HierarchicalProfiler()
+    : profilingFlag(false),
+      detailedTimingFlag(false),
+      traceFlag(false),
+      maxNumTraceEvents(1000000),
+      numDroppedEvents(0),
+      timeOrigin(0.)
+{
+    // Node 0 is the root of the tree; it has no scope.
+    nodes.push_back(Node(-1, -1));
+}
+
+void HierarchicalProfiler::turnOn() {
+    if (nodes.size()==1 && events.empty()) {
+        timeOrigin = getTime();
+    }
+    profilingFlag = true;
+}
+
+void HierarchicalProfiler::turnOff() {
+    flushPending();
+    profilingFlag = false;
+}
+
+void HierarchicalProfiler::toggleDetailedTiming(bool flag) {
+    detailedTimingFlag = flag;
+}
+
+void HierarchicalProfiler::toggleTrace(bool flag) {
+    traceFlag = flag;
+}
+
+void HierarchicalProfiler::setMaxNumTraceEvents(plint maxNumTraceEvents_) {
+    PLB_PRECONDITION( maxNumTraceEvents_ >= 0 );
+    maxNumTraceEvents = maxNumTraceEvents_;
+}
+
+void HierarchicalProfiler::reset() {
+    PLB_PRECONDITION( openScopes.empty() );
+    nodes.clear();
+    nodes.push_back(Node(-1, -1));
+    events.clear();
+    pending.clear();
+    numDroppedEvents = 0;
+    timeOrigin = getTime();
+}
+
+plint HierarchicalProfiler::registerScope(std::string const& name) {
+    std::map<std::string,plint>::const_iterator it = scopeIds.find(name);
+    if (it != scopeIds.end()) {
+        return it->second;
+    }
+    plint scopeId = (plint)scopeNames.size();
+    scopeNames.push_back(name);
+    scopeIds[name] = scopeId;
+    return scopeId;
+}
+
+std::string const& HierarchicalProfiler::getScopeName(plint scopeId) const {
+    PLB_PRECONDITION( scopeId>=0 && scopeId<(plint)scopeNames.size() );
+    return scopeNames[scopeId];
+}
+
+plint HierarchicalProfiler::getBlockScope(plint blockId) {
+    std::map<plint,plint>::const_iterator it = blockScopes.find(blockId);
+    if (it != blockScopes.end()) {
+        return it->second;
+    }
+    plint scopeId = registerScope("block "+util::val2str(blockId));
+    blockScopes[blockId] = scopeId;
+    blockScopeIds.insert(scopeId);
+    return scopeId;
+}
+
+plint HierarchicalProfiler::getTypeScope(std::type_info const& type) {
+    std::string mangledName(type.name());
+    std::map<std::string,plint>::const_iterator it = typeScopes.find(mangledName);
+    if (it != typeScopes.end()) {
+        return it->second;
+    }
+    std::string name(mangledName);
+#ifdef __GNUG__
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(mangledName.c_str(), 0, 0, &status);
+    if (status==0 && demangled) {
+        name = demangled;
+    }
+    free(demangled);
+#endif
+    // Semicolons separate the frames of the collapsed stacks.
+    std::replace(name.begin(), name.end(), ';', ',');
+    plint scopeId = registerScope(name);
+    typeScopes[mangledName] = scopeId;
+    return scopeId;
+}
+
+plint HierarchicalProfiler::childNode(plint parent, plint scopeId) {
+    std::vector<plint> const& children = nodes[parent].children;
+    for (pluint iChild=0; iChild<children.size(); ++iChild) {
+        if (nodes[children[iChild]].scopeId==scopeId) {
+            return children[iChild];
+        }
+    }
+    plint node = (plint)nodes.size();
+    nodes.push_back(Node(scopeId, parent));
+    nodes[parent].children.push_back(node);
+    return node;
+}
+
+plint HierarchicalProfiler::currentNode() const {
+    return openScopes.empty() ? 0 : openScopes.back().first;
+}
+
+void HierarchicalProfiler::enter(plint scopeId) {
+    if (!profilingFlag) return;
+    if (!smpThreadPool().inParallelRegion()) {
+        flushPending();
+    }
+    plint node = childNode(currentNode(), scopeId);
+    openScopes.push_back(std::make_pair(node, getTime()));
+}
+
+void HierarchicalProfiler::leave(plint scopeId) {
+    if (!profilingFlag || openScopes.empty() ||
+        nodes[openScopes.back().first].scopeId != scopeId)
+    {
+        return;
+    }
+    if (!smpThreadPool().inParallelRegion()) {
+        flushPending();
+    }
+    plint node = openScopes.back().first;
+    double start = openScopes.back().second;
+    double duration = getTime()-start;
+    openScopes.pop_back();
+    nodes[node].time += duration;
+    ++nodes[node].count;
+    addEvent(node, 0, start, duration);
+}
+
+void HierarchicalProfiler::setCurrentBlockScope(plint blockScope) {
+    smpThreadPool().lock();
+    plint threadId = smpThreadPool().getThreadId();
+    if (threadId >= (plint)currentBlockScopes.size()) {
+        currentBlockScopes.resize(threadId+1, -1);
+    }
+    currentBlockScopes[threadId] = blockScope;
+    smpThreadPool().unlock();
+}
+
+void HierarchicalProfiler::addBlockTime(plint blockScope, int threadId, double startTime, double duration) {
+    if (!profilingFlag) return;
+    flushPending();
+    plint node = childNode(currentNode(), blockScope);
+    nodes[node].time += duration;
+    ++nodes[node].count;
+    addEvent(node, threadId, startTime, duration);
+}
+
+void HierarchicalProfiler::addProcessorTime(std::type_info const& type, int threadId, double startTime, double duration) {
+    if (!profilingFlag) return;
+    smpThreadPool().lock();
+    PendingTime entry;
+    entry.blockScope = threadId < (int)currentBlockScopes.size() ? currentBlockScopes[threadId] : -1;
+    entry.typeScope = getTypeScope(type);
+    entry.threadId = threadId;
+    entry.start = startTime;
+    entry.duration = duration;
+    pending.push_back(entry);
+    smpThreadPool().unlock();
+}
+
+void HierarchicalProfiler::flushPending() {
+    for (pluint iEntry=0; iEntry<pending.size(); ++iEntry) {
+        PendingTime const& entry = pending[iEntry];
+        plint node = currentNode();
+        // The block is already the current scope if it was executed by the main thread.
+        if (entry.blockScope>=0 && nodes[node].scopeId!=entry.blockScope) {
+            node = childNode(node, entry.blockScope);
+        }
+        node = childNode(node, entry.typeScope);
+        nodes[node].time += entry.duration;
+        ++nodes[node].count;
+        addEvent(node, entry.threadId, entry.start, entry.duration);
+    }
+    pending.clear();
+}
+
+void HierarchicalProfiler::addEvent(plint node, int threadId, double start, double duration) {
+    if (!traceFlag) return;
+    if ((plint)events.size() >= maxNumTraceEvents) {
+        ++numDroppedEvents;
+        return;
+    }
+    Event event;
+    event.node = node;
+    event.threadId = threadId;
+    event.start = start;
+    event.duration = duration;
+    events.push_back(event);
+}
+
+double HierarchicalProfiler::getTime() const {
+#ifdef PLB_USE_POSIX
+    // Contrarily to MPI_Wtime, clock_gettime may be called by any thread.
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + 1.e-9*(double)now.tv_nsec;
+#elif defined PLB_MPI_PARALLEL
+    return mpi().getTime();
+#else
+    return (double)clock() / (double)CLOCKS_PER_SEC;
+#endif
+}
+
+std::string HierarchicalProfiler::getPath(plint node, bool mergeBlocks) const {
+    std::string path;
+    for (; node>0; node=nodes[node].parent) {
+        plint scopeId = nodes[node].scopeId;
+        std::string name = scopeNames[scopeId];
+        if (mergeBlocks && blockScopeIds.find(scopeId) != blockScopeIds.end()) {
+            name = "blocks";
+        }
+        path = path.empty() ? name : name+";"+path;
+    }
+    return path;
+}
+
+/// Write one chunk of text per process, preceded by a header and followed
+///   by a footer, which are written by the main process.
+void HierarchicalProfiler::writeRankData( FileName fName, std::string const& header,
+                                          std::string& localData, std::string const& footer )
+{
+    fName.defaultPath(directories().getOutputDir());
+    plint numProcs = mpi().getSize();
+    plint rank = mpi().getRank();
+    bool isMain = mpi().isMainProcessor();
+
+    std::vector<plint> sizes(numProcs+2, 0);
+    sizes[1+rank] = (plint)localData.size();
+    if (isMain) {
+        sizes[0] = (plint)header.size();
+        sizes[numProcs+1] = (plint)footer.size();
+    }
+#ifdef PLB_MPI_PARALLEL
+    mpi().allReduceVect(sizes, MPI_SUM);
+#endif
+    std::vector<plint> offset(sizes.size());
+    std::partial_sum(sizes.begin(), sizes.end(), offset.begin());
+
+    std::vector<plint> myChunkIds;
+    std::vector<std::vector<char> > data;
+    if (isMain && !header.empty()) {
+        myChunkIds.push_back(0);
+        data.push_back(std::vector<char>(header.begin(), header.end()));
+    }
+    if (!localData.empty()) {
+        myChunkIds.push_back(1+rank);
+        data.push_back(std::vector<char>(localData.begin(), localData.end()));
+    }
+    if (isMain && !footer.empty()) {
+        myChunkIds.push_back(numProcs+1);
+        data.push_back(std::vector<char>(footer.begin(), footer.end()));
+    }
+    // The chunks are written at fixed offsets: a previous, longer version
+    //   of the file must not leave its remainder at the end.
+    if (isMain) {
+        std::remove(fName.get().c_str());
+    }
+    mpi().barrier();
+    parallelIO::writeRawData(fName, myChunkIds, offset, data);
+}
+
+void HierarchicalProfiler::writeFlameGraph(FileName fName) {
+    flushPending();
+    fName.defaultExt("folded");
+    std::string prefix = "rank "+util::val2str(mpi().getRank());
+    std::ostringstream lines;
+    for (pluint iNode=1; iNode<nodes.size(); ++iNode) {
+        double selfTime = nodes[iNode].time;
+        for (pluint iChild=0; iChild<nodes[iNode].children.size(); ++iChild) {
+            selfTime -= nodes[nodes[iNode].children[iChild]].time;
+        }
+        // Children of a scope may be executed in parallel by several
+        //   threads, and exceed the wall-clock time of their parent.
+        plint microseconds = (plint)(std::max(selfTime, 0.)*1.e6 + 0.5);
+        if (microseconds>0) {
+            lines << prefix << ";" << getPath(iNode) << " " << microseconds << "\n";
+        }
+    }
+    std::string localData = lines.str();
+    writeRankData(fName, "", localData, "");
+}
+
+void HierarchicalProfiler::writeChromeTrace(FileName fName) {
+    flushPending();
+    fName.defaultExt("json");
+    plint rank = mpi().getRank();
+    std::ostringstream header;
+    header << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+           << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,"
+           << "\"args\":{\"name\":\"rank 0\"}}";
+    std::ostringstream local;
+    local << std::fixed << std::setprecision(3);
+    if (rank>0) {
+        local << ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank
+              << ",\"tid\":0,\"args\":{\"name\":\"rank " << rank << "\"}}";
+    }
+    for (pluint iEvent=0; iEvent<events.size(); ++iEvent) {
+        Event const& event = events[iEvent];
+        local << ",\n{\"name\":\"" << scopeNames[nodes[event.node].scopeId]
+              << "\",\"cat\":\"plb\",\"ph\":\"X\",\"pid\":" << rank
+              << ",\"tid\":" << event.threadId
+              << ",\"ts\":" << (event.start-timeOrigin)*1.e6
+              << ",\"dur\":" << event.duration*1.e6 << "}";
+    }
+    if (numDroppedEvents>0) {
+        local << ",\n{\"name\":\"dropped_events\",\"ph\":\"M\",\"pid\":" << rank
+              << ",\"tid\":0,\"args\":{\"count\":" << numDroppedEvents << "}}";
+    }
+    std::string localData = local.str();
+    writeRankData(fName, header.str(), localData, "\n]}\n");
+}
+
+void HierarchicalProfiler::writeImbalanceReport(FileName fName) {
+    flushPending();
+    fName.defaultPath(directories().getOutputDir());
+    fName.defaultExt("txt");
+
+    // Every process sends the total time of its nodes, by path, to the
+    //   main process.
+    std::ostringstream local;
+    local << std::setprecision(17);
+    for (pluint iNode=1; iNode<nodes.size(); ++iNode) {
+        local << getPath(iNode, true) << "\t" << nodes[iNode].time << "\n";
+    }
+    std::string localData = local.str();
+
+    plint numProcs = mpi().getSize();
+    std::vector<std::string> allData(numProcs);
+    allData[0] = localData;
+#ifdef PLB_MPI_PARALLEL
+    std::vector<plint> sizes(numProcs, 0);
+    sizes[mpi().getRank()] = (plint)localData.size();
+    mpi().allReduceVect(sizes, MPI_SUM);
+    if (mpi().isMainProcessor()) {
+        for (plint iProc=1; iProc<numProcs; ++iProc) {
+            if (sizes[iProc]>0) {
+                std::vector<char> buffer(sizes[iProc]);
+                mpi().receive(&buffer[0], (int)sizes[iProc], (int)iProc);
+                allData[iProc] = std::string(buffer.begin(), buffer.end());
+            }
+        }
+    }
+    else if (!localData.empty()) {
+        std::vector<char> buffer(localData.begin(), localData.end());
+        mpi().send(&buffer[0], (int)buffer.size(), mpi().bossId());
+    }
+#endif
+
+    if (mpi().isMainProcessor()) {
+        std::map<std::string, std::vector<double> > times;
+        for (plint iProc=0; iProc<numProcs; ++iProc) {
+            std::istringstream lines(allData[iProc]);
+            std::string line;
+            while (std::getline(lines, line)) {
+                std::string::size_type tab = line.rfind('\t');
+                if (tab==std::string::npos) continue;
+                std::vector<double>& pathTimes = times[line.substr(0,tab)];
+                pathTimes.resize(numProcs, 0.);
+                double time = 0.;
+                std::istringstream(line.substr(tab+1)) >> time;
+                pathTimes[iProc] += time;
+            }
+        }
+        plb_ofstream ofile(fName.get().c_str());
+        ofile << "# Time in seconds per scope, across " << numProcs << " processes.\n";
+        ofile << "# mean\tmin\tmax\tmax/mean\trank_of_max\tscope\n";
+        std::map<std::string, std::vector<double> >::const_iterator it = times.begin();
+        for (; it != times.end(); ++it) {
+            std::vector<double> const& pathTimes = it->second;
+            double sum = 0.;
+            plint maxRank = 0;
+            for (plint iProc=0; iProc<numProcs; ++iProc) {
+                sum += pathTimes[iProc];
+                if (pathTimes[iProc] > pathTimes[maxRank]) {
+                    maxRank = iProc;
+                }
+            }
+            double mean = sum/(double)numProcs;
+            double minTime = *std::min_element(pathTimes.begin(), pathTimes.end());
+            double maxTime = pathTimes[maxRank];
+            ofile << mean << "\t" << minTime << "\t" << maxTime << "\t"
+                  << (mean>0. ? maxTime/mean : 1.) << "\t" << maxRank << "\t"
+                  << it->first << "\n";
+        }
+    }
+}
+
+}  // namespace global
+
+}  // namespace plb
@@ -0,0 +1,191 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Profiler which measures the time spent in nested scopes, atomic-blocks
+ * and data-processor classes -- header file.
+ */
+#ifndef HIERARCHICAL_PROFILER_H
+#define HIERARCHICAL_PROFILER_H
+
+#include "core/globalDefs.h"
+#include "io/plbFiles.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <typeinfo>
+
+namespace plb {
+
+namespace global {
+
+/// Call tree of the time spent in nested scopes, per MPI process.
+/** Scopes are identified by integer ids obtained once through
+ *  registerScope(), so that opening and closing a scope costs no string
+ *  lookup. The timers of the Profiler are scopes, and are therefore
+ *  recorded in this tree whenever profiling is on.
+ *
+ *  With detailed timing, the execution of every atomic-block in the
+ *  shared-memory tasks of a multi-block, and the execution of every
+ *  internal data processor, is timed in addition. Blocks appear as
+ *  children "block N" of the scope in which they are executed, and data
+ *  processors as children of their block, named after the class of the
+ *  functional they execute.
+ *
+ *  The tree is written as a flame graph (collapsed stacks), as a summary
+ *  of the load imbalance between the processes, and, if tracing is on,
+ *  the individual events are written in the Chrome trace format.
+ *
+ *  The scopes are opened and closed by the main thread of the SMP thread
+ *  pool; worker threads only report the time of the blocks and processors
+ *  they execute.
+ */
+class HierarchicalProfiler {
+public:
+    /// Start recording (invoked by Profiler::turnOn()). The recorded data
+    ///   is kept; use reset() to discard it.
+    void turnOn();
+    void turnOff();
+    bool isOn() const {
+        return profilingFlag;
+    }
+    /// Time every atomic-block and data processor (default: false).
+    void toggleDetailedTiming(bool flag);
+    bool isDetailedTimingOn() const {
+        return profilingFlag && detailedTimingFlag;
+    }
+    /// Record the individual events for a Chrome trace (default: false).
+    void toggleTrace(bool flag);
+    bool isTraceOn() const {
+        return traceFlag;
+    }
+    /// Maximum number of events recorded per process for the trace;
+    ///   further events are dropped (default: one million).
+    void setMaxNumTraceEvents(plint maxNumTraceEvents_);
+    /// Discard all measurements. Must not be called inside a scope.
+    void reset();
+
+    /// Id of the scope with the given name; a new id is created the first
+    ///   time a name is registered.
+    plint registerScope(std::string const& name);
+    std::string const& getScopeName(plint scopeId) const;
+    /// Scope of a block, named "block N".
+    plint getBlockScope(plint blockId);
+    /// Scope of a class, named after the demangled type name.
+    plint getTypeScope(std::type_info const& type);
+
+    /// Open a scope, as a child of the innermost open scope.
+    void enter(plint scopeId);
+    /// Close a scope. Calls which don't match the innermost open scope, for
+    ///   example after the profiler was turned on inside the scope, are ignored.
+    void leave(plint scopeId);
+
+    /// Declare the calling thread as executing the atomic-block with the
+    ///   given scope (or none, with blockScope -1). Used for the attribution
+    ///   of the data processors. Thread-safe.
+    void setCurrentBlockScope(plint blockScope);
+    /// Add the execution time of a block, as measured by a task of a worker
+    ///   thread; to be called by the main thread once all tasks are completed.
+    ///   The blocks executed by the main thread are timed as ordinary scopes.
+    void addBlockTime(plint blockScope, int threadId, double startTime, double duration);
+    /// Add the execution time of a data processor. Thread-safe.
+    void addProcessorTime(std::type_info const& type, int threadId, double startTime, double duration);
+
+    /// Wall-clock time in seconds, with a process-wide origin.
+    double getTime() const;
+
+    /// Write the flame graph as collapsed stacks ("rank 0;cycle;collStream 1234"),
+    ///   one line per node of the tree of each process, with the time spent
+    ///   in the node itself in microseconds. Collective.
+    void writeFlameGraph(FileName fName);
+    /// Write the recorded events in the Chrome trace format (JSON), with one
+    ///   process per MPI rank and one thread per SMP thread. The times of
+    ///   the processes are relative to the time at which they turned the
+    ///   profiler on. Collective.
+    void writeChromeTrace(FileName fName);
+    /// Write a table with the mean, min and max time of every node of the
+    ///   tree across processes, and the ratio max/mean. The blocks of a
+    ///   process are merged into a single node "blocks". Collective.
+    void writeImbalanceReport(FileName fName);
+private:
+    HierarchicalProfiler();
+    struct Node {
+        Node(plint scopeId_, plint parent_)
+            : scopeId(scopeId_), parent(parent_), time(0.), count(0)
+        { }
+        plint scopeId, parent;
+        double time;
+        plint count;
+        std::vector<plint> children;
+    };
+    struct Event {
+        plint node;
+        int threadId;
+        double start, duration;
+    };
+    /// Time reported from a (possibly) non-main thread, which is inserted
+    ///   into the tree by the main thread.
+    struct PendingTime {
+        plint blockScope, typeScope;
+        int threadId;
+        double start, duration;
+    };
+    plint childNode(plint parent, plint scopeId);
+    plint currentNode() const;
+    void flushPending();
+    void addEvent(plint node, int threadId, double start, double duration);
+    std::string getPath(plint node, bool mergeBlocks=false) const;
+    void writeRankData(FileName fName, std::string const& header,
+                       std::string& localData, std::string const& footer);
+private:
+    bool profilingFlag;
+    bool detailedTimingFlag;
+    bool traceFlag;
+    plint maxNumTraceEvents;
+    plint numDroppedEvents;
+    double timeOrigin;
+    std::vector<std::string> scopeNames;
+    std::map<std::string,plint> scopeIds;
+    std::map<plint,plint> blockScopes;
+    std::set<plint> blockScopeIds;
+    std::map<std::string,plint> typeScopes;
+    std::vector<Node> nodes;
+    std::vector<std::pair<plint,double> > openScopes;
+    std::vector<Event> events;
+    std::vector<plint> currentBlockScopes;
+    std::vector<PendingTime> pending;
+friend HierarchicalProfiler& hierarchicalProfiler();
+};
+
+inline HierarchicalProfiler& hierarchicalProfiler() {
+    static HierarchicalProfiler instance;
+    return instance;
+}
+
+}  // namespace global
+
+}  // namespace plb
+
+#endif  // HIERARCHICAL_PROFILER_H
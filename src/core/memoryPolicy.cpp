@@ -0,0 +1,75 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Placement of the memory of the atomic-blocks: first-touch allocation
+ * by the thread which processes a block, huge pages and thread
+ * pinning -- implementation file.
+ */
+
+#include "core/memoryPolicy.h"
+#include <cstdlib>
+
+#if defined(PLB_USE_POSIX) && defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace plb {
+
+#if defined(PLB_USE_POSIX) && defined(__linux__) && defined(MADV_HUGEPAGE)
+static const pluint hugePageSize = 2*1024*1024;
+#endif
+
+void* allocateBlockMemory(pluint numBytes) {
+    if (numBytes==0) {
+        numBytes = 1;
+    }
+    void* ptr = 0;
+#if defined(PLB_USE_POSIX) && defined(__linux__) && defined(MADV_HUGEPAGE)
+    global::MemoryPolicy const& policy = global::memoryPolicy();
+    if (policy.isHugePagesOn() && numBytes >= policy.getHugePageThreshold()) {
+        // The memory is aligned on, and rounded up to, full huge pages,
+        //   which can all be backed by huge pages. The advice is only a
+        //   hint, and its failure is not an error.
+        pluint alignedBytes = (numBytes+hugePageSize-1) / hugePageSize * hugePageSize;
+        if (posix_memalign(&ptr, hugePageSize, alignedBytes) != 0) {
+            throw std::bad_alloc();
+        }
+        madvise(ptr, alignedBytes, MADV_HUGEPAGE);
+        return ptr;
+    }
+#endif
+    ptr = malloc(numBytes);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void releaseBlockMemory(void* ptr) {
+    free(ptr);
+}
+
+}  // namespace plb
@@ -0,0 +1,147 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Placement of the memory of the atomic-blocks: first-touch allocation
+ * by the thread which processes a block, huge pages and thread
+ * pinning -- header file.
+ */
+#ifndef MEMORY_POLICY_H
+#define MEMORY_POLICY_H
+
+#include "core/globalDefs.h"
+#include <new>
+
+namespace plb {
+
+namespace global {
+
+/// Global settings for the placement of the data of the atomic-blocks.
+/** On a NUMA machine, a memory page is placed on the node of the thread
+ *  which touches it first. With first-touch allocation, the multi-blocks
+ *  construct (and therefore initialize) their atomic-blocks in the
+ *  shared-memory thread pool, each block on the thread which is proposed
+ *  for it by the thread attribution, without work stealing. Together with
+ *  thread pinning, which prevents the threads from migrating to another
+ *  node, every thread then processes blocks which are stored in its local
+ *  memory.
+ *
+ *  Huge pages (transparent huge pages of 2 MB on Linux) reduce the number
+ *  of TLB misses on the large arrays of the atomic-blocks, such as the
+ *  populations of a lattice. They are requested for arrays above a
+ *  threshold size only.
+ *
+ *  All settings affect the blocks allocated afterwards; thread pinning
+ *  must be set before the number of threads of the pool.
+ */
+class MemoryPolicy {
+public:
+    /// Construct the atomic-blocks on the thread which processes them
+    ///   (default: false).
+    void toggleFirstTouch(bool flag) {
+        firstTouchFlag = flag;
+    }
+    bool isFirstTouchOn() const {
+        return firstTouchFlag;
+    }
+    /// Back the large arrays of the atomic-blocks by huge pages
+    ///   (default: false). Without support by the system, this setting
+    ///   has no effect.
+    void toggleHugePages(bool flag) {
+        hugePagesFlag = flag;
+    }
+    bool isHugePagesOn() const {
+        return hugePagesFlag;
+    }
+    /// Minimum size, in bytes, of an array backed by huge pages
+    ///   (default: 2 MB).
+    void setHugePageThreshold(pluint hugePageThreshold_) {
+        hugePageThreshold = hugePageThreshold_;
+    }
+    pluint getHugePageThreshold() const {
+        return hugePageThreshold;
+    }
+    /// Pin every thread of the shared-memory thread pool to one of the
+    ///   processors available to the MPI process (default: false).
+    void toggleThreadPinning(bool flag) {
+        threadPinningFlag = flag;
+    }
+    bool isThreadPinningOn() const {
+        return threadPinningFlag;
+    }
+private:
+    MemoryPolicy()
+        : firstTouchFlag(false),
+          hugePagesFlag(false),
+          hugePageThreshold(2*1024*1024),
+          threadPinningFlag(false)
+    { }
+private:
+    bool firstTouchFlag;
+    bool hugePagesFlag;
+    pluint hugePageThreshold;
+    bool threadPinningFlag;
+friend MemoryPolicy& memoryPolicy();
+};
+
+inline MemoryPolicy& memoryPolicy() {
+    static MemoryPolicy instance;
+    return instance;
+}
+
+}  // namespace global
+
+/// Allocate uninitialized memory for the data of an atomic-block, following
+///   the memory policy. Throws std::bad_alloc on failure.
+void* allocateBlockMemory(pluint numBytes);
+
+/// Release memory obtained from allocateBlockMemory().
+void releaseBlockMemory(void* ptr);
+
+/// Allocate an array of numElements default-constructed elements, following
+///   the memory policy. Replaces new[] for the data of the atomic-blocks.
+template<typename T>
+T* allocateArray(pluint numElements) {
+    T* array = static_cast<T*>(allocateBlockMemory(numElements*sizeof(T)));
+    for (pluint iElement=0; iElement<numElements; ++iElement) {
+        new (array+iElement) T();
+    }
+    return array;
+}
+
+/// Destroy and release an array obtained from allocateArray().
+template<typename T>
+void releaseArray(T* array, pluint numElements) {
+    if (array) {
+        for (pluint iElement=0; iElement<numElements; ++iElement) {
+            array[iElement].~T();
+        }
+        releaseBlockMemory(array);
+    }
+}
+
+}  // namespace plb
+
+#endif  // MEMORY_POLICY_H
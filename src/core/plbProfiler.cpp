@@ -42,21 +42,32 @@ Profiler::Profiler() {
     validCounters.insert("mpiSendChar");
     validCounters.insert("mpiReceiveChar");
     
-    validTimers.insert("collStream");
-    validTimers.insert("cycle");
-    validTimers.insert("dataProcessor");
-    validTimers.insert("mpiCommunication");
-    validTimers.insert("io");
-    validTimers.insert("totalTime");
+    timers.resize(ProfilerTimer::numTimers);
+    timerScopes.resize(ProfilerTimer::numTimers);
+    registerTimer(ProfilerTimer::collStream, "collStream");
+    registerTimer(ProfilerTimer::cycle, "cycle");
+    registerTimer(ProfilerTimer::dataProcessor, "dataProcessor");
+    registerTimer(ProfilerTimer::envelopeUpdate, "envelope-update");
+    registerTimer(ProfilerTimer::mpiCommunication, "mpiCommunication");
+    registerTimer(ProfilerTimer::io, "io");
+    registerTimer(ProfilerTimer::totalTime, "totalTime");
+}
+
+void Profiler::registerTimer(ProfilerTimer::TimerT timer, std::string const& name) {
+    validTimers[name] = timer;
+    timers[timer] = &plbTimer(name);
+    timerScopes[timer] = hierarchicalProfiler().registerScope(name);
 }
 
 void Profiler::turnOn() {
     profilingFlag = true;
-    start("totalTime");
+    hierarchicalProfiler().turnOn();
+    start(ProfilerTimer::totalTime);
 }
 
 void Profiler::turnOff() {
     profilingFlag = false;
+    hierarchicalProfiler().turnOff();
 }
 
 void Profiler::automaticCycling() {
@@ -121,10 +132,12 @@ void Profiler::addMainProcValue(XMLwriter& writer, std::string name, plint value
 }
 
 
-void Profiler::verifyTimer(std::string const& timer) {
-    if (validTimers.find(timer)==validTimers.end()) {
+ProfilerTimer::TimerT Profiler::verifyTimer(std::string const& timer) {
+    std::map<std::string,ProfilerTimer::TimerT>::const_iterator it = validTimers.find(timer);
+    if (it==validTimers.end()) {
         plbLogicError("Invalid timer for profiling: "+timer);
     }
+    return it->second;
 }
 
 void Profiler::verifyCounter(std::string const& counter) {
@@ -29,13 +29,24 @@
 #include "core/plbTimer.h"
 #include "io/plbFiles.h"
 #include "libraryInterfaces/TINYXML_xmlIO.h"
+#include "core/hierarchicalProfiler.h"
+#include "parallelism/smpThreadPool.h"
 #include <string>
 #include <set>
+#include <map>
+#include <vector>
 
 namespace plb {
 
 namespace global {
 
+/// Integer ids of the timers of the profiler, which are used by the library
+///   in place of the timer names to avoid a look-up at every measurement.
+namespace ProfilerTimer {
+    enum TimerT { collStream=0, cycle, dataProcessor, envelopeUpdate,
+                  mpiCommunication, io, totalTime, numTimers };
+}
+
 /**
  * Counters:
  * =========
@@ -53,6 +64,19 @@ namespace global {
  * "mpiCommunication":               Total Time for MPI communication.
  * "io":                             Time spent for I/O operations.
  * "totalTime":                      Total time.
+ *
+ * Shared-memory threads:
+ * ======================
+ * Timers are only measured on the main thread of the SMP thread pool;
+ * during a parallel region they therefore approximate the wall-clock
+ * time of the region. Counters are incremented by all threads.
+ *
+ * Hierarchy:
+ * ==========
+ * While profiling is on, the timers are also recorded as nested scopes
+ * of the hierarchicalProfiler(), which can additionally time individual
+ * atomic-blocks and data processors, and writes flame graphs, Chrome
+ * traces and load-imbalance summaries.
 **/
 class Profiler {
 public:
@@ -67,28 +91,42 @@ public:
     bool doProfiling() const {
         return profilingFlag;
     }
+    void start(ProfilerTimer::TimerT timer) {
+        if (doProfiling() && smpThreadPool().isMainThread()) {
+            timers[timer]->start();
+            hierarchicalProfiler().enter(timerScopes[timer]);
+        }
+    }
+    void stop(ProfilerTimer::TimerT timer) {
+        if (doProfiling() && smpThreadPool().isMainThread()) {
+            hierarchicalProfiler().leave(timerScopes[timer]);
+            timers[timer]->stop();
+        }
+    }
     void start(char const* timer) {
-        if (doProfiling()) {
-            verifyTimer(timer);
-            plbTimer(timer).start();
+        if (doProfiling() && smpThreadPool().isMainThread()) {
+            start(verifyTimer(timer));
         }
     }
     void stop(char const* timer) {
-        if (doProfiling()) {
-            verifyTimer(timer);
-            plbTimer(timer).stop();
+        if (doProfiling() && smpThreadPool().isMainThread()) {
+            stop(verifyTimer(timer));
         }
     }
     void increment(char const* counter) {
         if (doProfiling()) {
             verifyCounter(counter);
+            smpThreadPool().lock();
             plbCounter(counter).increment();
+            smpThreadPool().unlock();
         }
     }
     void increment(char const* counter, plint value) {
         if (doProfiling()) {
             verifyCounter(counter);
+            smpThreadPool().lock();
             plbCounter(counter).increment(value);
+            smpThreadPool().unlock();
         }
     }
     plint getCounter(char const* counter) {
@@ -102,7 +140,8 @@ public:
     void setReportFile(FileName const& reportFile_);
     void writeReport();
 private:
-    void verifyTimer(std::string const& timer);
+    ProfilerTimer::TimerT verifyTimer(std::string const& timer);
+    void registerTimer(ProfilerTimer::TimerT timer, std::string const& name);
     void verifyCounter(std::string const& counter);
     void addStatisticalValue(XMLwriter& writer, std::string name, double value);
     void addMainProcValue(XMLwriter& writer, std::string name, plint value);
@@ -112,8 +151,10 @@ private:
     bool profilingFlag;
     bool manualCycleFlag;
     FileName reportFile;
-    std::set<std::string> validTimers;
+    std::map<std::string,ProfilerTimer::TimerT> validTimers;
     std::set<std::string> validCounters;
+    std::vector<PlbTimer*> timers;
+    std::vector<plint> timerScopes;
 friend Profiler& profiler();
 };
 
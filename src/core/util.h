@@ -449,6 +449,13 @@ bool fpequal_abs(T x, T y, T eps)
     return fabs(x-y) <= eps;
 }
 
+/// Tell whether objects of type T can be copied byte by byte, with memcpy,
+///   as it is the case for the arithmetic types. By default, this is
+///   assumed for the types for which std::numeric_limits is specialized.
+template<typename T>
+struct IsTriviallyCopyable {
+    static const bool value = std::numeric_limits<T>::is_specialized;
+};
 
 class UniqueId {
 public:
@@ -251,10 +251,12 @@ template<typename T, template<typename U> class Descriptor>
 void InstantiateDynamicsFunctional3D<T,Descriptor>::process (
         Box3D domain, BlockLattice3D<T,Descriptor>& lattice )
 {
+    // Shareable dynamics are instantiated once, and shared by the cells.
+    Dynamics<T,Descriptor>* shared = lattice.getSharedDynamics(*dynamics);
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                lattice.attributeDynamics(iX,iY,iZ, dynamics->clone());
+                lattice.attributeDynamics(iX,iY,iZ, shared ? shared : dynamics->clone());
             }
         }
     }
@@ -318,12 +320,14 @@ template<typename T, template<typename U> class Descriptor>
 void InstantiateComplexDomainDynamicsFunctional3D<T,Descriptor>::process (
         Box3D boundingBox, BlockLattice3D<T,Descriptor>& lattice )
 {
+    // Shareable dynamics are instantiated once, and shared by the cells.
+    Dynamics<T,Descriptor>* shared = lattice.getSharedDynamics(*dynamics);
     Dot3D relativeOffset = lattice.getLocation();
     for (plint iX=boundingBox.x0; iX<=boundingBox.x1; ++iX) {
         for (plint iY=boundingBox.y0; iY<=boundingBox.y1; ++iY) {
             for (plint iZ=boundingBox.z0; iZ<=boundingBox.z1; ++iZ) {
                 if ((*domain)(iX+relativeOffset.x,iY+relativeOffset.y,iZ+relativeOffset.z)) {
-                    lattice.attributeDynamics(iX,iY,iZ, dynamics->clone());
+                    lattice.attributeDynamics(iX,iY,iZ, shared ? shared : dynamics->clone());
                 }
             }
         }
@@ -385,9 +389,11 @@ template<typename T, template<typename U> class Descriptor>
 void InstantiateDotDynamicsFunctional3D<T,Descriptor>::process (
         DotList3D const& dotList, BlockLattice3D<T,Descriptor>& lattice )
 {
+    // Shareable dynamics are instantiated once, and shared by the cells.
+    Dynamics<T,Descriptor>* shared = lattice.getSharedDynamics(*dynamics);
     for (plint iDot=0; iDot<dotList.getN(); ++iDot) {
         Dot3D const& dot = dotList.getDot(iDot);
-        lattice.attributeDynamics(dot.x, dot.y, dot.z, dynamics->clone());
+        lattice.attributeDynamics(dot.x, dot.y, dot.z, shared ? shared : dynamics->clone());
     }
 }
 
@@ -448,13 +454,15 @@ void DynamicsFromMaskFunctional3D<T,Descriptor>::process (
         Box3D domain, BlockLattice3D<T,Descriptor>& lattice,
                       ScalarField3D<bool>& mask )
 {
+    // Shareable dynamics are instantiated once, and shared by the cells.
+    Dynamics<T,Descriptor>* shared = lattice.getSharedDynamics(*dynamics);
     Dot3D offset = computeRelativeDisplacement(lattice, mask);
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
                 bool flag = mask.get(iX+offset.x, iY+offset.y, iZ+offset.z);
                 if ( util::boolIsEqual(flag, whichFlag) ) {
-                    lattice.attributeDynamics(iX,iY,iZ, dynamics->clone());
+                    lattice.attributeDynamics(iX,iY,iZ, shared ? shared : dynamics->clone());
                 }
             }
         }
@@ -518,13 +526,15 @@ void DynamicsFromIntMaskFunctional3D<T,Descriptor>::process (
         Box3D domain, BlockLattice3D<T,Descriptor>& lattice,
                       ScalarField3D<int>& mask )
 {
+    // Shareable dynamics are instantiated once, and shared by the cells.
+    Dynamics<T,Descriptor>* shared = lattice.getSharedDynamics(*dynamics);
     Dot3D offset = computeRelativeDisplacement(lattice, mask);
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
                 int flag = mask.get(iX+offset.x, iY+offset.y, iZ+offset.z);
                 if ( flag == whichFlag ) {
-                    lattice.attributeDynamics(iX,iY,iZ, dynamics->clone());
+                    lattice.attributeDynamics(iX,iY,iZ, shared ? shared : dynamics->clone());
                 }
             }
         }
@@ -654,7 +664,7 @@ void AssignOmegaFunctional3D<T,Descriptor>::process (
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                lattice.get(iX,iY,iZ).getDynamics().setOmega(scaledOmega);
+                lattice.setOmega(iX,iY,iZ, scaledOmega);
             }
         }
     }
@@ -710,7 +720,7 @@ void AssignScalarFieldOmegaFunctional3D<T,Descriptor>::process (
                 T nu_cs2 = (T)1/omega.get(oX,oY,oZ) - (T)1/(T)2;
                 T scaledOmega = (T)1/(scaleFactor*nu_cs2 + (T)1/(T)2);
                 
-                lattice.get(iX,iY,iZ).getDynamics().setOmega(scaledOmega);
+                lattice.setOmega(iX,iY,iZ, scaledOmega);
             }
         }
     }
@@ -0,0 +1,289 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Background thread which encodes and writes serialized data into files,
+ * while the simulation goes on -- implementation file.
+ */
+
+#include "io/asyncOutput.h"
+#include "io/mpiParallelIO.h"
+#include "parallelism/mpiManager.h"
+#include "core/plbDebug.h"
+#include "core/runTimeDiagnostics.h"
+#include <algorithm>
+#include <iostream>
+
+#ifdef PLB_USE_POSIX
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+namespace plb {
+
+namespace global {
+
+AsyncOutputWriter::AsyncOutputWriter()
+    : queueCapacity(2),
+      errorFlag(false)
+#ifdef PLB_USE_POSIX
+      , numPending(0),
+      threadStarted(false),
+      shutDown(false)
+#endif
+{
+#ifdef PLB_USE_POSIX
+    pthread_mutex_init(&mutex, 0);
+    pthread_cond_init(&jobCondition, 0);
+    pthread_cond_init(&doneCondition, 0);
+#endif
+}
+
+AsyncOutputWriter::~AsyncOutputWriter() {
+#ifdef PLB_USE_POSIX
+    if (threadStarted) {
+        // The worker completes the remaining outputs before it stops.
+        pthread_mutex_lock(&mutex);
+        shutDown = true;
+        pthread_cond_signal(&jobCondition);
+        pthread_mutex_unlock(&mutex);
+        pthread_join(thread, 0);
+    }
+    pthread_cond_destroy(&doneCondition);
+    pthread_cond_destroy(&jobCondition);
+    pthread_mutex_destroy(&mutex);
+#endif
+    if (errorFlag) {
+        std::cerr << errorMessage << std::endl;
+    }
+}
+
+void AsyncOutputWriter::setQueueCapacity(plint capacity) {
+    PLB_PRECONDITION( capacity >= 1 );
+    queueCapacity = capacity;
+    while ((plint)recentFiles.size() > queueCapacity) {
+        recentFiles.pop_front();
+    }
+}
+
+plint AsyncOutputWriter::getQueueCapacity() const {
+    return queueCapacity;
+}
+
+void AsyncOutputWriter::writeRawData (
+        FileName fName, std::vector<plint> const& myChunkIds,
+        std::vector<plint> const& offset, std::vector<std::vector<char> >& data,
+        OutputEncoder* encoder )
+{
+    PLB_ASSERT( myChunkIds.size() == data.size() );
+    fName.defaultPath(global::directories().getOutputDir());
+    fName.defaultExt("dat");
+    std::string fileName = fName.get();
+    checkErrors();
+
+    // The processes may lag behind each other by at most queueCapacity
+    //   outputs. A file which is possibly still written by some process
+    //   must be completed everywhere before it is written again.
+    if (std::find(recentFiles.begin(), recentFiles.end(), fileName) != recentFiles.end()) {
+        synchronize();
+    }
+    recentFiles.push_back(fileName);
+    if ((plint)recentFiles.size() > queueCapacity) {
+        recentFiles.pop_front();
+    }
+
+#ifdef PLB_USE_POSIX
+    OutputJob* job = new OutputJob;
+    job->fileName = fileName;
+    job->chunkOffsets.resize(myChunkIds.size());
+    for (pluint iChunk=0; iChunk<myChunkIds.size(); ++iChunk) {
+        plint chunkId = myChunkIds[iChunk];
+        job->chunkOffsets[iChunk] = chunkId==0 ? 0 : offset[chunkId-1];
+    }
+    job->data.swap(data);
+    job->totalSize = offset.empty() ? 0 : offset.back();
+    // The main process cuts the file to its size, in case it overwrites
+    //   a larger file.
+    job->truncate = global::mpi().isMainProcessor();
+    job->encoder = encoder;
+
+    if (!threadStarted) {
+        startThread();
+    }
+    pthread_mutex_lock(&mutex);
+    while (numPending >= queueCapacity) {
+        pthread_cond_wait(&doneCondition, &mutex);
+    }
+    queue.push_back(job);
+    ++numPending;
+    pthread_cond_signal(&jobCondition);
+    pthread_mutex_unlock(&mutex);
+#else
+    if (encoder) {
+        encoder->encode(data);
+        delete encoder;
+    }
+    parallelIO::writeRawData(fName, myChunkIds, offset, data);
+#endif
+}
+
+void AsyncOutputWriter::synchronize() {
+#ifdef PLB_USE_POSIX
+    pthread_mutex_lock(&mutex);
+    while (numPending > 0) {
+        pthread_cond_wait(&doneCondition, &mutex);
+    }
+    pthread_mutex_unlock(&mutex);
+#endif
+    recentFiles.clear();
+    checkErrors();
+}
+
+plint AsyncOutputWriter::getNumPendingOutputs() const {
+#ifdef PLB_USE_POSIX
+    pthread_mutex_lock(&mutex);
+    plint result = numPending;
+    pthread_mutex_unlock(&mutex);
+    return result;
+#else
+    return 0;
+#endif
+}
+
+void AsyncOutputWriter::checkErrors() {
+#ifdef PLB_USE_POSIX
+    pthread_mutex_lock(&mutex);
+#endif
+    bool localError = errorFlag;
+    std::string message = errorMessage;
+    errorFlag = false;
+    errorMessage.clear();
+#ifdef PLB_USE_POSIX
+    pthread_mutex_unlock(&mutex);
+#endif
+    // IMPORTANT: plbIOError synchronizes the processes, so that all of them
+    //   report an error of any of them.
+    plbIOError(localError, std::string("Asynchronous output failed. ")+message);
+}
+
+bool AsyncOutputWriter::writeJob(OutputJob& job, std::string& errorMessage) {
+#ifdef PLB_USE_POSIX
+    if (job.encoder) {
+        job.encoder->encode(job.data);
+    }
+    // The file is created, but not truncated, by whichever process opens
+    //   it first: the other processes may already have written into it.
+    int fd = open(job.fileName.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (fd < 0) {
+        errorMessage = std::string("Could not open file ")+job.fileName;
+        return false;
+    }
+    bool ok = true;
+    for (pluint iChunk=0; iChunk<job.data.size() && ok; ++iChunk) {
+        std::vector<char> const& chunk = job.data[iChunk];
+        plint position = job.chunkOffsets[iChunk];
+        plint written = 0;
+        while (written < (plint)chunk.size()) {
+            ssize_t result = pwrite(fd, &chunk[written], chunk.size()-written, position+written);
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result <= 0) {
+                ok = false;
+                break;
+            }
+            written += result;
+        }
+    }
+    if (ok && job.truncate) {
+        ok = ftruncate(fd, job.totalSize) == 0;
+    }
+    if (close(fd) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        errorMessage = std::string("File access unsuccessful in file ")+job.fileName;
+    }
+    return ok;
+#else
+    return true;
+#endif
+}
+
+#ifdef PLB_USE_POSIX
+
+void AsyncOutputWriter::startThread() {
+    int errCode = pthread_create(&thread, 0, workerEntry, this);
+    plbIOError(errCode != 0, "Could not start the thread for asynchronous output.");
+    threadStarted = true;
+}
+
+void AsyncOutputWriter::workerLoop() {
+    pthread_mutex_lock(&mutex);
+    while (true) {
+        while (queue.empty() && !shutDown) {
+            pthread_cond_wait(&jobCondition, &mutex);
+        }
+        if (queue.empty()) {
+            break;
+        }
+        OutputJob* job = queue.front();
+        queue.pop_front();
+        pthread_mutex_unlock(&mutex);
+
+        std::string message;
+        bool ok = false;
+        try {
+            ok = writeJob(*job, message);
+        }
+        catch (...) {
+            message = std::string("Could not encode the data of file ")+job->fileName;
+        }
+        delete job->encoder;
+        delete job;
+
+        pthread_mutex_lock(&mutex);
+        if (!ok && !errorFlag) {
+            errorFlag = true;
+            errorMessage = message;
+        }
+        --numPending;
+        pthread_cond_broadcast(&doneCondition);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+void* AsyncOutputWriter::workerEntry(void* arg) {
+    static_cast<AsyncOutputWriter*>(arg)->workerLoop();
+    return 0;
+}
+
+#endif  // PLB_USE_POSIX
+
+}  // namespace global
+
+}  // namespace plb
@@ -0,0 +1,131 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Background thread which encodes and writes serialized data into files,
+ * while the simulation goes on -- header file.
+ */
+#ifndef ASYNC_OUTPUT_H
+#define ASYNC_OUTPUT_H
+
+#include "core/globalDefs.h"
+#include "io/plbFiles.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+#ifdef PLB_USE_POSIX
+#include <pthread.h>
+#endif
+
+namespace plb {
+
+/// Transformation of the staged data of an output, executed by the
+///   background thread before the data is written.
+class OutputEncoder {
+public:
+    virtual ~OutputEncoder() { }
+    /// Encode the data chunks in place. The size of the encoded chunks
+    ///   must be the one which was used to compute the file offsets.
+    virtual void encode(std::vector<std::vector<char> >& data) =0;
+};
+
+namespace global {
+
+/// Asynchronous output stage, with one background thread per MPI process.
+/** The data of an output is handed over to the queue of the background
+ *  thread, which encodes it and writes it with plain POSIX file access,
+ *  without any MPI communication. When the queue is full, a new request
+ *  waits until an output is completed (back-pressure). Errors of the
+ *  background thread are reported, on all processes, at the next request
+ *  or at the next call to synchronize().
+ *
+ *  Without PLB_USE_POSIX, the outputs are written immediately.
+ */
+class AsyncOutputWriter {
+public:
+    ~AsyncOutputWriter();
+    /// Maximal number of outputs waiting or being written on a process.
+    void setQueueCapacity(plint capacity);
+    plint getQueueCapacity() const;
+    /// Write the chunks of data into a file, in the background. The chunk
+    ///   myChunkIds[i] is written at position offset[myChunkIds[i]-1] (or 0
+    ///   for the chunk 0), as in parallelIO::writeRawData. The content of
+    ///   data is taken over, and the encoder (which may be null) is deleted
+    ///   after use. Must be called by all processes.
+    void writeRawData( FileName fName, std::vector<plint> const& myChunkIds,
+                       std::vector<plint> const& offset, std::vector<std::vector<char> >& data,
+                       OutputEncoder* encoder=0 );
+    /// Wait until all outputs are written by all processes, and report
+    ///   errors. Must be called by all processes.
+    void synchronize();
+    /// Number of outputs of the current process which are not yet written.
+    plint getNumPendingOutputs() const;
+private:
+    AsyncOutputWriter();
+    struct OutputJob {
+        OutputJob() : totalSize(0), truncate(false), encoder(0) { }
+        std::string fileName;
+        std::vector<plint> chunkOffsets;
+        std::vector<std::vector<char> > data;
+        plint totalSize;
+        bool truncate;
+        OutputEncoder* encoder;
+    };
+    void checkErrors();
+    static bool writeJob(OutputJob& job, std::string& errorMessage);
+#ifdef PLB_USE_POSIX
+    void startThread();
+    void workerLoop();
+    static void* workerEntry(void* arg);
+#endif
+private:
+    plint queueCapacity;
+    /// Names of the last outputs, identical on all processes.
+    std::deque<std::string> recentFiles;
+    bool errorFlag;
+    std::string errorMessage;
+#ifdef PLB_USE_POSIX
+    std::deque<OutputJob*> queue;
+    plint numPending;
+    bool threadStarted;
+    bool shutDown;
+    pthread_t thread;
+    mutable pthread_mutex_t mutex;
+    pthread_cond_t jobCondition;
+    pthread_cond_t doneCondition;
+#endif
+friend AsyncOutputWriter& asyncOutput();
+};
+
+inline AsyncOutputWriter& asyncOutput() {
+    static AsyncOutputWriter instance;
+    return instance;
+}
+
+}  // namespace global
+
+}  // namespace plb
+
+#endif  // ASYNC_OUTPUT_H
@@ -0,0 +1,235 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Lossless compression of the data chunks of a checkpoint, one chunk per
+ * atomic-block -- implementation file.
+ */
+
+#include "io/chunkCompression.h"
+#include "core/plbDebug.h"
+#include "core/runTimeDiagnostics.h"
+#include <cstring>
+
+namespace plb {
+
+namespace parallelIO {
+
+/* *** Layout of a compressed chunk ***
+ *
+ * A header of three unsigned integers of type pluint (codec, size of the
+ * uncompressed data, length in bytes of the period of the data), followed
+ * by the encoded data. For the floatDelta codec, the data is seen as a
+ * sequence of records of one period each (usually one cell), followed by
+ * less than a period of remaining bytes. Every record is XOR-ed with the
+ * previous one, and the result is transposed, so that the bytes at the
+ * same position in all records are contiguous. This byte stream is
+ * run-length encoded as a sequence of (number of zeros, number of literal
+ * bytes, literal bytes), the two counts being stored as variable-length
+ * integers.
+ */
+
+static const pluint chunkHeaderSize = 3*sizeof(pluint);
+
+std::string compressionName(CheckpointCompression::CodecT codec) {
+    switch(codec) {
+        case CheckpointCompression::none: return "none";
+        case CheckpointCompression::floatDelta: return "floatDelta";
+        default: PLB_ASSERT(false);
+    }
+    return "";
+}
+
+CheckpointCompression::CodecT compressionFromName(std::string name) {
+    if (name=="none") {
+        return CheckpointCompression::none;
+    }
+    else if (name=="floatDelta") {
+        return CheckpointCompression::floatDelta;
+    }
+    plbIOError(std::string("Unknown checkpoint compression: ")+name);
+    return CheckpointCompression::none;
+}
+
+static void appendVarint(pluint value, std::vector<char>& out) {
+    while (value >= 0x80) {
+        out.push_back((char)((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+static bool readVarint(std::vector<char> const& in, pluint& pos, pluint& value) {
+    value = 0;
+    for (pluint shift=0; shift<8*sizeof(pluint); shift+=7) {
+        if (pos >= in.size()) {
+            return false;
+        }
+        unsigned char byte = (unsigned char)in[pos++];
+        value |= (pluint)(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Byte transposition of the XOR differences between consecutive records.
+static void deltaTranspose( char const* data, pluint numRecords, pluint period,
+                            std::vector<char>& planes )
+{
+    for (pluint iByte=0; iByte<period; ++iByte) {
+        char* plane = &planes[iByte*numRecords];
+        char previous = 0;
+        for (pluint iRecord=0; iRecord<numRecords; ++iRecord) {
+            char current = data[iRecord*period+iByte];
+            plane[iRecord] = current ^ previous;
+            previous = current;
+        }
+    }
+}
+
+static void inverseDeltaTranspose( char const* planes, pluint numRecords, pluint period,
+                                   char* data )
+{
+    for (pluint iByte=0; iByte<period; ++iByte) {
+        char const* plane = planes + iByte*numRecords;
+        char previous = 0;
+        for (pluint iRecord=0; iRecord<numRecords; ++iRecord) {
+            previous ^= plane[iRecord];
+            data[iRecord*period+iByte] = previous;
+        }
+    }
+}
+
+static void runLengthEncode(std::vector<char> const& in, std::vector<char>& out) {
+    pluint size = in.size();
+    pluint pos = 0;
+    while (pos < size) {
+        pluint zeroBegin = pos;
+        while (pos < size && in[pos]==0) {
+            ++pos;
+        }
+        pluint numZeros = pos-zeroBegin;
+        // A literal sequence ends at the next run of at least three zeros,
+        //   for which a new token is cheaper than the literal bytes.
+        pluint literalBegin = pos;
+        while ( pos < size &&
+                !( in[pos]==0 && pos+2 < size && in[pos+1]==0 && in[pos+2]==0 ) )
+        {
+            ++pos;
+        }
+        appendVarint(numZeros, out);
+        appendVarint(pos-literalBegin, out);
+        out.insert(out.end(), in.begin()+literalBegin, in.begin()+pos);
+    }
+}
+
+static bool runLengthDecode( std::vector<char> const& in, pluint pos,
+                             pluint size, std::vector<char>& out )
+{
+    out.assign(size, 0);
+    pluint outPos = 0;
+    while (outPos < size) {
+        pluint numZeros, numLiterals;
+        if (!readVarint(in, pos, numZeros) || !readVarint(in, pos, numLiterals)) {
+            return false;
+        }
+        outPos += numZeros;
+        if (outPos+numLiterals > size || pos+numLiterals > in.size()) {
+            return false;
+        }
+        if (numLiterals>0) {
+            memcpy(&out[outPos], &in[pos], numLiterals);
+        }
+        outPos += numLiterals;
+        pos += numLiterals;
+    }
+    return outPos==size && pos==in.size();
+}
+
+void compressChunk( CheckpointCompression::CodecT codec, plint numCells,
+                    std::vector<char>& data )
+{
+    PLB_PRECONDITION( codec == CheckpointCompression::floatDelta );
+    pluint size = data.size();
+    // The period is the size of a cell if all cells have the same size
+    //   (which is the case with a single dynamics class), and otherwise
+    //   the size of a floating-point value.
+    pluint period = sizeof(double);
+    if (numCells>0 && size>0 && size%(pluint)numCells==0) {
+        period = size/(pluint)numCells;
+    }
+    pluint numRecords = size/period;
+    pluint tail = size - numRecords*period;
+
+    std::vector<char> planes(size);
+    if (numRecords>0) {
+        deltaTranspose(&data[0], numRecords, period, planes);
+    }
+    if (tail>0) {
+        memcpy(&planes[numRecords*period], &data[numRecords*period], tail);
+    }
+
+    std::vector<char> compressed(chunkHeaderSize);
+    pluint header[3] = { (pluint)codec, size, period };
+    memcpy(&compressed[0], header, chunkHeaderSize);
+    compressed.reserve(chunkHeaderSize + size/2);
+    runLengthEncode(planes, compressed);
+    compressed.swap(data);
+}
+
+bool decompressChunk(std::vector<char>& data) {
+    if (data.size() < chunkHeaderSize) {
+        return false;
+    }
+    pluint header[3];
+    memcpy(header, &data[0], chunkHeaderSize);
+    pluint codec = header[0];
+    pluint size = header[1];
+    pluint period = header[2];
+    if (codec != (pluint)CheckpointCompression::floatDelta || period==0) {
+        return false;
+    }
+
+    std::vector<char> planes;
+    if (!runLengthDecode(data, chunkHeaderSize, size, planes)) {
+        return false;
+    }
+    pluint numRecords = size/period;
+    pluint tail = size - numRecords*period;
+    std::vector<char> uncompressed(size);
+    if (numRecords>0) {
+        inverseDeltaTranspose(&planes[0], numRecords, period, &uncompressed[0]);
+    }
+    if (tail>0) {
+        memcpy(&uncompressed[numRecords*period], &planes[numRecords*period], tail);
+    }
+    uncompressed.swap(data);
+    return true;
+}
+
+}  // namespace parallelIO
+
+}  // namespace plb
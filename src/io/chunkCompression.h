@@ -0,0 +1,61 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Lossless compression of the data chunks of a checkpoint, one chunk per
+ * atomic-block -- header file.
+ */
+#ifndef CHUNK_COMPRESSION_H
+#define CHUNK_COMPRESSION_H
+
+#include "core/globalDefs.h"
+#include <string>
+#include <vector>
+
+namespace plb {
+
+namespace parallelIO {
+
+/// Name of a codec, as it is written into the XML specification of a checkpoint.
+std::string compressionName(CheckpointCompression::CodecT codec);
+
+/// Codec corresponding to a name of the XML specification; throws a
+///   PlbIOException if the name is unknown.
+CheckpointCompression::CodecT compressionFromName(std::string name);
+
+/// Compress, in place, the serialized data of an atomic-block made of
+///   numCells cells. The compressed chunk is self-contained: it can be
+///   decompressed without any other information.
+void compressChunk( CheckpointCompression::CodecT codec, plint numCells,
+                    std::vector<char>& data );
+
+/// Restore, in place, the data of a chunk produced by compressChunk.
+///   Returns false if the chunk is corrupt.
+bool decompressChunk(std::vector<char>& data);
+
+}  // namespace parallelIO
+
+}  // namespace plb
+
+#endif  // CHUNK_COMPRESSION_H
@@ -38,3 +38,5 @@
 #include "io/plbFiles.h"
 #include "io/multiBlockReader3D.h"
 #include "io/multiBlockWriter3D.h"
+#include "io/asyncOutput.h"
+#include "io/chunkCompression.h"
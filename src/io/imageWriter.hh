@@ -123,11 +123,11 @@ void ImageWriter<T>::writePpm (
         MultiScalarField2D<T>& field,
         T minVal, T maxVal) const
 {
-    global::profiler().start("io");
+    global::profiler().start(global::ProfilerTimer::io);
     ScalarField2D<T> localField(field.getNx(), field.getNy());
     copySerializedBlock(field, localField);
     writePpmImplementation(fName, localField, minVal, maxVal);
-    global::profiler().stop("io");
+    global::profiler().stop(global::ProfilerTimer::io);
 }
 
 template<typename T>
@@ -390,7 +390,7 @@ template<typename T>
 void ImageWriter<T>::imageMagickResize( std::string const& fName,
                                         plint sizeX, plint sizeY) const
 {
-    global::profiler().start("io");
+    global::profiler().start(global::ProfilerTimer::io);
 #ifdef PLB_USE_POSIX
     if (global::mpi().isMainProcessor()) {
         std::stringstream imStream;
@@ -410,7 +410,7 @@ void ImageWriter<T>::imageMagickResize( std::string const& fName,
         if (errorRm != 0) plbWarning("Error in removing temporary ppm file.");
     }
 #endif  // PLB_USE_POSIX
-    global::profiler().stop("io");
+    global::profiler().stop(global::ProfilerTimer::io);
 }
 
 }  // namespace plb
@@ -29,6 +29,8 @@
 #include "core/globalDefs.h"
 #include "io/multiBlockReader3D.h"
 #include "io/mpiParallelIO.h"
+#include "io/asyncOutput.h"
+#include "io/chunkCompression.h"
 #include "parallelism/mpiManager.h"
 #include "libraryInterfaces/TINYXML_xmlIO.h"
 #include "libraryInterfaces/TINYXML_xmlIO.hh"
@@ -211,8 +213,87 @@ void readXmlSpec (
     }
 }
 
+/// Codec of the data of a checkpoint; checkpoints without this information
+///   are uncompressed.
+static CheckpointCompression::CodecT readXmlCompression(FileName fName)
+{
+    fName.defaultPath(global::directories().getInputDir());
+    fName.defaultExt("plb");
+    XMLreader reader(fName);
+    std::string codecName;
+    try {
+        reader["Block3D"]["Data"]["Compression"].read(codecName);
+    }
+    catch(PlbIOException const&) {
+        return CheckpointCompression::none;
+    }
+    return compressionFromName(codecName);
+}
+
+/// Base checkpoint referenced by an incremental checkpoint, and the content
+///   hash of its dynamics objects. Returns false for a regular checkpoint.
+static bool readXmlDynamicsBase(FileName fName, FileName& base_fName, std::string& dynamicsHash)
+{
+    fName.defaultPath(global::directories().getInputDir());
+    fName.defaultExt("plb");
+    XMLreader reader(fName);
+    std::string base_fName_str;
+    try {
+        reader["Block3D"]["Data"]["DynamicsBase"].read(base_fName_str);
+    }
+    catch(PlbIOException const&) {
+        return false;
+    }
+    reader["Block3D"]["Data"]["DynamicsHash"].read(dynamicsHash);
+    // As for the data file, a base without path specification is taken
+    //   to be in the same directory as the xml file.
+    base_fName = FileName(base_fName_str).defaultPath(fName.getPath());
+    base_fName.defaultExt("plb");
+    return true;
+}
+
+/// Verify that the base of an incremental checkpoint is the one with which
+///   it was written, and has the same block structure.
+static void checkDynamicsBase( MultiBlock3D& baseBlock, FileName base_fName,
+                               std::string const& dynamicsHash,
+                               std::vector<Box3D> const& components )
+{
+    XMLreader reader(base_fName);
+    std::string baseHash;
+    try {
+        reader["Block3D"]["Data"]["DynamicsHash"].read(baseHash);
+    }
+    catch(PlbIOException const&) { }
+    plbIOError( baseHash != dynamicsHash,
+                std::string("The base checkpoint ")+base_fName.get()+
+                " has been overwritten since the incremental checkpoint was written." );
+    std::map<plint,Box3D> const& bulks =
+        baseBlock.getMultiBlockManagement().getSparseBlockStructure().getBulks();
+    bool sameStructure = bulks.size()==components.size();
+    std::map<plint,Box3D>::const_iterator it = bulks.begin();
+    for (pluint iComp=0; sameStructure && iComp<components.size(); ++iComp, ++it) {
+        sameStructure = Box3D(it->second) == components[iComp];
+    }
+    plbIOError(!sameStructure, "Block structures of an incremental checkpoint and of its base differ.");
+}
+
+/// Decompress the chunks of the local atomic-blocks. As every chunk is
+///   self-contained, the chunks of the other atomic-blocks are not needed.
+static void decompressData(std::vector<std::vector<char> >& data)
+{
+    bool corruptData = false;
+    for (pluint iBlock=0; iBlock<data.size(); ++iBlock) {
+        if (!decompressChunk(data[iBlock])) {
+            corruptData = true;
+        }
+    }
+    plbIOError(corruptData, "Corrupt compressed data in checkpoint.");
+}
+
 MultiBlock3D* load3D(FileName fName)
 {
+    // The file may still be written by the asynchronous output.
+    global::asyncOutput().synchronize();
     Box3D boundingBox;
     std::vector<plint> offsets;
     plint envelopeWidth, gridLevel;
@@ -223,6 +304,24 @@ MultiBlock3D* load3D(FileName fName)
     readXmlSpec( fName, boundingBox, offsets, envelopeWidth, gridLevel, dataType,
                  descriptor, family, components, dynamicContent, data_fName );
 
+    FileName base_fName;
+    std::string dynamicsHash;
+    if (readXmlDynamicsBase(fName, base_fName, dynamicsHash)) {
+        // Incremental checkpoint: the dynamics objects are restored from the
+        //   base checkpoint, and the static content from the current one.
+        MultiBlock3D* newBlock = load3D(base_fName);
+        checkDynamicsBase(*newBlock, base_fName, dynamicsHash, components);
+        std::vector<plint> const& myBlockIds =
+            newBlock->getMultiBlockManagement().getLocalInfo().getBlocks();
+        std::vector<std::vector<char> > data(myBlockIds.size());
+        loadRawData( data_fName, myBlockIds, offsets, data);
+        if (readXmlCompression(fName) != CheckpointCompression::none) {
+            decompressData(data);
+        }
+        dumpRestoreData(*newBlock, false, myBlockIds, data, std::map<int,std::string>());
+        return newBlock;
+    }
+
     SparseBlockStructure3D blockStructure(boundingBox);
     for( plint iComponent=0; iComponent<(plint)components.size(); ++iComponent) {
         blockStructure.addBlock(components[iComponent], iComponent);
@@ -251,6 +350,9 @@ MultiBlock3D* load3D(FileName fName)
     PLB_ASSERT( newBlock );
     std::vector<std::vector<char> > data(myBlockIds.size());
     loadRawData( data_fName, myBlockIds, offsets, data);
+    if (readXmlCompression(fName) != CheckpointCompression::none) {
+        decompressData(data);
+    }
     std::map<int,std::string> foreignIds;
     createDynamicsForeignIds3D(fName, foreignIds);
     dumpRestoreData(*newBlock, dynamicContent, myBlockIds, data, foreignIds);
@@ -197,7 +197,7 @@ void transposeToBackward(plint sizeOfCell, Box2D const& domain, std::vector<char
 
 void save( MultiBlock2D& multiBlock, FileName fName, bool dynamicContent )
 {
-    global::profiler().start("io");
+    global::profiler().start(global::ProfilerTimer::io);
     std::vector<plint> offset;
     std::vector<plint> myBlockIds;
     std::vector<std::vector<char> > data;
@@ -206,12 +206,12 @@ void save( MultiBlock2D& multiBlock, FileName fName, bool dynamicContent )
 
     writeXmlSpec(multiBlock, fName, offset, dynamicContent);
     writeRawData(fName, myBlockIds, offset, data);
-    global::profiler().stop("io");
+    global::profiler().stop(global::ProfilerTimer::io);
 }
 
 void saveFull( MultiBlock2D& multiBlock, FileName fName, IndexOrdering::OrderingT ordering )
 {
-    global::profiler().start("io");
+    global::profiler().start(global::ProfilerTimer::io);
     SparseBlockStructure2D blockStructure(multiBlock.getBoundingBox());
     Box2D bbox = multiBlock.getBoundingBox();
     if (ordering==IndexOrdering::forward) {
@@ -263,7 +263,7 @@ void saveFull( MultiBlock2D& multiBlock, FileName fName, IndexOrdering::Ordering
     writeOneBlockXmlSpec(*multiAdjacentBlock, fName, totalSize, ordering);
     writeRawData(fName, myBlockIds, offset, data);
     delete multiAdjacentBlock;
-    global::profiler().stop("io");
+    global::profiler().stop(global::ProfilerTimer::io);
 }
 
 void dumpData( MultiBlock2D& multiBlock, bool dynamicContent,
@@ -30,6 +30,8 @@
 #include "parallelism/mpiManager.h"
 #include "io/multiBlockWriter3D.h"
 #include "io/mpiParallelIO.h"
+#include "io/asyncOutput.h"
+#include "io/chunkCompression.h"
 #include "libraryInterfaces/TINYXML_xmlIO.h"
 #include "libraryInterfaces/TINYXML_xmlIO.hh"
 #include "core/util.h"
@@ -41,6 +43,8 @@
 #include "multiBlock/multiBlockOperations3D.h"
 #include "io/plbFiles.h"
 #include <numeric>
+#include <iomanip>
+#include <sstream>
 #include <algorithm>
 #include <memory>
 
@@ -51,7 +55,10 @@ namespace parallelIO {
 /***** 1. Multi-Block Writer **************************************************/
 
 void writeXmlSpec( MultiBlock3D& multiBlock, FileName fName,
-                   std::vector<plint> const& offset, bool dynamicContent )
+                   std::vector<plint> const& offset, bool dynamicContent,
+                   CheckpointCompression::CodecT codec,
+                   std::vector<plint> const& uncompressedSize,
+                   std::string const& dynamicsHash, std::string const& dynamicsBase )
 {
     fName.defaultExt("plb");
     MultiBlockManagement3D const& management = multiBlock.getMultiBlockManagement();
@@ -91,6 +98,17 @@ void writeXmlSpec( MultiBlock3D& multiBlock, FileName fName,
     if (!offset.empty()) {
         xmlMultiBlock["Data"]["Offsets"].set(offset);
     }
+    if (codec != CheckpointCompression::none) {
+        PLB_ASSERT( uncompressedSize.size()==offset.size() );
+        xmlMultiBlock["Data"]["Compression"].setString(compressionName(codec));
+        xmlMultiBlock["Data"]["UncompressedSizes"].set(uncompressedSize);
+    }
+    if (!dynamicsHash.empty()) {
+        xmlMultiBlock["Data"]["DynamicsHash"].setString(dynamicsHash);
+    }
+    if (!dynamicsBase.empty()) {
+        xmlMultiBlock["Data"]["DynamicsBase"].setString(dynamicsBase);
+    }
 
     // The following prints a unique list of dynamics-id pairs for all dynamics
     //   classes used in the multi-block. This is necessary, because dynamics
@@ -198,23 +216,124 @@ void transposeToBackward(plint sizeOfCell, Box3D const& domain, std::vector<char
     transp.swap(data);
 }
 
-void save( MultiBlock3D& multiBlock, FileName fName, bool dynamicContent )
+/// Write the XML specification and the data of a checkpoint, with the
+///   compression of the current IO policy.
+static void writeCheckpoint( MultiBlock3D& multiBlock, FileName fName, bool dynamicContent,
+                             bool asynchronous, std::string const& dynamicsHash = std::string(),
+                             std::string const& dynamicsBase = std::string() )
 {
-    global::profiler().start("io");
     std::vector<plint> offset;
     std::vector<plint> myBlockIds;
     std::vector<std::vector<char> > data;
 
     dumpData(multiBlock, dynamicContent, offset, myBlockIds, data);
+    CheckpointCompression::CodecT codec = global::IOpolicy().getCheckpointCompression();
+    std::vector<plint> uncompressedSize;
+    compressData(multiBlock, codec, offset, myBlockIds, data, uncompressedSize);
+
+    writeXmlSpec( multiBlock, fName, offset, dynamicContent, codec, uncompressedSize,
+                  dynamicsHash, dynamicsBase );
+    if (asynchronous) {
+        global::asyncOutput().writeRawData(fName, myBlockIds, offset, data);
+    }
+    else {
+        writeRawData(fName, myBlockIds, offset, data);
+    }
+}
 
-    writeXmlSpec(multiBlock, fName, offset, dynamicContent);
-    writeRawData(fName, myBlockIds, offset, data);
-    global::profiler().stop("io");
+/// Content hash of the base checkpoints written by saveIncremental during
+///   this run, indexed by the full name of the base file.
+static std::map<std::string,std::string>& savedDynamicsBases() {
+    static std::map<std::string,std::string> bases;
+    return bases;
+}
+
+/// 64-bit FNV-1a hash.
+static void hashBytes(char const* bytes, pluint numBytes, pluint& hash) {
+    for (pluint iByte=0; iByte<numBytes; ++iByte) {
+        hash ^= (pluint)(unsigned char)bytes[iByte];
+        hash *= (pluint)1099511628211ULL;
+    }
+}
+
+void save( MultiBlock3D& multiBlock, FileName fName, bool dynamicContent )
+{
+    global::profiler().start(global::ProfilerTimer::io);
+    writeCheckpoint(multiBlock, fName, dynamicContent, false);
+    global::profiler().stop(global::ProfilerTimer::io);
+}
+
+void saveAsync( MultiBlock3D& multiBlock, FileName fName, bool dynamicContent )
+{
+    global::profiler().start(global::ProfilerTimer::io);
+    writeCheckpoint(multiBlock, fName, dynamicContent, true);
+    global::profiler().stop(global::ProfilerTimer::io);
+}
+
+std::string computeDynamicsHash(MultiBlock3D& multiBlock)
+{
+    MultiBlockManagement3D const& management = multiBlock.getMultiBlockManagement();
+    std::map<plint,Box3D> const& bulks = management.getSparseBlockStructure().getBulks();
+    std::vector<plint> const& myBlocks = management.getLocalInfo().getBlocks();
+    pluint const fnvOffsetBasis = (pluint)14695981039346656037ULL;
+
+    // The hash of every atomic-block is computed by the process which owns
+    //   it; the other processes contribute zero to the sum.
+    std::vector<plint> blockHash(bulks.size());
+    std::fill(blockHash.begin(), blockHash.end(), 0);
+    std::vector<char> data;
+    for (pluint iBlock=0; iBlock<myBlocks.size(); ++iBlock) {
+        plint blockId = myBlocks[iBlock];
+        SmartBulk3D bulk(management, blockId);
+        Box3D localBulk(bulk.toLocal(bulk.getBulk()));
+        multiBlock.getComponent(blockId).getDataTransfer().send(localBulk, data, modif::dynamicVariables);
+        pluint hash = fnvOffsetBasis;
+        hashBytes(data.empty() ? 0 : &data[0], data.size(), hash);
+        plint contiguousId = (plint)std::distance(bulks.begin(), bulks.find(blockId));
+        blockHash[contiguousId] = (plint)hash;
+    }
+#ifdef PLB_MPI_PARALLEL
+    global::mpi().allReduceVect(blockHash, MPI_SUM);
+#endif
+
+    pluint hash = fnvOffsetBasis;
+    std::map<plint,Box3D>::const_iterator it = bulks.begin();
+    plint contiguousId = 0;
+    for (; it != bulks.end(); ++it, ++contiguousId) {
+        Array<plint,6> bulk = it->second.to_plbArray();
+        hashBytes((char const*)&bulk[0], 6*sizeof(plint), hash);
+        hashBytes((char const*)&blockHash[contiguousId], sizeof(plint), hash);
+    }
+    std::ostringstream hashString;
+    hashString << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return hashString.str();
+}
+
+void saveIncremental( MultiBlock3D& multiBlock, FileName fName, FileName baseName )
+{
+    std::map<std::string,int> dynamicsDict;
+    multiBlock.getDynamicsDict(multiBlock.getBoundingBox(), dynamicsDict);
+    if (dynamicsDict.empty()) {
+        // Without dynamics objects, the dynamic content is the static one.
+        save(multiBlock, fName, false);
+        return;
+    }
+    global::profiler().start(global::ProfilerTimer::io);
+    std::string hash = computeDynamicsHash(multiBlock);
+    std::string baseKey =
+        FileName(baseName).defaultPath(global::directories().getOutputDir()).defaultExt("plb").get();
+    std::string& savedHash = savedDynamicsBases()[baseKey];
+    if (savedHash != hash) {
+        writeCheckpoint(multiBlock, baseName, true, false, hash);
+        savedHash = hash;
+    }
+    writeCheckpoint(multiBlock, fName, false, false, hash, baseName.get());
+    global::profiler().stop(global::ProfilerTimer::io);
 }
 
 void saveFull( MultiBlock3D& multiBlock, FileName fName, IndexOrdering::OrderingT ordering )
 {
-    global::profiler().start("io");
+    global::profiler().start(global::ProfilerTimer::io);
     SparseBlockStructure3D blockStructure(multiBlock.getBoundingBox());
     Box3D bbox = multiBlock.getBoundingBox();
     if (ordering==IndexOrdering::forward) {
@@ -267,7 +386,7 @@ void saveFull( MultiBlock3D& multiBlock, FileName fName, IndexOrdering::Ordering
     writeOneBlockXmlSpec(*multiAdjacentBlock, fName, totalSize, ordering);
     writeRawData(fName, myBlockIds, offset, data);
     delete multiAdjacentBlock;
-    global::profiler().stop("io");
+    global::profiler().stop(global::ProfilerTimer::io);
 }
 
 void dumpData( MultiBlock3D& multiBlock, bool dynamicContent,
@@ -309,6 +428,42 @@ void dumpData( MultiBlock3D& multiBlock, bool dynamicContent,
     std::partial_sum(blockSize.begin(), blockSize.end(), offset.begin());
 }
 
+void compressData( MultiBlock3D& multiBlock, CheckpointCompression::CodecT codec,
+                   std::vector<plint>& offset, std::vector<plint> const& myBlockIds,
+                   std::vector<std::vector<char> >& data, std::vector<plint>& uncompressedSize )
+{
+    uncompressedSize.clear();
+    if (codec == CheckpointCompression::none) {
+        return;
+    }
+    std::map<plint,Box3D> const& bulks =
+        multiBlock.getMultiBlockManagement().getSparseBlockStructure().getBulks();
+    plint numBlocks = (plint) bulks.size();
+    PLB_ASSERT( (plint)offset.size() == numBlocks );
+    // The ids of dumpData are contiguous, in increasing order of the original ids.
+    std::vector<plint> numCells;
+    numCells.reserve(numBlocks);
+    std::map<plint,Box3D>::const_iterator it = bulks.begin();
+    for (; it != bulks.end(); ++it) {
+        numCells.push_back(it->second.nCells());
+    }
+
+    uncompressedSize.resize(numBlocks);
+    std::adjacent_difference(offset.begin(), offset.end(), uncompressedSize.begin());
+
+    std::vector<plint> blockSize(numBlocks);
+    std::fill(blockSize.begin(), blockSize.end(), 0);
+    for (pluint iBlock=0; iBlock<myBlockIds.size(); ++iBlock) {
+        plint contiguousId = myBlockIds[iBlock];
+        compressChunk(codec, numCells[contiguousId], data[iBlock]);
+        blockSize[contiguousId] = (plint)data[iBlock].size();
+    }
+#ifdef PLB_MPI_PARALLEL
+    global::mpi().allReduceVect(blockSize, MPI_SUM);
+#endif
+    std::partial_sum(blockSize.begin(), blockSize.end(), offset.begin());
+}
+
 }  // namespace parallelIO
 
 }  // namespace plb
@@ -39,9 +39,27 @@ namespace plb {
 
 namespace parallelIO {
 
+/// Save a multi-block into a checkpoint (XML specification and raw data).
+///   The data is compressed according to global::IOpolicy().getCheckpointCompression().
 void save( MultiBlock3D& multiBlock, FileName fName,
            bool dynamicContent = true );
 
+/// Same as save, but the data is written to disk by the background thread
+///   of global::asyncOutput(), while the simulation goes on. The XML
+///   specification is written immediately. The data is copied before the
+///   function returns, so that the multi-block can be modified right away.
+void saveAsync( MultiBlock3D& multiBlock, FileName fName,
+                bool dynamicContent = true );
+
+/// Incremental checkpoint, in which the dynamics objects are written only
+///   when they have changed. The file baseName receives a full checkpoint
+///   (dynamic content included) the first time, and whenever the content
+///   hash of the dynamics objects differs from the one of the last base
+///   written during this run. The file fName receives only the static
+///   content (populations and external fields), and references the base
+///   and its hash. parallelIO::load reads both files.
+void saveIncremental( MultiBlock3D& multiBlock, FileName fName, FileName baseName );
+
 void saveFull( MultiBlock3D& multiBlock, FileName fName,
                IndexOrdering::OrderingT=IndexOrdering::forward );
 
@@ -60,8 +78,29 @@ void dumpData( MultiBlock3D& multiBlock, bool dynamicContent,
                std::vector<plint>& offset, std::vector<plint>& myBlockIds,
                std::vector<std::vector<char> >& data );
 
+/** Compress the data produced by dumpData, every atomic-block independently,
+ *  and recompute the offsets accordingly. This function must be called
+ *  by all processes. It has no effect if the codec is CheckpointCompression::none.
+ *  @var uncompressedSize: Size, in bytes, of the uncompressed data of
+ *                         every atomic-block.
+ **/
+void compressData( MultiBlock3D& multiBlock, CheckpointCompression::CodecT codec,
+                   std::vector<plint>& offset, std::vector<plint> const& myBlockIds,
+                   std::vector<std::vector<char> >& data, std::vector<plint>& uncompressedSize );
+
+/// Write the XML specification of a checkpoint. The offsets constitute
+///   the chunk index of the data file. For compressed data, the codec and
+///   the uncompressed size of every chunk are recorded as well.
 void writeXmlSpec( MultiBlock3D& multiBlock, FileName fName,
-                   std::vector<plint> const& offset, bool dynamicContent );
+                   std::vector<plint> const& offset, bool dynamicContent,
+                   CheckpointCompression::CodecT codec = CheckpointCompression::none,
+                   std::vector<plint> const& uncompressedSize = std::vector<plint>(),
+                   std::string const& dynamicsHash = std::string(),
+                   std::string const& dynamicsBase = std::string() );
+
+/// Content hash of the dynamics objects and of the block structure of a
+///   multi-block, as a hexadecimal string. Must be called by all processes.
+std::string computeDynamicsHash(MultiBlock3D& multiBlock);
 
 }  // namespace parallelIO
 
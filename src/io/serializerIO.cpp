@@ -103,9 +103,9 @@ void Base64Writer::writeHeader(pluint dataSize) {
 
 void Base64Writer::writeData(char const* dataBuffer, pluint bufferSize)
 {
-    global::profiler().start("io");
+    global::profiler().start(global::ProfilerTimer::io);
     dataEncoder->encode(dataBuffer, bufferSize);
-    global::profiler().stop("io");
+    global::profiler().stop(global::ProfilerTimer::io);
 }
 
 
@@ -177,9 +177,9 @@ void Base64Reader::readHeader(pluint dataSize) const {
 
 void Base64Reader::readData(char* dataBuffer, pluint bufferSize) const
 {
-    global::profiler().start("io");
+    global::profiler().start(global::ProfilerTimer::io);
     dataDecoder->decode(dataBuffer, bufferSize);
-    global::profiler().stop("io");
+    global::profiler().stop(global::ProfilerTimer::io);
 }
 
 
@@ -31,6 +31,14 @@
 #include "io/serializerIO.h"
 #include "io/base64.h"
 #include "io/base64.hh"
+#include "io/mpiParallelIO.h"
+#include "io/asyncOutput.h"
+#include "io/plbFiles.h"
+#include "multiBlock/multiBlockManagement3D.h"
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <numeric>
 
 namespace plb {
     
@@ -97,6 +105,222 @@ void VtkDataWriter3D::writeFooter() {
     }
 }
 
+////////// class ParallelVtkDataWriter3D ////////////////////////////////
+
+/// Copy the data of a block from the Palabos ordering (z-index varying
+///   fastest) to the VTK ordering (x-index varying fastest), preceded by
+///   the size of the data in bytes.
+static void toVtkOrdering( plint sizeOfCell, Box3D const& domain,
+                           std::vector<char> const& data, std::vector<char>& vtkData )
+{
+    plint nx = domain.getNx();
+    plint ny = domain.getNy();
+    plint nz = domain.getNz();
+    PLB_ASSERT( (plint)data.size() == sizeOfCell*nx*ny*nz );
+    pluint numBytes = data.size();
+    vtkData.resize(sizeof(pluint)+data.size());
+    memcpy(&vtkData[0], &numBytes, sizeof(pluint));
+    char* vtkCells = &vtkData[sizeof(pluint)];
+    for (plint iX=0; iX<nx; ++iX) {
+        for (plint iY=0; iY<ny; ++iY) {
+            for (plint iZ=0; iZ<nz; ++iZ) {
+                plint iForward = sizeOfCell*(iZ + nz*(iY + ny*iX));
+                plint iBackward = sizeOfCell*(iX + nx*(iY + ny*iZ));
+                memcpy(vtkCells+iBackward, &data[iForward], sizeOfCell);
+            }
+        }
+    }
+}
+
+/// Conversion of the data chunks of a file to the VTK ordering, executed
+///   either immediately or by the asynchronous output thread. Chunks with
+///   a cell size of zero (the XML header and footer) are left unchanged.
+class VtkOrderingEncoder : public OutputEncoder {
+public:
+    void addChunk(plint sizeOfCell, Box3D const& domain) {
+        sizeOfCells.push_back(sizeOfCell);
+        domains.push_back(domain);
+    }
+    virtual void encode(std::vector<std::vector<char> >& data) {
+        PLB_ASSERT( data.size() == sizeOfCells.size() );
+        std::vector<char> vtkData;
+        for (pluint iChunk=0; iChunk<data.size(); ++iChunk) {
+            if (sizeOfCells[iChunk]>0) {
+                toVtkOrdering(sizeOfCells[iChunk], domains[iChunk], data[iChunk], vtkData);
+                data[iChunk].swap(vtkData);
+            }
+        }
+    }
+private:
+    std::vector<plint> sizeOfCells;
+    std::vector<Box3D> domains;
+};
+
+ParallelVtkDataWriter3D::ParallelVtkDataWriter3D(std::string const& fileName_)
+    : fileName(fileName_),
+      asynchronousOutput(false)
+{ }
+
+void ParallelVtkDataWriter3D::toggleAsynchronousOutput(bool flag) {
+    asynchronousOutput = flag;
+}
+
+bool ParallelVtkDataWriter3D::isAsynchronousOutputOn() const {
+    return asynchronousOutput;
+}
+
+void ParallelVtkDataWriter3D::addDataField (
+        MultiBlock3D& multiBlock, std::string const& typeName,
+        std::string const& name, plint nDim )
+{
+    MultiBlockManagement3D const& management = multiBlock.getMultiBlockManagement();
+    std::map<plint,Box3D> const& bulks = management.getSparseBlockStructure().getBulks();
+    std::vector<plint> const& myBlocks = management.getLocalInfo().getBlocks();
+    if (fields.empty()) {
+        pieces = bulks;
+        localBlocks = myBlocks;
+    }
+    else {
+        PLB_PRECONDITION( pieces == bulks );
+        PLB_PRECONDITION( localBlocks == myBlocks );
+    }
+    localDomains.resize(localBlocks.size());
+    fields.push_back(DataField());
+    DataField& field = fields.back();
+    field.name = name;
+    field.typeName = typeName;
+    field.nDim = nDim;
+    field.sizeOfCell = multiBlock.sizeOfCell();
+    field.localData.resize(localBlocks.size());
+    for (pluint iBlock=0; iBlock<localBlocks.size(); ++iBlock) {
+        plint blockId = localBlocks[iBlock];
+        SmartBulk3D bulk(management, blockId);
+        localDomains[iBlock] = bulk.toLocal(bulk.getBulk());
+        multiBlock.getComponent(blockId).getDataTransfer().send (
+                localDomains[iBlock], field.localData[iBlock], modif::staticVariables );
+    }
+}
+
+bool ParallelVtkDataWriter3D::hasData() const {
+    return !fields.empty();
+}
+
+void ParallelVtkDataWriter3D::write(Box3D domain, Array<double,3> origin, double deltaX)
+{
+    plint numPieces = (plint)pieces.size();
+    plint numFields = (plint)fields.size();
+
+    // The file is made of chunks: the XML header, the data arrays of all
+    //   pieces (piece by piece in increasing order of the block ids, and
+    //   field by field within a piece), and the XML footer. As the block
+    //   structure is known to all processes, every process computes the
+    //   offsets of all chunks without communication.
+    plint numChunks = numPieces*numFields + 2;
+    std::vector<plint> chunkSize(numChunks);
+    std::map<plint,plint> toContiguousId;
+    plint iPiece = 0;
+    std::map<plint,Box3D>::const_iterator it = pieces.begin();
+    for (; it != pieces.end(); ++it, ++iPiece) {
+        toContiguousId[it->first] = iPiece;
+        for (plint iField=0; iField<numFields; ++iField) {
+            chunkSize[1+iPiece*numFields+iField] =
+                (plint)sizeof(pluint) + it->second.nCells()*fields[iField].sizeOfCell;
+        }
+    }
+
+    // Node values are written as cell data, so that the pieces can share
+    //   their boundaries. The origin is shifted by half a cell to keep
+    //   the nodes at the same place as in VtkImageOutput3D.
+    std::ostringstream header;
+    header << "<?xml version=\"1.0\"?>\n";
+    header << "<VTKFile type=\"ImageData\" version=\"1.0\" ";
+#ifdef PLB_BIG_ENDIAN
+    header << "byte_order=\"BigEndian\" ";
+#else
+    header << "byte_order=\"LittleEndian\" ";
+#endif
+    header << "header_type=\"UInt" << 8*sizeof(pluint) << "\">\n";
+    header << std::setprecision(17);
+    header << "<ImageData WholeExtent=\""
+           << domain.x0 << " " << domain.x1+1 << " "
+           << domain.y0 << " " << domain.y1+1 << " "
+           << domain.z0 << " " << domain.z1+1 << "\" "
+           << "Origin=\""
+           << origin[0]-deltaX/2. << " " << origin[1]-deltaX/2. << " " << origin[2]-deltaX/2. << "\" "
+           << "Spacing=\""
+           << deltaX << " " << deltaX << " " << deltaX << "\">\n";
+    plint appendedOffset = 0;
+    iPiece = 0;
+    for (it = pieces.begin(); it != pieces.end(); ++it, ++iPiece) {
+        Box3D const& piece = it->second;
+        header << "<Piece Extent=\""
+               << piece.x0 << " " << piece.x1+1 << " "
+               << piece.y0 << " " << piece.y1+1 << " "
+               << piece.z0 << " " << piece.z1+1 << "\">\n";
+        header << "<CellData>\n";
+        for (plint iField=0; iField<numFields; ++iField) {
+            header << "<DataArray type=\"" << fields[iField].typeName
+                   << "\" Name=\"" << fields[iField].name << "\" ";
+            if (fields[iField].nDim>1) {
+                header << "NumberOfComponents=\"" << fields[iField].nDim << "\" ";
+            }
+            header << "format=\"appended\" offset=\"" << appendedOffset << "\"/>\n";
+            appendedOffset += chunkSize[1+iPiece*numFields+iField];
+        }
+        header << "</CellData>\n";
+        header << "</Piece>\n";
+    }
+    header << "</ImageData>\n";
+    header << "<AppendedData encoding=\"raw\">\n_";
+    std::string headerString(header.str());
+    std::string footerString("\n</AppendedData>\n</VTKFile>\n");
+    chunkSize[0] = (plint)headerString.size();
+    chunkSize[numChunks-1] = (plint)footerString.size();
+
+    std::vector<plint> offset(numChunks);
+    std::partial_sum(chunkSize.begin(), chunkSize.end(), offset.begin());
+
+    std::vector<plint> myChunkIds;
+    std::vector<std::vector<char> > data;
+    VtkOrderingEncoder* encoder = new VtkOrderingEncoder;
+    if (global::mpi().isMainProcessor()) {
+        myChunkIds.push_back(0);
+        data.push_back(std::vector<char>(headerString.begin(), headerString.end()));
+        encoder->addChunk(0, Box3D());
+        myChunkIds.push_back(numChunks-1);
+        data.push_back(std::vector<char>(footerString.begin(), footerString.end()));
+        encoder->addChunk(0, Box3D());
+    }
+    for (pluint iBlock=0; iBlock<localBlocks.size(); ++iBlock) {
+        plint contiguousId = toContiguousId[localBlocks[iBlock]];
+        for (plint iField=0; iField<numFields; ++iField) {
+            myChunkIds.push_back(1+contiguousId*numFields+iField);
+            data.push_back(std::vector<char>());
+            data.back().swap(fields[iField].localData[iBlock]);
+            encoder->addChunk(fields[iField].sizeOfCell, localDomains[iBlock]);
+        }
+    }
+    fields.clear();
+    pieces.clear();
+    localBlocks.clear();
+    localDomains.clear();
+
+    if (asynchronousOutput) {
+        // The reordering of the data is left to the output thread.
+        global::asyncOutput().writeRawData(FileName(fileName), myChunkIds, offset, data, encoder);
+    }
+    else {
+        encoder->encode(data);
+        delete encoder;
+        // MPI-IO does not truncate existing files.
+        if (global::mpi().isMainProcessor()) {
+            std::remove(fileName.c_str());
+        }
+        global::mpi().barrier();
+        parallelIO::writeRawData(FileName(fileName), myChunkIds, offset, data);
+    }
+}
+
 template<>
 std::string VtkTypeNames<bool>::getBaseName() {
     return "Int";
@@ -37,7 +37,9 @@
 #include "multiBlock/multiDataField2D.h"
 #include "atomicBlock/dataField3D.h"
 #include "multiBlock/multiDataField3D.h"
+#include "multiBlock/multiBlock3D.h"
 #include "core/array.h"
+#include <map>
 
 namespace plb {
 
@@ -135,6 +137,81 @@ private:
     Box3D boundingBox;
 };
 
+/// Writer for a VTK image file in which every MPI process writes the data
+///   of its own atomic blocks, without gathering them on the main process.
+/** Each atomic block is a piece of the image, and the data is stored as
+ *  raw binary in the appended section of a single .vti file. Since the
+ *  pieces do not overlap, the data is written as cell data: the value of
+ *  a lattice node is located at the center of a VTK cell. The fields are
+ *  staged in memory by addDataField, and written collectively by write.
+ */
+class ParallelVtkDataWriter3D {
+public:
+    ParallelVtkDataWriter3D(std::string const& fileName_);
+    /// Stage the local data of a multi-block, with nDim components of
+    ///   type typeName per cell. All fields of a file must have the same
+    ///   block structure.
+    void addDataField( MultiBlock3D& multiBlock, std::string const& typeName,
+                       std::string const& name, plint nDim );
+    /// Write the file; must be called by all processes.
+    void write(Box3D domain, Array<double,3> origin, double deltaX);
+    /// Tells whether data has been staged since the last write.
+    bool hasData() const;
+    /// When asynchronous output is on, write returns as soon as the file
+    ///   offsets are known, and the data is reordered and written by
+    ///   global::asyncOutput() in the background.
+    void toggleAsynchronousOutput(bool flag);
+    bool isAsynchronousOutputOn() const;
+private:
+    struct DataField {
+        std::string name, typeName;
+        plint nDim, sizeOfCell;
+        /// Data of the local blocks, in the order of localBlocks, and in
+        ///   the Palabos ordering.
+        std::vector<std::vector<char> > localData;
+    };
+private:
+    std::string fileName;
+    std::map<plint,Box3D> pieces;
+    std::vector<plint> localBlocks;
+    std::vector<Box3D> localDomains;
+    std::vector<DataField> fields;
+    bool asynchronousOutput;
+};
+
+/// Parallel counterpart of VtkImageOutput3D for multi-blocks: each process
+///   writes its own data, through parallelIO::writeRawData. The file is
+///   written by the destructor, or explicitly by close().
+template<typename T>
+class ParallelVtkImageOutput3D {
+public:
+    ParallelVtkImageOutput3D(std::string fName, double deltaX_=1.);
+    ParallelVtkImageOutput3D(std::string fName, double deltaX_, Array<double,3> offset);
+    ~ParallelVtkImageOutput3D();
+    template<typename TConv>
+    void writeData(MultiScalarField3D<T>& scalarField,
+                   std::string scalarFieldName, TConv scalingFactor=(T)1);
+    template<plint n, typename TConv>
+    void writeData(MultiTensorField3D<T,n>& tensorField,
+                   std::string tensorFieldName, TConv scalingFactor=(T)1);
+    template<typename TConv>
+    void writeData(MultiNTensorField3D<T>& nTensorField, std::string nTensorFieldName);
+    /// Write the file. Must be called by all processes.
+    void close();
+    /// Write the file in the background; see ParallelVtkDataWriter3D.
+    void toggleAsynchronousOutput(bool flag);
+    bool isAsynchronousOutputOn() const;
+private:
+    void checkBoundingBox(Box3D boundingBox_);
+private:
+    std::string fullName;
+    ParallelVtkDataWriter3D vtkOut;
+    double deltaX;
+    Array<double,3> offset;
+    bool hasBoundingBox;
+    Box3D boundingBox;
+};
+
 } // namespace plb
 
 #endif  // VTK_DATA_OUTPUT_H
@@ -358,6 +358,93 @@ void VtkImageOutput3D<T>::writeData( MultiNTensorField3D<T>& nTensorField,
     delete transformedField;
 }
 
+////////// class ParallelVtkImageOutput3D ////////////////////////////
+
+template<typename T>
+ParallelVtkImageOutput3D<T>::ParallelVtkImageOutput3D(std::string fName, double deltaX_)
+    : fullName ( global::directories().getVtkOutDir() + fName+".vti" ),
+      vtkOut( fullName ),
+      deltaX(deltaX_),
+      offset(0.,0.,0.),
+      hasBoundingBox( false )
+{ }
+
+template<typename T>
+ParallelVtkImageOutput3D<T>::ParallelVtkImageOutput3D(std::string fName, double deltaX_, Array<double,3> offset_)
+    : fullName ( global::directories().getVtkOutDir() + fName+".vti" ),
+      vtkOut( fullName ),
+      deltaX(deltaX_),
+      offset(offset_),
+      hasBoundingBox( false )
+{ }
+
+template<typename T>
+ParallelVtkImageOutput3D<T>::~ParallelVtkImageOutput3D() {
+    close();
+}
+
+template<typename T>
+void ParallelVtkImageOutput3D<T>::close() {
+    if (hasBoundingBox) {
+        vtkOut.write(boundingBox, offset, deltaX);
+        hasBoundingBox = false;
+    }
+}
+
+template<typename T>
+void ParallelVtkImageOutput3D<T>::toggleAsynchronousOutput(bool flag) {
+    vtkOut.toggleAsynchronousOutput(flag);
+}
+
+template<typename T>
+bool ParallelVtkImageOutput3D<T>::isAsynchronousOutputOn() const {
+    return vtkOut.isAsynchronousOutputOn();
+}
+
+template<typename T>
+void ParallelVtkImageOutput3D<T>::checkBoundingBox(Box3D boundingBox_) {
+    if (hasBoundingBox) {
+        PLB_PRECONDITION(boundingBox == boundingBox_);
+    }
+    else {
+        boundingBox = boundingBox_;
+        hasBoundingBox = true;
+    }
+}
+
+template<typename T>
+template<typename TConv>
+void ParallelVtkImageOutput3D<T>::writeData( MultiScalarField3D<T>& scalarField,
+                                             std::string scalarFieldName, TConv scalingFactor )
+{
+    checkBoundingBox(scalarField.getBoundingBox());
+    std::auto_ptr<MultiScalarField3D<TConv> > transformedField = copyConvert<T,TConv>(scalarField);
+    multiplyInPlace(*transformedField, scalingFactor);
+    vtkOut.addDataField(*transformedField, VtkTypeNames<TConv>::getName(), scalarFieldName, 1);
+}
+
+template<typename T>
+template<plint n, typename TConv>
+void ParallelVtkImageOutput3D<T>::writeData( MultiTensorField3D<T,n>& tensorField,
+                                             std::string tensorFieldName, TConv scalingFactor )
+{
+    checkBoundingBox(tensorField.getBoundingBox());
+    std::auto_ptr<MultiTensorField3D<TConv,n> > transformedField = copyConvert<T,TConv,n>(tensorField);
+    multiplyInPlace(*transformedField, scalingFactor);
+    vtkOut.addDataField(*transformedField, VtkTypeNames<TConv>::getName(), tensorFieldName, n);
+}
+
+template<typename T>
+template<typename TConv>
+void ParallelVtkImageOutput3D<T>::writeData( MultiNTensorField3D<T>& nTensorField,
+                                             std::string nTensorFieldName )
+{
+    checkBoundingBox(nTensorField.getBoundingBox());
+    MultiNTensorField3D<TConv>* transformedField = copyConvert<T,TConv>(nTensorField, nTensorField.getBoundingBox());
+    vtkOut.addDataField(*transformedField, VtkTypeNames<TConv>::getName(), nTensorFieldName, nTensorField.getNdim());
+    delete transformedField;
+}
+
 }  // namespace plb
 
 #endif  // VTK_DATA_OUTPUT_HH
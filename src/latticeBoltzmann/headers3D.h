@@ -29,3 +29,4 @@
 #include "latticeBoltzmann/extendedNeighborhoodLattices3D.h"
 #include "latticeBoltzmann/advectionDiffusionLattices.h"
 #include "latticeBoltzmann/mrtLattices.h"
+#include "latticeBoltzmann/simdKernels3D.h"
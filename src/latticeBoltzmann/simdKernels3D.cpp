@@ -0,0 +1,360 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Vectorized collision kernels, which process several cells at once on
+ * populations stored as a structure of arrays. The instruction set is
+ * selected at run time -- implementation file.
+ *
+ * The kernels are written once, as templates over a vector type, with the
+ * vector extensions of GCC and compatible compilers. Each of them is
+ * instantiated with 4 doubles in functions compiled for AVX2, and with 8
+ * doubles in functions compiled for AVX-512; a plain double handles the
+ * remaining cells. The processor features are checked at run time, so
+ * that the library itself can be compiled without any -march option.
+ */
+
+#include "latticeBoltzmann/simdKernels3D.h"
+#include "latticeBoltzmann/nearestNeighborLattices3D.hh"
+#include "latticeBoltzmann/mrtLattices.hh"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PLB_SIMD_X86
+#endif
+
+#ifdef __GNUC__
+#define PLB_SIMD_INLINE inline __attribute__((always_inline))
+#else
+#define PLB_SIMD_INLINE inline
+#endif
+
+// Full unrolling lets the compiler fold the constant lattice coefficients.
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 8)
+#define PLB_SIMD_UNROLL _Pragma("GCC unroll 32")
+#else
+#define PLB_SIMD_UNROLL
+#endif
+
+namespace plb {
+
+namespace simd {
+
+#ifdef PLB_SIMD_X86
+typedef double Double4 __attribute__((vector_size(32)));
+typedef double Double8 __attribute__((vector_size(64)));
+#endif
+
+/* *************** Vector helpers ************************************ */
+
+// The vectors are passed by reference, so that the helpers have no ABI
+//   which depends on the instruction set.
+
+template<class V>
+PLB_SIMD_INLINE void loadVector(V& value, double const* data) {
+    std::memcpy(&value, data, sizeof(V));
+}
+
+template<class V>
+PLB_SIMD_INLINE void storeVector(double* data, V const& value) {
+    std::memcpy(data, &value, sizeof(V));
+}
+
+/* *************** BGK kernel **************************************** */
+
+/// BGK collision of width consecutive cells, stored in the vector type V.
+template<class V, int width, class Descriptor>
+PLB_SIMD_INLINE void bgkBatch (
+        double* f, plint stride, double omega, double* rhoBar, double* uSqr )
+{
+    typedef Descriptor D;
+    V fPop[D::q];
+    for (int iPop=0; iPop<D::q; ++iPop) {
+        loadVector(fPop[iPop], f+iPop*stride);
+    }
+    V rho = fPop[0];
+    V jX = V(), jY = V(), jZ = V();
+    PLB_SIMD_UNROLL
+    for (int iPop=1; iPop<D::q; ++iPop) {
+        rho += fPop[iPop];
+        jX += (double)D::c[iPop][0]*fPop[iPop];
+        jY += (double)D::c[iPop][1]*fPop[iPop];
+        jZ += (double)D::c[iPop][2]*fPop[iPop];
+    }
+    V one = V()+1.;
+    V invRho = one / (rho+one);
+    V jSqr = jX*jX + jY*jY + jZ*jZ;
+    V kx = (D::invCs2/2.)*invRho*jSqr;
+    double oneMinusOmega = 1.-omega;
+    PLB_SIMD_UNROLL
+    for (int iPop=0; iPop<D::q; ++iPop) {
+        V c_j = (double)D::c[iPop][0]*jX + (double)D::c[iPop][1]*jY + (double)D::c[iPop][2]*jZ;
+        V fEq = D::t[iPop] * ( rho + D::invCs2*c_j +
+                               (D::invCs2*D::invCs2/2.)*invRho*c_j*c_j - kx );
+        V fOut = oneMinusOmega*fPop[iPop] + omega*fEq;
+        storeVector(f+iPop*stride, fOut);
+    }
+    storeVector(rhoBar, rho);
+    V uSqrOut = jSqr*invRho*invRho;
+    storeVector(uSqr, uSqrOut);
+}
+
+template<class V, int width, class Descriptor>
+PLB_SIMD_INLINE void bgkRun (
+        double* f, plint stride, plint numCells, double omega,
+        double* rhoBar, double* uSqr )
+{
+    plint iCell=0;
+    for (; iCell+width<=numCells; iCell+=width) {
+        bgkBatch<V,width,Descriptor>(f+iCell, stride, omega, rhoBar+iCell, uSqr+iCell);
+    }
+    for (; iCell<numCells; ++iCell) {
+        bgkBatch<double,1,Descriptor>(f+iCell, stride, omega, rhoBar+iCell, uSqr+iCell);
+    }
+}
+
+/* *************** MRT kernel **************************************** */
+
+/// MRT collision of width consecutive D3Q19 cells, stored in the vector
+///   type V. The equilibrium moments are the ones of
+///   mrtTemplatesImpl<T, MRTD3Q19DescriptorBase<T> >.
+template<class V, int width>
+PLB_SIMD_INLINE void mrtD3Q19Batch (
+        double* f, plint stride, double const* invM_S, double* rhoBar, double* uSqr )
+{
+    typedef descriptors::MRTD3Q19DescriptorBase<double> D;
+    static const int q = 19;
+    V fPop[q];
+    for (int iPop=0; iPop<q; ++iPop) {
+        loadVector(fPop[iPop], f+iPop*stride);
+    }
+    // Moments. The matrices are sparse.
+    V moments[q];
+    PLB_SIMD_UNROLL
+    for (int iMom=0; iMom<q; ++iMom) {
+        moments[iMom] = V();
+        PLB_SIMD_UNROLL
+        for (int iPop=0; iPop<q; ++iPop) {
+            if (D::M[iMom][iPop] != 0.) {
+                moments[iMom] += D::M[iMom][iPop]*fPop[iPop];
+            }
+        }
+    }
+    V rho = moments[0];
+    V jX = moments[3], jY = moments[5], jZ = moments[7];
+    V one = V()+1.;
+    V invRho = one / (rho+one);
+    V jSqr = jX*jX + jY*jY + jZ*jZ;
+    // Non-equilibrium part of the moments.
+    V dm[q];
+    dm[0]  = V();
+    dm[1]  = moments[1] - (19.*jSqr*invRho - 11.*rho);
+    dm[2]  = moments[2] - (-5.5*jSqr*invRho + 3.*rho);
+    dm[3]  = V();
+    dm[4]  = moments[4] + (2./3.)*jX;
+    dm[5]  = V();
+    dm[6]  = moments[6] + (2./3.)*jY;
+    dm[7]  = V();
+    dm[8]  = moments[8] + (2./3.)*jZ;
+    dm[9]  = moments[9] - (2.*jX*jX - jY*jY - jZ*jZ)*invRho;
+    dm[10] = moments[10] - (-jX*jX + 0.5*jY*jY + 0.5*jZ*jZ)*invRho;
+    dm[11] = moments[11] - (jY*jY - jZ*jZ)*invRho;
+    dm[12] = moments[12] - (-0.5*jY*jY + 0.5*jZ*jZ)*invRho;
+    dm[13] = moments[13] - jY*jX*invRho;
+    dm[14] = moments[14] - jZ*jY*invRho;
+    dm[15] = moments[15] - jZ*jX*invRho;
+    dm[16] = moments[16];
+    dm[17] = moments[17];
+    dm[18] = moments[18];
+    // Relaxation; the conserved moments are skipped.
+    PLB_SIMD_UNROLL
+    for (int iPop=0; iPop<q; ++iPop) {
+        V collisionTerm = V();
+        PLB_SIMD_UNROLL
+        for (int iMom=1; iMom<q; ++iMom) {
+            if (iMom!=3 && iMom!=5 && iMom!=7) {
+                double coefficient = invM_S[iPop*q+iMom];
+                if (coefficient != 0.) {
+                    collisionTerm += coefficient*dm[iMom];
+                }
+            }
+        }
+        V fOut = fPop[iPop]-collisionTerm;
+        storeVector(f+iPop*stride, fOut);
+    }
+    storeVector(rhoBar, rho);
+    V uSqrOut = jSqr*invRho*invRho;
+    storeVector(uSqr, uSqrOut);
+}
+
+template<class V, int width>
+PLB_SIMD_INLINE void mrtD3Q19Run (
+        double* f, plint stride, plint numCells, double const* invM_S,
+        double* rhoBar, double* uSqr )
+{
+    plint iCell=0;
+    for (; iCell+width<=numCells; iCell+=width) {
+        mrtD3Q19Batch<V,width>(f+iCell, stride, invM_S, rhoBar+iCell, uSqr+iCell);
+    }
+    for (; iCell<numCells; ++iCell) {
+        mrtD3Q19Batch<double,1>(f+iCell, stride, invM_S, rhoBar+iCell, uSqr+iCell);
+    }
+}
+
+/* *************** Instantiations per instruction set **************** */
+
+typedef descriptors::D3Q19DescriptorBase<double> D3Q19;
+typedef descriptors::D3Q27DescriptorBase<double> D3Q27;
+
+#ifdef PLB_SIMD_X86
+
+__attribute__((target("avx2,fma")))
+static void bgkD3Q19Avx2(double* f, plint stride, plint numCells, double omega, double* rhoBar, double* uSqr) {
+    bgkRun<Double4,4,D3Q19>(f, stride, numCells, omega, rhoBar, uSqr);
+}
+
+__attribute__((target("avx2,fma")))
+static void bgkD3Q27Avx2(double* f, plint stride, plint numCells, double omega, double* rhoBar, double* uSqr) {
+    bgkRun<Double4,4,D3Q27>(f, stride, numCells, omega, rhoBar, uSqr);
+}
+
+__attribute__((target("avx2,fma")))
+static void mrtD3Q19Avx2(double* f, plint stride, plint numCells, double const* invM_S, double* rhoBar, double* uSqr) {
+    mrtD3Q19Run<Double4,4>(f, stride, numCells, invM_S, rhoBar, uSqr);
+}
+
+__attribute__((target("avx512f")))
+static void bgkD3Q19Avx512(double* f, plint stride, plint numCells, double omega, double* rhoBar, double* uSqr) {
+    bgkRun<Double8,8,D3Q19>(f, stride, numCells, omega, rhoBar, uSqr);
+}
+
+__attribute__((target("avx512f")))
+static void bgkD3Q27Avx512(double* f, plint stride, plint numCells, double omega, double* rhoBar, double* uSqr) {
+    bgkRun<Double8,8,D3Q27>(f, stride, numCells, omega, rhoBar, uSqr);
+}
+
+__attribute__((target("avx512f")))
+static void mrtD3Q19Avx512(double* f, plint stride, plint numCells, double const* invM_S, double* rhoBar, double* uSqr) {
+    mrtD3Q19Run<Double8,8>(f, stride, numCells, invM_S, rhoBar, uSqr);
+}
+
+#endif  // PLB_SIMD_X86
+
+/* *************** Run-time selection ******************************** */
+
+InstructionSet detectInstructionSet() {
+#ifdef PLB_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return avx512Instructions;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return avx2Instructions;
+    }
+#endif
+    return scalarInstructions;
+}
+
+static InstructionSet& currentInstructionSet() {
+    static InstructionSet instructionSet = detectInstructionSet();
+    return instructionSet;
+}
+
+InstructionSet getInstructionSet() {
+    return currentInstructionSet();
+}
+
+void setInstructionSet(InstructionSet instructionSet) {
+    InstructionSet detected = detectInstructionSet();
+    currentInstructionSet() = instructionSet<=detected ? instructionSet : detected;
+}
+
+std::string instructionSetName(InstructionSet instructionSet) {
+    switch(instructionSet) {
+        case avx2Instructions:   return "AVX2";
+        case avx512Instructions: return "AVX-512";
+        default:                 return "scalar";
+    }
+}
+
+bool bgk_ma2_collision_d3q19 (
+        double* f, plint stride, plint numCells, double omega,
+        double* rhoBar, double* uSqr )
+{
+#ifdef PLB_SIMD_X86
+    switch(getInstructionSet()) {
+        case avx512Instructions:
+            bgkD3Q19Avx512(f, stride, numCells, omega, rhoBar, uSqr);
+            return true;
+        case avx2Instructions:
+            bgkD3Q19Avx2(f, stride, numCells, omega, rhoBar, uSqr);
+            return true;
+        default:
+            break;
+    }
+#endif
+    return false;
+}
+
+bool bgk_ma2_collision_d3q27 (
+        double* f, plint stride, plint numCells, double omega,
+        double* rhoBar, double* uSqr )
+{
+#ifdef PLB_SIMD_X86
+    switch(getInstructionSet()) {
+        case avx512Instructions:
+            bgkD3Q27Avx512(f, stride, numCells, omega, rhoBar, uSqr);
+            return true;
+        case avx2Instructions:
+            bgkD3Q27Avx2(f, stride, numCells, omega, rhoBar, uSqr);
+            return true;
+        default:
+            break;
+    }
+#endif
+    return false;
+}
+
+bool mrt_collision_d3q19 (
+        double* f, plint stride, plint numCells, double const* invM_S,
+        double* rhoBar, double* uSqr )
+{
+#ifdef PLB_SIMD_X86
+    switch(getInstructionSet()) {
+        case avx512Instructions:
+            mrtD3Q19Avx512(f, stride, numCells, invM_S, rhoBar, uSqr);
+            return true;
+        case avx2Instructions:
+            mrtD3Q19Avx2(f, stride, numCells, invM_S, rhoBar, uSqr);
+            return true;
+        default:
+            break;
+    }
+#endif
+    return false;
+}
+
+}  // namespace simd
+
+}  // namespace plb
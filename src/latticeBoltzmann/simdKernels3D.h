@@ -0,0 +1,139 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Vectorized collision kernels, which process several cells at once on
+ * populations stored as a structure of arrays. The instruction set is
+ * selected at run time -- header file.
+ */
+#ifndef SIMD_KERNELS_3D_H
+#define SIMD_KERNELS_3D_H
+
+#include "core/globalDefs.h"
+#include "latticeBoltzmann/nearestNeighborLattices3D.h"
+#include "latticeBoltzmann/mrtLattices.h"
+#include <string>
+
+namespace plb {
+
+namespace simd {
+
+/// Instruction sets for which the kernels are compiled.
+enum InstructionSet { scalarInstructions=0, avx2Instructions=1, avx512Instructions=2 };
+
+/// Most advanced instruction set supported both by the compiler and
+///   by the processor on which the program is running.
+InstructionSet detectInstructionSet();
+
+/// Instruction set currently used by the kernels. The default is the
+///   detected one.
+InstructionSet getInstructionSet();
+
+/// Select the instruction set used by the kernels. A request for an
+///   instruction set which is not supported is replaced by the
+///   detected one.
+void setInstructionSet(InstructionSet instructionSet);
+
+/// Human readable name of an instruction set.
+std::string instructionSetName(InstructionSet instructionSet);
+
+/// BGK collision with second-order equilibrium on numCells consecutive
+///   D3Q19 cells. Population iPop of cell iCell is f[iPop*stride+iCell].
+///   On output, rhoBar[iCell] and uSqr[iCell] contain the macroscopic
+///   variables of each cell, as required by the statistics. Returns false,
+///   without doing anything, if the scalar instruction set is selected:
+///   the generic code of the dynamics class is then used instead.
+bool bgk_ma2_collision_d3q19 (
+        double* f, plint stride, plint numCells, double omega,
+        double* rhoBar, double* uSqr );
+
+/// BGK collision with second-order equilibrium on numCells consecutive
+///   D3Q27 cells, with the same conventions as the D3Q19 kernel.
+bool bgk_ma2_collision_d3q27 (
+        double* f, plint stride, plint numCells, double omega,
+        double* rhoBar, double* uSqr );
+
+/// MRT collision on numCells consecutive D3Q19 cells, with the same
+///   conventions as the BGK kernels. invM_S is the row-major 19-by-19
+///   matrix of MRTparam::getInvM().
+bool mrt_collision_d3q19 (
+        double* f, plint stride, plint numCells, double const* invM_S,
+        double* rhoBar, double* uSqr );
+
+}  // namespace simd
+
+/// Access to the vectorized BGK kernels from the templated dynamics
+///   classes. The generic version has no kernel and returns false.
+///   The specializations return false if no vector instruction set is
+///   available.
+template<typename T, class Descriptor>
+struct SimdBgkKernel {
+    static bool collide( T* f, plint stride, plint numCells, T omega,
+                         T* rhoBar, T* uSqr )
+    {
+        return false;
+    }
+};
+
+template<>
+struct SimdBgkKernel<double, descriptors::D3Q19DescriptorBase<double> > {
+    static bool collide( double* f, plint stride, plint numCells, double omega,
+                         double* rhoBar, double* uSqr )
+    {
+        return simd::bgk_ma2_collision_d3q19(f, stride, numCells, omega, rhoBar, uSqr);
+    }
+};
+
+template<>
+struct SimdBgkKernel<double, descriptors::D3Q27DescriptorBase<double> > {
+    static bool collide( double* f, plint stride, plint numCells, double omega,
+                         double* rhoBar, double* uSqr )
+    {
+        return simd::bgk_ma2_collision_d3q27(f, stride, numCells, omega, rhoBar, uSqr);
+    }
+};
+
+/// Access to the vectorized MRT kernels from the templated dynamics
+///   classes, with the same conventions as SimdBgkKernel.
+template<typename T, class Descriptor>
+struct SimdMrtKernel {
+    static bool collide( T* f, plint stride, plint numCells, T const* invM_S,
+                         T* rhoBar, T* uSqr )
+    {
+        return false;
+    }
+};
+
+template<>
+struct SimdMrtKernel<double, descriptors::MRTD3Q19DescriptorBase<double> > {
+    static bool collide( double* f, plint stride, plint numCells, double const* invM_S,
+                         double* rhoBar, double* uSqr )
+    {
+        return simd::mrt_collision_d3q19(f, stride, numCells, invM_S, rhoBar, uSqr);
+    }
+};
+
+}  // namespace plb
+
+#endif  // SIMD_KERNELS_3D_H
@@ -45,6 +45,25 @@ struct BlockCommunicator3D {
      *  is being transmitted.
      **/
     virtual void duplicateOverlaps(MultiBlock3D& multiBlock, modif::ModifT whichData) const =0;
+    /// Initiate the duplication of overlaps, without waiting for its completion.
+    /** All data is read from the bulk of multiBlock before this function returns. The
+     *  envelopes are guaranteed to be filled only after a subsequent call to
+     *  finalizeDuplicateOverlaps(). In the meantime, the envelopes must not be accessed,
+     *  but the bulk can be modified freely. The default implementation is blocking.
+     **/
+    virtual void startDuplicateOverlaps(MultiBlock3D& multiBlock, modif::ModifT whichData) const {
+        duplicateOverlaps(multiBlock, whichData);
+    }
+    /// Conclude a duplication of overlaps initiated with startDuplicateOverlaps().
+    virtual void finalizeDuplicateOverlaps(MultiBlock3D& multiBlock) const { }
+    /// Fill the overlaps with the part of the static data of the bulks which
+    ///   is streamed into the neighboring bulks (see BlockDataTransfer3D::sendDirectional()).
+    /** The remaining content of the envelopes is undefined after this operation.
+     *  The default implementation duplicates all static data.
+     **/
+    virtual void duplicateDirectionalOverlaps(MultiBlock3D& multiBlock) const {
+        duplicateOverlaps(multiBlock, modif::staticVariables);
+    }
     /// Transmit data between two multi-blocks, according to a user-defined pattern.
     /** The variable whichData specifies which type of content (static/dynamic/full dynamics object)
      *  is being transmitted.
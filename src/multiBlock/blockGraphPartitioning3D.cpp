@@ -0,0 +1,618 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Multilevel partitioning of the graph of the blocks of a sparse block
+ * structure -- implementation file.
+ */
+
+#include "multiBlock/blockGraphPartitioning3D.h"
+#include "core/plbDebug.h"
+#include <algorithm>
+#include <set>
+#include <cmath>
+
+namespace plb {
+
+void computeBlockGraph( SparseBlockStructure3D const& sparseBlock,
+                        std::map<plint,double> const& weights,
+                        plint envelopeWidth, BlockGraph3D& graph )
+{
+    std::map<plint,Box3D> const& bulks = sparseBlock.getBulks();
+    plint numVertices = (plint)bulks.size();
+    graph.blockIds.resize(numVertices);
+    graph.vertexWeights.resize(numVertices);
+    graph.offsets.assign(1, 0);
+    graph.adjacency.clear();
+    graph.edgeWeights.clear();
+
+    std::map<plint,plint> vertexIds;
+    std::map<plint,Box3D>::const_iterator it = bulks.begin();
+    for (plint iVertex=0; it != bulks.end(); ++it, ++iVertex) {
+        vertexIds[it->first] = iVertex;
+    }
+
+    it = bulks.begin();
+    for (plint iVertex=0; it != bulks.end(); ++it, ++iVertex) {
+        Box3D const& bulk = it->second;
+        graph.blockIds[iVertex] = it->first;
+        std::map<plint,double>::const_iterator weightIt = weights.find(it->first);
+        graph.vertexWeights[iVertex] =
+            weightIt != weights.end() ? weightIt->second : (double)bulk.nCells();
+
+        std::vector<plint> neighbors;
+        sparseBlock.findNeighbors(it->first, envelopeWidth, neighbors);
+        std::vector<std::pair<plint,double> > edges;
+        for (pluint iNeighbor=0; iNeighbor<neighbors.size(); ++iNeighbor) {
+            Box3D neighborBulk, received, sent;
+            sparseBlock.getBulk(neighbors[iNeighbor], neighborBulk);
+            plint numCells = 0;
+            if (intersect(bulk.enlarge(envelopeWidth), neighborBulk, received)) {
+                numCells += received.nCells();
+            }
+            if (intersect(neighborBulk.enlarge(envelopeWidth), bulk, sent)) {
+                numCells += sent.nCells();
+            }
+            if (numCells>0) {
+                edges.push_back(std::make_pair(vertexIds[neighbors[iNeighbor]], (double)numCells));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (pluint iEdge=0; iEdge<edges.size(); ++iEdge) {
+            graph.adjacency.push_back(edges[iEdge].first);
+            graph.edgeWeights.push_back(edges[iEdge].second);
+        }
+        graph.offsets.push_back((plint)graph.adjacency.size());
+    }
+}
+
+namespace {
+
+/// Graph of one level of the multilevel partitioning, in the same format
+///   as BlockGraph3D.
+struct WeightedGraph {
+    std::vector<double> vertexWeights;
+    std::vector<plint> offsets;
+    std::vector<plint> adjacency;
+    std::vector<double> edgeWeights;
+    plint size() const {
+        return (plint)vertexWeights.size();
+    }
+    double totalWeight() const {
+        double sum = 0.;
+        for (pluint i=0; i<vertexWeights.size(); ++i) {
+            sum += vertexWeights[i];
+        }
+        return sum;
+    }
+    double maxVertexWeight() const {
+        double maxWeight = 0.;
+        for (pluint i=0; i<vertexWeights.size(); ++i) {
+            maxWeight = std::max(maxWeight, vertexWeights[i]);
+        }
+        return maxWeight;
+    }
+};
+
+struct DegreeComparison {
+    DegreeComparison(WeightedGraph const& graph_)
+        : graph(graph_)
+    { }
+    bool operator()(plint v1, plint v2) const {
+        return graph.offsets[v1+1]-graph.offsets[v1] < graph.offsets[v2+1]-graph.offsets[v2];
+    }
+    WeightedGraph const& graph;
+};
+
+/// Merge pairs of vertices connected by heavy edges. The vertices are
+///   visited by increasing degree, and are matched with the unmatched
+///   neighbor with the heaviest edge, unless the merged vertex would
+///   be heavier than maxVertexWeight.
+void coarsenGraph( WeightedGraph const& fine, double maxVertexWeight,
+                   WeightedGraph& coarse, std::vector<plint>& coarseIds )
+{
+    plint numVertices = fine.size();
+    std::vector<plint> order(numVertices);
+    for (plint v=0; v<numVertices; ++v) {
+        order[v] = v;
+    }
+    std::stable_sort(order.begin(), order.end(), DegreeComparison(fine));
+
+    std::vector<plint> match(numVertices, -1);
+    for (plint iVertex=0; iVertex<numVertices; ++iVertex) {
+        plint u = order[iVertex];
+        if (match[u]>=0) {
+            continue;
+        }
+        plint partner = u;
+        double heaviestEdge = -1.;
+        for (plint k=fine.offsets[u]; k<fine.offsets[u+1]; ++k) {
+            plint v = fine.adjacency[k];
+            if ( v!=u && match[v]<0 && fine.edgeWeights[k] > heaviestEdge &&
+                 fine.vertexWeights[u]+fine.vertexWeights[v] <= maxVertexWeight )
+            {
+                partner = v;
+                heaviestEdge = fine.edgeWeights[k];
+            }
+        }
+        match[u] = partner;
+        match[partner] = u;
+    }
+
+    coarseIds.assign(numVertices, -1);
+    std::vector<plint> firstVertex, secondVertex;
+    for (plint v=0; v<numVertices; ++v) {
+        if (coarseIds[v]<0) {
+            coarseIds[v] = (plint)firstVertex.size();
+            coarseIds[match[v]] = coarseIds[v];
+            firstVertex.push_back(v);
+            secondVertex.push_back(match[v]);
+        }
+    }
+
+    plint numCoarse = (plint)firstVertex.size();
+    coarse.vertexWeights.resize(numCoarse);
+    coarse.offsets.assign(1, 0);
+    coarse.adjacency.clear();
+    coarse.edgeWeights.clear();
+    std::vector<plint> edgePosition(numCoarse, -1);
+    for (plint c=0; c<numCoarse; ++c) {
+        plint members[2] = { firstVertex[c], secondVertex[c] };
+        plint numMembers = members[0]==members[1] ? 1 : 2;
+        coarse.vertexWeights[c] = 0.;
+        plint firstEdge = (plint)coarse.adjacency.size();
+        for (plint iMember=0; iMember<numMembers; ++iMember) {
+            plint v = members[iMember];
+            coarse.vertexWeights[c] += fine.vertexWeights[v];
+            for (plint k=fine.offsets[v]; k<fine.offsets[v+1]; ++k) {
+                plint neighbor = coarseIds[fine.adjacency[k]];
+                if (neighbor==c) {
+                    continue;
+                }
+                if (edgePosition[neighbor]<firstEdge) {
+                    edgePosition[neighbor] = (plint)coarse.adjacency.size();
+                    coarse.adjacency.push_back(neighbor);
+                    coarse.edgeWeights.push_back(fine.edgeWeights[k]);
+                }
+                else {
+                    coarse.edgeWeights[edgePosition[neighbor]] += fine.edgeWeights[k];
+                }
+            }
+        }
+        coarse.offsets.push_back((plint)coarse.adjacency.size());
+    }
+}
+
+/// Sum of the weights by which the two sides exceed their maximum weight.
+double excessWeight(double const weights[2], double const maxWeights[2]) {
+    return std::max(0., weights[0]-maxWeights[0]) + std::max(0., weights[1]-maxWeights[1]);
+}
+
+double bisectionCut(WeightedGraph const& graph, std::vector<plint> const& side) {
+    double cut = 0.;
+    for (plint v=0; v<graph.size(); ++v) {
+        for (plint k=graph.offsets[v]; k<graph.offsets[v+1]; ++k) {
+            if (side[graph.adjacency[k]] != side[v]) {
+                cut += graph.edgeWeights[k];
+            }
+        }
+    }
+    return cut/2.;
+}
+
+/// Fiduccia-Mattheyses refinement of a bisection: in every pass, the vertex
+///   with largest gain which respects the balance is moved, until all vertices
+///   have been moved once, and the best intermediate bisection is kept.
+///   If the bisection is unbalanced, vertices are moved out of the heavier
+///   side first.
+void refineBisection( WeightedGraph const& graph, double const maxWeights[2],
+                      std::vector<plint>& side )
+{
+    static const plint maxNumPasses = 8;
+    plint numVertices = graph.size();
+    for (plint iPass=0; iPass<maxNumPasses; ++iPass) {
+        double weights[2] = { 0., 0. };
+        std::vector<double> gains(numVertices, 0.);
+        for (plint v=0; v<numVertices; ++v) {
+            weights[side[v]] += graph.vertexWeights[v];
+            for (plint k=graph.offsets[v]; k<graph.offsets[v+1]; ++k) {
+                gains[v] += side[graph.adjacency[k]]==side[v] ?
+                                -graph.edgeWeights[k] : graph.edgeWeights[k];
+            }
+        }
+        std::set<std::pair<double,plint> > queues[2];
+        for (plint v=0; v<numVertices; ++v) {
+            queues[side[v]].insert(std::make_pair(-gains[v], v));
+        }
+
+        double cut = bisectionCut(graph, side);
+        double bestCut = cut;
+        double bestExcess = excessWeight(weights, maxWeights);
+        std::vector<plint> moves;
+        plint numBestMoves = 0;
+        std::vector<bool> locked(numVertices, false);
+        while (true) {
+            plint from = -1;
+            if (weights[0] > maxWeights[0]) {
+                from = 0;
+            }
+            else if (weights[1] > maxWeights[1]) {
+                from = 1;
+            }
+            else {
+                double bestGain = 0.;
+                for (plint iSide=0; iSide<2; ++iSide) {
+                    if (queues[iSide].empty()) {
+                        continue;
+                    }
+                    plint v = queues[iSide].begin()->second;
+                    if ( weights[1-iSide]+graph.vertexWeights[v] <= maxWeights[1-iSide] &&
+                         (from<0 || gains[v] > bestGain) )
+                    {
+                        from = iSide;
+                        bestGain = gains[v];
+                    }
+                }
+            }
+            if (from<0 || queues[from].empty()) {
+                break;
+            }
+            plint to = 1-from;
+            plint v = queues[from].begin()->second;
+            queues[from].erase(queues[from].begin());
+            locked[v] = true;
+            side[v] = to;
+            weights[from] -= graph.vertexWeights[v];
+            weights[to] += graph.vertexWeights[v];
+            cut -= gains[v];
+            moves.push_back(v);
+            for (plint k=graph.offsets[v]; k<graph.offsets[v+1]; ++k) {
+                plint u = graph.adjacency[k];
+                if (locked[u]) {
+                    continue;
+                }
+                queues[side[u]].erase(std::make_pair(-gains[u], u));
+                gains[u] += side[u]==to ? -2.*graph.edgeWeights[k] : 2.*graph.edgeWeights[k];
+                queues[side[u]].insert(std::make_pair(-gains[u], u));
+            }
+
+            double excess = excessWeight(weights, maxWeights);
+            if (excess < bestExcess || (excess==bestExcess && cut < bestCut)) {
+                bestExcess = excess;
+                bestCut = cut;
+                numBestMoves = (plint)moves.size();
+            }
+        }
+        for (plint iMove=(plint)moves.size()-1; iMove>=numBestMoves; --iMove) {
+            side[moves[iMove]] = 1-side[moves[iMove]];
+        }
+        if (numBestMoves==0) {
+            break;
+        }
+    }
+}
+
+/// Initial bisection of the coarsest graph: side 0 is grown from a seed
+///   vertex, by adding the vertex most strongly connected to it, until it
+///   reaches the weight target0. Several seeds are tried, and the best
+///   refined bisection is kept.
+void growBisection( WeightedGraph const& graph, double target0, double const maxWeights[2],
+                    std::vector<plint>& side )
+{
+    static const plint numSeeds = 6;
+    plint numVertices = graph.size();
+    double bestCut = 0., bestExcess = 0.;
+    bool first = true;
+    for (plint iSeed=0; iSeed<std::min(numSeeds, numVertices); ++iSeed) {
+        plint seed = iSeed*numVertices/std::min(numSeeds, numVertices);
+        std::vector<plint> trial(numVertices, 1);
+        std::vector<double> connection(numVertices, 0.);
+        std::set<std::pair<double,plint> > frontier;
+        double weight0 = 0.;
+        plint next = seed;
+        while (next>=0) {
+            if (weight0 > 0. && weight0 + 0.5*graph.vertexWeights[next] > target0) {
+                break;
+            }
+            trial[next] = 0;
+            weight0 += graph.vertexWeights[next];
+            frontier.erase(std::make_pair(-connection[next], next));
+            for (plint k=graph.offsets[next]; k<graph.offsets[next+1]; ++k) {
+                plint u = graph.adjacency[k];
+                if (trial[u]==1) {
+                    frontier.erase(std::make_pair(-connection[u], u));
+                    connection[u] += graph.edgeWeights[k];
+                    frontier.insert(std::make_pair(-connection[u], u));
+                }
+            }
+            next = -1;
+            if (!frontier.empty()) {
+                next = frontier.begin()->second;
+            }
+            else {
+                // Disconnected graph: continue with the first remaining vertex.
+                for (plint v=0; v<numVertices; ++v) {
+                    if (trial[v]==1) {
+                        next = v;
+                        break;
+                    }
+                }
+            }
+        }
+        refineBisection(graph, maxWeights, trial);
+
+        double weights[2] = { 0., 0. };
+        for (plint v=0; v<numVertices; ++v) {
+            weights[trial[v]] += graph.vertexWeights[v];
+        }
+        double excess = excessWeight(weights, maxWeights);
+        double cut = bisectionCut(graph, trial);
+        if (first || excess < bestExcess || (excess==bestExcess && cut < bestCut)) {
+            first = false;
+            bestExcess = excess;
+            bestCut = cut;
+            side.swap(trial);
+        }
+    }
+}
+
+/// Multilevel bisection, in which side 0 receives the weight fraction
+///   fraction0 of the total weight.
+void multilevelBisection( WeightedGraph const& graph, double fraction0, double maxImbalance,
+                          std::vector<plint>& side )
+{
+    static const plint coarsestSize = 40;
+    double totalWeight = graph.totalWeight();
+    double targets[2] = { fraction0*totalWeight, (1.-fraction0)*totalWeight };
+
+    std::vector<WeightedGraph> levels(1, graph);
+    std::vector<std::vector<plint> > coarseIds;
+    double maxVertexWeight = 1.5*totalWeight/(double)coarsestSize;
+    while (levels.back().size() > coarsestSize) {
+        WeightedGraph coarse;
+        std::vector<plint> ids;
+        coarsenGraph(levels.back(), std::max(maxVertexWeight, levels.back().maxVertexWeight()),
+                     coarse, ids);
+        if ((double)coarse.size() > 0.95*(double)levels.back().size()) {
+            break;
+        }
+        levels.push_back(coarse);
+        coarseIds.push_back(ids);
+    }
+
+    // On every level, a side may exceed its target by the tolerance, or by
+    //   the heaviest vertex, which is needed on the coarse levels.
+    plint level = (plint)levels.size()-1;
+    double maxWeights[2];
+    for (plint iSide=0; iSide<2; ++iSide) {
+        maxWeights[iSide] = std::max( targets[iSide]*maxImbalance,
+                                      targets[iSide]+levels[level].maxVertexWeight() );
+    }
+    growBisection(levels[level], targets[0], maxWeights, side);
+    for (--level; level>=0; --level) {
+        std::vector<plint> fineSide(levels[level].size());
+        for (plint v=0; v<levels[level].size(); ++v) {
+            fineSide[v] = side[coarseIds[level][v]];
+        }
+        side.swap(fineSide);
+        for (plint iSide=0; iSide<2; ++iSide) {
+            maxWeights[iSide] = std::max( targets[iSide]*maxImbalance,
+                                          targets[iSide]+levels[level].maxVertexWeight() );
+        }
+        refineBisection(levels[level], maxWeights, side);
+    }
+}
+
+/// Sub-graph of the vertices of one side of a bisection.
+void extractSubgraph( WeightedGraph const& graph, std::vector<plint> const& side, plint whichSide,
+                      WeightedGraph& subgraph, std::vector<plint>& vertices )
+{
+    std::vector<plint> subIds(graph.size(), -1);
+    vertices.clear();
+    for (plint v=0; v<graph.size(); ++v) {
+        if (side[v]==whichSide) {
+            subIds[v] = (plint)vertices.size();
+            vertices.push_back(v);
+        }
+    }
+    subgraph.vertexWeights.resize(vertices.size());
+    subgraph.offsets.assign(1, 0);
+    subgraph.adjacency.clear();
+    subgraph.edgeWeights.clear();
+    for (pluint i=0; i<vertices.size(); ++i) {
+        plint v = vertices[i];
+        subgraph.vertexWeights[i] = graph.vertexWeights[v];
+        for (plint k=graph.offsets[v]; k<graph.offsets[v+1]; ++k) {
+            if (subIds[graph.adjacency[k]]>=0) {
+                subgraph.adjacency.push_back(subIds[graph.adjacency[k]]);
+                subgraph.edgeWeights.push_back(graph.edgeWeights[k]);
+            }
+        }
+        subgraph.offsets.push_back((plint)subgraph.adjacency.size());
+    }
+}
+
+void recursiveBisection( WeightedGraph const& graph, std::vector<plint> const& vertices,
+                         plint numParts, plint firstPart, double maxImbalance,
+                         std::vector<plint>& parts )
+{
+    if (numParts==1 || graph.size()<=1) {
+        for (pluint i=0; i<vertices.size(); ++i) {
+            parts[vertices[i]] = firstPart;
+        }
+        return;
+    }
+    plint numParts0 = numParts/2;
+    std::vector<plint> side;
+    multilevelBisection(graph, (double)numParts0/(double)numParts, maxImbalance, side);
+
+    for (plint iSide=0; iSide<2; ++iSide) {
+        WeightedGraph subgraph;
+        std::vector<plint> subVertices;
+        extractSubgraph(graph, side, iSide, subgraph, subVertices);
+        for (pluint i=0; i<subVertices.size(); ++i) {
+            subVertices[i] = vertices[subVertices[i]];
+        }
+        recursiveBisection( subgraph, subVertices,
+                            iSide==0 ? numParts0 : numParts-numParts0,
+                            iSide==0 ? firstPart : firstPart+numParts0,
+                            maxImbalance, parts );
+    }
+}
+
+/// Greedy k-way refinement: boundary vertices are moved to the adjacent part
+///   which reduces the cut most, as long as the balance is respected. Vertices
+///   of overloaded parts are moved even if the cut increases.
+void refineKway( WeightedGraph const& graph, plint numParts, double maxImbalance,
+                 std::vector<plint>& parts )
+{
+    static const plint maxNumPasses = 4;
+    plint numVertices = graph.size();
+    std::vector<double> weights(numParts, 0.);
+    for (plint v=0; v<numVertices; ++v) {
+        weights[parts[v]] += graph.vertexWeights[v];
+    }
+    double maxWeight = graph.totalWeight()/(double)numParts*maxImbalance;
+    std::vector<double> connection(numParts, 0.);
+    for (plint iPass=0; iPass<maxNumPasses; ++iPass) {
+        plint numMoves = 0;
+        for (plint v=0; v<numVertices; ++v) {
+            plint own = parts[v];
+            std::vector<plint> adjacentParts;
+            for (plint k=graph.offsets[v]; k<graph.offsets[v+1]; ++k) {
+                plint p = parts[graph.adjacency[k]];
+                if (connection[p]==0. && p!=own) {
+                    adjacentParts.push_back(p);
+                }
+                connection[p] += graph.edgeWeights[k];
+            }
+            bool overloaded = weights[own] > maxWeight;
+            plint target = -1;
+            double bestGain = 0.;
+            for (pluint i=0; i<adjacentParts.size(); ++i) {
+                plint p = adjacentParts[i];
+                double gain = connection[p]-connection[own];
+                bool fits = weights[p]+graph.vertexWeights[v] <= maxWeight;
+                if ( fits && ( (gain > bestGain) || (overloaded && (target<0 || gain > bestGain)) ) ) {
+                    target = p;
+                    bestGain = gain;
+                }
+            }
+            for (plint k=graph.offsets[v]; k<graph.offsets[v+1]; ++k) {
+                connection[parts[graph.adjacency[k]]] = 0.;
+            }
+            if (target>=0) {
+                parts[v] = target;
+                weights[own] -= graph.vertexWeights[v];
+                weights[target] += graph.vertexWeights[v];
+                ++numMoves;
+            }
+        }
+        if (numMoves==0) {
+            break;
+        }
+    }
+}
+
+}  // namespace
+
+std::vector<plint> partitionBlockGraph( BlockGraph3D const& blockGraph, plint numParts,
+                                        double maxImbalance )
+{
+    PLB_PRECONDITION( numParts>0 );
+    PLB_PRECONDITION( maxImbalance>=1. );
+    WeightedGraph graph;
+    graph.vertexWeights = blockGraph.vertexWeights;
+    graph.offsets = blockGraph.offsets;
+    graph.adjacency = blockGraph.adjacency;
+    graph.edgeWeights = blockGraph.edgeWeights;
+
+    plint numVertices = graph.size();
+    std::vector<plint> parts(numVertices, 0);
+    std::vector<plint> vertices(numVertices);
+    for (plint v=0; v<numVertices; ++v) {
+        vertices[v] = v;
+    }
+    // The imbalance tolerated at each level of the recursion compounds.
+    plint depth = 0;
+    while (((plint)1<<depth) < numParts) {
+        ++depth;
+    }
+    double levelImbalance = depth>0 ? std::pow(maxImbalance, 1./(double)depth) : maxImbalance;
+    recursiveBisection(graph, vertices, numParts, 0, levelImbalance, parts);
+    refineKway(graph, numParts, maxImbalance, parts);
+    return parts;
+}
+
+double computeEdgeCut(BlockGraph3D const& graph, std::vector<plint> const& parts) {
+    double cut = 0.;
+    for (plint v=0; v<graph.getNumVertices(); ++v) {
+        for (plint k=graph.offsets[v]; k<graph.offsets[v+1]; ++k) {
+            if (parts[graph.adjacency[k]] != parts[v]) {
+                cut += graph.edgeWeights[k];
+            }
+        }
+    }
+    return cut/2.;
+}
+
+ExplicitThreadAttribution* graphPartitionedThreadAttribution (
+        SparseBlockStructure3D const& sparseBlock,
+        std::map<plint,double> const& weights, plint envelopeWidth,
+        plint numProcs, double maxImbalance )
+{
+    BlockGraph3D graph;
+    computeBlockGraph(sparseBlock, weights, envelopeWidth, graph);
+    std::vector<plint> parts = partitionBlockGraph(graph, numProcs, maxImbalance);
+
+    // The blocks of a process are distributed in turn over its threads.
+    ExplicitThreadAttribution* newAttribution = new ExplicitThreadAttribution;
+    std::vector<plint> numLocalBlocks(numProcs, 0);
+    for (plint v=0; v<graph.getNumVertices(); ++v) {
+        newAttribution->addBlock(graph.blockIds[v], parts[v], numLocalBlocks[parts[v]]++);
+    }
+    return newAttribution;
+}
+
+GraphPartitionedRedistribute3D::GraphPartitionedRedistribute3D (
+        std::map<plint,double> const& weights_, double maxImbalance_ )
+    : weights(weights_),
+      maxImbalance(maxImbalance_)
+{ }
+
+MultiBlockManagement3D GraphPartitionedRedistribute3D::redistribute (
+        MultiBlockManagement3D const& original ) const
+{
+    SparseBlockStructure3D const& originalSparseBlock = original.getSparseBlockStructure();
+    ExplicitThreadAttribution* newAttribution =
+        graphPartitionedThreadAttribution (
+                originalSparseBlock, weights, original.getEnvelopeWidth(),
+                global::mpi().getSize(), maxImbalance );
+    return MultiBlockManagement3D (
+            originalSparseBlock, newAttribution,
+            original.getEnvelopeWidth(), original.getRefinementLevel() );
+}
+
+}  // namespace plb
@@ -0,0 +1,111 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Multilevel partitioning of the graph of the blocks of a sparse block
+ * structure -- header file.
+ */
+
+#ifndef BLOCK_GRAPH_PARTITIONING_3D_H
+#define BLOCK_GRAPH_PARTITIONING_3D_H
+
+#include "core/globalDefs.h"
+#include "parallelism/mpiManager.h"
+#include "multiBlock/sparseBlockStructure3D.h"
+#include "multiBlock/threadAttribution.h"
+#include "multiBlock/redistribution3D.h"
+#include <vector>
+#include <map>
+
+namespace plb {
+
+/// Graph of the blocks of a sparse block structure, in the compressed
+///   adjacency format used by METIS and Scotch.
+/** The neighbors of the vertex i are adjacency[offsets[i]] to
+ *  adjacency[offsets[i+1]-1], and the edge to adjacency[k] has the weight
+ *  edgeWeights[k]. Vertex i represents the block blockIds[i].
+ */
+struct BlockGraph3D {
+    std::vector<plint> blockIds;
+    std::vector<double> vertexWeights;
+    std::vector<plint> offsets;
+    std::vector<plint> adjacency;
+    std::vector<double> edgeWeights;
+    plint getNumVertices() const {
+        return (plint)blockIds.size();
+    }
+};
+
+/// Create the graph of the blocks of a sparse block structure. Two blocks
+///   are connected if they exchange envelope cells, and the edge weight is
+///   the number of cells exchanged in both directions. The vertex weights
+///   are taken from weights (for example the number of active cells, see
+///   countActiveCells()), and default to the number of cells of the block.
+///   Contacts through periodic boundaries are not represented.
+void computeBlockGraph( SparseBlockStructure3D const& sparseBlock,
+                        std::map<plint,double> const& weights,
+                        plint envelopeWidth, BlockGraph3D& graph );
+
+/// Partition a graph into numParts parts with balanced vertex weights, while
+///   minimizing the weight of the cut edges. Returns the part of every vertex.
+/** Multilevel recursive bisection: the graph is coarsened by heavy-edge
+ *  matching, bisected by greedy graph growing, and the bisection is refined
+ *  by Fiduccia-Mattheyses passes while the graph is uncoarsened. The
+ *  k-way partition is finally refined by moving boundary vertices. The
+ *  weight of a part may exceed the average by the factor maxImbalance,
+ *  or by the weight of a single vertex. The algorithm is deterministic.
+ */
+std::vector<plint> partitionBlockGraph( BlockGraph3D const& graph, plint numParts,
+                                        double maxImbalance=1.03 );
+
+/// Total weight of the edges between vertices of different parts.
+double computeEdgeCut(BlockGraph3D const& graph, std::vector<plint> const& parts);
+
+/// Attribute the blocks to numProcs processes by partitioning their graph
+///   (see computeBlockGraph() and partitionBlockGraph()), so that the
+///   computational load is balanced and the number of envelope cells
+///   exchanged between processes is minimized. The weights must be known on
+///   all processes. This function is not collective: all processes compute
+///   the same attribution.
+ExplicitThreadAttribution* graphPartitionedThreadAttribution (
+        SparseBlockStructure3D const& sparseBlock,
+        std::map<plint,double> const& weights, plint envelopeWidth,
+        plint numProcs = global::mpi().getSize(), double maxImbalance=1.03 );
+
+/// Redistribution through graphPartitionedThreadAttribution().
+class GraphPartitionedRedistribute3D : public MultiBlockRedistribute3D {
+public:
+    GraphPartitionedRedistribute3D (
+            std::map<plint,double> const& weights_ = std::map<plint,double>(),
+            double maxImbalance_=1.03 );
+    virtual MultiBlockManagement3D redistribute(MultiBlockManagement3D const& original) const;
+private:
+    std::map<plint,double> weights;
+    double maxImbalance;
+};
+
+}  // namespace plb
+
+#endif  // BLOCK_GRAPH_PARTITIONING_3D_H
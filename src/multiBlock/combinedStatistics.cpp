@@ -26,12 +26,21 @@
  * The CombinedStatistics class -- implementation.
  */
 #include "multiBlock/combinedStatistics.h"
+#include "core/plbDebug.h"
 #include <cmath>
 #include <numeric>
 #include <limits>
 
 namespace plb {
 
+CombinedStatistics::CombinedStatistics()
+    : combinationPending(false)
+{ }
+
+CombinedStatistics::CombinedStatistics(CombinedStatistics const& rhs)
+    : combinationPending(false)
+{ }
+
 CombinedStatistics::~CombinedStatistics()
 { }
 
@@ -105,26 +114,41 @@ void CombinedStatistics::computeLocalIntSum (
 }
 
 
-void CombinedStatistics::combine (
-            std::vector<BlockStatistics const*>& individualStatistics,
-            BlockStatistics& result ) const
+void CombinedStatistics::computeLocalStatistics (
+            std::vector<BlockStatistics const*> const& individualStatistics,
+            BlockStatistics& result,
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables ) const
 {
     // Local averages
-    std::vector<double> averageObservables(result.getAverageVect().size());
-    std::vector<double> sumWeights(result.getAverageVect().size());
+    averageObservables.resize(result.getAverageVect().size());
+    sumWeights.resize(result.getAverageVect().size());
     computeLocalAverage(individualStatistics, averageObservables, sumWeights);
 
     // Local sums
-    std::vector<double> sumObservables(result.getSumVect().size());
+    sumObservables.resize(result.getSumVect().size());
     computeLocalSum(individualStatistics, sumObservables);
 
     // Local maxima
-    std::vector<double> maxObservables(result.getMaxVect().size());
+    maxObservables.resize(result.getMaxVect().size());
     computeLocalMax(individualStatistics, maxObservables);
 
     // Local integer sums
-    std::vector<plint> intSumObservables(result.getIntSumVect().size());
+    intSumObservables.resize(result.getIntSumVect().size());
     computeLocalIntSum(individualStatistics, intSumObservables);
+}
+
+void CombinedStatistics::combine (
+            std::vector<BlockStatistics const*>& individualStatistics,
+            BlockStatistics& result ) const
+{
+    std::vector<double> averageObservables, sumWeights, sumObservables, maxObservables;
+    std::vector<plint> intSumObservables;
+    computeLocalStatistics( individualStatistics, result, averageObservables, sumWeights,
+                            sumObservables, maxObservables, intSumObservables );
 
     // Compute global, cross-core statistics
     this->reduceStatistics (
@@ -138,6 +162,46 @@ void CombinedStatistics::combine (
         averageObservables, sumObservables, maxObservables, intSumObservables, 0 );
 }
 
+void CombinedStatistics::startCombination (
+            std::vector<BlockStatistics const*>& individualStatistics,
+            BlockStatistics& result )
+{
+    PLB_PRECONDITION( !combinationPending );
+    computeLocalStatistics( individualStatistics, result, pendingAverages, pendingWeights,
+                            pendingSums, pendingMax, pendingIntSums );
+    startReduction(pendingAverages, pendingWeights, pendingSums, pendingMax, pendingIntSums);
+    combinationPending = true;
+}
+
+void CombinedStatistics::completeCombination(BlockStatistics& result) {
+    if (!combinationPending) return;
+    completeReduction(pendingAverages, pendingWeights, pendingSums, pendingMax, pendingIntSums);
+    combinationPending = false;
+    result.evaluate(pendingAverages, pendingSums, pendingMax, pendingIntSums, 0);
+}
+
+bool CombinedStatistics::hasPendingCombination() const {
+    return combinationPending;
+}
+
+void CombinedStatistics::startReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables )
+{
+    reduceStatistics(averageObservables, sumWeights, sumObservables, maxObservables, intSumObservables);
+}
+
+void CombinedStatistics::completeReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables )
+{ }
+
 
 SerialCombinedStatistics* SerialCombinedStatistics::clone() const {
     return new SerialCombinedStatistics(*this);
@@ -36,11 +36,25 @@ namespace plb {
 
 class CombinedStatistics {
 public:
+    CombinedStatistics();
+    /// The copy has no pending combination.
+    CombinedStatistics(CombinedStatistics const& rhs);
     virtual ~CombinedStatistics();
     virtual CombinedStatistics* clone() const =0;
     void combine (
             std::vector<BlockStatistics const*>& individualStatistics,
             BlockStatistics& result ) const;
+    /// Non-blocking version of combine(): the statistics of the local blocks
+    ///   are combined, and their reduction across processes is started. The
+    ///   result is written into result by completeCombination(), which must
+    ///   be called before the next combination.
+    void startCombination (
+            std::vector<BlockStatistics const*>& individualStatistics,
+            BlockStatistics& result );
+    /// Wait for the combination started by startCombination() and write its
+    ///   result. Does nothing if no combination is pending.
+    void completeCombination(BlockStatistics& result);
+    bool hasPendingCombination() const;
 protected:
     virtual void reduceStatistics (
             std::vector<double>& averageObservables,
@@ -48,7 +62,31 @@ protected:
             std::vector<double>& sumObservables,
             std::vector<double>& maxObservables,
             std::vector<plint>& intSumObservables ) const =0;
+    /// Start the reduction of reduceStatistics() without waiting for its
+    ///   completion. The arguments remain untouched until completeReduction()
+    ///   is called, which writes the result into them. By default, the
+    ///   reduction is executed immediately by reduceStatistics().
+    virtual void startReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables );
+    virtual void completeReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables );
 private:
+    void computeLocalStatistics (
+            std::vector<BlockStatistics const*> const& individualStatistics,
+            BlockStatistics& result,
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables ) const;
     void computeLocalAverage (
             std::vector<BlockStatistics const*> const& individualStatistics,
             std::vector<double>& averageObservables,
@@ -62,6 +100,10 @@ private:
     void computeLocalIntSum (
             std::vector<BlockStatistics const*> const& individualStatistics,
             std::vector<plint>& intSumObservables ) const;
+private:
+    bool combinationPending;
+    std::vector<double> pendingAverages, pendingWeights, pendingSums, pendingMax;
+    std::vector<plint> pendingIntSums;
 };
 
 class SerialCombinedStatistics : public CombinedStatistics {
@@ -45,4 +45,7 @@
 #include "multiBlock/localMultiBlockInfo3D.h"
 #include "multiBlock/nonLocalTransfer3D.h"
 #include "multiBlock/multiBlockGenerator3D.h"
+#include "multiBlock/redistribution3D.h"
+#include "multiBlock/loadBalancer3D.h"
+#include "multiBlock/blockGraphPartitioning3D.h"
 
@@ -0,0 +1,141 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Dynamic load balancing of multi-blocks, based on the measured cost
+ * of their atomic-blocks -- implementation file.
+ */
+
+#include "multiBlock/loadBalancer3D.h"
+#include "multiBlock/redistribution3D.h"
+#include "multiBlock/multiBlockOperations3D.h"
+#include "core/plbDebug.h"
+#include <algorithm>
+
+namespace plb {
+
+LoadBalancer3D::LoadBalancer3D(plint period_, double maxImbalance_)
+    : period(period_),
+      maxImbalance(maxImbalance_),
+      iteration(0),
+      lastImbalance(1.),
+      numMigrations(0)
+{
+    PLB_PRECONDITION( period>0 );
+}
+
+void LoadBalancer3D::addMultiBlock(MultiBlock3D& multiBlock) {
+    PLB_PRECONDITION( multiBlocks.empty() ||
+                      multiBlock.getSparseBlockStructure().getNumBlocks() ==
+                      multiBlocks[0]->getSparseBlockStructure().getNumBlocks() );
+    if (multiBlocks.empty()) {
+        multiBlock.toggleBlockCostMeasurement(true);
+        multiBlock.resetMeasuredBlockCosts();
+    }
+    multiBlocks.push_back(&multiBlock);
+}
+
+bool LoadBalancer3D::iterate() {
+    PLB_PRECONDITION( !multiBlocks.empty() );
+    ++iteration;
+    if (iteration%period != 0) {
+        return false;
+    }
+    lastImbalance = computeLoadImbalance(multiBlocks[0]->getMeasuredBlockCosts());
+    if (lastImbalance > maxImbalance) {
+        rebalance();
+        return true;
+    }
+    multiBlocks[0]->resetMeasuredBlockCosts();
+    return false;
+}
+
+void LoadBalancer3D::rebalance() {
+    PLB_PRECONDITION( !multiBlocks.empty() );
+    // A data processor acting on a multi-block outside the group would be
+    //   re-created on atomic-blocks which are distributed differently.
+    PLB_PRECONDITION( processorsStayInGroup() );
+    MultiBlock3D& measuredBlock = *multiBlocks[0];
+    MultiBlockManagement3D const& management = measuredBlock.getMultiBlockManagement();
+    ExplicitThreadAttribution* newAttribution =
+            costBalancedThreadAttribution (
+                management.getSparseBlockStructure(), management.getThreadAttribution(),
+                measuredBlock.getMeasuredBlockCosts() );
+
+    // 1. Migrate all multi-blocks, before any data processor is re-created.
+    std::vector<MultiBlock3D*> previousBlocks(multiBlocks.size());
+    for (pluint iBlock=0; iBlock<multiBlocks.size(); ++iBlock) {
+        MultiBlockManagement3D const& oldManagement = multiBlocks[iBlock]->getMultiBlockManagement();
+        MultiBlockManagement3D newManagement (
+                oldManagement.getSparseBlockStructure(), newAttribution->clone(),
+                oldManagement.getEnvelopeWidth(), oldManagement.getRefinementLevel() );
+        previousBlocks[iBlock] = multiBlocks[iBlock]->migrate(newManagement);
+    }
+    delete newAttribution;
+    // 2. Re-create the data processors on the new atomic-blocks, with the
+    //    multi-block in which they were stored as actor. They refer to their
+    //    arguments by id, and hence to the migrated multi-blocks.
+    for (pluint iBlock=0; iBlock<previousBlocks.size(); ++iBlock) {
+        std::vector<MultiBlock3D::ProcessorStorage3D> const& processors =
+            previousBlocks[iBlock]->getStoredProcessors();
+        for (pluint iProcessor=0; iProcessor<processors.size(); ++iProcessor) {
+            addInternalProcessor( processors[iProcessor].getGenerator(), *multiBlocks[iBlock],
+                                  processors[iProcessor].getMultiBlocks(),
+                                  processors[iProcessor].getLevel() );
+        }
+        delete previousBlocks[iBlock];
+    }
+    measuredBlock.resetMeasuredBlockCosts();
+    ++numMigrations;
+}
+
+double LoadBalancer3D::getLastImbalance() const {
+    return lastImbalance;
+}
+
+plint LoadBalancer3D::getNumMigrations() const {
+    return numMigrations;
+}
+
+bool LoadBalancer3D::processorsStayInGroup() const {
+    std::vector<id_t> groupIds(multiBlocks.size());
+    for (pluint iBlock=0; iBlock<multiBlocks.size(); ++iBlock) {
+        groupIds[iBlock] = multiBlocks[iBlock]->getId();
+    }
+    for (pluint iBlock=0; iBlock<multiBlocks.size(); ++iBlock) {
+        std::vector<MultiBlock3D::ProcessorStorage3D> const& processors =
+            multiBlocks[iBlock]->getStoredProcessors();
+        for (pluint iProcessor=0; iProcessor<processors.size(); ++iProcessor) {
+            std::vector<id_t> const& ids = processors[iProcessor].getMultiBlockIds();
+            for (pluint iId=0; iId<ids.size(); ++iId) {
+                if (std::find(groupIds.begin(), groupIds.end(), ids[iId]) == groupIds.end()) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace plb
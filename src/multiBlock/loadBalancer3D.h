@@ -0,0 +1,85 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Dynamic load balancing of multi-blocks, based on the measured cost
+ * of their atomic-blocks -- header file.
+ */
+
+#ifndef LOAD_BALANCER_3D_H
+#define LOAD_BALANCER_3D_H
+
+#include "core/globalDefs.h"
+#include "multiBlock/multiBlock3D.h"
+#include <vector>
+
+namespace plb {
+
+/// Periodically migrates the atomic-blocks of a group of multi-blocks between
+///   the MPI processes, to balance the execution time of the atomic-blocks of
+///   the first multi-block of the group.
+/** The multi-blocks must have the same sparse block structure, and they all
+ *  receive the same new thread attribution (see costBalancedThreadAttribution()).
+ *  The data processors of the multi-blocks are re-created after the migration,
+ *  which requires that all multi-blocks coupled by a data processor belong
+ *  to the group: the data processors stored in a multi-block of the group
+ *  may only act on multi-blocks of the group (this is checked in debug mode),
+ *  and the data processors stored in other multi-blocks may not act on the
+ *  group. The multi-blocks must outlive the load balancer.
+ */
+class LoadBalancer3D {
+public:
+    /// Every period iterations, the load imbalance (see computeLoadImbalance())
+    ///   of the costs measured during these iterations is evaluated, and the
+    ///   blocks are migrated if it exceeds maxImbalance.
+    LoadBalancer3D(plint period_, double maxImbalance_=1.1);
+    /// Add a multi-block to the group. The cost of the atomic-blocks is measured
+    ///   on the first multi-block.
+    void addMultiBlock(MultiBlock3D& multiBlock);
+    /// To be called once per iteration. Returns true if the atomic-blocks have
+    ///   been migrated. Collective, every period iterations.
+    bool iterate();
+    /// Migrate the atomic-blocks according to the costs measured since the last
+    ///   evaluation, independently of the load imbalance. Collective.
+    void rebalance();
+    /// Load imbalance obtained at the last evaluation.
+    double getLastImbalance() const;
+    /// Number of times the atomic-blocks have been migrated.
+    plint getNumMigrations() const;
+private:
+    /// Tells whether all data processors stored in the multi-blocks of the
+    ///   group act on multi-blocks of the group only.
+    bool processorsStayInGroup() const;
+private:
+    plint period;
+    double maxImbalance;
+    plint iteration;
+    double lastImbalance;
+    plint numMigrations;
+    std::vector<MultiBlock3D*> multiBlocks;
+};
+
+}  // namespace plb
+
+#endif  // LOAD_BALANCER_3D_H
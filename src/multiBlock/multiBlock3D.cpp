@@ -28,10 +28,13 @@
 #include "multiBlock/multiBlock3D.h"
 #include "core/plbDebug.h"
 #include "core/plbProfiler.h"
+#include "core/runTimeDiagnostics.h"
 #include "atomicBlock/atomicBlock3D.h"
 #include "multiBlock/multiBlockOperations3D.h"
 #include "multiBlock/multiBlockSerializer3D.h"
 #include "multiBlock/defaultMultiBlockPolicy3D.h"
+#include "parallelism/smpThreadPool.h"
+#include "core/memoryPolicy.h"
 #include <cmath>
 #include <algorithm>
 
@@ -238,6 +241,86 @@ void MultiBlock3D::ProcessorStorage3D::replace (
 }
 
 
+/* *************** Class InternalProcessorsTask3D *************************** */
+
+/// Executes the internal processors of one atomic-block at a given level.
+class InternalProcessorsTask3D : public SmpTask {
+public:
+    InternalProcessorsTask3D(AtomicBlock3D& block_, plint level_)
+        : block(block_),
+          level(level_)
+    { }
+    virtual void execute() {
+        block.executeInternalProcessors(level);
+    }
+private:
+    AtomicBlock3D& block;
+    plint level;
+};
+
+/* *************** Class TimedBlockTask3D *********************************** */
+
+/// Executes the task of an atomic-block and measures its execution time,
+///   for the detailed timing of the hierarchical profiler. On the main
+///   thread, the block is a scope which contains the timers of the task.
+class TimedBlockTask3D : public SmpTask {
+public:
+    /// The scope of the block is registered here, by the main thread.
+    TimedBlockTask3D(SmpTask* task_, plint blockId)
+        : task(task_),
+          blockScope(global::hierarchicalProfiler().getBlockScope(blockId)),
+          threadId(0),
+          startTime(0.),
+          duration(0.)
+    { }
+    virtual void execute() {
+        global::HierarchicalProfiler& profiler = global::hierarchicalProfiler();
+        threadId = global::smpThreadPool().getThreadId();
+        profiler.setCurrentBlockScope(blockScope);
+        if (threadId==0) {
+            profiler.enter(blockScope);
+            task->execute();
+            profiler.leave(blockScope);
+        }
+        else {
+            startTime = profiler.getTime();
+            task->execute();
+            duration = profiler.getTime()-startTime;
+        }
+        profiler.setCurrentBlockScope(-1);
+    }
+    void report() const {
+        if (threadId!=0) {
+            global::hierarchicalProfiler().addBlockTime(blockScope, threadId, startTime, duration);
+        }
+    }
+private:
+    SmpTask* task;
+    plint blockScope;
+    int threadId;
+    double startTime, duration;
+};
+
+/* *************** Class MeasuredBlockTask3D ********************************* */
+
+/// Executes the task of an atomic-block and measures its execution time,
+///   for the cost measurement of the multi-block.
+class MeasuredBlockTask3D : public SmpTask {
+public:
+    MeasuredBlockTask3D(SmpTask* task_, double& duration_)
+        : task(task_),
+          duration(duration_)
+    { }
+    virtual void execute() {
+        double startTime = global::hierarchicalProfiler().getTime();
+        task->execute();
+        duration = global::hierarchicalProfiler().getTime()-startTime;
+    }
+private:
+    SmpTask* task;
+    double& duration;
+};
+
 /* *************** Class MultiBlock3D *************************************** */
 
 MultiBlock3D::MultiBlock3D( MultiBlockManagement3D const& multiBlockManagement_,
@@ -250,8 +333,13 @@ MultiBlock3D::MultiBlock3D( MultiBlockManagement3D const& multiBlockManagement_,
       combinedStatistics(combinedStatistics_),
       statSubscriber(*this),
       statisticsOn(true),
+      deferredStatisticsFlag(false),
       periodicitySwitch(*this),
-      internalModifT(modif::staticVariables)
+      internalModifT(modif::staticVariables),
+      deferredEnvelopeFlag(false),
+      envelopeUpdatePending(false),
+      pendingEnvelopeModifT(modif::nothing),
+      blockCostFlag(false)
 { 
     id = multiBlockRegistration3D().announce(*this);
 }
@@ -265,8 +353,13 @@ MultiBlock3D::MultiBlock3D(plint nx, plint ny, plint nz, plint envelopeWidth)
       combinedStatistics(defaultMultiBlockPolicy3D().getCombinedStatistics()),
       statSubscriber(*this),
       statisticsOn(true),
+      deferredStatisticsFlag(false),
       periodicitySwitch(*this),
-      internalModifT(modif::staticVariables)
+      internalModifT(modif::staticVariables),
+      deferredEnvelopeFlag(false),
+      envelopeUpdatePending(false),
+      pendingEnvelopeModifT(modif::nothing),
+      blockCostFlag(false)
 { 
     id = multiBlockRegistration3D().announce(*this);
 }
@@ -282,9 +375,19 @@ MultiBlock3D::MultiBlock3D(MultiBlock3D const& rhs)
       combinedStatistics(rhs.combinedStatistics -> clone()),
       statSubscriber(*this),
       statisticsOn(rhs.statisticsOn),
+      deferredStatisticsFlag(rhs.deferredStatisticsFlag),
       periodicitySwitch(*this, rhs.periodicitySwitch),
-      internalModifT(rhs.internalModifT)
+      internalModifT(rhs.internalModifT),
+      deferredEnvelopeFlag(rhs.deferredEnvelopeFlag),
+      // The envelope of the copy is as outdated as the one of the original.
+      envelopeUpdatePending(rhs.envelopeUpdatePending),
+      pendingEnvelopeModifT(rhs.pendingEnvelopeModifT),
+      blockCostFlag(rhs.blockCostFlag)
 { 
+    // The copy does not inherit a pending reduction: it copies its result.
+    if (rhs.hasPendingStatisticsReduction()) {
+        internalStatistics = rhs.getInternalStatistics();
+    }
     id = multiBlockRegistration3D().announce(*this);
 }
 
@@ -297,8 +400,13 @@ MultiBlock3D::MultiBlock3D(MultiBlock3D const& rhs, Box3D subDomain, bool crop)
       combinedStatistics(rhs.combinedStatistics->clone()),
       statSubscriber(*this),
       statisticsOn(true),
+      deferredStatisticsFlag(false),
       periodicitySwitch(*this),
-      internalModifT(rhs.internalModifT)
+      internalModifT(rhs.internalModifT),
+      deferredEnvelopeFlag(false),
+      envelopeUpdatePending(false),
+      pendingEnvelopeModifT(modif::nothing),
+      blockCostFlag(false)
 { 
     id = multiBlockRegistration3D().announce(*this);
 }
@@ -313,8 +421,14 @@ void MultiBlock3D::swap(MultiBlock3D& rhs) {
     std::swap(internalStatistics, rhs.internalStatistics);
     std::swap(combinedStatistics, rhs.combinedStatistics);
     std::swap(statisticsOn, rhs.statisticsOn);
+    std::swap(deferredStatisticsFlag, rhs.deferredStatisticsFlag);
     std::swap(periodicitySwitch, rhs.periodicitySwitch);
     std::swap(internalModifT, rhs.internalModifT);
+    std::swap(deferredEnvelopeFlag, rhs.deferredEnvelopeFlag);
+    std::swap(envelopeUpdatePending, rhs.envelopeUpdatePending);
+    std::swap(pendingEnvelopeModifT, rhs.pendingEnvelopeModifT);
+    std::swap(blockCostFlag, rhs.blockCostFlag);
+    blockCosts.swap(rhs.blockCosts);
 }
 
 MultiBlock3D::~MultiBlock3D() {
@@ -364,10 +478,13 @@ SparseBlockStructure3D const& MultiBlock3D::getSparseBlockStructure() const {
 }
 
 BlockStatistics& MultiBlock3D::getInternalStatistics() {
+    completeStatisticsReduction();
     return internalStatistics;
 }
 
 BlockStatistics const& MultiBlock3D::getInternalStatistics() const {
+    // The result of a deferred reduction is collected at the first access.
+    const_cast<MultiBlock3D*>(this)->completeStatisticsReduction();
     return internalStatistics;
 }
 
@@ -384,9 +501,58 @@ BlockCommunicator3D const& MultiBlock3D::getBlockCommunicator() const {
 }
 
 void MultiBlock3D::duplicateOverlaps(modif::ModifT whichData) {
+    // A postponed update is taken care of on the way.
+    if (envelopeUpdatePending) {
+        whichData = combine(whichData, pendingEnvelopeModifT);
+        envelopeUpdatePending = false;
+    }
     this->getBlockCommunicator().duplicateOverlaps(*this, whichData);
 }
 
+void MultiBlock3D::deferEnvelopeUpdates(bool flag) {
+    deferredEnvelopeFlag = flag;
+    if (!deferredEnvelopeFlag) {
+        updateDeferredEnvelope();
+    }
+}
+
+bool MultiBlock3D::envelopeUpdatesAreDeferred() const {
+    return deferredEnvelopeFlag;
+}
+
+bool MultiBlock3D::hasDeferredEnvelopeUpdate() const {
+    return envelopeUpdatePending;
+}
+
+void MultiBlock3D::startDeferredEnvelopeUpdate() {
+    PLB_PRECONDITION( envelopeUpdatePending );
+    this->getBlockCommunicator().startDuplicateOverlaps(*this, pendingEnvelopeModifT);
+}
+
+void MultiBlock3D::finalizeDeferredEnvelopeUpdate() {
+    PLB_PRECONDITION( envelopeUpdatePending );
+    this->getBlockCommunicator().finalizeDuplicateOverlaps(*this);
+    envelopeUpdatePending = false;
+}
+
+void MultiBlock3D::updateDeferredEnvelope() {
+    if (envelopeUpdatePending) {
+        envelopeUpdatePending = false;
+        this->getBlockCommunicator().duplicateOverlaps(*this, pendingEnvelopeModifT);
+    }
+}
+
+void MultiBlock3D::discardDeferredEnvelopeUpdate(modif::ModifT discardedData) {
+    if ( envelopeUpdatePending &&
+         combine(pendingEnvelopeModifT, discardedData) == discardedData )
+    {
+        envelopeUpdatePending = false;
+    }
+    else {
+        updateDeferredEnvelope();
+    }
+}
+
 void MultiBlock3D::signalPeriodicity() {
     getBlockCommunicator().signalPeriodicity();
 }
@@ -417,6 +583,9 @@ void MultiBlock3D::getDynamicsDict(Box3D domain, std::map<std::string,int>& dict
 }
 
 void MultiBlock3D::evaluateStatistics() {
+    // A deferred reduction must be collected before the statistics of the
+    //   atomic-blocks are overwritten.
+    completeStatisticsReduction();
     std::vector<plint> const& blocks = getLocalInfo().getBlocks();
     for (pluint iBlock=0; iBlock<blocks.size(); ++iBlock) {
         plint blockId = blocks[iBlock];
@@ -434,6 +603,11 @@ void MultiBlock3D::reduceStatistics() {
         individualStatistics.push_back(&getComponent(blockId).getInternalStatistics());
     }
 
+    if (deferredStatisticsFlag) {
+        combinedStatistics -> startCombination(individualStatistics, internalStatistics);
+        return;
+    }
+
     // Execute reduction operation on all individual statistics and store result into
     //   statistics of current MultiBlock.
     combinedStatistics -> combine(individualStatistics, this->getInternalStatistics());
@@ -452,6 +626,37 @@ bool MultiBlock3D::isInternalStatisticsOn() const {
     return statisticsOn;
 }
 
+void MultiBlock3D::deferStatisticsReduction(bool flag) {
+    if (!flag) {
+        completeStatisticsReduction();
+    }
+    deferredStatisticsFlag = flag;
+}
+
+bool MultiBlock3D::statisticsReductionIsDeferred() const {
+    return deferredStatisticsFlag;
+}
+
+bool MultiBlock3D::hasPendingStatisticsReduction() const {
+    return combinedStatistics->hasPendingCombination();
+}
+
+void MultiBlock3D::completeStatisticsReduction() {
+    if (!combinedStatistics->hasPendingCombination()) return;
+    combinedStatistics -> completeCombination(internalStatistics);
+    // Copy the result to each individual statistics. Only the public values
+    //   are copied, because the blocks may already gather the statistics of
+    //   the current iteration.
+    std::vector<plint> const& blocks = getLocalInfo().getBlocks();
+    for (pluint iBlock=0; iBlock<blocks.size(); ++iBlock) {
+        BlockStatistics& statistics = getComponent(blocks[iBlock]).getInternalStatistics();
+        statistics.getAverageVect() = internalStatistics.getAverageVect();
+        statistics.getSumVect() = internalStatistics.getSumVect();
+        statistics.getMaxVect() = internalStatistics.getMaxVect();
+        statistics.getIntSumVect() = internalStatistics.getIntSumVect();
+    }
+}
+
 PeriodicitySwitch3D const& MultiBlock3D::periodicity() const {
     return periodicitySwitch;
 }
@@ -476,31 +681,136 @@ void MultiBlock3D::setRefinementLevel(plint newLevel)
 }
 
 void MultiBlock3D::executeInternalProcessors() {
-    global::profiler().start("dataProcessor");
+    global::profiler().start(global::ProfilerTimer::dataProcessor);
     // Execute all automatic internal processors.
     for (plint iLevel=0; iLevel<=maxProcessorLevel; ++iLevel) {
         executeInternalProcessors(iLevel);
     }
     // Duplicate boundaries at least once in case there is no automatic processor.
     if (maxProcessorLevel==-1) {
-        global::profiler().start("envelope-update");
-        this->duplicateOverlaps(internalModifT);
-        global::profiler().stop("envelope-update");
+        global::profiler().start(global::ProfilerTimer::envelopeUpdate);
+        duplicateOwnOverlapsAtLevelZero(internalModifT);
+        global::profiler().stop(global::ProfilerTimer::envelopeUpdate);
     }
-    global::profiler().stop("dataProcessor");
+    global::profiler().stop(global::ProfilerTimer::dataProcessor);
 }
 
 void MultiBlock3D::executeInternalProcessors(plint level, bool communicate) {
+    updateDeferredEnvelopesOfProcessorArguments(level);
     std::vector<plint> const& blocks = getLocalInfo().getBlocks();
+    std::vector<SmpTask*> tasks(blocks.size());
     for (pluint iBlock=0; iBlock<blocks.size(); ++iBlock) {
         plint blockId = blocks[iBlock];
-        getComponent(blockId).executeInternalProcessors(level);
+        tasks[iBlock] = new InternalProcessorsTask3D(getComponent(blockId), level);
     }
+    executeLocalTasks(blocks, tasks);
     if (communicate) {
         duplicateOverlapsInModifiedMultiBlocks(level);
     }
 }
 
+plint MultiBlock3D::getMaxProcessorLevel() const {
+    return maxProcessorLevel;
+}
+
+void MultiBlock3D::executeAllocationTasks( std::vector<plint> const& blockIds,
+                                           std::vector<SmpTask*> const& tasks ) const
+{
+    PLB_PRECONDITION( blockIds.size()==tasks.size() );
+    ThreadAttribution const& threadAttribution = multiBlockManagement.getThreadAttribution();
+    std::vector<int> threadIds(tasks.size());
+    std::vector<plint> costs(tasks.size());
+    for (pluint iTask=0; iTask<tasks.size(); ++iTask) {
+        threadIds[iTask] = threadAttribution.getLocalThreadId(blockIds[iTask]);
+        costs[iTask] = SmartBulk3D(multiBlockManagement, blockIds[iTask]).computeEnvelope().nCells();
+    }
+    try {
+        if (global::memoryPolicy().isFirstTouchOn()) {
+            // Without stealing, the pages of a block are touched first by
+            //   the thread which processes the block.
+            global::smpThreadPool().execute(tasks, threadIds, costs, false);
+        }
+        else {
+            for (pluint iTask=0; iTask<tasks.size(); ++iTask) {
+                tasks[iTask]->execute();
+            }
+        }
+    }
+    catch (...) {
+        for (pluint iTask=0; iTask<tasks.size(); ++iTask) {
+            delete tasks[iTask];
+        }
+        throw;
+    }
+    for (pluint iTask=0; iTask<tasks.size(); ++iTask) {
+        delete tasks[iTask];
+    }
+}
+
+void MultiBlock3D::executeLocalTasks( std::vector<plint> const& blockIds,
+                                      std::vector<SmpTask*> const& tasks ) const
+{
+    PLB_PRECONDITION( blockIds.size()==tasks.size() );
+    ThreadAttribution const& threadAttribution = multiBlockManagement.getThreadAttribution();
+    std::vector<int> threadIds(tasks.size());
+    std::vector<plint> costs(tasks.size());
+    for (pluint iTask=0; iTask<tasks.size(); ++iTask) {
+        threadIds[iTask] = threadAttribution.getLocalThreadId(blockIds[iTask]);
+        costs[iTask] = SmartBulk3D(multiBlockManagement, blockIds[iTask]).getBulk().nCells();
+    }
+    // With detailed timing, the tasks are wrapped to measure the time of
+    //   each block. Nested calls, inside a task, are not timed separately.
+    global::HierarchicalProfiler& profiler = global::hierarchicalProfiler();
+    bool timeBlocks = profiler.isDetailedTimingOn() && !global::smpThreadPool().inParallelRegion();
+    std::vector<SmpTask*> timedTasks;
+    if (timeBlocks) {
+        timedTasks.resize(tasks.size());
+        for (pluint iTask=0; iTask<tasks.size(); ++iTask) {
+            timedTasks[iTask] = new TimedBlockTask3D(tasks[iTask], blockIds[iTask]);
+        }
+    }
+    // With cost measurement, the (possibly timed) tasks are wrapped once more.
+    bool measureBlocks = blockCostFlag && !global::smpThreadPool().inParallelRegion();
+    std::vector<SmpTask*> measuredTasks;
+    std::vector<double> durations;
+    if (measureBlocks) {
+        measuredTasks.resize(tasks.size());
+        durations.resize(tasks.size());
+        for (pluint iTask=0; iTask<tasks.size(); ++iTask) {
+            measuredTasks[iTask] = new MeasuredBlockTask3D (
+                    timeBlocks ? timedTasks[iTask] : tasks[iTask], durations[iTask] );
+        }
+    }
+    try {
+        global::smpThreadPool().execute (
+                measureBlocks ? measuredTasks : (timeBlocks ? timedTasks : tasks),
+                threadIds, costs );
+    }
+    catch (...) {
+        for (pluint iTask=0; iTask<tasks.size(); ++iTask) {
+            delete tasks[iTask];
+        }
+        for (pluint iTask=0; iTask<timedTasks.size(); ++iTask) {
+            delete timedTasks[iTask];
+        }
+        for (pluint iTask=0; iTask<measuredTasks.size(); ++iTask) {
+            delete measuredTasks[iTask];
+        }
+        throw;
+    }
+    for (pluint iTask=0; iTask<measuredTasks.size(); ++iTask) {
+        blockCosts[blockIds[iTask]] += durations[iTask];
+        delete measuredTasks[iTask];
+    }
+    for (pluint iTask=0; iTask<timedTasks.size(); ++iTask) {
+        static_cast<TimedBlockTask3D*>(timedTasks[iTask])->report();
+        delete timedTasks[iTask];
+    }
+    for (pluint iTask=0; iTask<tasks.size(); ++iTask) {
+        delete tasks[iTask];
+    }
+}
+
 void MultiBlock3D::subscribeProcessor (
         plint level,
         std::vector<MultiBlock3D*> modifiedBlocks,
@@ -534,6 +844,54 @@ std::vector<MultiBlock3D::ProcessorStorage3D> const&
     return storedProcessors;
 }
 
+void MultiBlock3D::toggleBlockCostMeasurement(bool flag) {
+    blockCostFlag = flag;
+}
+
+bool MultiBlock3D::isBlockCostMeasurementOn() const {
+    return blockCostFlag;
+}
+
+std::map<plint,double> const& MultiBlock3D::getMeasuredBlockCosts() const {
+    return blockCosts;
+}
+
+void MultiBlock3D::resetMeasuredBlockCosts() {
+    blockCosts.clear();
+}
+
+MultiBlock3D* MultiBlock3D::migrate(MultiBlockManagement3D const& newManagement) {
+    PLB_PRECONDITION( newManagement.getSparseBlockStructure().getNumBlocks() ==
+                      getSparseBlockStructure().getNumBlocks() );
+    // Pending updates refer to the current atomic-blocks.
+    updateDeferredEnvelope();
+    completeStatisticsReduction();
+    // The clone receives a copy of the content, distributed according to
+    //   newManagement. Its atomic-blocks are then exchanged with the current ones.
+    MultiBlock3D* previous = clone(newManagement);
+    swapComponents(*previous);
+    swapDistribution(*previous);
+    // The envelopes of the clone may contain no dynamics objects.
+    duplicateOverlaps(modif::dataStructure);
+    return previous;
+}
+
+void MultiBlock3D::swapComponents(MultiBlock3D& rhs) {
+    plbLogicError(std::string("The atomic-blocks of a ")+getBlockName()+" cannot be migrated.");
+}
+
+void MultiBlock3D::swapDistribution(MultiBlock3D& rhs) {
+    multiBlockManagement.swap(rhs.multiBlockManagement);
+    multiBlocksChangedByManualProcessors.swap(rhs.multiBlocksChangedByManualProcessors);
+    multiBlocksChangedByAutomaticProcessors.swap(rhs.multiBlocksChangedByAutomaticProcessors);
+    std::swap(maxProcessorLevel, rhs.maxProcessorLevel);
+    storedProcessors.swap(rhs.storedProcessors);
+    blockCosts.swap(rhs.blockCosts);
+    // The communication patterns of the previous distribution are obsolete.
+    signalPeriodicity();
+    rhs.signalPeriodicity();
+}
+
 void MultiBlock3D::addModifiedBlocks (
         plint level,
         std::vector<MultiBlock3D*> modifiedBlocks,
@@ -612,7 +970,7 @@ void MultiBlock3D::duplicateOverlapsAtLevelZero (
             treatedThis = true;
             // If it's the current multi-block we are treating, make sure
             //   type of modification is equal to internalModifT or stronger.
-            this->duplicateOverlaps(combine(modificationType, internalModifT));
+            duplicateOwnOverlapsAtLevelZero(combine(modificationType, internalModifT));
         }
         else {
             modifiedBlock->duplicateOverlaps(modificationType);
@@ -622,7 +980,38 @@ void MultiBlock3D::duplicateOverlapsAtLevelZero (
     //   overlaps explicitly (because overlaps are expected to be duplicated
     //   in any case at level 0).
     if (!treatedThis) {
-        this->duplicateOverlaps(internalModifT);
+        duplicateOwnOverlapsAtLevelZero(internalModifT);
+    }
+}
+
+void MultiBlock3D::duplicateOwnOverlapsAtLevelZero(modif::ModifT whichData)
+{
+    // The update can only be postponed if no further processor is going to
+    //   be executed on the outdated envelope during the current cycle.
+    if (deferredEnvelopeFlag && maxProcessorLevel<=0) {
+        pendingEnvelopeModifT = envelopeUpdatePending ?
+                                    combine(pendingEnvelopeModifT, whichData) : whichData;
+        envelopeUpdatePending = true;
+    }
+    else {
+        this->duplicateOverlaps(whichData);
+    }
+}
+
+/// Processors of the current multi-block may read the envelope of other
+///   multi-blocks. Make sure these envelopes are up-to-date.
+void MultiBlock3D::updateDeferredEnvelopesOfProcessorArguments(plint level)
+{
+    for (pluint iProcessor=0; iProcessor<storedProcessors.size(); ++iProcessor) {
+        if (storedProcessors[iProcessor].getLevel()==level) {
+            std::vector<id_t> const& ids = storedProcessors[iProcessor].getMultiBlockIds();
+            for (pluint iArg=0; iArg<ids.size(); ++iArg) {
+                MultiBlock3D* argument = multiBlockRegistration3D().find(ids[iArg]);
+                if (argument && argument!=this) {
+                    argument->updateDeferredEnvelope();
+                }
+            }
+        }
     }
 }
 
@@ -41,12 +41,14 @@
 #include <utility>
 #include <string>
 #include <vector>
+#include <map>
 
 namespace plb {
 
 class AtomicBlock3D;
 class MultiBlock3D;
 class MultiBlockRegistration3D;
+class SmpTask;
 template <typename T> class TypedAtomicBlock3D;
 template <typename T> class EulerianAtomicBlock3D;
 
@@ -139,6 +141,20 @@ public:
     void executeInternalProcessors();
     /// Execute all internal dataProcessors at a given level.
     void executeInternalProcessors(plint level, bool communicate=true);
+    /// Highest level of the internal dataProcessors, or -1 if there are
+    ///   no internal dataProcessors at positive or zero level.
+    plint getMaxProcessorLevel() const;
+    /// Execute tasks[iTask], which treats the local atomic-block blockIds[iTask],
+    ///   on the shared-memory thread pool, following the local-thread
+    ///   attribution of the blocks. The tasks are deleted afterwards.
+    void executeLocalTasks(std::vector<plint> const& blockIds,
+                           std::vector<SmpTask*> const& tasks) const;
+    /// Execute tasks[iTask], which allocates the local atomic-block
+    ///   blockIds[iTask]. With first-touch allocation, every task is executed
+    ///   by the thread which processes the block, and otherwise sequentially
+    ///   by the calling thread. The tasks are deleted afterwards.
+    void executeAllocationTasks(std::vector<plint> const& blockIds,
+                                std::vector<SmpTask*> const& tasks) const;
     /// After adding an internal processor to the atomic-blocks, subscribe it
     /// in the multi-block to guarantee it will be executed.
     void subscribeProcessor(plint level,
@@ -148,6 +164,23 @@ public:
     void storeProcessor(DataProcessorGenerator3D const& generator,
                         std::vector<MultiBlock3D*> multiBlocks, plint level);
     std::vector<ProcessorStorage3D> const& getStoredProcessors() const;
+    /// Measure the execution time of the tasks of every local atomic-block,
+    ///   such as the collision-streaming step and the data processors
+    ///   (default: false).
+    void toggleBlockCostMeasurement(bool flag);
+    bool isBlockCostMeasurementOn() const;
+    /// Execution time in seconds of the local atomic-blocks, accumulated since
+    ///   the last reset. Blocks which executed no task are absent.
+    std::map<plint,double> const& getMeasuredBlockCosts() const;
+    void resetMeasuredBlockCosts();
+    /// Move the atomic-blocks between the MPI processes, following the thread
+    ///   attribution of newManagement, which must have the same sparse block
+    ///   structure as the current one. The content of the multi-block is
+    ///   preserved. The data processors are not re-created: the multi-block
+    ///   which is returned holds the previous atomic-blocks and the stored
+    ///   processors, which must be transferred once all multi-blocks on which
+    ///   they act have been migrated (see LoadBalancer3D).
+    MultiBlock3D* migrate(MultiBlockManagement3D const& newManagement);
 public:
     MultiBlockManagement3D const& getMultiBlockManagement() const;
     void setCoProcessors(std::map<plint,int> const& coProcessors);
@@ -165,6 +198,19 @@ public:
     CombinedStatistics const& getCombinedStatistics() const;
     void toggleInternalStatistics(bool statisticsOn_);
     bool isInternalStatisticsOn() const;
+    /// If true, the reduction of the internal statistics across processes,
+    ///   which follows every evaluation of the statistics, is not waited for.
+    ///   It completes in the background, and its result is collected at the
+    ///   next access to the internal statistics of the multi-block (for
+    ///   example by getStoredAverageEnergy()), or at the next evaluation.
+    ///   Until then, the statistics of the atomic-blocks are not updated.
+    void deferStatisticsReduction(bool flag);
+    bool statisticsReductionIsDeferred() const;
+    /// True if a deferred reduction of the statistics is not yet collected.
+    bool hasPendingStatisticsReduction() const;
+    /// Wait for a deferred reduction of the statistics, if there is one, and
+    ///   store its result.
+    void completeStatisticsReduction();
     PeriodicitySwitch3D const& periodicity() const;
     PeriodicitySwitch3D& periodicity();
     /// Returns: which kind of data is modified by level-0 processors and by
@@ -179,7 +225,13 @@ public:
     virtual AtomicBlock3D const& getComponent(plint blockId) const =0;
     virtual plint sizeOfCell() const =0;
     virtual plint getCellDim() const =0;
+protected:
+    /// Exchange the atomic-blocks with the ones of rhs, a multi-block of the
+    ///   same type (used by migrate()). By default, migration is not supported.
+    virtual void swapComponents(MultiBlock3D& rhs);
 private:
+    /// Exchange all data which depends on the distribution of the atomic-blocks.
+    void swapDistribution(MultiBlock3D& rhs);
     void addModifiedBlocks(plint level,
                            std::vector<MultiBlock3D*> modifiedBlocks,
                            std::vector<modif::ModifT> typeOfModification,
@@ -188,6 +240,8 @@ private:
     void duplicateOverlapsInModifiedMultiBlocks(plint level);
     void duplicateOverlapsInModifiedMultiBlocks(std::vector<BlockAndModif>& multiBlocks);
     void duplicateOverlapsAtLevelZero(std::vector<BlockAndModif>& multiBlocks);
+    void duplicateOwnOverlapsAtLevelZero(modif::ModifT whichData);
+    void updateDeferredEnvelopesOfProcessorArguments(plint level);
     void reduceStatistics();
 public:
     BlockCommunicator3D const& getBlockCommunicator() const;
@@ -195,6 +249,24 @@ public:
                 MultiBlock3D const& fromBlock, Box3D const& fromDomain,
                 Box3D const& toDomain, modif::ModifT whichData=modif::dataStructure ) =0;
     void duplicateOverlaps(modif::ModifT whichData);
+    /// If true, the update of the own envelope which is due at the end of the
+    ///   level-0 processors is not executed immediately, but postponed until
+    ///   it is executed explicitly or implicitly, through one of the functions
+    ///   below. This is only done when there are no processors at level>0.
+    void deferEnvelopeUpdates(bool flag);
+    bool envelopeUpdatesAreDeferred() const;
+    /// True if the envelope is outdated because of a postponed update.
+    bool hasDeferredEnvelopeUpdate() const;
+    /// Initiate the postponed envelope update without waiting for its completion.
+    void startDeferredEnvelopeUpdate();
+    /// Conclude the envelope update initiated by startDeferredEnvelopeUpdate().
+    void finalizeDeferredEnvelopeUpdate();
+    /// Execute the postponed envelope update, if there is one.
+    void updateDeferredEnvelope();
+    /// Drop the postponed envelope update if it concerns at most the given
+    ///   type of data, because the caller takes care of the envelope in
+    ///   another way. Any other postponed update is executed.
+    void discardDeferredEnvelopeUpdate(modif::ModifT discardedData);
     void signalPeriodicity();
     virtual DataSerializer* getBlockSerializer (
             Box3D const& domain, IndexOrdering::OrderingT ordering ) const;
@@ -224,8 +296,14 @@ private:
     CombinedStatistics* combinedStatistics;
     MultiStatSubscriber3D statSubscriber;
     bool statisticsOn;
+    bool deferredStatisticsFlag;
     PeriodicitySwitch3D periodicitySwitch;
     modif::ModifT internalModifT;
+    bool deferredEnvelopeFlag;
+    bool envelopeUpdatePending;
+    modif::ModifT pendingEnvelopeModifT;
+    bool blockCostFlag;
+    mutable std::map<plint,double> blockCosts;
     id_t id;
 };
 
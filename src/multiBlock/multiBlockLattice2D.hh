@@ -294,7 +294,7 @@ void MultiBlockLattice2D<T,Descriptor>::collideAndStream(Box2D domain) {
 
 template<typename T, template<typename U> class Descriptor>
 void MultiBlockLattice2D<T,Descriptor>::collideAndStream() {
-    global::profiler().start("cycle");
+    global::profiler().start(global::ProfilerTimer::cycle);
     for ( typename BlockMap::iterator it = blockLattices.begin();
           it != blockLattices.end(); ++it)
     {
@@ -311,7 +311,7 @@ void MultiBlockLattice2D<T,Descriptor>::collideAndStream() {
     if (global::profiler().cyclingIsAutomatic()) {
         global::profiler().cycle();
     }
-    global::profiler().stop("cycle");
+    global::profiler().stop(global::ProfilerTimer::cycle);
 }
 
 template<typename T, template<typename U> class Descriptor>
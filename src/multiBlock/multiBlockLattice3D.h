@@ -35,6 +35,7 @@
 #include "core/blockStatistics.h"
 #include "core/cell.h"
 #include "core/dynamics.h"
+#include "parallelism/smpThreadPool.h"
 #include <vector>
 
 namespace plb {
@@ -42,6 +43,98 @@ namespace plb {
 template<typename T, template<typename U> class Descriptor> class BlockLattice3D;
 
 
+/// Executes collision-streaming on a domain of one atomic-block.
+template<typename T, template<typename U> class Descriptor>
+class CollideAndStreamTask3D : public SmpTask {
+public:
+    CollideAndStreamTask3D(BlockLattice3D<T,Descriptor>& lattice_, Box3D domain_)
+        : lattice(lattice_),
+          domain(domain_)
+    { }
+    virtual void execute() {
+        lattice.collideAndStream(domain);
+    }
+private:
+    BlockLattice3D<T,Descriptor>& lattice;
+    Box3D domain;
+};
+
+/// Executes several collision-streaming steps on one atomic-block, on a
+///   domain which shrinks by the lattice vicinity at each step on the sides
+///   on which it extends beyond the bulk.
+template<typename T, template<typename U> class Descriptor>
+class MultiStepCollideAndStreamTask3D : public SmpTask {
+public:
+    MultiStepCollideAndStreamTask3D( BlockLattice3D<T,Descriptor>& lattice_,
+                                     Box3D domain_, Box3D bulk_, plint numSteps_ )
+        : lattice(lattice_),
+          domain(domain_),
+          bulk(bulk_),
+          numSteps(numSteps_)
+    { }
+    virtual void execute();
+private:
+    BlockLattice3D<T,Descriptor>& lattice;
+    Box3D domain, bulk;
+    plint numSteps;
+};
+
+/// Executes BlockLattice3D::completeCollideAndStream on one atomic-block.
+template<typename T, template<typename U> class Descriptor>
+class CompleteCollideAndStreamTask3D : public SmpTask {
+public:
+    CompleteCollideAndStreamTask3D(BlockLattice3D<T,Descriptor>& lattice_, Box3D domain_, Box3D core_)
+        : lattice(lattice_),
+          domain(domain_),
+          core(core_)
+    { }
+    virtual void execute() {
+        lattice.completeCollideAndStream(domain, core);
+    }
+private:
+    BlockLattice3D<T,Descriptor>& lattice;
+    Box3D domain, core;
+};
+
+/// Executes BlockLattice3D::completeStream on one atomic-block.
+template<typename T, template<typename U> class Descriptor>
+class CompleteStreamTask3D : public SmpTask {
+public:
+    CompleteStreamTask3D(BlockLattice3D<T,Descriptor>& lattice_, Box3D domain_, Box3D core_)
+        : lattice(lattice_),
+          domain(domain_),
+          core(core_)
+    { }
+    virtual void execute() {
+        lattice.completeStream(domain, core);
+    }
+private:
+    BlockLattice3D<T,Descriptor>& lattice;
+    Box3D domain, core;
+};
+
+/// Constructs one atomic-block of a multi-block lattice, with the envelope
+///   as its domain; see MultiBlock3D::executeAllocationTasks().
+template<typename T, template<typename U> class Descriptor>
+class AllocateBlockLatticeTask3D : public SmpTask {
+public:
+    AllocateBlockLatticeTask3D( Box3D envelope_, Dynamics<T,Descriptor>* backgroundDynamics_,
+                                BlockLattice3D<T,Descriptor>*& lattice_ )
+        : envelope(envelope_),
+          backgroundDynamics(backgroundDynamics_),
+          lattice(lattice_)
+    { }
+    virtual void execute() {
+        lattice = new BlockLattice3D<T,Descriptor> (
+                envelope.getNx(), envelope.getNy(), envelope.getNz(), backgroundDynamics );
+        lattice -> setLocation(Dot3D(envelope.x0, envelope.y0, envelope.z0));
+    }
+private:
+    Box3D envelope;
+    Dynamics<T,Descriptor>* backgroundDynamics;
+    BlockLattice3D<T,Descriptor>*& lattice;
+};
+
 template<typename T, template<typename U> class Descriptor>
 struct MultiCellAccess3D {
     virtual ~MultiCellAccess3D() { }
@@ -105,6 +198,72 @@ public:
     virtual void stream();
     virtual void collideAndStream(Box3D domain);
     virtual void collideAndStream();
+    /// Overlap the update of the envelopes with the collision-streaming step.
+    /** When this mode is on, the envelope update which concludes a cycle is
+     *  postponed to the next call to collideAndStream(). There, the communication
+     *  is initiated, the bulk of each atomic-block is treated while the messages
+     *  are in transit, and the envelope is treated when the messages have arrived.
+     *  The mode is inactive on lattices with data processors at a level larger than 0.
+     */
+    void toggleCommunicationOverlap(bool overlap);
+    bool isCommunicationOverlapOn() const;
+    /// Only communicate the populations which are streamed into the neighboring blocks.
+    /** When this mode is on, the envelope update which concludes a cycle is
+     *  postponed, as with toggleCommunicationOverlap(). In the next call to
+     *  collideAndStream(), the envelope is not collided. Instead, the bulk of
+     *  each atomic-block is treated first, and only the populations which leave
+     *  the bulk across a face, an edge or a corner of an overlap are sent to
+     *  the neighbors, to be streamed into their bulk (for D3Q19, 5 populations
+     *  per cell on a face instead of all 19 and the external scalars). The
+     *  envelope is updated in full only when it is accessed between two cycles.
+     *  This mode takes precedence over the overlap of communication and
+     *  computation, and is inactive on lattices with data processors at a
+     *  level larger than 0.
+     */
+    void toggleDirectionalEnvelope(bool directional);
+    bool isDirectionalEnvelopeOn() const;
+    /// Execute numSteps collision-streaming cycles with temporal blocking
+    ///   (experimental).
+    /** The envelope is exchanged once for up to k=envelopeWidth/vicinity
+     *  cycles: each atomic-block executes these k cycles back-to-back, on
+     *  its bulk and envelope at the first cycle, and on a domain which shrinks
+     *  by the vicinity at each further cycle, so that the bulk is exact after
+     *  k cycles. The lattice must therefore be constructed with an envelope
+     *  width of k times the vicinity. The temporal tile is the whole
+     *  atomic-block: the memory traffic can only be reduced with atomic-blocks
+     *  which fit into the cache, and the redundant computations in the
+     *  envelope grow with k. No speed-up over collideAndStream() has been
+     *  measured so far.
+     *  The result differs from numSteps calls to collideAndStream() in the
+     *  statistics: they are evaluated once every k cycles, so that
+     *  getInternalStatistics() and the getStored... functions give averages
+     *  and maxima over the last k cycles, instead of the last cycle.
+     *  On lattices with internal data processors at a positive or zero level
+     *  (as set up by the non-local boundary conditions, for example),
+     *  or with co-processors, the cycles are executed one by one through
+     *  collideAndStream().
+     */
+    void multiStepCollideAndStream(plint numSteps);
+    /// Store the populations of all local atomic-blocks as a structure of arrays.
+    /** See BlockLattice3D::toggleStructureOfArrays(). */
+    void toggleStructureOfArrays(bool soaFlag_);
+    bool isStructureOfArraysOn() const;
+    /// Store the structure of arrays of all local atomic-blocks in single precision.
+    /** The structure-of-arrays mode is turned on along with this setting.
+     *  See BlockLattice3D::toggleSinglePrecisionStorage().
+     */
+    void toggleSinglePrecisionStorage(bool singlePrecisionFlag_);
+    bool isSinglePrecisionStorageOn() const;
+    /// Restrict the collision-streaming step of all local atomic-blocks
+    ///   to the cells whose dynamics is not NoDynamics.
+    /** See BlockLattice3D::toggleIndirectAddressing(). */
+    void toggleIndirectAddressing(bool indirectFlag_);
+    bool isIndirectAddressingOn() const;
+    /// Share all identical compactable dynamics between the cells of each local
+    ///   atomic-block.
+    /** See BlockLattice3D::toggleCompactDynamics(). */
+    void toggleCompactDynamics(bool compactDynamicsFlag_);
+    bool isCompactDynamicsOn() const;
     virtual void incrementTime();
     virtual void resetTime(pluint value);
     virtual BlockLattice3D<T,Descriptor>& getComponent(plint blockId);
@@ -124,14 +283,25 @@ public:
     static std::string blockName();
     static std::string basicType();
     static std::string descriptorType();
+protected:
+    virtual void swapComponents(MultiBlock3D& rhs);
 private:
     void allocateAndInitialize();
     void eliminateStatisticsInEnvelope();
+    void overlappingCollideAndStream();
+    void directionalCollideAndStream();
     Box3D extendPeriodic(Box3D const& box, plint envelopeWidth) const;
 private:
     Dynamics<T,Descriptor>* backgroundDynamics;
     MultiCellAccess3D<T,Descriptor>* multiCellAccess;
     BlockMap blockLattices;
+    bool directionalEnvelopeFlag;
+    /// Modes of the local atomic-blocks, stored here so that all processes
+    ///   agree on them, including those which hold no atomic-block.
+    bool soaFlag;
+    bool singlePrecisionFlag;
+    bool indirectFlag;
+    bool compactDynamicsFlag;
     static const int staticId;
 };
 
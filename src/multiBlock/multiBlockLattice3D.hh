@@ -47,6 +47,28 @@
 
 namespace plb {
 
+////////////////////// Class MultiStepCollideAndStreamTask3D /////////////////////////
+
+/** The populations which enter the domain from outside are wrong after each
+ *  step; the error propagates by one vicinity per step, and is kept outside
+ *  the domain of the next step by shrinking it accordingly.
+ */
+template<typename T, template<typename U> class Descriptor>
+void MultiStepCollideAndStreamTask3D<T,Descriptor>::execute() {
+    static const plint vicinity = Descriptor<T>::vicinity;
+    for (plint iStep=0; iStep<numSteps; ++iStep) {
+        plint shrink = iStep*vicinity;
+        Box3D stepDomain(domain);
+        if (domain.x0<bulk.x0) stepDomain.x0 = std::min(domain.x0+shrink, bulk.x0);
+        if (domain.x1>bulk.x1) stepDomain.x1 = std::max(domain.x1-shrink, bulk.x1);
+        if (domain.y0<bulk.y0) stepDomain.y0 = std::min(domain.y0+shrink, bulk.y0);
+        if (domain.y1>bulk.y1) stepDomain.y1 = std::max(domain.y1-shrink, bulk.y1);
+        if (domain.z0<bulk.z0) stepDomain.z0 = std::min(domain.z0+shrink, bulk.z0);
+        if (domain.z1>bulk.z1) stepDomain.z1 = std::max(domain.z1-shrink, bulk.z1);
+        lattice.collideAndStream(stepDomain);
+    }
+}
+
 ////////////////////// Class MultiBlockLattice3D /////////////////////////
 
 template<typename T, template<typename U> class Descriptor>
@@ -65,7 +87,12 @@ MultiBlockLattice3D<T,Descriptor>::MultiBlockLattice3D (
         Dynamics<T,Descriptor>* backgroundDynamics_ )
     : MultiBlock3D(multiBlockManagement_, blockCommunicator_, combinedStatistics_ ),
       backgroundDynamics(backgroundDynamics_),
-      multiCellAccess(multiCellAccess_)
+      multiCellAccess(multiCellAccess_),
+      directionalEnvelopeFlag(false),
+      soaFlag(false),
+      singlePrecisionFlag(false),
+      indirectFlag(false),
+      compactDynamicsFlag(false)
 {
     allocateAndInitialize();
     eliminateStatisticsInEnvelope();
@@ -78,7 +105,12 @@ MultiBlockLattice3D<T,Descriptor>::MultiBlockLattice3D (
         Dynamics<T,Descriptor>* backgroundDynamics_ )
     : MultiBlock3D(nx,ny,nz,Descriptor<T>::vicinity),
       backgroundDynamics(backgroundDynamics_),
-      multiCellAccess(defaultMultiBlockPolicy3D().getMultiCellAccess<T,Descriptor>())
+      multiCellAccess(defaultMultiBlockPolicy3D().getMultiCellAccess<T,Descriptor>()),
+      directionalEnvelopeFlag(false),
+      soaFlag(false),
+      singlePrecisionFlag(false),
+      indirectFlag(false),
+      compactDynamicsFlag(false)
 {
     allocateAndInitialize();
     eliminateStatisticsInEnvelope();
@@ -101,7 +133,12 @@ MultiBlockLattice3D<T,Descriptor>::MultiBlockLattice3D(MultiBlockLattice3D<T,Des
     : BlockLatticeBase3D<T,Descriptor>(rhs),
       MultiBlock3D(rhs),
       backgroundDynamics(rhs.backgroundDynamics->clone()),
-      multiCellAccess(rhs.multiCellAccess->clone())
+      multiCellAccess(rhs.multiCellAccess->clone()),
+      directionalEnvelopeFlag(rhs.directionalEnvelopeFlag),
+      soaFlag(rhs.soaFlag),
+      singlePrecisionFlag(rhs.singlePrecisionFlag),
+      indirectFlag(rhs.indirectFlag),
+      compactDynamicsFlag(rhs.compactDynamicsFlag)
 {
     for ( typename  BlockMap::const_iterator it = rhs.blockLattices.begin();
           it != rhs.blockLattices.end(); ++it )
@@ -115,7 +152,12 @@ MultiBlockLattice3D<T,Descriptor>::MultiBlockLattice3D(MultiBlock3D const& rhs)
       // Use MultiBlock's sub-domain constructor to avoid that the data-processors are copied
     : MultiBlock3D(rhs, rhs.getBoundingBox(), false),
       backgroundDynamics(new NoDynamics<T,Descriptor>),
-      multiCellAccess(defaultMultiBlockPolicy3D().getMultiCellAccess<T,Descriptor>())
+      multiCellAccess(defaultMultiBlockPolicy3D().getMultiCellAccess<T,Descriptor>()),
+      directionalEnvelopeFlag(false),
+      soaFlag(false),
+      singlePrecisionFlag(false),
+      indirectFlag(false),
+      compactDynamicsFlag(false)
 {
     allocateAndInitialize();
     eliminateStatisticsInEnvelope();
@@ -125,7 +167,12 @@ template<typename T, template<typename U> class Descriptor>
 MultiBlockLattice3D<T,Descriptor>::MultiBlockLattice3D(MultiBlock3D const& rhs, Box3D subDomain, bool crop)
     : MultiBlock3D(rhs, subDomain, crop),
       backgroundDynamics(new NoDynamics<T,Descriptor>),
-      multiCellAccess(defaultMultiBlockPolicy3D().getMultiCellAccess<T,Descriptor>())
+      multiCellAccess(defaultMultiBlockPolicy3D().getMultiCellAccess<T,Descriptor>()),
+      directionalEnvelopeFlag(false),
+      soaFlag(false),
+      singlePrecisionFlag(false),
+      indirectFlag(false),
+      compactDynamicsFlag(false)
 {
     allocateAndInitialize();
     eliminateStatisticsInEnvelope();
@@ -137,9 +184,33 @@ void MultiBlockLattice3D<T,Descriptor>::swap(MultiBlockLattice3D<T,Descriptor>&
     MultiBlock3D::swap(rhs);
     std::swap(backgroundDynamics, rhs.backgroundDynamics);
     std::swap(multiCellAccess, rhs.multiCellAccess);
+    std::swap(directionalEnvelopeFlag, rhs.directionalEnvelopeFlag);
+    std::swap(soaFlag, rhs.soaFlag);
+    std::swap(singlePrecisionFlag, rhs.singlePrecisionFlag);
+    std::swap(indirectFlag, rhs.indirectFlag);
+    std::swap(compactDynamicsFlag, rhs.compactDynamicsFlag);
     blockLattices.swap(rhs.blockLattices);
 }
 
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::swapComponents(MultiBlock3D& rhs) {
+    MultiBlockLattice3D<T,Descriptor>& rhsLattice =
+        dynamic_cast<MultiBlockLattice3D<T,Descriptor>&>(rhs);
+    blockLattices.swap(rhsLattice.blockLattices);
+    std::swap(multiCellAccess, rhsLattice.multiCellAccess);
+    // The new atomic-blocks inherit the modes and the time of the lattice,
+    //   and the previous ones, now in rhs, keep theirs.
+    rhsLattice.soaFlag = soaFlag;
+    rhsLattice.singlePrecisionFlag = singlePrecisionFlag;
+    rhsLattice.indirectFlag = indirectFlag;
+    rhsLattice.compactDynamicsFlag = compactDynamicsFlag;
+    toggleSinglePrecisionStorage(singlePrecisionFlag);
+    toggleStructureOfArrays(soaFlag);
+    toggleIndirectAddressing(indirectFlag);
+    toggleCompactDynamics(compactDynamicsFlag);
+    resetTime(this->getTimeCounter().getTime());
+}
+
 template<typename T, template<typename U> class Descriptor>
 MultiBlockLattice3D<T,Descriptor>& MultiBlockLattice3D<T,Descriptor>::operator= (
         MultiBlockLattice3D<T,Descriptor> const& rhs )
@@ -203,6 +274,7 @@ void MultiBlockLattice3D<T,Descriptor>::specifyStatisticsStatus (Box3D domain, b
 
 template<typename T, template<typename U> class Descriptor>
 void MultiBlockLattice3D<T,Descriptor>::collide(Box3D domain) {
+    this->updateDeferredEnvelope();
     Box3D inters;
     for ( typename BlockMap::iterator it = blockLattices.begin();
           it != blockLattices.end(); ++it)
@@ -217,6 +289,7 @@ void MultiBlockLattice3D<T,Descriptor>::collide(Box3D domain) {
 
 template<typename T, template<typename U> class Descriptor>
 void MultiBlockLattice3D<T,Descriptor>::collide() {
+    this->updateDeferredEnvelope();
     for ( typename BlockMap::iterator it = blockLattices.begin();
           it != blockLattices.end(); ++it)
     {
@@ -226,6 +299,7 @@ void MultiBlockLattice3D<T,Descriptor>::collide() {
 
 template<typename T, template<typename U> class Descriptor>
 void MultiBlockLattice3D<T,Descriptor>::stream(Box3D domain) {
+    this->updateDeferredEnvelope();
     Box3D inters;
     for ( typename BlockMap::iterator it = blockLattices.begin();
           it != blockLattices.end(); ++it)
@@ -275,6 +349,7 @@ Box3D MultiBlockLattice3D<T,Descriptor>::extendPeriodic(Box3D const& box, plint
 
 template<typename T, template<typename U> class Descriptor>
 void MultiBlockLattice3D<T,Descriptor>::stream() {
+    this->updateDeferredEnvelope();
     for ( typename BlockMap::iterator it = blockLattices.begin();
           it != blockLattices.end(); ++it)
     {
@@ -291,6 +366,7 @@ void MultiBlockLattice3D<T,Descriptor>::stream() {
 
 template<typename T, template<typename U> class Descriptor>
 void MultiBlockLattice3D<T,Descriptor>::collideAndStream(Box3D domain) {
+    this->updateDeferredEnvelope();
     Box3D inters;
     for ( typename BlockMap::iterator it = blockLattices.begin();
           it != blockLattices.end(); ++it)
@@ -305,9 +381,10 @@ void MultiBlockLattice3D<T,Descriptor>::collideAndStream(Box3D domain) {
 
 template<typename T, template<typename U> class Descriptor>
 void MultiBlockLattice3D<T,Descriptor>::collideAndStream() {
-    global::profiler().start("cycle");
+    global::profiler().start(global::ProfilerTimer::cycle);
     ThreadAttribution const& threadAttribution=this->getMultiBlockManagement().getThreadAttribution();
     if (threadAttribution.hasCoProcessors()) {
+        this->updateDeferredEnvelope();
         for ( typename BlockMap::iterator it = blockLattices.begin();
               it != blockLattices.end(); ++it )
         {
@@ -326,7 +403,15 @@ void MultiBlockLattice3D<T,Descriptor>::collideAndStream() {
             }
         }
     }
+    else if (directionalEnvelopeFlag && this->hasDeferredEnvelopeUpdate()) {
+        directionalCollideAndStream();
+    }
+    else if (this->hasDeferredEnvelopeUpdate()) {
+        overlappingCollideAndStream();
+    }
     else  {
+        std::vector<plint> blockIds;
+        std::vector<SmpTask*> tasks;
         for ( typename BlockMap::iterator it = blockLattices.begin();
               it != blockLattices.end(); ++it)
         {
@@ -335,8 +420,10 @@ void MultiBlockLattice3D<T,Descriptor>::collideAndStream() {
             //   including currently active envelopes.
             Box3D domain = extendPeriodic(bulk.computeNonPeriodicEnvelope(),
                                           this->getMultiBlockManagement().getEnvelopeWidth());
-            it->second -> collideAndStream( bulk.toLocal(domain) );
+            blockIds.push_back(it->first);
+            tasks.push_back(new CollideAndStreamTask3D<T,Descriptor>(*it->second, bulk.toLocal(domain)));
         }
+        this->executeLocalTasks(blockIds, tasks);
     }
     this->executeInternalProcessors();
     this->evaluateStatistics();
@@ -344,7 +431,205 @@ void MultiBlockLattice3D<T,Descriptor>::collideAndStream() {
     if (global::profiler().cyclingIsAutomatic()) {
         global::profiler().cycle();
     }
-    global::profiler().stop("cycle");
+    global::profiler().stop(global::ProfilerTimer::cycle);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::multiStepCollideAndStream(plint numSteps) {
+    plint envelopeWidth = this->getMultiBlockManagement().getEnvelopeWidth();
+    plint stepsPerSweep = envelopeWidth / Descriptor<T>::vicinity;
+    if ( this->getMultiBlockManagement().getThreadAttribution().hasCoProcessors() ||
+         this->getMaxProcessorLevel()>=0 || stepsPerSweep<=1 )
+    {
+        for (plint iStep=0; iStep<numSteps; ++iStep) {
+            collideAndStream();
+        }
+        return;
+    }
+    plint iStep = 0;
+    while (iStep<numSteps) {
+        plint sweepSteps = std::min(stepsPerSweep, numSteps-iStep);
+        global::profiler().start(global::ProfilerTimer::cycle);
+        this->updateDeferredEnvelope();
+        std::vector<plint> blockIds;
+        std::vector<SmpTask*> tasks;
+        for ( typename BlockMap::iterator it = blockLattices.begin();
+              it != blockLattices.end(); ++it)
+        {
+            SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+            Box3D domain = extendPeriodic(bulk.computeNonPeriodicEnvelope(), envelopeWidth);
+            blockIds.push_back(it->first);
+            tasks.push_back(new MultiStepCollideAndStreamTask3D<T,Descriptor> (
+                                *it->second, bulk.toLocal(domain), bulk.toLocal(bulk.getBulk()),
+                                sweepSteps ));
+        }
+        this->executeLocalTasks(blockIds, tasks);
+        // Without processors, this only updates the envelope.
+        this->executeInternalProcessors();
+        this->evaluateStatistics();
+        for (plint iSweepStep=0; iSweepStep<sweepSteps; ++iSweepStep) {
+            this->incrementTime();
+        }
+        if (global::profiler().cyclingIsAutomatic()) {
+            global::profiler().cycle();
+        }
+        global::profiler().stop(global::ProfilerTimer::cycle);
+        iStep += sweepSteps;
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::overlappingCollideAndStream() {
+    // 1. Send the bulk data which is needed by the envelopes of the neighbors.
+    this->startDeferredEnvelopeUpdate();
+    // 2. While the messages are in transit, treat the bulk which does not depend
+    //    on the envelope.
+    std::vector<plint> blockIds;
+    std::vector<SmpTask*> tasks;
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+        blockIds.push_back(it->first);
+        tasks.push_back(new CollideAndStreamTask3D<T,Descriptor>(*it->second, bulk.toLocal(bulk.getBulk())));
+    }
+    this->executeLocalTasks(blockIds, tasks);
+    // 3. Treat the envelope once the messages have arrived.
+    this->finalizeDeferredEnvelopeUpdate();
+    tasks.clear();
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+        Box3D domain = extendPeriodic(bulk.computeNonPeriodicEnvelope(),
+                                      this->getMultiBlockManagement().getEnvelopeWidth());
+        tasks.push_back(new CompleteCollideAndStreamTask3D<T,Descriptor> (
+                                *it->second, bulk.toLocal(domain), bulk.toLocal(bulk.getBulk()) ));
+    }
+    this->executeLocalTasks(blockIds, tasks);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::directionalCollideAndStream() {
+    // 1. The envelope is not collided, and the postponed update of its static
+    //    variables is therefore not needed.
+    this->discardDeferredEnvelopeUpdate(modif::staticVariables);
+    // 2. Collision-streaming in the bulk. The populations which leave the bulk
+    //    are left in place, in the state of after the collision.
+    std::vector<plint> blockIds;
+    std::vector<SmpTask*> tasks;
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+        blockIds.push_back(it->first);
+        tasks.push_back(new CollideAndStreamTask3D<T,Descriptor>(*it->second, bulk.toLocal(bulk.getBulk())));
+    }
+    this->executeLocalTasks(blockIds, tasks);
+    // 3. Send these populations to the envelopes of the neighbors.
+    this->getBlockCommunicator().duplicateDirectionalOverlaps(*this);
+    // 4. Stream the received populations into the bulk.
+    tasks.clear();
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+        Box3D domain = extendPeriodic(bulk.computeNonPeriodicEnvelope(),
+                                      this->getMultiBlockManagement().getEnvelopeWidth());
+        tasks.push_back(new CompleteStreamTask3D<T,Descriptor> (
+                                *it->second, bulk.toLocal(domain), bulk.toLocal(bulk.getBulk()) ));
+    }
+    this->executeLocalTasks(blockIds, tasks);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::toggleCommunicationOverlap(bool overlap) {
+    this->deferEnvelopeUpdates(overlap);
+}
+
+template<typename T, template<typename U> class Descriptor>
+bool MultiBlockLattice3D<T,Descriptor>::isCommunicationOverlapOn() const {
+    return this->envelopeUpdatesAreDeferred();
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::toggleDirectionalEnvelope(bool directional) {
+    directionalEnvelopeFlag = directional;
+    this->deferEnvelopeUpdates(directional);
+}
+
+template<typename T, template<typename U> class Descriptor>
+bool MultiBlockLattice3D<T,Descriptor>::isDirectionalEnvelopeOn() const {
+    return directionalEnvelopeFlag && this->envelopeUpdatesAreDeferred();
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::toggleStructureOfArrays(bool soaFlag_) {
+    PLB_PRECONDITION( !(soaFlag_ && indirectFlag) );
+    soaFlag = soaFlag_;
+    if (!soaFlag) {
+        singlePrecisionFlag = false;
+    }
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        it->second -> toggleStructureOfArrays(soaFlag);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+bool MultiBlockLattice3D<T,Descriptor>::isStructureOfArraysOn() const {
+    return soaFlag;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::toggleSinglePrecisionStorage(bool singlePrecisionFlag_) {
+    PLB_PRECONDITION( !(singlePrecisionFlag_ && indirectFlag) );
+    singlePrecisionFlag = singlePrecisionFlag_;
+    if (singlePrecisionFlag) {
+        soaFlag = true;
+    }
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        it->second -> toggleSinglePrecisionStorage(singlePrecisionFlag);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+bool MultiBlockLattice3D<T,Descriptor>::isSinglePrecisionStorageOn() const {
+    return singlePrecisionFlag;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::toggleIndirectAddressing(bool indirectFlag_) {
+    PLB_PRECONDITION( !(indirectFlag_ && soaFlag) );
+    indirectFlag = indirectFlag_;
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        it->second -> toggleIndirectAddressing(indirectFlag);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+bool MultiBlockLattice3D<T,Descriptor>::isIndirectAddressingOn() const {
+    return indirectFlag;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::toggleCompactDynamics(bool compactDynamicsFlag_) {
+    compactDynamicsFlag = compactDynamicsFlag_;
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        it->second -> toggleCompactDynamics(compactDynamicsFlag);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+bool MultiBlockLattice3D<T,Descriptor>::isCompactDynamicsOn() const {
+    return compactDynamicsFlag;
 }
 
 template<typename T, template<typename U> class Descriptor>
@@ -375,16 +660,17 @@ void MultiBlockLattice3D<T,Descriptor>::allocateAndInitialize()
     this->getInternalStatistics().subscribeAverage(); // Subscribe average uSqr
     this->getInternalStatistics().subscribeMax();     // Subscribe max uSqr
 
-    for (pluint iBlock=0; iBlock<this->getLocalInfo().getBlocks().size(); ++iBlock) {
-        plint blockId = this->getLocalInfo().getBlocks()[iBlock];
-        SmartBulk3D bulk(this->getMultiBlockManagement(), blockId);
-        Box3D envelope = bulk.computeEnvelope();
-        BlockLattice3D<T,Descriptor>* newLattice
-            = new BlockLattice3D<T,Descriptor> (
-                    envelope.getNx(), envelope.getNy(), envelope.getNz(),
-                    backgroundDynamics->clone() );
-        newLattice -> setLocation(Dot3D(envelope.x0, envelope.y0, envelope.z0));
-        blockLattices[blockId] = newLattice;
+    std::vector<plint> const& blockIds = this->getLocalInfo().getBlocks();
+    std::vector<BlockLattice3D<T,Descriptor>*> newLattices(blockIds.size());
+    std::vector<SmpTask*> tasks(blockIds.size());
+    for (pluint iBlock=0; iBlock<blockIds.size(); ++iBlock) {
+        SmartBulk3D bulk(this->getMultiBlockManagement(), blockIds[iBlock]);
+        tasks[iBlock] = new AllocateBlockLatticeTask3D<T,Descriptor> (
+                bulk.computeEnvelope(), backgroundDynamics->clone(), newLattices[iBlock] );
+    }
+    this->executeAllocationTasks(blockIds, tasks);
+    for (pluint iBlock=0; iBlock<blockIds.size(); ++iBlock) {
+        blockLattices[blockIds[iBlock]] = newLattices[iBlock];
     }
 }
 
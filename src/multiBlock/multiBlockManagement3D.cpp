@@ -403,6 +403,13 @@ Box3D SmartBulk3D::toLocal(Box3D const& coord) const
 
 }
 
+Dot3D SmartBulk3D::directionOfBulk(Box3D const& coord) const
+{
+    return Dot3D( coord.x1<bulk.x0 ? 1 : (coord.x0>bulk.x1 ? -1 : 0),
+                  coord.y1<bulk.y0 ? 1 : (coord.y0>bulk.y1 ? -1 : 0),
+                  coord.z1<bulk.z0 ? 1 : (coord.z0>bulk.z1 ? -1 : 0) );
+}
+
 plint SmartBulk3D::toLocalX(plint iX) const {
     return iX-bulk.x0+envelopeWidth;
 }
@@ -149,6 +149,10 @@ public:
     Box3D computeNonPeriodicEnvelope() const;
     /// Convert to local coordinates of a given block.
     Box3D toLocal(Box3D const& coord) const;
+    /// Direction in which the bulk lies, seen from a domain (components -1, 0
+    ///   or 1). A component is zero if the domain is not entirely on one side
+    ///   of the bulk in the corresponding direction.
+    Dot3D directionOfBulk(Box3D const& coord) const;
     /// Convert to local x-coordinate of a given block.
     plint toLocalX(plint iX) const;
     /// Convert to local y-coordinate of a given block.
@@ -316,9 +316,18 @@ void MultiProcessing3D<OriginalGenerator,MutableGenerator>::updateEnvelopesWhere
 }
 
 
+/// Data processors may access the envelope: make sure it is not outdated.
+static void updateDeferredEnvelopes(std::vector<MultiBlock3D*> const& multiBlocks)
+{
+    for (pluint iBlock=0; iBlock<multiBlocks.size(); ++iBlock) {
+        multiBlocks[iBlock]->updateDeferredEnvelope();
+    }
+}
+
 void executeDataProcessor( DataProcessorGenerator3D const& generator,
                            std::vector<MultiBlock3D*> multiBlocks )
 {
+    updateDeferredEnvelopes(multiBlocks);
     MultiProcessing3D<DataProcessorGenerator3D const, DataProcessorGenerator3D >
         multiProcessing(generator, multiBlocks);
     std::vector<DataProcessorGenerator3D*> const& retainedGenerators = multiProcessing.getRetainedGenerators();
@@ -359,6 +368,7 @@ void executeDataProcessor( DataProcessorGenerator3D const& generator,
 void executeDataProcessor( ReductiveDataProcessorGenerator3D& generator,
                            std::vector<MultiBlock3D*> multiBlocks )
 {
+    updateDeferredEnvelopes(multiBlocks);
     MultiProcessing3D<ReductiveDataProcessorGenerator3D, ReductiveDataProcessorGenerator3D >
         multiProcessing(generator, multiBlocks);
     std::vector<ReductiveDataProcessorGenerator3D*> const& retainedGenerators = multiProcessing.getRetainedGenerators();
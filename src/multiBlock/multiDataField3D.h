@@ -36,10 +36,75 @@
 #include "atomicBlock/dataField2D.h"
 #include "atomicBlock/dataField3D.h"
 #include "multiBlock/multiBlock3D.h"
+#include "parallelism/smpThreadPool.h"
 #include <vector>
 
 namespace plb {
 
+/// Constructs one atomic-block of a multi-scalar-field, with the envelope
+///   as its domain; see MultiBlock3D::executeAllocationTasks().
+template<typename T>
+class AllocateScalarFieldTask3D : public SmpTask {
+public:
+    AllocateScalarFieldTask3D(Box3D envelope_, T iniVal_, ScalarField3D<T>*& field_)
+        : envelope(envelope_),
+          iniVal(iniVal_),
+          field(field_)
+    { }
+    virtual void execute() {
+        field = new ScalarField3D<T> (
+                envelope.getNx(), envelope.getNy(), envelope.getNz(), iniVal );
+        field -> setLocation(Dot3D(envelope.x0, envelope.y0, envelope.z0));
+    }
+private:
+    Box3D envelope;
+    T iniVal;
+    ScalarField3D<T>*& field;
+};
+
+/// Constructs one atomic-block of a multi-tensor-field.
+template<typename T, int nDim>
+class AllocateTensorFieldTask3D : public SmpTask {
+public:
+    AllocateTensorFieldTask3D(Box3D envelope_, Array<T,nDim> const& iniVal_, TensorField3D<T,nDim>*& field_)
+        : envelope(envelope_),
+          iniVal(iniVal_),
+          field(field_)
+    { }
+    virtual void execute() {
+        field = new TensorField3D<T,nDim> (
+                envelope.getNx(), envelope.getNy(), envelope.getNz(), iniVal );
+        field -> setLocation(Dot3D(envelope.x0, envelope.y0, envelope.z0));
+    }
+private:
+    Box3D envelope;
+    Array<T,nDim> iniVal;
+    TensorField3D<T,nDim>*& field;
+};
+
+/// Constructs one atomic-block of a multi-n-tensor-field.
+template<typename T>
+class AllocateNTensorFieldTask3D : public SmpTask {
+public:
+    AllocateNTensorFieldTask3D( Box3D envelope_, plint ndim_, T const* iniVal_,
+                                NTensorField3D<T>*& field_ )
+        : envelope(envelope_),
+          ndim(ndim_),
+          iniVal(iniVal_),
+          field(field_)
+    { }
+    virtual void execute() {
+        field = new NTensorField3D<T> (
+                envelope.getNx(), envelope.getNy(), envelope.getNz(), ndim, iniVal );
+        field -> setLocation(Dot3D(envelope.x0, envelope.y0, envelope.z0));
+    }
+private:
+    Box3D envelope;
+    plint ndim;
+    T const* iniVal;
+    NTensorField3D<T>*& field;
+};
+
 template<typename T> class MultiScalarField3D;
 
 template<typename T>
@@ -95,6 +160,8 @@ public:
     std::vector<std::string> getTypeInfo() const;
     static std::string blockName();
     static std::string basicType();
+protected:
+    virtual void swapComponents(MultiBlock3D& rhs);
 private:
     void allocateFields(T iniVal=T());
     void deAllocateFields();
@@ -167,6 +234,8 @@ public:
     std::vector<std::string> getTypeInfo() const;
     static std::string blockName();
     static std::string basicType();
+protected:
+    virtual void swapComponents(MultiBlock3D& rhs);
 private:
     void allocateFields();
     void allocateFields(Array<T,nDim> const& iniVal);
@@ -241,6 +310,8 @@ public:
     std::vector<std::string> getTypeInfo() const;
     static std::string blockName();
     static std::string basicType();
+protected:
+    virtual void swapComponents(MultiBlock3D& rhs);
 private:
     void allocateFields();
     void allocateFields(T const* iniVal);
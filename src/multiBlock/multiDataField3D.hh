@@ -143,6 +143,13 @@ void MultiScalarField3D<T>::swap(MultiScalarField3D<T>& rhs) {
     std::swap(multiScalarAccess, rhs.multiScalarAccess);
 }
 
+template<typename T>
+void MultiScalarField3D<T>::swapComponents(MultiBlock3D& rhs) {
+    MultiScalarField3D<T>& rhsField = dynamic_cast<MultiScalarField3D<T>&>(rhs);
+    fields.swap(rhsField.fields);
+    std::swap(multiScalarAccess, rhsField.multiScalarAccess);
+}
+
 template<typename T>
 void MultiScalarField3D<T>::reset() {
     for ( typename BlockMap::iterator it = fields.begin();
@@ -155,15 +162,17 @@ void MultiScalarField3D<T>::reset() {
 template<typename T>
 void MultiScalarField3D<T>::allocateFields(T iniVal)
 {
-    for (pluint iBlock=0; iBlock<this->getLocalInfo().getBlocks().size(); ++iBlock) {
-        plint blockId = this->getLocalInfo().getBlocks()[iBlock];
-        SmartBulk3D bulk(this->getMultiBlockManagement(), blockId);
-        Box3D envelope = bulk.computeEnvelope();
-        ScalarField3D<T>* newField =
-            new ScalarField3D<T> (
-                    envelope.getNx(), envelope.getNy(), envelope.getNz(), iniVal );
-        newField -> setLocation(Dot3D(envelope.x0, envelope.y0, envelope.z0));
-        fields[blockId] = newField;
+    std::vector<plint> const& blockIds = this->getLocalInfo().getBlocks();
+    std::vector<ScalarField3D<T>*> newFields(blockIds.size());
+    std::vector<SmpTask*> tasks(blockIds.size());
+    for (pluint iBlock=0; iBlock<blockIds.size(); ++iBlock) {
+        SmartBulk3D bulk(this->getMultiBlockManagement(), blockIds[iBlock]);
+        tasks[iBlock] = new AllocateScalarFieldTask3D<T> (
+                bulk.computeEnvelope(), iniVal, newFields[iBlock] );
+    }
+    this->executeAllocationTasks(blockIds, tasks);
+    for (pluint iBlock=0; iBlock<blockIds.size(); ++iBlock) {
+        fields[blockIds[iBlock]] = newFields[iBlock];
     }
 }
 
@@ -379,6 +388,13 @@ void MultiTensorField3D<T,nDim>::swap(MultiTensorField3D<T,nDim>& rhs) {
     std::swap(multiTensorAccess, rhs.multiTensorAccess);
 }
 
+template<typename T, int nDim>
+void MultiTensorField3D<T,nDim>::swapComponents(MultiBlock3D& rhs) {
+    MultiTensorField3D<T,nDim>& rhsField = dynamic_cast<MultiTensorField3D<T,nDim>&>(rhs);
+    fields.swap(rhsField.fields);
+    std::swap(multiTensorAccess, rhsField.multiTensorAccess);
+}
+
 template<typename T, int nDim>
 void MultiTensorField3D<T,nDim>::reset() {
     for ( typename BlockMap::iterator it = fields.begin();
@@ -399,15 +415,17 @@ void MultiTensorField3D<T,nDim>::allocateFields()
 template<typename T, int nDim>
 void MultiTensorField3D<T,nDim>::allocateFields(Array<T,nDim> const& iniVal) 
 {
-    for (pluint iBlock=0; iBlock<this->getLocalInfo().getBlocks().size(); ++iBlock) {
-        plint blockId = this->getLocalInfo().getBlocks()[iBlock];
-        SmartBulk3D bulk(this->getMultiBlockManagement(), blockId);
-        Box3D envelope = bulk.computeEnvelope();
-        TensorField3D<T,nDim>* newField =
-            new TensorField3D<T,nDim> (
-                    envelope.getNx(), envelope.getNy(), envelope.getNz(), iniVal );
-        newField -> setLocation(Dot3D(envelope.x0, envelope.y0, envelope.z0));
-        fields[blockId] = newField;
+    std::vector<plint> const& blockIds = this->getLocalInfo().getBlocks();
+    std::vector<TensorField3D<T,nDim>*> newFields(blockIds.size());
+    std::vector<SmpTask*> tasks(blockIds.size());
+    for (pluint iBlock=0; iBlock<blockIds.size(); ++iBlock) {
+        SmartBulk3D bulk(this->getMultiBlockManagement(), blockIds[iBlock]);
+        tasks[iBlock] = new AllocateTensorFieldTask3D<T,nDim> (
+                bulk.computeEnvelope(), iniVal, newFields[iBlock] );
+    }
+    this->executeAllocationTasks(blockIds, tasks);
+    for (pluint iBlock=0; iBlock<blockIds.size(); ++iBlock) {
+        fields[blockIds[iBlock]] = newFields[iBlock];
     }
 }
 
@@ -633,6 +651,13 @@ void MultiNTensorField3D<T>::swap(MultiNTensorField3D<T>& rhs) {
     std::swap(multiNTensorAccess, rhs.multiNTensorAccess);
 }
 
+template<typename T>
+void MultiNTensorField3D<T>::swapComponents(MultiBlock3D& rhs) {
+    MultiNTensorField3D<T>& rhsField = dynamic_cast<MultiNTensorField3D<T>&>(rhs);
+    fields.swap(rhsField.fields);
+    std::swap(multiNTensorAccess, rhsField.multiNTensorAccess);
+}
+
 template<typename T>
 void MultiNTensorField3D<T>::reset() {
     for ( typename BlockMap::iterator it = fields.begin();
@@ -652,16 +677,17 @@ void MultiNTensorField3D<T>::allocateFields() {
 template<typename T>
 void MultiNTensorField3D<T>::allocateFields(T const* iniVal) 
 {
-    for (pluint iBlock=0; iBlock<this->getLocalInfo().getBlocks().size(); ++iBlock) {
-        plint blockId = this->getLocalInfo().getBlocks()[iBlock];
-        SmartBulk3D bulk(this->getMultiBlockManagement(), blockId );
-        Box3D envelope = bulk.computeEnvelope();
-        NTensorField3D<T>* newField =
-            new NTensorField3D<T> (
-                    envelope.getNx(), envelope.getNy(), envelope.getNz(),
-                    this->getNdim(), iniVal );
-        newField -> setLocation(Dot3D(envelope.x0, envelope.y0, envelope.z0));
-        fields[blockId] = newField;
+    std::vector<plint> const& blockIds = this->getLocalInfo().getBlocks();
+    std::vector<NTensorField3D<T>*> newFields(blockIds.size());
+    std::vector<SmpTask*> tasks(blockIds.size());
+    for (pluint iBlock=0; iBlock<blockIds.size(); ++iBlock) {
+        SmartBulk3D bulk(this->getMultiBlockManagement(), blockIds[iBlock]);
+        tasks[iBlock] = new AllocateNTensorFieldTask3D<T> (
+                bulk.computeEnvelope(), this->getNdim(), iniVal, newFields[iBlock] );
+    }
+    this->executeAllocationTasks(blockIds, tasks);
+    for (pluint iBlock=0; iBlock<blockIds.size(); ++iBlock) {
+        fields[blockIds[iBlock]] = newFields[iBlock];
     }
 }
 
@@ -28,7 +28,12 @@
 
 #include "core/globalDefs.h"
 #include "multiBlock/redistribution3D.h"
+#include "core/plbDebug.h"
 #include <cstdlib>
+#include <algorithm>
+#include <set>
+#include <sstream>
+#include <iomanip>
 
 namespace plb {
 
@@ -69,5 +74,395 @@ MultiBlockManagement3D RandomRedistribute3D::redistribute (
             original.getEnvelopeWidth(), original.getRefinementLevel() );
 }
 
-}  // namespace plb
+namespace {
+
+/// Order of treatment of the blocks in costBalancedThreadAttribution().
+struct BlockCostComparison {
+    BlockCostComparison(std::vector<double> const& costs_)
+        : costs(costs_)
+    { }
+    bool operator()(plint pos1, plint pos2) const {
+        return costs[pos1] > costs[pos2];
+    }
+    std::vector<double> const& costs;
+};
+
+}  // namespace
+
+ExplicitThreadAttribution* costBalancedThreadAttribution (
+        SparseBlockStructure3D const& sparseBlock, ThreadAttribution const& oldAttribution,
+        std::map<plint,double> const& localCosts )
+{
+    std::map<plint,Box3D> const& domains = sparseBlock.getBulks();
+    plint numBlocks = (plint)domains.size();
+    plint numProcs = global::mpi().getSize();
+
+    // 1. Cost of all blocks, identified by their position in the map of bulks.
+    std::vector<plint> blockIds(numBlocks);
+    std::vector<double> costs(numBlocks, 0.);
+    std::map<plint,Box3D>::const_iterator it = domains.begin();
+    for (plint pos=0; it != domains.end(); ++it, ++pos) {
+        blockIds[pos] = it->first;
+        std::map<plint,double>::const_iterator costIt = localCosts.find(it->first);
+        if (costIt != localCosts.end() && oldAttribution.isLocal(it->first)) {
+            costs[pos] = costIt->second;
+        }
+    }
+#ifdef PLB_MPI_PARALLEL
+    global::mpi().allReduceVect(costs, MPI_SUM);
+#endif
+
+    // 2. Blocks without a measured cost are estimated from the average cost per cell.
+    double measuredCost = 0.;
+    plint measuredCells = 0;
+    it = domains.begin();
+    for (plint pos=0; it != domains.end(); ++it, ++pos) {
+        if (costs[pos]>0.) {
+            measuredCost += costs[pos];
+            measuredCells += it->second.nCells();
+        }
+    }
+    double costPerCell = measuredCells>0 ? measuredCost/(double)measuredCells : 1.;
+    double totalCost = 0.;
+    it = domains.begin();
+    for (plint pos=0; it != domains.end(); ++it, ++pos) {
+        if (costs[pos]<=0.) {
+            costs[pos] = costPerCell*(double)it->second.nCells();
+        }
+        totalCost += costs[pos];
+    }
+    double averageLoad = totalCost/(double)numProcs;
+
+    // 3. Treat the blocks by decreasing cost. The computation is identical on
+    //    all processes, which therefore obtain the same attribution.
+    std::vector<plint> order(numBlocks);
+    for (plint pos=0; pos<numBlocks; ++pos) {
+        order[pos] = pos;
+    }
+    std::stable_sort(order.begin(), order.end(), BlockCostComparison(costs));
+
+    std::vector<double> loads(numProcs, 0.);
+    std::vector<plint> newProcs(numBlocks, -1);
+    for (plint iBlock=0; iBlock<numBlocks; ++iBlock) {
+        plint pos = order[iBlock];
+        plint oldProc = oldAttribution.getMpiProcess(blockIds[pos]);
+        if (oldProc>=0 && oldProc<numProcs && loads[oldProc]+costs[pos] <= averageLoad) {
+            newProcs[pos] = oldProc;
+            loads[oldProc] += costs[pos];
+        }
+    }
+    for (plint iBlock=0; iBlock<numBlocks; ++iBlock) {
+        plint pos = order[iBlock];
+        if (newProcs[pos]<0) {
+            plint leastLoaded = std::min_element(loads.begin(), loads.end()) - loads.begin();
+            newProcs[pos] = leastLoaded;
+            loads[leastLoaded] += costs[pos];
+        }
+    }
+
+    // 4. The blocks of a process are distributed in turn over its threads.
+    ExplicitThreadAttribution* newAttribution = new ExplicitThreadAttribution;
+    std::vector<plint> numLocalBlocks(numProcs, 0);
+    for (plint pos=0; pos<numBlocks; ++pos) {
+        plint proc = newProcs[pos];
+        newAttribution->addBlock(blockIds[pos], proc, numLocalBlocks[proc]++);
+    }
+    return newAttribution;
+}
+
+double computeLoadImbalance(std::map<plint,double> const& localCosts) {
+    double localLoad = 0.;
+    std::map<plint,double>::const_iterator it = localCosts.begin();
+    for (; it != localCosts.end(); ++it) {
+        localLoad += it->second;
+    }
+    double maxLoad = localLoad;
+    double totalLoad = localLoad;
+#ifdef PLB_MPI_PARALLEL
+    global::mpi().reduceAndBcast(totalLoad, MPI_SUM);
+    global::mpi().reduceAndBcast(maxLoad, MPI_MAX);
+#endif
+    double averageLoad = totalLoad/(double)global::mpi().getSize();
+    if (averageLoad<=0.) {
+        return 1.;
+    }
+    return maxLoad/averageLoad;
+}
+
+CostBalancedRedistribute3D::CostBalancedRedistribute3D(std::map<plint,double> const& localCosts_)
+    : localCosts(localCosts_)
+{ }
+
+MultiBlockManagement3D CostBalancedRedistribute3D::redistribute (
+        MultiBlockManagement3D const& original ) const
+{
+    SparseBlockStructure3D const& originalSparseBlock = original.getSparseBlockStructure();
+    ExplicitThreadAttribution* newAttribution =
+        costBalancedThreadAttribution (
+                originalSparseBlock, original.getThreadAttribution(), localCosts );
+    return MultiBlockManagement3D (
+            originalSparseBlock, newAttribution,
+            original.getEnvelopeWidth(), original.getRefinementLevel() );
+}
+
+pluint spaceFillingCurveKey( plint iX, plint iY, plint iZ, plint numBits,
+                             spaceFillingCurve::CurveT curve )
+{
+    PLB_PRECONDITION( numBits>0 && numBits<=21 );
+    PLB_PRECONDITION( iX>=0 && iY>=0 && iZ>=0 );
+    pluint x[3] = { (pluint)iX, (pluint)iY, (pluint)iZ };
+    if (curve==spaceFillingCurve::hilbert) {
+        // Convert the coordinates into the "transposed" Hilbert index
+        //   (J. Skilling, AIP Conf. Proc. 707, 2004).
+        pluint m = (pluint)1 << (numBits-1);
+        for (pluint q=m; q>1; q>>=1) {
+            pluint p = q-1;
+            for (plint i=0; i<3; ++i) {
+                if (x[i] & q) {
+                    x[0] ^= p;
+                }
+                else {
+                    pluint t = (x[0]^x[i]) & p;
+                    x[0] ^= t;
+                    x[i] ^= t;
+                }
+            }
+        }
+        x[1] ^= x[0];
+        x[2] ^= x[1];
+        pluint t = 0;
+        for (pluint q=m; q>1; q>>=1) {
+            if (x[2] & q) {
+                t ^= q-1;
+            }
+        }
+        for (plint i=0; i<3; ++i) {
+            x[i] ^= t;
+        }
+    }
+    // Interleave the bits, from the most significant one.
+    pluint key = 0;
+    for (plint bit=numBits-1; bit>=0; --bit) {
+        for (plint i=0; i<3; ++i) {
+            key = (key << 1) | ((x[i] >> bit) & 1);
+        }
+    }
+    return key;
+}
+
+namespace {
+
+/// Order of the blocks along the space-filling curve.
+struct CurveKeyComparison {
+    CurveKeyComparison(std::vector<pluint> const& keys_)
+        : keys(keys_)
+    { }
+    bool operator()(plint pos1, plint pos2) const {
+        return keys[pos1] < keys[pos2];
+    }
+    std::vector<pluint> const& keys;
+};
+
+}  // namespace
+
+ExplicitThreadAttribution* spaceFillingCurveThreadAttribution (
+        SparseBlockStructure3D const& sparseBlock,
+        std::map<plint,double> const& weights,
+        spaceFillingCurve::CurveT curve, plint numProcs )
+{
+    PLB_PRECONDITION( numProcs>0 );
+    std::map<plint,Box3D> const& domains = sparseBlock.getBulks();
+    plint numBlocks = (plint)domains.size();
+    Box3D boundingBox = sparseBlock.getBoundingBox();
+
+    // 1. The curve is evaluated at the block centers, on a grid which is
+    //    coarsened if the domain is too large for the key.
+    plint maxExtent = std::max(boundingBox.getNx(), std::max(boundingBox.getNy(), boundingBox.getNz()));
+    plint numBits = 1;
+    while (numBits<21 && ((plint)1<<numBits) < maxExtent) {
+        ++numBits;
+    }
+    plint shift = 0;
+    while ((maxExtent-1) >> shift >= ((plint)1<<numBits)) {
+        ++shift;
+    }
+
+    std::vector<plint> blockIds(numBlocks);
+    std::vector<pluint> keys(numBlocks);
+    std::vector<double> blockWeights(numBlocks);
+    double totalWeight = 0.;
+    std::map<plint,Box3D>::const_iterator it = domains.begin();
+    for (plint pos=0; it != domains.end(); ++it, ++pos) {
+        Box3D const& bulk = it->second;
+        blockIds[pos] = it->first;
+        keys[pos] = spaceFillingCurveKey (
+                ((bulk.x0+bulk.x1)/2-boundingBox.x0) >> shift,
+                ((bulk.y0+bulk.y1)/2-boundingBox.y0) >> shift,
+                ((bulk.z0+bulk.z1)/2-boundingBox.z0) >> shift,
+                numBits, curve );
+        std::map<plint,double>::const_iterator weightIt = weights.find(it->first);
+        blockWeights[pos] = weightIt != weights.end() ? weightIt->second : (double)bulk.nCells();
+        totalWeight += blockWeights[pos];
+    }
+
+    std::vector<plint> order(numBlocks);
+    for (plint pos=0; pos<numBlocks; ++pos) {
+        order[pos] = pos;
+    }
+    std::stable_sort(order.begin(), order.end(), CurveKeyComparison(keys));
+
+    // 2. Cut the curve into segments of equal weight: a block belongs to the
+    //    segment which contains the middle of its portion of the curve.
+    ExplicitThreadAttribution* newAttribution = new ExplicitThreadAttribution;
+    std::vector<plint> numLocalBlocks(numProcs, 0);
+    double cumulatedWeight = 0.;
+    for (plint iBlock=0; iBlock<numBlocks; ++iBlock) {
+        plint pos = order[iBlock];
+        plint proc = 0;
+        if (totalWeight>0.) {
+            double middle = cumulatedWeight + 0.5*blockWeights[pos];
+            proc = std::min(numProcs-1, (plint)(middle/totalWeight*(double)numProcs));
+        }
+        else {
+            proc = iBlock*numProcs/numBlocks;
+        }
+        cumulatedWeight += blockWeights[pos];
+        newAttribution->addBlock(blockIds[pos], proc, numLocalBlocks[proc]++);
+    }
+    return newAttribution;
+}
+
+std::map<plint,double> countActiveCells (
+        SparseBlockStructure3D const& sparseBlock, CellTypeField3D const& cellTypeField )
+{
+    Box3D boundingBox = sparseBlock.getBoundingBox();
+    PLB_PRECONDITION( cellTypeField.getNx()==boundingBox.getNx() &&
+                      cellTypeField.getNy()==boundingBox.getNy() &&
+                      cellTypeField.getNz()==boundingBox.getNz() );
+    std::map<plint,double> numActiveCells;
+    std::map<plint,Box3D> const& domains = sparseBlock.getBulks();
+    std::map<plint,Box3D>::const_iterator it = domains.begin();
+    for (; it != domains.end(); ++it) {
+        Box3D const& bulk = it->second;
+        plint numActive = 0;
+        for (plint iX=bulk.x0; iX<=bulk.x1; ++iX) {
+            for (plint iY=bulk.y0; iY<=bulk.y1; ++iY) {
+                for (plint iZ=bulk.z0; iZ<=bulk.z1; ++iZ) {
+                    if (cellTypeField.get(iX-boundingBox.x0, iY-boundingBox.y0, iZ-boundingBox.z0) > 0) {
+                        ++numActive;
+                    }
+                }
+            }
+        }
+        numActiveCells[it->first] = (double)numActive;
+    }
+    return numActiveCells;
+}
+
+SpaceFillingCurveRedistribute3D::SpaceFillingCurveRedistribute3D (
+        std::map<plint,double> const& weights_, spaceFillingCurve::CurveT curve_ )
+    : weights(weights_),
+      curve(curve_)
+{ }
+
+MultiBlockManagement3D SpaceFillingCurveRedistribute3D::redistribute (
+        MultiBlockManagement3D const& original ) const
+{
+    SparseBlockStructure3D const& originalSparseBlock = original.getSparseBlockStructure();
+    ExplicitThreadAttribution* newAttribution =
+        spaceFillingCurveThreadAttribution(originalSparseBlock, weights, curve);
+    return MultiBlockManagement3D (
+            originalSparseBlock, newAttribution,
+            original.getEnvelopeWidth(), original.getRefinementLevel() );
+}
+
+double PartitionQuality3D::getSurfaceToVolume(plint iProc) const {
+    PLB_PRECONDITION( iProc>=0 && iProc<(plint)volume.size() );
+    return volume[iProc]>0 ? (double)surface[iProc]/(double)volume[iProc] : 0.;
+}
+
+double PartitionQuality3D::getMaxSurfaceToVolume() const {
+    double maxRatio = 0.;
+    for (plint iProc=0; iProc<(plint)volume.size(); ++iProc) {
+        maxRatio = std::max(maxRatio, getSurfaceToVolume(iProc));
+    }
+    return maxRatio;
+}
 
+double PartitionQuality3D::getAverageNumNeighbors() const {
+    if (numNeighbors.empty()) {
+        return 0.;
+    }
+    double sum = 0.;
+    for (pluint iProc=0; iProc<numNeighbors.size(); ++iProc) {
+        sum += (double)numNeighbors[iProc];
+    }
+    return sum/(double)numNeighbors.size();
+}
+
+plint PartitionQuality3D::getMaxNumNeighbors() const {
+    plint maxNeighbors = 0;
+    for (pluint iProc=0; iProc<numNeighbors.size(); ++iProc) {
+        maxNeighbors = std::max(maxNeighbors, numNeighbors[iProc]);
+    }
+    return maxNeighbors;
+}
+
+std::string PartitionQuality3D::report() const {
+    std::stringstream out;
+    out << std::setw(8) << "process" << std::setw(14) << "volume" << std::setw(14) << "surface"
+        << std::setw(14) << "surf/volume" << std::setw(12) << "neighbors" << std::endl;
+    for (plint iProc=0; iProc<(plint)volume.size(); ++iProc) {
+        out << std::setw(8) << iProc << std::setw(14) << volume[iProc]
+            << std::setw(14) << surface[iProc]
+            << std::setw(14) << getSurfaceToVolume(iProc)
+            << std::setw(12) << numNeighbors[iProc] << std::endl;
+    }
+    out << "Max surface/volume: " << getMaxSurfaceToVolume()
+        << "; neighbors: average " << getAverageNumNeighbors()
+        << ", max " << getMaxNumNeighbors() << std::endl;
+    return out.str();
+}
+
+PartitionQuality3D computePartitionQuality(MultiBlockManagement3D const& management) {
+    SparseBlockStructure3D const& sparseBlock = management.getSparseBlockStructure();
+    ThreadAttribution const& attribution = management.getThreadAttribution();
+    plint envelopeWidth = management.getEnvelopeWidth();
+    plint numProcs = global::mpi().getSize();
+
+    PartitionQuality3D quality;
+    quality.volume.resize(numProcs, 0);
+    quality.surface.resize(numProcs, 0);
+    quality.numNeighbors.resize(numProcs, 0);
+    std::vector<std::set<plint> > neighborProcs(numProcs);
+
+    std::map<plint,Box3D> const& domains = sparseBlock.getBulks();
+    std::map<plint,Box3D>::const_iterator it = domains.begin();
+    for (; it != domains.end(); ++it) {
+        plint proc = attribution.getMpiProcess(it->first);
+        PLB_ASSERT( proc>=0 && proc<numProcs );
+        Box3D const& bulk = it->second;
+        quality.volume[proc] += bulk.nCells();
+        Box3D envelope(bulk.enlarge(envelopeWidth));
+        std::vector<plint> neighbors;
+        sparseBlock.findNeighbors(it->first, envelopeWidth, neighbors);
+        for (pluint iNeighbor=0; iNeighbor<neighbors.size(); ++iNeighbor) {
+            plint neighborProc = attribution.getMpiProcess(neighbors[iNeighbor]);
+            if (neighborProc == proc) {
+                continue;
+            }
+            Box3D neighborBulk, intersection;
+            sparseBlock.getBulk(neighbors[iNeighbor], neighborBulk);
+            if (intersect(envelope, neighborBulk, intersection)) {
+                quality.surface[proc] += intersection.nCells();
+                neighborProcs[proc].insert(neighborProc);
+            }
+        }
+    }
+    for (plint iProc=0; iProc<numProcs; ++iProc) {
+        quality.numNeighbors[iProc] = (plint)neighborProcs[iProc].size();
+    }
+    return quality;
+}
+
+}  // namespace plb
@@ -32,6 +32,10 @@
 #include "parallelism/mpiManager.h"
 #include "core/globalDefs.h"
 #include "multiBlock/multiBlockManagement3D.h"
+#include "multiBlock/staticRepartitions3D.h"
+#include <map>
+#include <vector>
+#include <string>
 
 namespace plb {
 
@@ -48,6 +52,98 @@ private:
     pluint rseed;
 };
 
+/// Attribute the blocks to the processes in such a way that the sum of the
+///   costs of the blocks is balanced between processes.
+/** localCosts contains the cost of the blocks which are local according to
+ *  oldAttribution; the costs are exchanged between all processes (this
+ *  function is collective). Blocks with no cost are estimated from their
+ *  number of cells. To limit the amount of data which is moved, the blocks
+ *  are treated by decreasing cost, and are kept on their process as long
+ *  as its load does not exceed the average; the remaining blocks are
+ *  attributed to the least loaded processes.
+ */
+ExplicitThreadAttribution* costBalancedThreadAttribution (
+        SparseBlockStructure3D const& sparseBlock, ThreadAttribution const& oldAttribution,
+        std::map<plint,double> const& localCosts );
+
+/// Ratio between the largest cost of a process and the average cost of the
+///   processes, given the cost of the local blocks. Collective.
+double computeLoadImbalance(std::map<plint,double> const& localCosts);
+
+/// Redistribution which balances measured costs of the blocks, through
+///   costBalancedThreadAttribution().
+class CostBalancedRedistribute3D : public MultiBlockRedistribute3D {
+public:
+    CostBalancedRedistribute3D(std::map<plint,double> const& localCosts_);
+    virtual MultiBlockManagement3D redistribute(MultiBlockManagement3D const& original) const;
+private:
+    std::map<plint,double> localCosts;
+};
+
+namespace spaceFillingCurve {
+    /// Hilbert curves keep consecutive blocks adjacent; Morton (z-order)
+    ///   curves are cheaper to evaluate but jump between octants.
+    enum CurveT { hilbert, morton };
+}
+
+/// Position along a space-filling curve of the cell (iX,iY,iZ), whose
+///   coordinates are non-negative and lower than 2^numBits (numBits<=21).
+pluint spaceFillingCurveKey( plint iX, plint iY, plint iZ, plint numBits,
+                             spaceFillingCurve::CurveT curve );
+
+/// Attribute the blocks to numProcs processes by ordering their centers along
+///   a space-filling curve, and cutting the curve into segments of equal
+///   weight, so that the blocks of a process form a compact region.
+/** The weights of the blocks (for example their number of active cells, see
+ *  countActiveCells()) must be known on all processes; blocks without a
+ *  weight are weighted with their number of cells. This function is not
+ *  collective: all processes compute the same attribution.
+ */
+ExplicitThreadAttribution* spaceFillingCurveThreadAttribution (
+        SparseBlockStructure3D const& sparseBlock,
+        std::map<plint,double> const& weights,
+        spaceFillingCurve::CurveT curve = spaceFillingCurve::hilbert,
+        plint numProcs = global::mpi().getSize() );
+
+/// Number of active cells (cells with a non-zero type) of every block; the
+///   cell-type field covers the bounding box of the sparse block-structure.
+std::map<plint,double> countActiveCells (
+        SparseBlockStructure3D const& sparseBlock, CellTypeField3D const& cellTypeField );
+
+/// Redistribution along a space-filling curve, through
+///   spaceFillingCurveThreadAttribution().
+class SpaceFillingCurveRedistribute3D : public MultiBlockRedistribute3D {
+public:
+    SpaceFillingCurveRedistribute3D (
+            std::map<plint,double> const& weights_ = std::map<plint,double>(),
+            spaceFillingCurve::CurveT curve_ = spaceFillingCurve::hilbert );
+    virtual MultiBlockManagement3D redistribute(MultiBlockManagement3D const& original) const;
+private:
+    std::map<plint,double> weights;
+    spaceFillingCurve::CurveT curve;
+};
+
+/// Communication properties of a data distribution, per process.
+struct PartitionQuality3D {
+    /// Number of cells of the blocks of each process.
+    std::vector<plint> volume;
+    /// Number of envelope cells of each process which are received from
+    ///   other processes.
+    std::vector<plint> surface;
+    /// Number of other processes with which each process communicates.
+    std::vector<plint> numNeighbors;
+    double getSurfaceToVolume(plint iProc) const;
+    double getMaxSurfaceToVolume() const;
+    double getAverageNumNeighbors() const;
+    plint getMaxNumNeighbors() const;
+    /// One line per process, followed by the average and maximum values.
+    std::string report() const;
+};
+
+/// Compute the surface-to-volume ratio and the number of neighbor processes
+///   of each process. Not collective.
+PartitionQuality3D computePartitionQuality(MultiBlockManagement3D const& management);
+
 }  // namespace plb
 
 #endif  // REDISTRIBUTION_3D_H
@@ -44,7 +44,7 @@ SerialBlockCommunicator3D* SerialBlockCommunicator3D::clone() const {
 void SerialBlockCommunicator3D::copyOverlap (
         Overlap3D const& overlap,
         MultiBlock3D const& fromMultiBlock, MultiBlock3D& toMultiBlock,
-        modif::ModifT whichData ) const
+        modif::ModifT whichData, bool directional ) const
 {
     MultiBlockManagement3D const& fromManagement = fromMultiBlock.getMultiBlockManagement();
     MultiBlockManagement3D const& toManagement = toMultiBlock.getMultiBlockManagement();
@@ -70,18 +70,37 @@ void SerialBlockCommunicator3D::copyOverlap (
     plint deltaY = originalCoords.y0 - overlapCoords.y0;
     plint deltaZ = originalCoords.z0 - overlapCoords.z0;
 
-    overlapBlock -> getDataTransfer().attribute(overlapCoords, deltaX, deltaY, deltaZ,
-                                                *originalBlock, whichData);
+    if (directional) {
+        overlapBlock -> getDataTransfer().attributeDirectional (
+                overlapCoords, deltaX, deltaY, deltaZ, *originalBlock,
+                overlapBulk.directionOfBulk(overlap.getOverlapCoordinates()) );
+    }
+    else {
+        overlapBlock -> getDataTransfer().attribute(overlapCoords, deltaX, deltaY, deltaZ,
+                                                    *originalBlock, whichData);
+    }
 }
 
 void SerialBlockCommunicator3D::duplicateOverlaps(MultiBlock3D& multiBlock, modif::ModifT whichData) const
+{
+    duplicateOverlaps(multiBlock, whichData, false);
+}
+
+void SerialBlockCommunicator3D::duplicateDirectionalOverlaps(MultiBlock3D& multiBlock) const
+{
+    duplicateOverlaps(multiBlock, modif::staticVariables, true);
+}
+
+void SerialBlockCommunicator3D::duplicateOverlaps (
+        MultiBlock3D& multiBlock, modif::ModifT whichData, bool directional ) const
 {
     MultiBlockManagement3D const& multiBlockManagement = multiBlock.getMultiBlockManagement();
     LocalMultiBlockInfo3D const& localInfo = multiBlockManagement.getLocalInfo();
 
     // Non-periodic communication
     for (pluint iOverlap=0; iOverlap<localInfo.getNormalOverlaps().size(); ++iOverlap) {
-        copyOverlap(localInfo.getNormalOverlaps()[iOverlap], multiBlock, multiBlock, whichData);
+        copyOverlap(localInfo.getNormalOverlaps()[iOverlap], multiBlock, multiBlock,
+                    whichData, directional);
     }
 
     // Periodic communication
@@ -89,7 +108,7 @@ void SerialBlockCommunicator3D::duplicateOverlaps(MultiBlock3D& multiBlock, modi
     for (pluint iOverlap=0; iOverlap<localInfo.getPeriodicOverlaps().size(); ++iOverlap) {
         PeriodicOverlap3D const& pOverlap = localInfo.getPeriodicOverlaps()[iOverlap];
         if (periodicity.get(pOverlap.normalX, pOverlap.normalY, pOverlap.normalZ)) {
-            copyOverlap(pOverlap.overlap, multiBlock, multiBlock, whichData);
+            copyOverlap(pOverlap.overlap, multiBlock, multiBlock, whichData, directional);
         }
     }
 }
@@ -44,11 +44,17 @@ public:
                               MultiBlock3D const& originMultiBlock,
                               MultiBlock3D& destinationMultiBlock, modif::ModifT whichData ) const;
     virtual void duplicateOverlaps(MultiBlock3D& multiBlock, modif::ModifT whichData) const;
+    virtual void duplicateDirectionalOverlaps(MultiBlock3D& multiBlock) const;
     virtual void signalPeriodicity() const;
 private:
+    void duplicateOverlaps( MultiBlock3D& multiBlock, modif::ModifT whichData,
+                            bool directional ) const;
+    /// If directional is true, only the data streamed into the bulk of the
+    ///   destination is copied (see BlockDataTransfer3D::sendDirectional()).
     void copyOverlap( Overlap3D const& overlap,
                       MultiBlock3D const& fromMultiBlock,
-                      MultiBlock3D& toMultiBlock, modif::ModifT whichData ) const;
+                      MultiBlock3D& toMultiBlock, modif::ModifT whichData,
+                      bool directional=false ) const;
 };
 
 }  // namespace plb
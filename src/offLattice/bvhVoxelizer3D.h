@@ -0,0 +1,160 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Voxelization of a closed triangular surface mesh by ray parity along
+ * the z-lines of the domain, with a bounding-volume hierarchy of the
+ * triangles -- header file.
+ */
+#ifndef BVH_VOXELIZER_3D_H
+#define BVH_VOXELIZER_3D_H
+
+#include "core/globalDefs.h"
+#include "core/geometry3D.h"
+#include "offLattice/triangularSurfaceMesh.h"
+#include "offLattice/voxelizer.h"
+#include "multiBlock/multiDataField3D.h"
+#include "parallelism/smpThreadPool.h"
+#include <vector>
+
+namespace plb {
+
+namespace global {
+
+/// Choice of the algorithm used by voxelize3D.
+/** With the BVH voxelizer, the versions of voxelize3D without seed (and
+ *  therefore VoxelizedDomain3D) call bvhVoxelize3D instead of the
+ *  flood-fill voxelization based on a TriangleHash.
+ */
+class VoxelizerPolicy {
+public:
+    /// Voxelize by ray parity with a BVH (default: false).
+    void toggleBVH(bool flag) {
+        bvhFlag = flag;
+    }
+    bool isBVHOn() const {
+        return bvhFlag;
+    }
+private:
+    VoxelizerPolicy()
+        : bvhFlag(false)
+    { }
+private:
+    bool bvhFlag;
+friend VoxelizerPolicy& voxelizerPolicy();
+};
+
+inline VoxelizerPolicy& voxelizerPolicy() {
+    static VoxelizerPolicy instance;
+    return instance;
+}
+
+}  // namespace global
+
+/// Bounding-volume hierarchy of the projection of the triangles of a mesh
+///   onto the x-y plane, to find the crossings of the mesh with lines
+///   parallel to the z-axis.
+/** The hierarchy is built by median splits along the longest side of the
+ *  boxes. The nodes are stored in depth-first order, with the left child
+ *  following its parent, and the vertices of the triangles are copied in
+ *  the order of the leaves, so that a query reads contiguous memory.
+ */
+template<typename T>
+class TriangleBVH3D {
+public:
+    /// Hierarchy of all triangles of the mesh.
+    TriangleBVH3D(TriangularSurfaceMesh<T> const& mesh);
+    /// Hierarchy of the triangles of the mesh whose projection onto the
+    ///   x-y plane intersects the given range; the lines outside this range
+    ///   must not be queried.
+    TriangleBVH3D(TriangularSurfaceMesh<T> const& mesh,
+                  Array<T,2> const& xRange, Array<T,2> const& yRange);
+    /// Append to "crossings" the z-coordinates at which the line parallel
+    ///   to the z-axis through (x,y) crosses the triangles. Returns false if
+    ///   the line touches an edge or a vertex, in which case the parity of
+    ///   the crossings is ambiguous.
+    bool lineCrossings(T x, T y, std::vector<T>& crossings) const;
+    plint getNumTriangles() const {
+        return (plint)triangles.size()/9;
+    }
+private:
+    struct Node {
+        T xMin, xMax, yMin, yMax;
+        /// For a leaf, index of the first triangle; otherwise, index of the
+        ///   right child.
+        plint index;
+        /// Number of triangles of a leaf, zero for an inner node.
+        plint numTriangles;
+    };
+    void construct(TriangularSurfaceMesh<T> const& mesh,
+                   Array<T,2> const& xRange, Array<T,2> const& yRange, bool restrictToRange);
+    void buildNode(std::vector<plint>& ids, std::vector<Array<T,4> > const& boxes,
+                   std::vector<Array<T,2> > const& centers, plint first, plint last);
+private:
+    std::vector<Node> nodes;
+    std::vector<T> triangles;
+};
+
+/// Voxelize a closed mesh in a domain which extends its bounding box by
+///   "symmetricLayer" cells in each direction, as voxelize3D.
+template<typename T>
+std::auto_ptr<MultiScalarField3D<int> > bvhVoxelize3D (
+        TriangularSurfaceMesh<T> const& mesh,
+        plint symmetricLayer, plint borderWidth );
+
+/// Voxelize a closed mesh by ray parity: a cell is inside if the number of
+///   crossings of the mesh below it, along its z-line, is odd.
+/** Every MPI process builds a BVH of the triangles which are above or below
+ *  its own atomic-blocks, and the lines of every block are treated by one
+ *  task of the shared-memory thread pool. The flags are written directly,
+ *  without triangle hash and without iterations over the multi-block.
+ *  As with voxelize3D, the cells which lie on the surface are inside.
+ *  The mesh must be closed (watertight); a line with an odd number of
+ *  crossings is considered to be outside above its last crossing.
+ */
+template<typename T>
+std::auto_ptr<MultiScalarField3D<int> > bvhVoxelize3D (
+        TriangularSurfaceMesh<T> const& mesh,
+        Box3D const& domain, plint borderWidth );
+
+/// Flag the cells of a domain of an atomic-block (in local coordinates) by
+///   ray parity along the z-lines.
+template<typename T>
+class BVHVoxelizeTask3D : public SmpTask {
+public:
+    BVHVoxelizeTask3D(TriangleBVH3D<T> const& bvh_, ScalarField3D<int>& voxels_, Box3D domain_);
+    virtual void execute();
+private:
+    /// Flag as inside the cells of the line (iX,iY) between two consecutive
+    ///   crossings, the crossings being sorted in place.
+    void markInside(plint iX, plint iY, std::vector<T>& crossings);
+private:
+    TriangleBVH3D<T> const& bvh;
+    ScalarField3D<int>& voxels;
+    Box3D domain;
+};
+
+} // namespace plb
+
+#endif  // BVH_VOXELIZER_3D_H
@@ -0,0 +1,333 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Voxelization of a closed triangular surface mesh by ray parity along
+ * the z-lines of the domain, with a bounding-volume hierarchy of the
+ * triangles -- generic implementation.
+ */
+#ifndef BVH_VOXELIZER_3D_HH
+#define BVH_VOXELIZER_3D_HH
+
+#include "core/globalDefs.h"
+#include "offLattice/bvhVoxelizer3D.h"
+#include "offLattice/voxelizer3D.h"
+#include "atomicBlock/dataField3D.h"
+#include "multiBlock/multiBlockGenerator3D.h"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace plb {
+
+/* ******** TriangleBVH3D ************************************* */
+
+/// Order of the triangles along the x- or y-coordinate of the center of
+///   their bounding box.
+template<typename T>
+class BVHCenterLess3D {
+public:
+    BVHCenterLess3D(std::vector<Array<T,2> > const& centers_, int axis_)
+        : centers(centers_), axis(axis_)
+    { }
+    bool operator()(plint iTriangle1, plint iTriangle2) const {
+        return centers[iTriangle1][axis] < centers[iTriangle2][axis];
+    }
+private:
+    std::vector<Array<T,2> > const& centers;
+    int axis;
+};
+
+template<typename T>
+TriangleBVH3D<T>::TriangleBVH3D(TriangularSurfaceMesh<T> const& mesh)
+{
+    construct(mesh, Array<T,2>(), Array<T,2>(), false);
+}
+
+template<typename T>
+TriangleBVH3D<T>::TriangleBVH3D (
+        TriangularSurfaceMesh<T> const& mesh,
+        Array<T,2> const& xRange, Array<T,2> const& yRange )
+{
+    construct(mesh, xRange, yRange, true);
+}
+
+template<typename T>
+void TriangleBVH3D<T>::construct (
+        TriangularSurfaceMesh<T> const& mesh,
+        Array<T,2> const& xRange, Array<T,2> const& yRange, bool restrictToRange )
+{
+    plint numTriangles = mesh.getNumTriangles();
+    // Boxes are stored as (xMin, xMax, yMin, yMax).
+    std::vector<Array<T,4> > boxes(numTriangles);
+    std::vector<Array<T,2> > centers(numTriangles);
+    std::vector<plint> ids;
+    ids.reserve(numTriangles);
+    for (plint iTriangle=0; iTriangle<numTriangles; ++iTriangle) {
+        Array<T,3> const& a = mesh.getVertex(iTriangle, 0);
+        Array<T,3> const& b = mesh.getVertex(iTriangle, 1);
+        Array<T,3> const& c = mesh.getVertex(iTriangle, 2);
+        Array<T,4>& box = boxes[iTriangle];
+        box[0] = std::min(a[0], std::min(b[0], c[0]));
+        box[1] = std::max(a[0], std::max(b[0], c[0]));
+        box[2] = std::min(a[1], std::min(b[1], c[1]));
+        box[3] = std::max(a[1], std::max(b[1], c[1]));
+        if ( restrictToRange && (box[1]<xRange[0] || box[0]>xRange[1] ||
+                          box[3]<yRange[0] || box[2]>yRange[1]) )
+        {
+            continue;
+        }
+        centers[iTriangle] = Array<T,2>((box[0]+box[1])/(T)2, (box[2]+box[3])/(T)2);
+        ids.push_back(iTriangle);
+    }
+    if (ids.empty()) {
+        return;
+    }
+    nodes.reserve(2*ids.size());
+    buildNode(ids, boxes, centers, 0, (plint)ids.size());
+
+    // The vertices are copied in the order of the leaves.
+    triangles.reserve(9*ids.size());
+    for (pluint iId=0; iId<ids.size(); ++iId) {
+        for (int iVertex=0; iVertex<3; ++iVertex) {
+            Array<T,3> const& vertex = mesh.getVertex(ids[iId], iVertex);
+            triangles.push_back(vertex[0]);
+            triangles.push_back(vertex[1]);
+            triangles.push_back(vertex[2]);
+        }
+    }
+}
+
+template<typename T>
+void TriangleBVH3D<T>::buildNode (
+        std::vector<plint>& ids, std::vector<Array<T,4> > const& boxes,
+        std::vector<Array<T,2> > const& centers, plint first, plint last )
+{
+    static const plint maxLeafSize = 4;
+    plint iNode = (plint)nodes.size();
+    nodes.push_back(Node());
+
+    Node node;
+    node.xMin = node.yMin = std::numeric_limits<T>::max();
+    node.xMax = node.yMax = -std::numeric_limits<T>::max();
+    Array<T,2> centerMin(std::numeric_limits<T>::max(), std::numeric_limits<T>::max());
+    Array<T,2> centerMax(-std::numeric_limits<T>::max(), -std::numeric_limits<T>::max());
+    for (plint iId=first; iId<last; ++iId) {
+        Array<T,4> const& box = boxes[ids[iId]];
+        node.xMin = std::min(node.xMin, box[0]);
+        node.xMax = std::max(node.xMax, box[1]);
+        node.yMin = std::min(node.yMin, box[2]);
+        node.yMax = std::max(node.yMax, box[3]);
+        Array<T,2> const& center = centers[ids[iId]];
+        for (int iD=0; iD<2; ++iD) {
+            centerMin[iD] = std::min(centerMin[iD], center[iD]);
+            centerMax[iD] = std::max(centerMax[iD], center[iD]);
+        }
+    }
+
+    if (last-first <= maxLeafSize) {
+        // The triangles of the leaves are numbered in the order of ids,
+        //   which is final once the leaf is created.
+        node.index = first;
+        node.numTriangles = last-first;
+        nodes[iNode] = node;
+        return;
+    }
+
+    int axis = centerMax[0]-centerMin[0] >= centerMax[1]-centerMin[1] ? 0 : 1;
+    plint middle = (first+last)/2;
+    std::nth_element( ids.begin()+first, ids.begin()+middle, ids.begin()+last,
+                      BVHCenterLess3D<T>(centers, axis) );
+    node.numTriangles = 0;
+    nodes[iNode] = node;
+    buildNode(ids, boxes, centers, first, middle);
+    nodes[iNode].index = (plint)nodes.size();
+    buildNode(ids, boxes, centers, middle, last);
+}
+
+template<typename T>
+bool TriangleBVH3D<T>::lineCrossings(T x, T y, std::vector<T>& crossings) const
+{
+    if (nodes.empty()) {
+        return true;
+    }
+    bool isRegular = true;
+    // With median splits, the depth of the tree is log2 of the number of leaves.
+    plint stack[128];
+    plint stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize>0) {
+        plint iNode = stack[--stackSize];
+        Node const& node = nodes[iNode];
+        if (x<node.xMin || x>node.xMax || y<node.yMin || y>node.yMax) {
+            continue;
+        }
+        if (node.numTriangles==0) {
+            stack[stackSize++] = node.index;
+            stack[stackSize++] = iNode+1;
+            continue;
+        }
+        T const* vertices = &triangles[9*node.index];
+        for (plint iTriangle=0; iTriangle<node.numTriangles; ++iTriangle, vertices+=9) {
+            T ax = vertices[0]-x, ay = vertices[1]-y;
+            T bx = vertices[3]-x, by = vertices[4]-y;
+            T cx = vertices[6]-x, cy = vertices[7]-y;
+            // Barycentric coordinates of the line in the projected triangle,
+            //   multiplied by twice its signed area.
+            T wa = bx*cy - by*cx;
+            T wb = cx*ay - cy*ax;
+            T wc = ax*by - ay*bx;
+            if ( (wa>T() && wb>T() && wc>T()) || (wa<T() && wb<T() && wc<T()) ) {
+                crossings.push_back((wa*vertices[2] + wb*vertices[5] + wc*vertices[8]) / (wa+wb+wc));
+            }
+            else if ( (wa>=T() && wb>=T() && wc>=T()) || (wa<=T() && wb<=T() && wc<=T()) ) {
+                // The line touches an edge, a vertex, or a triangle parallel
+                //   to the z-axis: the parity is ambiguous.
+                isRegular = false;
+            }
+        }
+    }
+    return isRegular;
+}
+
+/* ******** BVHVoxelizeTask3D ************************************* */
+
+template<typename T>
+BVHVoxelizeTask3D<T>::BVHVoxelizeTask3D (
+        TriangleBVH3D<T> const& bvh_, ScalarField3D<int>& voxels_, Box3D domain_ )
+    : bvh(bvh_), voxels(voxels_), domain(domain_)
+{ }
+
+template<typename T>
+void BVHVoxelizeTask3D<T>::execute()
+{
+    static const plint maxNumAttempts = 4;
+    Dot3D location = voxels.getLocation();
+    T shift = std::sqrt(std::numeric_limits<T>::epsilon());
+    std::vector<T> crossings;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        T x = (T)(iX+location.x);
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            T y = (T)(iY+location.y);
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                voxels.get(iX,iY,iZ) = voxelFlag::outside;
+            }
+            crossings.clear();
+            if (bvh.lineCrossings(x, y, crossings)) {
+                markInside(iX, iY, crossings);
+                continue;
+            }
+            // The line touches the surface, for example because the mesh is
+            //   aligned with the lattice. As with voxelize3D, the cells on the
+            //   surface are inside: a cell is inside if it is inside for any of
+            //   four lines which are shifted by a small, irrational fraction
+            //   of a cell in the diagonal directions.
+            for (int iShift=0; iShift<4; ++iShift) {
+                T xShift = (iShift%2==0 ? (T)0.7548776662466927 : -(T)0.7548776662466927) * shift;
+                T yShift = (iShift/2==0 ? (T)0.5698402909980532 : -(T)0.5698402909980532) * shift;
+                for (plint iAttempt=1; iAttempt<=maxNumAttempts; ++iAttempt) {
+                    crossings.clear();
+                    if (bvh.lineCrossings(x+(T)iAttempt*xShift, y+(T)iAttempt*yShift, crossings)) {
+                        break;
+                    }
+                }
+                markInside(iX, iY, crossings);
+            }
+        }
+    }
+}
+
+template<typename T>
+void BVHVoxelizeTask3D<T>::markInside(plint iX, plint iY, std::vector<T>& crossings)
+{
+    std::sort(crossings.begin(), crossings.end());
+    T zLocation = (T)voxels.getLocation().z;
+    // With an odd number of crossings (non-closed mesh), the line is
+    //   outside above its last crossing.
+    for (pluint iCrossing=1; iCrossing<crossings.size(); iCrossing+=2) {
+        plint zMin = std::max(domain.z0, (plint)std::ceil(crossings[iCrossing-1]-zLocation));
+        plint zMax = std::min(domain.z1, (plint)std::floor(crossings[iCrossing]-zLocation));
+        for (plint iZ=zMin; iZ<=zMax; ++iZ) {
+            voxels.get(iX,iY,iZ) = voxelFlag::inside;
+        }
+    }
+}
+
+/* ******** bvhVoxelize3D ************************************* */
+
+template<typename T>
+std::auto_ptr<MultiScalarField3D<int> > bvhVoxelize3D (
+        TriangularSurfaceMesh<T> const& mesh,
+        plint symmetricLayer, plint borderWidth )
+{
+    Array<T,2> xRange, yRange, zRange;
+    mesh.computeBoundingBox(xRange, yRange, zRange);
+    // The +1 is because if the resolution is N, the number of nodes is N+1.
+    plint nx = (plint)(xRange[1] - xRange[0]) + 1 + 2*symmetricLayer;
+    plint ny = (plint)(yRange[1] - yRange[0]) + 1 + 2*symmetricLayer;
+    plint nz = (plint)(zRange[1] - zRange[0]) + 1 + 2*symmetricLayer;
+
+    return bvhVoxelize3D(mesh, Box3D(0,nx-1, 0,ny-1, 0,nz-1), borderWidth);
+}
+
+template<typename T>
+std::auto_ptr<MultiScalarField3D<int> > bvhVoxelize3D (
+        TriangularSurfaceMesh<T> const& mesh,
+        Box3D const& domain, plint borderWidth )
+{
+    plint envelopeWidth=1;
+    std::auto_ptr<MultiScalarField3D<int> > voxelMatrix
+        = generateMultiScalarField<int>(domain, voxelFlag::undetermined, envelopeWidth);
+
+    // Only the triangles above or below the local blocks are needed by
+    //   this process.
+    MultiBlockManagement3D const& management = voxelMatrix->getMultiBlockManagement();
+    std::vector<plint> const& blocks = management.getLocalInfo().getBlocks();
+    Box3D localBox;
+    for (pluint iBlock=0; iBlock<blocks.size(); ++iBlock) {
+        Box3D bulk = management.getBulk(blocks[iBlock]);
+        localBox = iBlock==0 ? bulk : bound(localBox, bulk);
+    }
+    if (!blocks.empty()) {
+        // Enlarged by one cell, to account for the shift of the lines.
+        TriangleBVH3D<T> bvh( mesh, Array<T,2>((T)(localBox.x0-1), (T)(localBox.x1+1)),
+                                    Array<T,2>((T)(localBox.y0-1), (T)(localBox.y1+1)) );
+        std::vector<SmpTask*> tasks(blocks.size());
+        for (pluint iBlock=0; iBlock<blocks.size(); ++iBlock) {
+            SmartBulk3D bulk(management, blocks[iBlock]);
+            tasks[iBlock] = new BVHVoxelizeTask3D<T> (
+                    bvh, voxelMatrix->getComponent(blocks[iBlock]), bulk.toLocal(bulk.getBulk()) );
+        }
+        voxelMatrix->executeLocalTasks(blocks, tasks);
+    }
+    voxelMatrix->duplicateOverlaps(modif::staticVariables);
+
+    detectBorderLine(*voxelMatrix, voxelMatrix->getBoundingBox(), borderWidth);
+
+    return std::auto_ptr<MultiScalarField3D<int> >(voxelMatrix);
+}
+
+} // namespace plb
+
+#endif  // BVH_VOXELIZER_3D_HH
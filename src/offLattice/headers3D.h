@@ -32,6 +32,7 @@
 #include "offLattice/triangleToDef.h"
 #include "offLattice/triangularSurfaceMesh.h"
 #include "offLattice/voxelizer3D.h"
+#include "offLattice/bvhVoxelizer3D.h"
 #include "offLattice/makeSparse3D.h"
 #include "offLattice/triangleHash.h"
 #include "offLattice/offLatticeBoundaryProcessor3D.h"
@@ -32,6 +32,7 @@
 #include "offLattice/triangleToDef.hh"
 #include "offLattice/triangularSurfaceMesh.hh"
 #include "offLattice/voxelizer3D.hh"
+#include "offLattice/bvhVoxelizer3D.hh"
 #include "offLattice/makeSparse3D.hh"
 #include "offLattice/triangleHash.hh"
 #include "offLattice/offLatticeBoundaryProcessor3D.hh"
@@ -29,6 +29,7 @@
 #include "atomicBlock/dataProcessingFunctional3D.h"
 #include "multiBlock/multiContainerBlock3D.h"
 #include "multiBlock/multiDataField3D.h"
+#include "multiBlock/redistribution3D.h"
 
 namespace plb {
 
@@ -51,6 +52,13 @@ template<typename T>
 MultiBlockManagement3D computeSparseManagement (
         MultiScalarField3D<T>& field, plint newEnvelopeWidth );
 
+/// Same as above, but the blocks are attributed to the processes along a
+///   space-filling curve, in segments with an equal number of active cells.
+template<typename T>
+MultiBlockManagement3D computeSparseManagement (
+        MultiScalarField3D<T>& field, plint newEnvelopeWidth,
+        spaceFillingCurve::CurveT curve );
+
 }  // namespace plb
 
 #endif  // MAKE_SPARSE_3D_H
@@ -37,6 +37,7 @@ namespace plb {
 
 struct FlagData3D : public ContainerBlockData {
     bool keepThisBlock;
+    plint numActiveCells;
     virtual FlagData3D* clone() const {
         return new FlagData3D(*this);
     }
@@ -58,17 +59,19 @@ void ComputeSparsityFunctional3D<T>::processGenericBlocks (
     AtomicContainerBlock3D* container = dynamic_cast<AtomicContainerBlock3D*>(blocks[1]);
     PLB_ASSERT( field );
     PLB_ASSERT( container );
-    bool exclusivelyEliminateCells = true;
+    plint numActiveCells = 0;
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
                 if (field->get(iX,iY,iZ) != 0) {
-                    exclusivelyEliminateCells = false;
+                    ++numActiveCells;
                 }
             }
         }
     }
+    bool exclusivelyEliminateCells = numActiveCells==0;
     FlagData3D* flagData = new FlagData3D;
+    flagData->numActiveCells = numActiveCells;
     if (exclusivelyEliminateCells) {
         flagData->keepThisBlock = false;
         this->getStatistics().gatherIntSum(numBlocksId, 1);
@@ -103,9 +106,11 @@ pluint ComputeSparsityFunctional3D<T>::getNumBlocks() const {
 
 /* ******** computeSparseManagement ************************************ */
 
+/// Remove the blocks of the field which contain no active cell, and return
+///   the number of active cells of the remaining blocks.
 template<typename T>
-MultiBlockManagement3D computeSparseManagement (
-        MultiScalarField3D<T>& field, plint newEnvelopeWidth )
+SparseBlockStructure3D computeSparseStructure (
+        MultiScalarField3D<T>& field, std::vector<plint>& numActiveCells )
 {
     MultiContainerBlock3D multiFlagBlock(field);
     std::vector<MultiBlock3D*> args;
@@ -121,7 +126,7 @@ MultiBlockManagement3D computeSparseManagement (
 
     std::map<plint,Box3D> const& domains = sparseBlock.getBulks();
     std::vector<plint> domainIds(domains.size());
-    std::vector<int> keepThisBlock(domains.size());
+    std::vector<plint> blockNumActiveCells(domains.size());
 
     std::map<plint,Box3D>::const_iterator it = domains.begin();
     plint pos = 0;
@@ -133,58 +138,83 @@ MultiBlockManagement3D computeSparseManagement (
             FlagData3D const* data =
                 dynamic_cast<FlagData3D const*> (flagBlock.getData());
             PLB_ASSERT( data );
-            keepThisBlock[pos] = data->keepThisBlock ? 1:0;
+            blockNumActiveCells[pos] = data->keepThisBlock ? data->numActiveCells : 0;
         }
         else {
-            keepThisBlock[pos] = 0;
+            blockNumActiveCells[pos] = 0;
         }
         ++pos;
     }
 
 #ifdef PLB_MPI_PARALLEL
-    std::vector<int> tmp(keepThisBlock.size());
-    global::mpi().reduceVect(keepThisBlock, tmp, MPI_SUM);
-    global::mpi().bCast(&tmp[0], tmp.size());
-    tmp.swap(keepThisBlock);
+    global::mpi().allReduceVect(blockNumActiveCells, MPI_SUM);
 #endif
 
     SparseBlockStructure3D newSparseBlock(field.getBoundingBox());
+    numActiveCells.clear();
     plint newId = 0;
-    for (pluint iBlock=0; iBlock<keepThisBlock.size(); ++iBlock) {
-        if (keepThisBlock[iBlock]) {
+    for (pluint iBlock=0; iBlock<blockNumActiveCells.size(); ++iBlock) {
+        if (blockNumActiveCells[iBlock]>0) {
             plint id = domainIds[iBlock];
             Box3D bulk, uniqueBulk;
             sparseBlock.getBulk(id, bulk);
             sparseBlock.getUniqueBulk(id, uniqueBulk);
             newSparseBlock.addBlock(bulk, uniqueBulk, newId++);
+            numActiveCells.push_back(blockNumActiveCells[iBlock]);
         }
     }
     // If this assertion fails, that means that the domain covered
     // by the sparse block-structure is empty.
     PLB_ASSERT( newId>0 );
+    return newSparseBlock;
+}
+
+template<typename T>
+MultiBlockManagement3D computeSparseManagement (
+        MultiScalarField3D<T>& field, plint newEnvelopeWidth )
+{
+    std::vector<plint> numActiveCells;
+    SparseBlockStructure3D newSparseBlock = computeSparseStructure(field, numActiveCells);
+    plint newId = (plint)numActiveCells.size();
 
     ExplicitThreadAttribution* newAttribution = new ExplicitThreadAttribution;
     std::vector<std::pair<plint,plint> > ranges;
     plint numRanges = std::min(newId, (plint)global::mpi().getSize());
     util::linearRepartition(0, newId-1, numRanges, ranges);
     
-    std::vector<plint> localBlocks;
     for (pluint iProc=0; iProc<ranges.size(); ++iProc) {
         for (plint blockId=ranges[iProc].first; blockId<=ranges[iProc].second; ++blockId) {
             newAttribution -> addBlock(blockId, iProc);
-            if (iProc==(pluint)global::mpi().getRank()) {
-                localBlocks.push_back(blockId);
-            }
         }
     }
 
     MultiBlockManagement3D newManagement (
             newSparseBlock, newAttribution,
             newEnvelopeWidth,
-            management.getRefinementLevel() );
+            field.getMultiBlockManagement().getRefinementLevel() );
     return newManagement;
 }
 
+template<typename T>
+MultiBlockManagement3D computeSparseManagement (
+        MultiScalarField3D<T>& field, plint newEnvelopeWidth,
+        spaceFillingCurve::CurveT curve )
+{
+    std::vector<plint> numActiveCells;
+    SparseBlockStructure3D newSparseBlock = computeSparseStructure(field, numActiveCells);
+    std::map<plint,double> weights;
+    for (pluint iBlock=0; iBlock<numActiveCells.size(); ++iBlock) {
+        weights[iBlock] = (double)numActiveCells[iBlock];
+    }
+    ExplicitThreadAttribution* newAttribution =
+        spaceFillingCurveThreadAttribution(newSparseBlock, weights, curve);
+
+    return MultiBlockManagement3D (
+            newSparseBlock, newAttribution,
+            newEnvelopeWidth,
+            field.getMultiBlockManagement().getRefinementLevel() );
+}
+
 }  // namespace plb
 
 #endif  // MAKE_SPARSE_3D_HH
@@ -30,6 +30,7 @@
 #include "core/globalDefs.h"
 #include "core/plbTimer.h"
 #include "offLattice/voxelizer3D.h"
+#include "offLattice/bvhVoxelizer3D.h"
 #include "atomicBlock/dataField3D.h"
 #include "multiBlock/multiBlockGenerator3D.h"
 #include "dataProcessors/dataInitializerWrapper3D.h"
@@ -58,6 +59,9 @@ std::auto_ptr<MultiScalarField3D<int> > voxelize3D (
         TriangularSurfaceMesh<T> const& mesh,
         Box3D const& domain, plint borderWidth )
 {
+    if (global::voxelizerPolicy().isBVHOn()) {
+        return bvhVoxelize3D(mesh, domain, borderWidth);
+    }
     // As initial seed, a one-cell layer around the outer boundary is tagged
     //   as ouside cells.
     plint envelopeWidth=1;
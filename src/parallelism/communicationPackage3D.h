@@ -42,6 +42,9 @@ struct CommunicationInfo3D {
     int toProcessId;
     Box3D toDomain;
     Dot3D absoluteOffset;
+    /// Direction of the bulk of the destination block, seen from the
+    ///   destination domain (see SmartBulk3D::directionOfBulk()).
+    Dot3D bulkDirection;
 };
 
 typedef std::vector<CommunicationInfo3D> CommunicationPackage3D;
@@ -33,3 +33,4 @@
 #include "parallelism/parallelMultiDataField2D.h"
 #include "parallelism/parallelStatistics.h"
 #include "parallelism/sendRecvPool.h"
+#include "parallelism/smpThreadPool.h"
@@ -41,7 +41,8 @@ namespace global {
 
 MpiManager::MpiManager()
     : ok(false),
-      responsibleForMpiMachine(false)
+      responsibleForMpiMachine(false),
+      sharedMemoryHaloFlag(false)
 { }
 
 MpiManager::~MpiManager() {
@@ -56,7 +57,13 @@ void MpiManager::init(int *argc, char ***argv, bool verbous) {
     if (verbous) {
         std::cerr << "Constructing an MPI thread" << std::endl;
     }
+#ifdef PLB_SMP_PARALLEL
+    // Only the main thread of the SMP thread pool communicates.
+    int threadSupport;
+    int ok1 = MPI_Init_thread(argc, argv, MPI_THREAD_FUNNELED, &threadSupport);
+#else
     int ok1 = MPI_Init(argc, argv);
+#endif
     // If I'm the one who calls MPI_Init, then I need to be
     // the one who calls MPI_Finalize.
     responsibleForMpiMachine = true;
@@ -102,6 +109,14 @@ MPI_Comm MpiManager::getGlobalCommunicator() const {
     return globalCommunicator;
 }
 
+void MpiManager::toggleSharedMemoryHalo(bool flag) {
+    sharedMemoryHaloFlag = flag;
+}
+
+bool MpiManager::isSharedMemoryHaloOn() const {
+    return sharedMemoryHaloFlag;
+}
+
 void MpiManager::barrier() {
     if (!ok) return;
     MPI_Barrier(getGlobalCommunicator());
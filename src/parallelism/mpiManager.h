@@ -145,6 +145,14 @@ public:
     /// Complete a non-blocking MPI operation
     void wait(MPI_Request* request, MPI_Status* status);
 
+    /// Exchange the static envelope data of the multi-blocks between processes
+    ///   of the same node through MPI-3 shared-memory windows, instead of
+    ///   messages (default: false). The setting must be the same on all
+    ///   processes, and applies to the communication structures created
+    ///   after the call.
+    void toggleSharedMemoryHalo(bool flag);
+    bool isSharedMemoryHaloOn() const;
+
 private:
     /// Implementation code for Scatter
     template <typename T>
@@ -162,6 +170,7 @@ private:
     int numTasks, taskId;
     bool ok;
     bool responsibleForMpiMachine;
+    bool sharedMemoryHaloFlag;
     MPI_Comm globalCommunicator;
 
 friend MpiManager& mpi();
@@ -191,6 +200,9 @@ public:
     void bCast(std::string& message, int root = 0) { }
     /// Synchronizes the processes
     void barrier() { }
+    /// There is no communication between processes in serial mode.
+    void toggleSharedMemoryHalo(bool flag) { }
+    bool isSharedMemoryHaloOn() const { return false; }
 
 friend MpiManager& mpi();
 };
@@ -177,9 +177,9 @@ void ParallelBlockCommunicator2D::communicate (
             originMultiBlock.getMultiBlockManagement(),
             destinationMultiBlock.getMultiBlockManagement(),
             originMultiBlock.sizeOfCell() );
-    global::profiler().start("mpiCommunication");
+    global::profiler().start(global::ProfilerTimer::mpiCommunication);
     communicate(communication, originMultiBlock, destinationMultiBlock, whichData);
-    global::profiler().stop("mpiCommunication");
+    global::profiler().stop(global::ProfilerTimer::mpiCommunication);
 }
 
 void ParallelBlockCommunicator2D::communicate (
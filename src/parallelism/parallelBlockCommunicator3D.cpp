@@ -40,11 +40,13 @@ namespace plb {
 
 #ifdef PLB_MPI_PARALLEL
 
-CommunicationStructure3D::CommunicationStructure3D (
+void computeCommunicationPackages3D (
         std::vector<Overlap3D> const& overlaps,
         MultiBlockManagement3D const& originManagement,
         MultiBlockManagement3D const& destinationManagement,
-        plint sizeOfCell )
+        CommunicationPackage3D& sendPackage,
+        CommunicationPackage3D& recvPackage,
+        CommunicationPackage3D& sendRecvPackage )
 {
     plint fromEnvelopeWidth = originManagement.getEnvelopeWidth();
     plint toEnvelopeWidth = destinationManagement.getEnvelopeWidth();
@@ -52,8 +54,12 @@ CommunicationStructure3D::CommunicationStructure3D (
         = originManagement.getSparseBlockStructure();
     SparseBlockStructure3D const& toSparseBlock
         = destinationManagement.getSparseBlockStructure();
+    ThreadAttribution const& fromAttribution = originManagement.getThreadAttribution();
+    ThreadAttribution const& toAttribution = destinationManagement.getThreadAttribution();
 
-    SendRecvPool sendPool, recvPool;
+    sendPackage.clear();
+    recvPackage.clear();
+    sendRecvPackage.clear();
     for (pluint iOverlap=0; iOverlap<overlaps.size(); ++iOverlap) {
         Overlap3D const& overlap = overlaps[iOverlap];
         CommunicationInfo3D info;
@@ -72,18 +78,12 @@ CommunicationStructure3D::CommunicationStructure3D (
                 overlapCoordinates.x0 - originalCoordinates.x0,
                 overlapCoordinates.y0 - originalCoordinates.y0,
                 overlapCoordinates.z0 - originalCoordinates.z0 );
+        info.bulkDirection = overlapBulk.directionOfBulk(overlapCoordinates);
 
-        plint lx = info.fromDomain.x1-info.fromDomain.x0+1;
-        plint ly = info.fromDomain.y1-info.fromDomain.y0+1;
-        plint lz = info.fromDomain.z1-info.fromDomain.z0+1;
-        PLB_PRECONDITION(lx == info.toDomain.x1-info.toDomain.x0+1);
-        PLB_PRECONDITION(ly == info.toDomain.y1-info.toDomain.y0+1);
-        PLB_PRECONDITION(lz == info.toDomain.z1-info.toDomain.z0+1);
+        PLB_PRECONDITION(info.fromDomain.getNx() == info.toDomain.getNx());
+        PLB_PRECONDITION(info.fromDomain.getNy() == info.toDomain.getNy());
+        PLB_PRECONDITION(info.fromDomain.getNz() == info.toDomain.getNz());
 
-        plint numberOfCells = lx*ly*lz;
-
-        ThreadAttribution const& fromAttribution = originManagement.getThreadAttribution();
-        ThreadAttribution const& toAttribution = destinationManagement.getThreadAttribution();
         info.fromProcessId = fromAttribution.getMpiProcess(info.fromBlockId);
         info.toProcessId   = toAttribution.getMpiProcess(info.toBlockId);
 
@@ -95,34 +95,153 @@ CommunicationStructure3D::CommunicationStructure3D (
         else if (fromAttribution.isLocal(info.fromBlockId))
         {
             sendPackage.push_back(info);
-            sendPool.subscribeMessage(info.toProcessId, numberOfCells*sizeOfCell);
         }
         else if (toAttribution.isLocal(info.toBlockId))
         {
             recvPackage.push_back(info);
-            recvPool.subscribeMessage(info.fromProcessId, numberOfCells*sizeOfCell);
         }
     }
+}
+
+CommunicationStructure3D::CommunicationStructure3D (
+        std::vector<Overlap3D> const& overlaps,
+        MultiBlockManagement3D const& originManagement,
+        MultiBlockManagement3D const& destinationManagement,
+        plint sizeOfCell_ )
+    : sizeOfCell(sizeOfCell_),
+      sharedMemory(0)
+{
+    computeCommunicationPackages3D (
+            overlaps, originManagement, destinationManagement,
+            sendPackage, recvPackage, sendRecvPackage );
+    subscribeMessages();
+}
 
+CommunicationStructure3D::CommunicationStructure3D (
+        CommunicationPackage3D const& sendPackage_,
+        CommunicationPackage3D const& recvPackage_,
+        CommunicationPackage3D const& sendRecvPackage_,
+        plint sizeOfCell_,
+        std::vector<plint> const& directionalCellSizes_ )
+    : sizeOfCell(sizeOfCell_),
+      directionalCellSizes(directionalCellSizes_),
+      sendPackage(sendPackage_),
+      recvPackage(recvPackage_),
+      sendRecvPackage(sendRecvPackage_),
+      sharedMemory(0)
+{
+    subscribeMessages();
+}
+
+CommunicationStructure3D::~CommunicationStructure3D() {
+    delete sharedMemory;
+}
+
+void CommunicationStructure3D::useSharedMemory() {
+    if (!sharedMemory) {
+        SendRecvPool sendPool, recvPool;
+        subscribeMessages(sendPool, recvPool);
+        sharedMemory = new SharedMemoryExchange(sendPool, recvPool);
+        sendComm.useSharedMemory(sharedMemory);
+        recvComm.useSharedMemory(sharedMemory);
+    }
+}
+
+plint CommunicationStructure3D::cellSize(CommunicationInfo3D const& info) const {
+    if (isDirectional()) {
+        return directionalCellSizes[directionIndex(info.bulkDirection)];
+    }
+    return sizeOfCell;
+}
+
+void CommunicationStructure3D::subscribeMessages() {
+    SendRecvPool sendPool, recvPool;
+    subscribeMessages(sendPool, recvPool);
     sendComm = SendPoolCommunicator(sendPool);
     recvComm = RecvPoolCommunicator(recvPool);
 }
 
+void CommunicationStructure3D::subscribeMessages(SendRecvPool& sendPool, SendRecvPool& recvPool) const {
+    for (pluint iSend=0; iSend<sendPackage.size(); ++iSend) {
+        CommunicationInfo3D const& info = sendPackage[iSend];
+        sendPool.subscribeMessage(info.toProcessId, info.fromDomain.nCells()*cellSize(info));
+    }
+    for (pluint iRecv=0; iRecv<recvPackage.size(); ++iRecv) {
+        CommunicationInfo3D const& info = recvPackage[iRecv];
+        recvPool.subscribeMessage(info.fromProcessId, info.fromDomain.nCells()*cellSize(info));
+    }
+}
+
+namespace {
+
+bool sameBox(Box3D const& box1, Box3D const& box2) {
+    return box1.x0==box2.x0 && box1.x1==box2.x1 &&
+           box1.y0==box2.y0 && box1.y1==box2.y1 &&
+           box1.z0==box2.z0 && box1.z1==box2.z1;
+}
+
+bool samePackage(CommunicationPackage3D const& package1, CommunicationPackage3D const& package2)
+{
+    if (package1.size() != package2.size()) {
+        return false;
+    }
+    for (pluint iInfo=0; iInfo<package1.size(); ++iInfo) {
+        CommunicationInfo3D const& info1 = package1[iInfo];
+        CommunicationInfo3D const& info2 = package2[iInfo];
+        if ( info1.fromBlockId != info2.fromBlockId ||
+             info1.toBlockId != info2.toBlockId ||
+             info1.fromProcessId != info2.fromProcessId ||
+             info1.toProcessId != info2.toProcessId ||
+             !sameBox(info1.fromDomain, info2.fromDomain) ||
+             !sameBox(info1.toDomain, info2.toDomain) ||
+             !(info1.absoluteOffset == info2.absoluteOffset) ||
+             !(info1.bulkDirection == info2.bulkDirection) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+bool CommunicationStructure3D::matches (
+        CommunicationPackage3D const& sendPackage_,
+        CommunicationPackage3D const& recvPackage_,
+        CommunicationPackage3D const& sendRecvPackage_,
+        plint sizeOfCell_ ) const
+{
+    return !isDirectional() && sizeOfCell == sizeOfCell_ &&
+           samePackage(sendPackage, sendPackage_) &&
+           samePackage(recvPackage, recvPackage_) &&
+           samePackage(sendRecvPackage, sendRecvPackage_);
+}
+
 ////////////////////// Class ParallelBlockCommunicator3D /////////////////////
 
 ParallelBlockCommunicator3D::ParallelBlockCommunicator3D()
     : overlapsModified(true),
-      communication(0)
+      communication(0),
+      directionalCommunication(0),
+      duplicationPending(false),
+      pendingModifT(modif::nothing),
+      maxNumCachedTransfers(8)
 { }
 
 ParallelBlockCommunicator3D::ParallelBlockCommunicator3D (
         ParallelBlockCommunicator3D const& rhs )
     : overlapsModified(true),
-      communication(0)
+      communication(0),
+      directionalCommunication(0),
+      duplicationPending(false),
+      pendingModifT(modif::nothing),
+      maxNumCachedTransfers(rhs.maxNumCachedTransfers)
 { }
 
 ParallelBlockCommunicator3D::~ParallelBlockCommunicator3D() {
     delete communication;
+    delete directionalCommunication;
+    clearCachedTransfers();
 }
 
 ParallelBlockCommunicator3D& ParallelBlockCommunicator3D::operator= (
@@ -135,14 +254,18 @@ ParallelBlockCommunicator3D& ParallelBlockCommunicator3D::operator= (
 void ParallelBlockCommunicator3D::swap(ParallelBlockCommunicator3D& rhs) {
     std::swap(overlapsModified,rhs.overlapsModified);
     std::swap(communication,rhs.communication);
+    std::swap(directionalCommunication,rhs.directionalCommunication);
+    std::swap(duplicationPending,rhs.duplicationPending);
+    std::swap(pendingModifT,rhs.pendingModifT);
+    transferStructures.swap(rhs.transferStructures);
+    std::swap(maxNumCachedTransfers,rhs.maxNumCachedTransfers);
 }
 
 ParallelBlockCommunicator3D* ParallelBlockCommunicator3D::clone() const {
     return new ParallelBlockCommunicator3D(*this);
 }
 
-void ParallelBlockCommunicator3D::duplicateOverlaps( MultiBlock3D& multiBlock,
-                                                     modif::ModifT whichData ) const
+void ParallelBlockCommunicator3D::updateCommunicationStructure(MultiBlock3D const& multiBlock) const
 {
     MultiBlockManagement3D const& multiBlockManagement = multiBlock.getMultiBlockManagement();
     PeriodicitySwitch3D const& periodicity             = multiBlock.periodicity();
@@ -163,11 +286,85 @@ void ParallelBlockCommunicator3D::duplicateOverlaps( MultiBlock3D& multiBlock,
                                 overlaps,
                                 multiBlockManagement, multiBlockManagement,
                                 multiBlock.sizeOfCell() );
+        if (global::mpi().isSharedMemoryHaloOn()) {
+            communication->useSharedMemory();
+        }
+        delete directionalCommunication;
+        directionalCommunication = 0;
     }
+}
+
+void ParallelBlockCommunicator3D::updateDirectionalCommunicationStructure (
+        MultiBlock3D const& multiBlock ) const
+{
+    updateCommunicationStructure(multiBlock);
+    if (!directionalCommunication) {
+        // The size of the transmitted cells depends on the direction, and is
+        //   given by the data transfer of the atomic-blocks, which is the same
+        //   for all blocks.
+        std::vector<plint> directionalCellSizes(27, multiBlock.sizeOfCell());
+        std::vector<plint> const& blocks = multiBlock.getMultiBlockManagement().getLocalInfo().getBlocks();
+        if (!blocks.empty()) {
+            BlockDataTransfer3D const& dataTransfer = multiBlock.getComponent(blocks[0]).getDataTransfer();
+            for (plint dx=-1; dx<=1; ++dx) {
+                for (plint dy=-1; dy<=1; ++dy) {
+                    for (plint dz=-1; dz<=1; ++dz) {
+                        Dot3D direction(dx,dy,dz);
+                        directionalCellSizes[CommunicationStructure3D::directionIndex(direction)]
+                            = dataTransfer.directionalCellSize(direction);
+                    }
+                }
+            }
+        }
+        directionalCommunication = new CommunicationStructure3D (
+                communication->sendPackage, communication->recvPackage,
+                communication->sendRecvPackage, multiBlock.sizeOfCell(),
+                directionalCellSizes );
+        if (global::mpi().isSharedMemoryHaloOn()) {
+            directionalCommunication->useSharedMemory();
+        }
+    }
+}
 
+void ParallelBlockCommunicator3D::duplicateOverlaps( MultiBlock3D& multiBlock,
+                                                     modif::ModifT whichData ) const
+{
+    PLB_PRECONDITION( !duplicationPending );
+    updateCommunicationStructure(multiBlock);
     communicate(*communication, multiBlock, multiBlock, whichData);
 }
 
+void ParallelBlockCommunicator3D::startDuplicateOverlaps( MultiBlock3D& multiBlock,
+                                                          modif::ModifT whichData ) const
+{
+    PLB_PRECONDITION( !duplicationPending );
+    updateCommunicationStructure(multiBlock);
+    global::profiler().start(global::ProfilerTimer::mpiCommunication);
+    startCommunication(*communication, multiBlock, multiBlock, whichData);
+    global::profiler().stop(global::ProfilerTimer::mpiCommunication);
+    duplicationPending = true;
+    pendingModifT = whichData;
+}
+
+void ParallelBlockCommunicator3D::finalizeDuplicateOverlaps(MultiBlock3D& multiBlock) const
+{
+    PLB_PRECONDITION( duplicationPending );
+    // Only the time spent waiting for messages which have not yet arrived is
+    //   accounted for: the communication which overlapped with the computations
+    //   between start and finalize is hidden and does not count.
+    global::profiler().start(global::ProfilerTimer::mpiCommunication);
+    finalizeCommunication(*communication, multiBlock, pendingModifT);
+    global::profiler().stop(global::ProfilerTimer::mpiCommunication);
+    duplicationPending = false;
+}
+
+void ParallelBlockCommunicator3D::duplicateDirectionalOverlaps(MultiBlock3D& multiBlock) const
+{
+    PLB_PRECONDITION( !duplicationPending );
+    updateDirectionalCommunicationStructure(multiBlock);
+    communicate(*directionalCommunication, multiBlock, multiBlock, modif::staticVariables);
+}
+
 void ParallelBlockCommunicator3D::communicate (
         std::vector<Overlap3D> const& overlaps,
         MultiBlock3D const& originMultiBlock,
@@ -176,12 +373,55 @@ void ParallelBlockCommunicator3D::communicate (
     PLB_PRECONDITION( originMultiBlock.sizeOfCell() ==
                       destinationMultiBlock.sizeOfCell() );
 
-    CommunicationStructure3D communication (
-            overlaps,
-            originMultiBlock.getMultiBlockManagement(),
-            destinationMultiBlock.getMultiBlockManagement(),
-            originMultiBlock.sizeOfCell() );
-    communicate(communication, originMultiBlock, destinationMultiBlock, whichData);
+    if (maxNumCachedTransfers==0) {
+        CommunicationStructure3D communication (
+                overlaps,
+                originMultiBlock.getMultiBlockManagement(),
+                destinationMultiBlock.getMultiBlockManagement(),
+                originMultiBlock.sizeOfCell() );
+        communicate(communication, originMultiBlock, destinationMultiBlock, whichData);
+    }
+    else {
+        CommunicationStructure3D& communication = getTransferStructure (
+                overlaps,
+                originMultiBlock.getMultiBlockManagement(),
+                destinationMultiBlock.getMultiBlockManagement(),
+                originMultiBlock.sizeOfCell() );
+        communicate(communication, originMultiBlock, destinationMultiBlock, whichData);
+    }
+}
+
+CommunicationStructure3D& ParallelBlockCommunicator3D::getTransferStructure (
+        std::vector<Overlap3D> const& overlaps,
+        MultiBlockManagement3D const& originManagement,
+        MultiBlockManagement3D const& destinationManagement,
+        plint sizeOfCell ) const
+{
+    // The overlaps are sorted into packages in any case, because the
+    //   packages identify the transfer independently of the life time of
+    //   the multi-blocks. What is saved is the construction of the message
+    //   pools, and the reallocation of the buffers at the first use.
+    CommunicationPackage3D sendPackage, recvPackage, sendRecvPackage;
+    computeCommunicationPackages3D (
+            overlaps, originManagement, destinationManagement,
+            sendPackage, recvPackage, sendRecvPackage );
+
+    std::list<CommunicationStructure3D*>::iterator it = transferStructures.begin();
+    for (; it != transferStructures.end(); ++it) {
+        if ((*it)->matches(sendPackage, recvPackage, sendRecvPackage, sizeOfCell)) {
+            // Move the structure to the front of the list.
+            transferStructures.splice(transferStructures.begin(), transferStructures, it);
+            return *transferStructures.front();
+        }
+    }
+
+    while ((plint)transferStructures.size() >= maxNumCachedTransfers) {
+        delete transferStructures.back();
+        transferStructures.pop_back();
+    }
+    transferStructures.push_front (
+            new CommunicationStructure3D(sendPackage, recvPackage, sendRecvPackage, sizeOfCell) );
+    return *transferStructures.front();
 }
 
 void ParallelBlockCommunicator3D::communicate (
@@ -189,7 +429,17 @@ void ParallelBlockCommunicator3D::communicate (
         MultiBlock3D const& originMultiBlock,
         MultiBlock3D& destinationMultiBlock, modif::ModifT whichData ) const
 {
-    global::profiler().start("mpiCommunication");
+    global::profiler().start(global::ProfilerTimer::mpiCommunication);
+    startCommunication(communication, originMultiBlock, destinationMultiBlock, whichData);
+    finalizeCommunication(communication, destinationMultiBlock, whichData);
+    global::profiler().stop(global::ProfilerTimer::mpiCommunication);
+}
+
+void ParallelBlockCommunicator3D::startCommunication (
+        CommunicationStructure3D& communication,
+        MultiBlock3D const& originMultiBlock,
+        MultiBlock3D& destinationMultiBlock, modif::ModifT whichData ) const
+{
     bool staticMessage = whichData == modif::staticVariables;
     // 1. Non-blocking receives.
     communication.recvComm.startBeingReceptive(staticMessage);
@@ -198,9 +448,20 @@ void ParallelBlockCommunicator3D::communicate (
     for (unsigned iSend=0; iSend<communication.sendPackage.size(); ++iSend) {
         CommunicationInfo3D const& info = communication.sendPackage[iSend];
         AtomicBlock3D const& fromBlock = originMultiBlock.getComponent(info.fromBlockId);
-        fromBlock.getDataTransfer().send (
-                info.fromDomain, communication.sendComm.getSendBuffer(info.toProcessId),
-                whichData );
+        // Static data is written in place into the message which is sent.
+        if (communication.isDirectional()) {
+            char* sendBuffer = communication.sendComm.getStaticSendBuffer(info.toProcessId);
+            fromBlock.getDataTransfer().sendDirectional (
+                    info.fromDomain, sendBuffer, info.bulkDirection );
+        }
+        else if (staticMessage) {
+            char* sendBuffer = communication.sendComm.getStaticSendBuffer(info.toProcessId);
+            fromBlock.getDataTransfer().sendStatic(info.fromDomain, sendBuffer);
+        }
+        else {
+            std::vector<char>& sendBuffer = communication.sendComm.getSendBuffer(info.toProcessId);
+            fromBlock.getDataTransfer().send(info.fromDomain, sendBuffer, whichData);
+        }
         communication.sendComm.acceptMessage(info.toProcessId, staticMessage);
     }
 
@@ -212,30 +473,78 @@ void ParallelBlockCommunicator3D::communicate (
         plint deltaX = info.fromDomain.x0 - info.toDomain.x0;
         plint deltaY = info.fromDomain.y0 - info.toDomain.y0;
         plint deltaZ = info.fromDomain.z0 - info.toDomain.z0;
-        toBlock.getDataTransfer().attribute (
-                info.toDomain, deltaX, deltaY, deltaZ, fromBlock,
-                whichData, info.absoluteOffset );
+        if (communication.isDirectional()) {
+            toBlock.getDataTransfer().attributeDirectional (
+                    info.toDomain, deltaX, deltaY, deltaZ, fromBlock, info.bulkDirection );
+        }
+        else {
+            toBlock.getDataTransfer().attribute (
+                    info.toDomain, deltaX, deltaY, deltaZ, fromBlock,
+                    whichData, info.absoluteOffset );
+        }
     }
+}
 
+void ParallelBlockCommunicator3D::finalizeCommunication (
+        CommunicationStructure3D& communication,
+        MultiBlock3D& destinationMultiBlock, modif::ModifT whichData ) const
+{
+    bool staticMessage = whichData == modif::staticVariables;
     // 4. Finalize the receives.
     for (unsigned iRecv=0; iRecv<communication.recvPackage.size(); ++iRecv) {
         CommunicationInfo3D const& info = communication.recvPackage[iRecv];
         AtomicBlock3D& toBlock = destinationMultiBlock.getComponent(info.toBlockId);
-        toBlock.getDataTransfer().receive (
-                info.toDomain,
-                communication.recvComm.receiveMessage(info.fromProcessId, staticMessage),
-                whichData, info.absoluteOffset );
+        if (communication.isDirectional()) {
+            char const* recvBuffer
+                = communication.recvComm.receiveStaticMessage(info.fromProcessId);
+            toBlock.getDataTransfer().receiveDirectional (
+                    info.toDomain, recvBuffer, info.bulkDirection );
+        }
+        else if (staticMessage) {
+            char const* recvBuffer
+                = communication.recvComm.receiveStaticMessage(info.fromProcessId);
+            toBlock.getDataTransfer().receiveStatic (
+                    info.toDomain, recvBuffer, info.absoluteOffset );
+        }
+        else {
+            std::vector<char> const& recvBuffer
+                = communication.recvComm.receiveMessage(info.fromProcessId, staticMessage);
+            toBlock.getDataTransfer().receive (
+                    info.toDomain, recvBuffer, whichData, info.absoluteOffset );
+        }
     }
 
+    communication.recvComm.finalize();
+
     // 5. Finalize the sends.
     communication.sendComm.finalize(staticMessage);
-    global::profiler().stop("mpiCommunication");
 }
 
 void ParallelBlockCommunicator3D::signalPeriodicity() const {
     overlapsModified = true;
 }
 
+void ParallelBlockCommunicator3D::setMaxNumCachedTransfers(plint maxNumCachedTransfers_) {
+    PLB_PRECONDITION( maxNumCachedTransfers_ >= 0 );
+    maxNumCachedTransfers = maxNumCachedTransfers_;
+    while ((plint)transferStructures.size() > maxNumCachedTransfers) {
+        delete transferStructures.back();
+        transferStructures.pop_back();
+    }
+}
+
+plint ParallelBlockCommunicator3D::getMaxNumCachedTransfers() const {
+    return maxNumCachedTransfers;
+}
+
+void ParallelBlockCommunicator3D::clearCachedTransfers() const {
+    std::list<CommunicationStructure3D*>::iterator it = transferStructures.begin();
+    for (; it != transferStructures.end(); ++it) {
+        delete *it;
+    }
+    transferStructures.clear();
+}
+
 #endif  // PLB_MPI_PARALLEL
 
 }  // namespace plb
@@ -36,11 +36,22 @@
 #include "parallelism/sendRecvPool.h"
 #include "parallelism/communicationPackage3D.h"
 #include <vector>
+#include <list>
 
 namespace plb {
 
 #ifdef PLB_MPI_PARALLEL
 
+/// Sort the overlaps into the transfers which the current process sends,
+///   receives, or executes as a local copy.
+void computeCommunicationPackages3D (
+        std::vector<Overlap3D> const& overlaps,
+        MultiBlockManagement3D const& originManagement,
+        MultiBlockManagement3D const& destinationManagement,
+        CommunicationPackage3D& sendPackage,
+        CommunicationPackage3D& recvPackage,
+        CommunicationPackage3D& sendRecvPackage );
+
 struct CommunicationStructure3D
 {
     CommunicationStructure3D (
@@ -48,11 +59,49 @@ struct CommunicationStructure3D
             MultiBlockManagement3D const& originManagement,
             MultiBlockManagement3D const& destinationManagement,
             plint sizeOfCell );
+    /// Build the structure from packages computed by computeCommunicationPackages3D().
+    /** If directionalCellSizes_ is not empty, the structure is used for the
+     *  directional transfers of BlockCommunicator3D::duplicateDirectionalOverlaps(),
+     *  and directionalCellSizes_ holds the number of bytes per cell for every
+     *  direction, indexed by directionIndex().
+     **/
+    CommunicationStructure3D (
+            CommunicationPackage3D const& sendPackage_,
+            CommunicationPackage3D const& recvPackage_,
+            CommunicationPackage3D const& sendRecvPackage_,
+            plint sizeOfCell_,
+            std::vector<plint> const& directionalCellSizes_ = std::vector<plint>() );
+    /// Check if this structure implements the given transfers, in which
+    ///   case it can be reused, together with its buffers.
+    bool matches( CommunicationPackage3D const& sendPackage_,
+                  CommunicationPackage3D const& recvPackage_,
+                  CommunicationPackage3D const& sendRecvPackage_,
+                  plint sizeOfCell_ ) const;
+    ~CommunicationStructure3D();
+    bool isDirectional() const {
+        return !directionalCellSizes.empty();
+    }
+    /// Exchange the static data with the processes of the same node through
+    ///   a shared-memory window (see SharedMemoryExchange). Collective.
+    void useSharedMemory();
+    /// Index, between 0 and 26, of a direction with components -1, 0 or 1.
+    static plint directionIndex(Dot3D const& direction) {
+        return (direction.x+1)*9 + (direction.y+1)*3 + direction.z+1;
+    }
+    plint sizeOfCell;
+    std::vector<plint> directionalCellSizes;
     CommunicationPackage3D sendPackage;
     CommunicationPackage3D recvPackage;
     CommunicationPackage3D sendRecvPackage;
     SendPoolCommunicator sendComm;
     RecvPoolCommunicator recvComm;
+    SharedMemoryExchange* sharedMemory;
+private:
+    CommunicationStructure3D(CommunicationStructure3D const& rhs);
+    CommunicationStructure3D& operator=(CommunicationStructure3D const& rhs);
+    plint cellSize(CommunicationInfo3D const& info) const;
+    void subscribeMessages();
+    void subscribeMessages(SendRecvPool& sendPool, SendRecvPool& recvPool) const;
 };
 
 
@@ -66,21 +115,56 @@ public:
     void swap(ParallelBlockCommunicator3D& rhs);
     virtual ParallelBlockCommunicator3D* clone() const;
     virtual void duplicateOverlaps(MultiBlock3D& multiBlock, modif::ModifT whichData) const;
+    virtual void startDuplicateOverlaps(MultiBlock3D& multiBlock, modif::ModifT whichData) const;
+    virtual void finalizeDuplicateOverlaps(MultiBlock3D& multiBlock) const;
+    virtual void duplicateDirectionalOverlaps(MultiBlock3D& multiBlock) const;
     virtual void communicate( std::vector<Overlap3D> const& overlaps,
                               MultiBlock3D const& originMultiBlock,
                               MultiBlock3D& destinationMultiBlock,
                               modif::ModifT whichData ) const;
     virtual void signalPeriodicity() const;
+    /// Maximum number of communication structures kept by communicate() for
+    ///   the transfers between multi-blocks (default: 8). The least recently
+    ///   used structure is discarded first; with 0, nothing is cached.
+    void setMaxNumCachedTransfers(plint maxNumCachedTransfers_);
+    plint getMaxNumCachedTransfers() const;
+    /// Discard the cached communication structures of communicate().
+    void clearCachedTransfers() const;
 private:
+    void updateCommunicationStructure(MultiBlock3D const& multiBlock) const;
+    /// Create the structure of the directional transfers, if needed.
+    void updateDirectionalCommunicationStructure(MultiBlock3D const& multiBlock) const;
+    /// Cached structure for the given overlaps, which is created if needed.
+    CommunicationStructure3D& getTransferStructure (
+            std::vector<Overlap3D> const& overlaps,
+            MultiBlockManagement3D const& originManagement,
+            MultiBlockManagement3D const& destinationManagement,
+            plint sizeOfCell ) const;
     void communicate( CommunicationStructure3D& communication,
                       MultiBlock3D const& originMultiBlock,
                       MultiBlock3D& destinationMultiBlock, modif::ModifT whichData ) const;
+    /// Post the receives, send the data, and execute the local copies.
+    void startCommunication( CommunicationStructure3D& communication,
+                             MultiBlock3D const& originMultiBlock,
+                             MultiBlock3D& destinationMultiBlock, modif::ModifT whichData ) const;
+    /// Unpack the received data, and wait for the sends to complete.
+    void finalizeCommunication( CommunicationStructure3D& communication,
+                                MultiBlock3D& destinationMultiBlock, modif::ModifT whichData ) const;
     void subscribeOverlap (
         Overlap3D const& overlap, MultiBlockManagement3D const& multiBlockManagement,
         SendRecvPool& sendPool, SendRecvPool& recvPool, plint sizeOfCell ) const;
 private:
     mutable bool overlapsModified;
     mutable CommunicationStructure3D* communication;
+    /// Same overlaps as communication, for directional transfers. Created
+    ///   at the first use.
+    mutable CommunicationStructure3D* directionalCommunication;
+    /// Set between startDuplicateOverlaps() and finalizeDuplicateOverlaps().
+    mutable bool duplicationPending;
+    mutable modif::ModifT pendingModifT;
+    /// Communication structures of communicate(), most recently used first.
+    mutable std::list<CommunicationStructure3D*> transferStructures;
+    plint maxNumCachedTransfers;
 };
 
 #endif  // PLB_MPI_PARALLEL
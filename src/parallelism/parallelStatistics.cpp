@@ -27,61 +27,235 @@
  */
 #include "parallelism/mpiManager.h"
 #include "parallelism/parallelStatistics.h"
+#include "core/plbDebug.h"
 #include <cmath>
+#include <cstring>
 
 namespace plb {
 
 #ifdef PLB_MPI_PARALLEL
 
-ParallelCombinedStatistics* ParallelCombinedStatistics::clone() const
+/* *** Layout of the reduction buffer ***
+ *
+ * Three header entries (number of summed entries, number of maxima, number
+ * of integer sums), followed by the summed entries (the weighted averages,
+ * the weights of the averages and the sums), the maxima, and the integer
+ * sums, whose bits are copied into entries of type double. The header is
+ * the same on all processes, and tells the reduction operation which
+ * entries it must sum or compare. The buffer is reduced as a single
+ * element of a contiguous datatype, because MPI may apply a reduction
+ * operation to any subset of the elements, which would separate the
+ * entries from their header.
+ */
+
+static const int statisticsHeaderSize = 3;
+
+static void packStatistics (
+        std::vector<double> const& averageObservables,
+        std::vector<double> const& sumWeights,
+        std::vector<double> const& sumObservables,
+        std::vector<double> const& maxObservables,
+        std::vector<plint> const& intSumObservables,
+        std::vector<double>& buffer )
 {
-    return new ParallelCombinedStatistics(*this);
+    PLB_ASSERT( sizeof(plint) <= sizeof(double) );
+    pluint numAverages = averageObservables.size();
+    pluint numSums = 2*numAverages + sumObservables.size();
+    buffer.assign(statisticsHeaderSize + numSums + maxObservables.size()
+                  + intSumObservables.size(), 0.);
+    buffer[0] = (double)numSums;
+    buffer[1] = (double)maxObservables.size();
+    buffer[2] = (double)intSumObservables.size();
+    double* pos = &buffer[statisticsHeaderSize];
+    for (pluint iAverage=0; iAverage<numAverages; ++iAverage) {
+        *pos++ = averageObservables[iAverage]*sumWeights[iAverage];
+    }
+    for (pluint iAverage=0; iAverage<numAverages; ++iAverage) {
+        *pos++ = sumWeights[iAverage];
+    }
+    for (pluint iSum=0; iSum<sumObservables.size(); ++iSum) {
+        *pos++ = sumObservables[iSum];
+    }
+    for (pluint iMax=0; iMax<maxObservables.size(); ++iMax) {
+        *pos++ = maxObservables[iMax];
+    }
+    for (pluint iSum=0; iSum<intSumObservables.size(); ++iSum) {
+        memcpy(pos++, &intSumObservables[iSum], sizeof(plint));
+    }
 }
 
-void ParallelCombinedStatistics::reduceStatistics (
-            std::vector<double>& averageObservables,
-            std::vector<double>& sumWeights,
-            std::vector<double>& sumObservables,
-            std::vector<double>& maxObservables,
-            std::vector<plint>& intSumObservables ) const
+static void unpackStatistics (
+        std::vector<double> const& buffer,
+        std::vector<double>& averageObservables,
+        std::vector<double>& sumWeights,
+        std::vector<double>& sumObservables,
+        std::vector<double>& maxObservables,
+        std::vector<plint>& intSumObservables )
 {
-    // Averages
-    for (pluint iAverage=0; iAverage<averageObservables.size(); ++iAverage) {
-        double globalAverage, globalWeight;
-        global::mpi().reduce(averageObservables[iAverage]*sumWeights[iAverage], globalAverage, MPI_SUM);
-        global::mpi().reduce(sumWeights[iAverage], globalWeight, MPI_SUM);
-        if (global::mpi().isMainProcessor() && fabs(globalWeight) > 0.5) {
+    pluint numAverages = averageObservables.size();
+    double const* pos = &buffer[statisticsHeaderSize];
+    for (pluint iAverage=0; iAverage<numAverages; ++iAverage) {
+        double globalAverage = pos[iAverage];
+        double globalWeight = pos[numAverages+iAverage];
+        if (std::fabs(globalWeight) > 0.5) {
             globalAverage /= globalWeight;
         }
-        global::mpi().bCast(&globalAverage, 1);
         averageObservables[iAverage] = globalAverage;
+        sumWeights[iAverage] = globalWeight;
     }
-
-    // Sum
+    pos += 2*numAverages;
     for (pluint iSum=0; iSum<sumObservables.size(); ++iSum) {
-        double globalSum;
-        global::mpi().reduce(sumObservables[iSum], globalSum, MPI_SUM);
-        global::mpi().bCast(&globalSum, 1);
-        sumObservables[iSum] = globalSum;
+        sumObservables[iSum] = *pos++;
     }
-
-    // Max
     for (pluint iMax=0; iMax<maxObservables.size(); ++iMax) {
-        double globalMax;
-        global::mpi().reduce(maxObservables[iMax], globalMax, MPI_MAX);
-        global::mpi().bCast(&globalMax, 1);
-        maxObservables[iMax] = globalMax;
+        maxObservables[iMax] = *pos++;
     }
-
-    // Integer sum
     for (pluint iSum=0; iSum<intSumObservables.size(); ++iSum) {
-        plint globalSum;
-        global::mpi().reduce(intSumObservables[iSum], globalSum, MPI_SUM);
-        global::mpi().bCast(&globalSum, 1);
-        intSumObservables[iSum] = globalSum;
+        memcpy(&intSumObservables[iSum], pos++, sizeof(plint));
+    }
+}
+
+/// Reduce one buffer of statistics into another.
+static void reduceStatisticsBuffer(double const* inBuffer, double* inoutBuffer, plint bufferSize)
+{
+    plint numSums = (plint)inoutBuffer[0];
+    plint numMax = (plint)inoutBuffer[1];
+    plint numIntSums = (plint)inoutBuffer[2];
+    PLB_ASSERT( statisticsHeaderSize+numSums+numMax+numIntSums == bufferSize );
+    plint pos = statisticsHeaderSize;
+    for (plint iSum=0; iSum<numSums; ++iSum, ++pos) {
+        inoutBuffer[pos] += inBuffer[pos];
+    }
+    for (plint iMax=0; iMax<numMax; ++iMax, ++pos) {
+        if (inBuffer[pos] > inoutBuffer[pos]) {
+            inoutBuffer[pos] = inBuffer[pos];
+        }
+    }
+    for (plint iSum=0; iSum<numIntSums; ++iSum, ++pos) {
+        plint value, inValue;
+        memcpy(&value, &inoutBuffer[pos], sizeof(plint));
+        memcpy(&inValue, &inBuffer[pos], sizeof(plint));
+        value += inValue;
+        memcpy(&inoutBuffer[pos], &value, sizeof(plint));
+    }
+}
+
+/// User-defined MPI reduction operation on elements of the datatype
+///   created by createStatisticsType(), each of which is a whole buffer.
+static void reduceStatisticsBuffers(void* in, void* inout, int* len, MPI_Datatype* datatype)
+{
+    int typeSize = 0;
+    MPI_Type_size(*datatype, &typeSize);
+    plint bufferSize = (plint)typeSize / (plint)sizeof(double);
+    PLB_ASSERT( bufferSize >= statisticsHeaderSize );
+    double const* inBuffer = static_cast<double const*>(in);
+    double* inoutBuffer = static_cast<double*>(inout);
+    for (int iBuffer=0; iBuffer<*len; ++iBuffer) {
+        reduceStatisticsBuffer(inBuffer+iBuffer*bufferSize, inoutBuffer+iBuffer*bufferSize, bufferSize);
+    }
+}
+
+/// Callback of MPI_Finalize, which frees the reduction operation.
+static int freeStatisticsReductionOp(MPI_Comm, int, void* attributeValue, void*)
+{
+    MPI_Op* op = static_cast<MPI_Op*>(attributeValue);
+    MPI_Op_free(op);
+    return MPI_SUCCESS;
+}
+
+static MPI_Op statisticsReductionOp() {
+    static MPI_Op op = MPI_OP_NULL;
+    if (op == MPI_OP_NULL) {
+        MPI_Op_create(&reduceStatisticsBuffers, 1, &op);
+        // MPI_Finalize deletes the attributes of MPI_COMM_SELF first, and
+        //   thereby frees the operation.
+        int keyval;
+        MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, &freeStatisticsReductionOp, &keyval, 0);
+        MPI_Comm_set_attr(MPI_COMM_SELF, keyval, &op);
+        MPI_Comm_free_keyval(&keyval);
+    }
+    return op;
+}
+
+/// Create the datatype of a whole buffer of statistics. It can be freed as
+///   soon as the reduction has been started.
+static MPI_Datatype createStatisticsType(std::vector<double> const& buffer) {
+    MPI_Datatype bufferType;
+    MPI_Type_contiguous((int)buffer.size(), MPI_DOUBLE, &bufferType);
+    MPI_Type_commit(&bufferType);
+    return bufferType;
+}
+
+ParallelCombinedStatistics::ParallelCombinedStatistics()
+    : request(MPI_REQUEST_NULL)
+{ }
+
+ParallelCombinedStatistics::ParallelCombinedStatistics(ParallelCombinedStatistics const& rhs)
+    : CombinedStatistics(rhs),
+      request(MPI_REQUEST_NULL)
+{ }
+
+ParallelCombinedStatistics::~ParallelCombinedStatistics()
+{
+    // MPI may still write into the buffer of a pending reduction.
+    if (request != MPI_REQUEST_NULL) {
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
     }
 }
 
+ParallelCombinedStatistics* ParallelCombinedStatistics::clone() const
+{
+    return new ParallelCombinedStatistics(*this);
+}
+
+void ParallelCombinedStatistics::reduceStatistics (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables ) const
+{
+    std::vector<double> buffer;
+    packStatistics(averageObservables, sumWeights, sumObservables, maxObservables, intSumObservables, buffer);
+    MPI_Datatype bufferType = createStatisticsType(buffer);
+    MPI_Allreduce( MPI_IN_PLACE, &buffer[0], 1, bufferType,
+                   statisticsReductionOp(), global::mpi().getGlobalCommunicator() );
+    MPI_Type_free(&bufferType);
+    unpackStatistics(buffer, averageObservables, sumWeights, sumObservables, maxObservables, intSumObservables);
+}
+
+void ParallelCombinedStatistics::startReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables )
+{
+#if MPI_VERSION >= 3
+    PLB_PRECONDITION( request == MPI_REQUEST_NULL );
+    packStatistics(averageObservables, sumWeights, sumObservables, maxObservables, intSumObservables, reductionBuffer);
+    MPI_Datatype bufferType = createStatisticsType(reductionBuffer);
+    MPI_Iallreduce( MPI_IN_PLACE, &reductionBuffer[0], 1, bufferType,
+                    statisticsReductionOp(), global::mpi().getGlobalCommunicator(), &request );
+    MPI_Type_free(&bufferType);
+#else
+    reduceStatistics(averageObservables, sumWeights, sumObservables, maxObservables, intSumObservables);
+#endif
+}
+
+void ParallelCombinedStatistics::completeReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables )
+{
+#if MPI_VERSION >= 3
+    MPI_Wait(&request, MPI_STATUS_IGNORE);
+    unpackStatistics(reductionBuffer, averageObservables, sumWeights, sumObservables, maxObservables, intSumObservables);
+#endif
+}
+
 #endif  // PLB_MPI_PARALLEL
 
 }  // namespace plb
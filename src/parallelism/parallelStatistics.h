@@ -30,14 +30,25 @@
 
 #include "core/globalDefs.h"
 #include "multiBlock/combinedStatistics.h"
+#include "parallelism/mpiManager.h"
 #include <vector>
 
 namespace plb {
 
 #ifdef PLB_MPI_PARALLEL
 
+/// Reduction of the statistics across MPI processes.
+/** All observables are packed into a single buffer, which is reduced by one
+ *  MPI_Allreduce with a user-defined operation (sum for the averages and
+ *  sums, max for the maxima, integer sum for the integer sums). The buffer
+ *  is a single element of a contiguous datatype, so that MPI never splits
+ *  it. With MPI-3, startReduction() uses the non-blocking MPI_Iallreduce.
+ */
 class ParallelCombinedStatistics : public CombinedStatistics {
 public:
+    ParallelCombinedStatistics();
+    ParallelCombinedStatistics(ParallelCombinedStatistics const& rhs);
+    ~ParallelCombinedStatistics();
     virtual ParallelCombinedStatistics* clone() const;
 protected:
     virtual void reduceStatistics (
@@ -46,6 +57,22 @@ protected:
             std::vector<double>& sumObservables,
             std::vector<double>& maxObservables,
             std::vector<plint>& intSumObservables ) const;
+    virtual void startReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables );
+    virtual void completeReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables );
+private:
+    /// Buffer and request of a pending non-blocking reduction.
+    std::vector<double> reductionBuffer;
+    MPI_Request request;
 };
  
 #endif  // PLB_MPI_PARALLEL
@@ -39,12 +39,187 @@ namespace plb {
 
 #ifdef PLB_MPI_PARALLEL
 
+/* *************** Class SharedMemoryExchange ******************************* */
+
+namespace {
+    // Tags of the messages on the node communicator of the window.
+    const int sharedAreaOffsetTag = 1;
+    const int sharedWrittenTag    = 2;
+    const int sharedReleaseTag    = 3;
+    // The areas of the different senders are aligned on cache lines.
+    const int sharedAreaAlignment = 64;
+}
+
+SharedMemoryExchange::SharedMemoryExchange (
+        SendRecvPool const& sendPool, SendRecvPool const& recvPool )
+    : allocated(false)
+{
+#if MPI_VERSION >= 3
+    MPI_Comm globalCommunicator = global::mpi().getGlobalCommunicator();
+    MPI_Comm_split_type( globalCommunicator, MPI_COMM_TYPE_SHARED,
+                         global::mpi().getRank(), MPI_INFO_NULL, &nodeCommunicator );
+    int nodeSize;
+    MPI_Comm_size(nodeCommunicator, &nodeSize);
+    std::vector<int> globalRanks(nodeSize);
+    int globalRank = global::mpi().getRank();
+    MPI_Allgather(&globalRank, 1, MPI_INT, &globalRanks[0], 1, MPI_INT, nodeCommunicator);
+    for (int iRank=0; iRank<nodeSize; ++iRank) {
+        nodeRanks[globalRanks[iRank]] = iRank;
+    }
+
+    // 1. The memory of the local process holds the messages received from
+    //    the processes of the node, one after the other.
+    std::vector<int> offsets;
+    std::vector<int> senders;
+    MPI_Aint windowSize = 0;
+    SendRecvPool::SubsT::const_iterator it = recvPool.begin();
+    for (; it != recvPool.end(); ++it) {
+        if (it->first != globalRank && nodeRanks.find(it->first) != nodeRanks.end() &&
+            it->second.cumDataLength > 0)
+        {
+            senders.push_back(it->first);
+            offsets.push_back((int)windowSize);
+            windowSize += ( (it->second.cumDataLength+sharedAreaAlignment-1) /
+                            sharedAreaAlignment ) * sharedAreaAlignment;
+        }
+    }
+    MPI_Info info;
+    MPI_Info_create(&info);
+    // Let every process place its memory on its own NUMA domain.
+    MPI_Info_set(info, const_cast<char*>("alloc_shared_noncontig"), const_cast<char*>("true"));
+    char* localBase = 0;
+    MPI_Win_allocate_shared(windowSize, 1, info, nodeCommunicator, &localBase, &window);
+    MPI_Info_free(&info);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+    allocated = true;
+
+    // 2. The senders are informed of the position of their messages.
+    std::vector<MPI_Request> requests(senders.size());
+    for (pluint iSender=0; iSender<senders.size(); ++iSender) {
+        recvAreas[senders[iSender]] = localBase + offsets[iSender];
+        MPI_Isend( &offsets[iSender], 1, MPI_INT, nodeRanks[senders[iSender]],
+                   sharedAreaOffsetTag, nodeCommunicator, &requests[iSender] );
+    }
+    for (it = sendPool.begin(); it != sendPool.end(); ++it) {
+        if (it->first != globalRank && nodeRanks.find(it->first) != nodeRanks.end() &&
+            it->second.cumDataLength > 0)
+        {
+            int nodeRank = nodeRanks[it->first];
+            int offset;
+            MPI_Recv( &offset, 1, MPI_INT, nodeRank, sharedAreaOffsetTag,
+                      nodeCommunicator, MPI_STATUS_IGNORE );
+            MPI_Aint size;
+            int dispUnit;
+            char* base;
+            MPI_Win_shared_query(window, nodeRank, &size, &dispUnit, &base);
+            sendAreas[it->first] = base + offset;
+            pendingReleases[it->first] = false;
+        }
+    }
+    if (!requests.empty()) {
+        MPI_Waitall((int)requests.size(), &requests[0], MPI_STATUSES_IGNORE);
+    }
+#endif
+}
+
+SharedMemoryExchange::~SharedMemoryExchange() {
+#if MPI_VERSION >= 3
+    if (allocated) {
+        // Complete the notifications which are still in progress.
+        std::map<int,bool>::iterator senderIt = pendingReleases.begin();
+        for (; senderIt != pendingReleases.end(); ++senderIt) {
+            if (senderIt->second) {
+                waitForRelease(senderIt->first);
+            }
+        }
+        std::map<int,MPI_Request>::iterator receiverIt = releaseRequests.begin();
+        for (; receiverIt != releaseRequests.end(); ++receiverIt) {
+            MPI_Wait(&receiverIt->second, MPI_STATUS_IGNORE);
+        }
+        MPI_Win_unlock_all(window);
+        MPI_Win_free(&window);
+        MPI_Comm_free(&nodeCommunicator);
+    }
+#endif
+}
+
+char* SharedMemoryExchange::getSendArea(int toProc) const {
+    std::map<int,char*>::const_iterator it = sendAreas.find(toProc);
+    return it==sendAreas.end() ? 0 : it->second;
+}
+
+char* SharedMemoryExchange::getRecvArea(int fromProc) const {
+    std::map<int,char*>::const_iterator it = recvAreas.find(fromProc);
+    return it==recvAreas.end() ? 0 : it->second;
+}
+
+void SharedMemoryExchange::synchronize() {
+#if MPI_VERSION >= 3
+    MPI_Win_sync(window);
+#endif
+}
+
+void SharedMemoryExchange::waitForRelease(int toProc) {
+    std::map<int,bool>::iterator it = pendingReleases.find(toProc);
+    PLB_ASSERT( it != pendingReleases.end() );
+    if (it->second) {
+        MPI_Recv( 0, 0, MPI_CHAR, nodeRanks[toProc], sharedReleaseTag,
+                  nodeCommunicator, MPI_STATUS_IGNORE );
+        synchronize();
+        it->second = false;
+    }
+}
+
+void SharedMemoryExchange::signalWritten(int toProc, MPI_Request* request) {
+    synchronize();
+    MPI_Isend(0, 0, MPI_CHAR, nodeRanks[toProc], sharedWrittenTag, nodeCommunicator, request);
+    pendingReleases[toProc] = true;
+}
+
+void SharedMemoryExchange::expectWritten(int fromProc, MPI_Request* request) {
+    MPI_Irecv(0, 0, MPI_CHAR, nodeRanks[fromProc], sharedWrittenTag, nodeCommunicator, request);
+}
+
+void SharedMemoryExchange::waitWritten(MPI_Request* request) {
+    MPI_Wait(request, MPI_STATUS_IGNORE);
+    synchronize();
+}
+
+void SharedMemoryExchange::release(int fromProc) {
+    synchronize();
+    std::map<int,MPI_Request>::iterator it = releaseRequests.find(fromProc);
+    if (it == releaseRequests.end()) {
+        it = releaseRequests.insert(std::make_pair(fromProc, MPI_Request())).first;
+    }
+    else {
+        MPI_Wait(&it->second, MPI_STATUS_IGNORE);
+    }
+    MPI_Isend(0, 0, MPI_CHAR, nodeRanks[fromProc], sharedReleaseTag, nodeCommunicator, &it->second);
+}
+
+plint SharedMemoryExchange::getNumSharedPeers() const {
+    std::map<int,char*> peers(sendAreas);
+    peers.insert(recvAreas.begin(), recvAreas.end());
+    return (plint)peers.size();
+}
+
+/* *************** Class SendPoolCommunicator ******************************* */
+
 SendPoolCommunicator::SendPoolCommunicator(SendRecvPool const& pool)
-    : subscriptions(pool.begin(), pool.end())
+    : subscriptions(pool.begin(), pool.end()),
+      sharedMemory(0)
 {
     //PLB_PRECONDITION(!pool.empty());
 }
 
+void SendPoolCommunicator::useSharedMemory(SharedMemoryExchange* sharedMemory_) {
+    sharedMemory = sharedMemory_;
+    std::map<int,CommunicatorEntry>::iterator it = subscriptions.begin();
+    for (; it != subscriptions.end(); ++it) {
+        it->second.sharedData = sharedMemory ? sharedMemory->getSendArea(it->first) : 0;
+    }
+}
+
 std::vector<char>& SendPoolCommunicator::getSendBuffer(int toProc) {
     std::map<int,CommunicatorEntry>::iterator entryPtr = subscriptions.find(toProc);
     PLB_ASSERT( entryPtr != subscriptions.end() );
@@ -53,6 +228,27 @@ std::vector<char>& SendPoolCommunicator::getSendBuffer(int toProc) {
     return entry.messages[entry.currentMessage];
 }
 
+char* SendPoolCommunicator::getStaticSendBuffer(int toProc) {
+    std::map<int,CommunicatorEntry>::iterator entryPtr = subscriptions.find(toProc);
+    PLB_ASSERT( entryPtr != subscriptions.end() );
+    CommunicatorEntry& entry = entryPtr->second;
+    PLB_ASSERT( entry.currentMessage < (int)entry.messages.size() );
+    // Messages written in place and through getSendBuffer() cannot be mixed.
+    PLB_ASSERT( entry.currentMessage==0 || entry.packedInPlace );
+    if (entry.sharedData) {
+        // The receiver must have read the previous messages before they
+        //   are overwritten.
+        if (entry.currentMessage==0) {
+            sharedMemory->waitForRelease(toProc);
+        }
+    }
+    else {
+        entry.data.resize(entry.cumDataLength);
+    }
+    entry.packedInPlace = true;
+    return entry.currentStaticMessage();
+}
+
 void SendPoolCommunicator::acceptMessage(int toProc, bool staticMessage)
 {
     std::map<int,CommunicatorEntry>::iterator entryPtr = subscriptions.find(toProc);
@@ -61,7 +257,7 @@ void SendPoolCommunicator::acceptMessage(int toProc, bool staticMessage)
     PLB_ASSERT( entry.currentMessage < (int)entry.messages.size() );
     // If communication is static, make sure that the message has
     //   the right size.
-    PLB_ASSERT( !staticMessage ||
+    PLB_ASSERT( !staticMessage || entry.packedInPlace ||
                 ( (int)entry.messages[entry.currentMessage].size() ==
                   entry.lengths[entry.currentMessage] ) );
     entry.currentMessage++;
@@ -80,8 +276,11 @@ void SendPoolCommunicator::finalize(bool staticMessage) {
         if (!staticMessage) {
             global::mpi().wait(&entry.sizeRequest, &entry.sizeStatus);
         }
+        if (staticMessage && entry.sharedData) {
+            global::mpi().wait(&entry.messageRequest, &entry.messageStatus);
+        }
         // Empty messages are neither sent nor received.
-        if (!entry.data.empty()) {
+        else if (!entry.data.empty()) {
             global::mpi().wait(&entry.messageRequest, &entry.messageStatus);
         }
     }
@@ -92,10 +291,28 @@ void SendPoolCommunicator::startCommunication(int toProc, bool staticMessage)
     std::map<int,CommunicatorEntry>::iterator entryPtr = subscriptions.find(toProc);
     PLB_ASSERT( entryPtr != subscriptions.end() );
     CommunicatorEntry& entry = entryPtr->second;
+    if (staticMessage && entry.sharedData) {
+        // Messages which were not written in place are copied into the
+        //   shared memory.
+        if (!entry.packedInPlace) {
+            sharedMemory->waitForRelease(toProc);
+        }
+        for (pluint iMessage=0; !entry.packedInPlace && iMessage<entry.messages.size(); ++iMessage) {
+            PLB_ASSERT( (int)entry.messages[iMessage].size() == entry.lengths[iMessage] );
+            if (!entry.messages[iMessage].empty()) {
+                std::copy( entry.messages[iMessage].begin(), entry.messages[iMessage].end(),
+                           entry.sharedData + entry.offsets[iMessage] );
+            }
+        }
+        global::profiler().increment("mpiSendChar", (plint)entry.cumDataLength);
+        sharedMemory->signalWritten(toProc, &entry.messageRequest);
+        return;
+    }
     if (staticMessage) {
         entry.data.resize(entry.cumDataLength);
     }
     else {
+        PLB_ASSERT( !entry.packedInPlace );
         // If the communicated data is non-static, the overall size of transmitted
         //   data must be computed.
         int dynamicDataLength = 0;
@@ -106,9 +323,10 @@ void SendPoolCommunicator::startCommunication(int toProc, bool staticMessage)
         }
         entry.data.resize(dynamicDataLength);
     }
-    // Merge the individual messages into a single vector.
+    // Merge the individual messages into a single vector, unless they
+    //   were written there in the first place.
     int pos=0;
-    for (pluint iMessage=0; iMessage<entry.messages.size(); ++iMessage) {
+    for (pluint iMessage=0; !entry.packedInPlace && iMessage<entry.messages.size(); ++iMessage) {
         PLB_ASSERT( !staticMessage ||
                     ( (int)entry.messages[iMessage].size() == entry.lengths[iMessage] ));
         PLB_ASSERT(pos+entry.messages[iMessage].size() <= entry.data.size());
@@ -131,10 +349,21 @@ void SendPoolCommunicator::startCommunication(int toProc, bool staticMessage)
     }
 }
 
+/* *************** Class RecvPoolCommunicator ******************************* */
+
 RecvPoolCommunicator::RecvPoolCommunicator(SendRecvPool const& pool)
-    : subscriptions(pool.begin(), pool.end())
+    : subscriptions(pool.begin(), pool.end()),
+      sharedMemory(0)
 { }
 
+void RecvPoolCommunicator::useSharedMemory(SharedMemoryExchange* sharedMemory_) {
+    sharedMemory = sharedMemory_;
+    std::map<int,CommunicatorEntry>::iterator it = subscriptions.begin();
+    for (; it != subscriptions.end(); ++it) {
+        it->second.sharedData = sharedMemory ? sharedMemory->getRecvArea(it->first) : 0;
+    }
+}
+
 void RecvPoolCommunicator::startBeingReceptive(bool staticMessage)
 {
     // If the message has dynamic content, the receives cannot be intantiated
@@ -143,10 +372,16 @@ void RecvPoolCommunicator::startBeingReceptive(bool staticMessage)
     if (!staticMessage) {
         return;
     }
+    finalize();
     std::map<int, CommunicatorEntry >::iterator iter = subscriptions.begin();
     for (; iter != subscriptions.end(); ++iter) {
         int fromProc = iter->first;
         CommunicatorEntry& entry = iter->second;
+        if (entry.sharedData) {
+            global::profiler().increment("mpiReceiveChar", (plint)entry.cumDataLength);
+            sharedMemory->expectWritten(fromProc, &entry.messageRequest);
+            continue;
+        }
         entry.data.resize(entry.cumDataLength);
         // Empty messages are neither sent nor received.
         if (!entry.data.empty()) {
@@ -180,6 +415,42 @@ std::vector<char> const& RecvPoolCommunicator::receiveMessage (
     return message;
 }
 
+char const* RecvPoolCommunicator::receiveStaticMessage(int fromProc)
+{
+    std::map<int,CommunicatorEntry>::iterator entryPtr = subscriptions.find(fromProc);
+    PLB_ASSERT( entryPtr!= subscriptions.end() );
+    CommunicatorEntry& entry = entryPtr->second;
+    PLB_ASSERT( entry.currentMessage < (int)entry.messages.size() );
+    // Make sure the package of messages has been received. Empty messages
+    //   are neither sent nor received.
+    if (entry.currentMessage==0) {
+        if (entry.sharedData) {
+            sharedMemory->waitWritten(&entry.messageRequest);
+        }
+        else if (!entry.data.empty()) {
+            global::mpi().wait(&entry.messageRequest, &entry.messageStatus);
+        }
+    }
+    char const* message = entry.currentStaticMessage();
+    entry.currentMessage++;
+    if (entry.currentMessage==(int)entry.lengths.size()) {
+        // The shared memory is released once the messages have been read,
+        //   in finalize().
+        if (entry.sharedData) {
+            pendingReleases.push_back(fromProc);
+        }
+        entry.reset();
+    }
+    return message;
+}
+
+void RecvPoolCommunicator::finalize() {
+    for (pluint iRelease=0; iRelease<pendingReleases.size(); ++iRelease) {
+        sharedMemory->release(pendingReleases[iRelease]);
+    }
+    pendingReleases.clear();
+}
+
 void RecvPoolCommunicator::receiveDynamic(int fromProc)
 {
     std::map<int,CommunicatorEntry>::iterator entryPtr = subscriptions.find(fromProc);
@@ -222,8 +493,16 @@ void RecvPoolCommunicator::finalizeStatic(int fromProc)
     PLB_ASSERT( entryPtr != subscriptions.end() );
     CommunicatorEntry& entry = entryPtr->second;
 
+    if (entry.sharedData) {
+        sharedMemory->waitWritten(&entry.messageRequest);
+        for (pluint iMessage=0; iMessage<entry.messages.size(); ++iMessage) {
+            char const* message = entry.sharedData + entry.offsets[iMessage];
+            entry.messages[iMessage].assign(message, message+entry.lengths[iMessage]);
+        }
+        sharedMemory->release(fromProc);
+    }
     // Empty messages are neither sent nor received.
-    if (!entry.data.empty()) {
+    else if (!entry.data.empty()) {
         // 1. Make sure the package of messages has been received.
         global::mpi().wait(&entry.messageRequest, &entry.messageStatus);
         
@@ -31,6 +31,7 @@
 
 #include "core/globalDefs.h"
 #include "core/util.h"
+#include "core/plbDebug.h"
 #include "parallelism/mpiManager.h"
 #include <map>
 #include <vector>
@@ -80,23 +81,42 @@ private:
 struct CommunicatorEntry {
     CommunicatorEntry() 
         : lengths(),
+          offsets(),
           cumDataLength(0),
           messages(),
           data(),
-          currentMessage(0)
+          currentMessage(0),
+          packedInPlace(false),
+          sharedData(0)
     { } 
     CommunicatorEntry(PoolEntry const& poolEntry)
         : lengths(poolEntry.lengths),
+          offsets(lengths.size()),
           cumDataLength(poolEntry.cumDataLength),
           messages(lengths.size()),
-          currentMessage(0)
+          currentMessage(0),
+          packedInPlace(false),
+          sharedData(0)
     {
+        int offset=0;
         for (pluint iMessage=0; iMessage<messages.size(); ++iMessage) {
             messages[iMessage].resize(lengths[iMessage]);
+            offsets[iMessage] = offset;
+            offset += lengths[iMessage];
         }
     }
     void reset() {
         currentMessage=0;
+        packedInPlace=false;
+    }
+    /// Position of the current message inside data, which must have been
+    ///   resized to the static data length.
+    char* currentStaticMessage() {
+        if (sharedData) {
+            return sharedData + offsets[currentMessage];
+        }
+        PLB_ASSERT( (int)data.size() == cumDataLength );
+        return data.empty() ? 0 : &data[0] + offsets[currentMessage];
     }
     std::string info() {
         std::stringstream infostr;
@@ -108,6 +128,8 @@ struct CommunicatorEntry {
         return infostr.str();
     }
     std::vector<int> lengths;
+    /// Position of the individual static messages inside data.
+    std::vector<int> offsets;
     int              cumDataLength;
     std::vector<std::vector<char> > messages;
     /// The variable data holds the message which in the end is being sent.
@@ -122,37 +144,112 @@ struct CommunicatorEntry {
     ///   allocations.
     std::vector<int> dynamicDataSizes;
     int currentMessage;
+    /// True if the static messages are written directly into data, in which
+    ///   case they need not be merged before being sent.
+    bool packedInPlace;
+    /// If the static messages are exchanged through a shared-memory window,
+    ///   location of the messages in the window of the receiving process.
+    char* sharedData;
     MPI_Request sizeRequest, messageRequest;
     MPI_Status  sizeStatus, messageStatus;
 };
 
+/// Shared-memory window through which processes of the same node exchange
+///   their static messages. Every process allocates in the window the memory
+///   into which it receives the messages of the other processes of the node,
+///   and the senders write their data directly into it. The completion of the
+///   writes, and of the reads, is notified with empty messages.
+/** Without MPI-3, or for processes on other nodes, no shared memory is
+ *  provided, and the messages are sent as usual.
+ */
+class SharedMemoryExchange {
+public:
+    /// Allocate the window for the static messages of the pools. Collective.
+    SharedMemoryExchange(SendRecvPool const& sendPool, SendRecvPool const& recvPool);
+    /// Free the window. Collective.
+    ~SharedMemoryExchange();
+    /// Memory into which the messages to toProc are written, or 0 if toProc is
+    ///   not on the same node.
+    char* getSendArea(int toProc) const;
+    /// Memory from which the messages of fromProc are read, or 0 if fromProc is
+    ///   not on the same node.
+    char* getRecvArea(int fromProc) const;
+    /// Wait until toProc has read the messages previously written into its memory.
+    void waitForRelease(int toProc);
+    /// Notify toProc that the messages have been written.
+    void signalWritten(int toProc, MPI_Request* request);
+    /// Post the reception of the notification of fromProc.
+    void expectWritten(int fromProc, MPI_Request* request);
+    /// Wait for the notification posted by expectWritten().
+    void waitWritten(MPI_Request* request);
+    /// Notify fromProc that its messages have been read.
+    void release(int fromProc);
+    /// Number of processes with which messages are exchanged through shared memory.
+    plint getNumSharedPeers() const;
+private:
+    SharedMemoryExchange(SharedMemoryExchange const& rhs);
+    SharedMemoryExchange& operator=(SharedMemoryExchange const& rhs);
+    void synchronize();
+private:
+    bool allocated;
+    MPI_Comm nodeCommunicator;
+    MPI_Win window;
+    /// Rank in nodeCommunicator of the processes of the node.
+    std::map<int,int> nodeRanks;
+    std::map<int,char*> sendAreas, recvAreas;
+    /// Senders: processes which have not yet read the last messages.
+    std::map<int,bool> pendingReleases;
+    /// Receivers: notifications of the reads in progress.
+    std::map<int,MPI_Request> releaseRequests;
+};
+
 /// The "in-action" device for all messages sent from a processor.
 class SendPoolCommunicator {
 public:
-    SendPoolCommunicator() { }
+    SendPoolCommunicator() : sharedMemory(0) { }
     SendPoolCommunicator(SendRecvPool const& pool);
+    /// Exchange the static messages with the processes of the same node
+    ///   through the window of sharedMemory, which must outlive this object.
+    void useSharedMemory(SharedMemoryExchange* sharedMemory_);
     std::vector<char>& getSendBuffer(int toProc);
+    /// Memory into which the current static message is written, in place of
+    ///   getSendBuffer(). It is located inside the message which is eventually
+    ///   sent, and avoids copying the individual messages into it.
+    char* getStaticSendBuffer(int toProc);
     void acceptMessage(int toProc, bool staticMessage);
     void finalize(bool staticMessage);
 private:
     void startCommunication(int toProc, bool staticMessage);
 private:
     std::map<int, CommunicatorEntry > subscriptions;
+    SharedMemoryExchange* sharedMemory;
 };
 
 /// The "in-action" device for all messages received on a processor.
 class RecvPoolCommunicator {
 public:
-    RecvPoolCommunicator() { }
+    RecvPoolCommunicator() : sharedMemory(0) { }
     RecvPoolCommunicator(SendRecvPool const& pool);
+    /// Counterpart of SendPoolCommunicator::useSharedMemory().
+    void useSharedMemory(SharedMemoryExchange* sharedMemory_);
     /// Initiate non-blocking communication.
     void startBeingReceptive(bool staticMessage);
     std::vector<char> const& receiveMessage(int fromProc, bool staticMessage);
+    /// Static message, which is read in place inside the received data,
+    ///   without being copied as with receiveMessage().
+    char const* receiveStaticMessage(int fromProc);
+    /// Declare that the messages obtained from receiveStaticMessage() have
+    ///   been read. Required with shared memory, to let the senders write
+    ///   the next messages.
+    void finalize();
 private:
     void finalizeStatic(int fromProc);
     void receiveDynamic(int fromProc);
 private:
     std::map<int, CommunicatorEntry > subscriptions;
+    SharedMemoryExchange* sharedMemory;
+    /// Processes whose messages in shared memory are being read.
+    std::vector<int> pendingReleases;
 };
 
 #endif  // PLB_MPI_PARALLEL
@@ -0,0 +1,339 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Pool of shared-memory threads which executes the local atomic blocks
+ * of a multi-block concurrently -- implementation file.
+ */
+
+#ifdef PLB_SMP_PARALLEL
+
+#include "parallelism/smpThreadPool.h"
+#include "core/plbDebug.h"
+#include "core/runTimeDiagnostics.h"
+#include "core/memoryPolicy.h"
+#include <algorithm>
+#include <exception>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace plb {
+
+namespace global {
+
+/// Orders task indices by decreasing cost.
+class TaskCostComparison {
+public:
+    TaskCostComparison(std::vector<plint> const& costs_)
+        : costs(costs_)
+    { }
+    bool operator()(plint iTask1, plint iTask2) const {
+        return costs[iTask1] > costs[iTask2];
+    }
+private:
+    std::vector<plint> const& costs;
+};
+
+SmpThreadPool::SmpThreadPool()
+    : numThreads(1),
+      queues(1),
+      currentTasks(0),
+      stealingFlag(true),
+      generation(0),
+      numFinishedWorkers(0),
+      shutDown(false),
+      parallelRegion(false),
+      taskFailed(false)
+{
+    pthread_key_create(&threadIdKey, 0);
+    pthread_mutex_init(&poolMutex, 0);
+    pthread_mutex_init(&criticalMutex, 0);
+    pthread_cond_init(&startCondition, 0);
+    pthread_cond_init(&doneCondition, 0);
+    pthread_mutex_init(&queues[0].mutex, 0);
+}
+
+SmpThreadPool::~SmpThreadPool() {
+    setNumThreads(1);
+    pthread_mutex_destroy(&queues[0].mutex);
+    pthread_cond_destroy(&doneCondition);
+    pthread_cond_destroy(&startCondition);
+    pthread_mutex_destroy(&criticalMutex);
+    pthread_mutex_destroy(&poolMutex);
+    pthread_key_delete(threadIdKey);
+}
+
+int SmpThreadPool::getNumThreads() const {
+    return numThreads;
+}
+
+void SmpThreadPool::setNumThreads(int numThreads_) {
+    PLB_PRECONDITION( numThreads_ >= 1 );
+    PLB_PRECONDITION( isMainThread() && !inParallelRegion() );
+    if (numThreads_ == numThreads) {
+        return;
+    }
+    // Stop the current workers.
+    if (!workers.empty()) {
+        pthread_mutex_lock(&poolMutex);
+        shutDown = true;
+        pthread_cond_broadcast(&startCondition);
+        pthread_mutex_unlock(&poolMutex);
+        for (pluint iWorker=0; iWorker<workers.size(); ++iWorker) {
+            pthread_join(workers[iWorker], 0);
+        }
+        workers.clear();
+        shutDown = false;
+    }
+    for (pluint iQueue=0; iQueue<queues.size(); ++iQueue) {
+        pthread_mutex_destroy(&queues[iQueue].mutex);
+    }
+    queues.clear();
+    queues.resize(numThreads_);
+    for (pluint iQueue=0; iQueue<queues.size(); ++iQueue) {
+        pthread_mutex_init(&queues[iQueue].mutex, 0);
+    }
+    numThreads = numThreads_;
+    pinThread(0);
+
+    // Start the new workers. Thread 0 is the main thread.
+    workerArgs.resize(numThreads);
+    workers.resize(numThreads-1);
+    for (int iThread=1; iThread<numThreads; ++iThread) {
+        workerArgs[iThread].pool = this;
+        workerArgs[iThread].threadId = iThread;
+        workerArgs[iThread].initialGeneration = generation;
+        int errCode = pthread_create(&workers[iThread-1], 0, workerEntry, &workerArgs[iThread]);
+        if (errCode != 0) {
+            workers.resize(iThread-1);
+            numThreads = iThread;
+            plbWarning("Could not create all requested shared-memory threads.");
+            break;
+        }
+    }
+}
+
+int SmpThreadPool::getThreadId() const {
+    WorkerArg const* arg = static_cast<WorkerArg const*>(pthread_getspecific(threadIdKey));
+    return arg ? arg->threadId : 0;
+}
+
+bool SmpThreadPool::isMainThread() const {
+    return getThreadId()==0;
+}
+
+bool SmpThreadPool::inParallelRegion() const {
+    return parallelRegion;
+}
+
+void SmpThreadPool::execute( std::vector<SmpTask*> const& tasks,
+                             std::vector<int> const& threadIds,
+                             std::vector<plint> const& costs,
+                             bool allowStealing )
+{
+    if (numThreads==1 || tasks.size()<=1 || inParallelRegion() || !isMainThread()) {
+        for (pluint iTask=0; iTask<tasks.size(); ++iTask) {
+            tasks[iTask]->execute();
+        }
+        return;
+    }
+    PLB_PRECONDITION( threadIds.size()==tasks.size() );
+    PLB_PRECONDITION( costs.size()==tasks.size() );
+
+    // Distribute the tasks over the queues, and sort each queue by
+    //   decreasing cost.
+    for (pluint iQueue=0; iQueue<queues.size(); ++iQueue) {
+        queues[iQueue].tasks.clear();
+    }
+    for (pluint iTask=0; iTask<tasks.size(); ++iTask) {
+        int threadId = threadIds[iTask] % numThreads;
+        if (threadId<0) {
+            threadId += numThreads;
+        }
+        queues[threadId].tasks.push_back(iTask);
+    }
+    for (pluint iQueue=0; iQueue<queues.size(); ++iQueue) {
+        TaskQueue& queue = queues[iQueue];
+        std::stable_sort(queue.tasks.begin(), queue.tasks.end(), TaskCostComparison(costs));
+        queue.front = 0;
+        queue.back = queue.tasks.size();
+    }
+    currentTasks = &tasks;
+    stealingFlag = allowStealing;
+    taskFailed = false;
+
+    // Wake up the workers, and take part in the execution.
+    pthread_mutex_lock(&poolMutex);
+    parallelRegion = true;
+    numFinishedWorkers = 0;
+    ++generation;
+    pthread_cond_broadcast(&startCondition);
+    pthread_mutex_unlock(&poolMutex);
+
+    runQueues(0);
+
+    pthread_mutex_lock(&poolMutex);
+    while (numFinishedWorkers < numThreads-1) {
+        pthread_cond_wait(&doneCondition, &poolMutex);
+    }
+    parallelRegion = false;
+    pthread_mutex_unlock(&poolMutex);
+    currentTasks = 0;
+
+    if (taskFailed) {
+        throw PlbLogicException(failureMessage);
+    }
+}
+
+void SmpThreadPool::lock() {
+    pthread_mutex_lock(&criticalMutex);
+}
+
+void SmpThreadPool::unlock() {
+    pthread_mutex_unlock(&criticalMutex);
+}
+
+void SmpThreadPool::runQueues(int threadId) {
+    plint iTask;
+    while (popOwnTask(threadId, iTask) || (stealingFlag && stealTask(threadId, iTask))) {
+        executeTask(iTask);
+    }
+}
+
+bool SmpThreadPool::popOwnTask(int threadId, plint& iTask) {
+    TaskQueue& queue = queues[threadId];
+    bool found = false;
+    pthread_mutex_lock(&queue.mutex);
+    if (queue.front < queue.back) {
+        iTask = queue.tasks[queue.front++];
+        found = true;
+    }
+    pthread_mutex_unlock(&queue.mutex);
+    return found;
+}
+
+bool SmpThreadPool::stealTask(int threadId, plint& iTask) {
+    for (int iVictim=1; iVictim<numThreads; ++iVictim) {
+        TaskQueue& queue = queues[(threadId+iVictim) % numThreads];
+        bool found = false;
+        pthread_mutex_lock(&queue.mutex);
+        if (queue.front < queue.back) {
+            iTask = queue.tasks[--queue.back];
+            found = true;
+        }
+        pthread_mutex_unlock(&queue.mutex);
+        if (found) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SmpThreadPool::executeTask(plint iTask) {
+    try {
+        (*currentTasks)[iTask]->execute();
+    }
+    catch (std::exception& exception) {
+        pthread_mutex_lock(&poolMutex);
+        if (!taskFailed) {
+            taskFailed = true;
+            failureMessage = exception.what();
+        }
+        pthread_mutex_unlock(&poolMutex);
+    }
+    catch (...) {
+        pthread_mutex_lock(&poolMutex);
+        if (!taskFailed) {
+            taskFailed = true;
+            failureMessage = "Unknown exception in shared-memory task.";
+        }
+        pthread_mutex_unlock(&poolMutex);
+    }
+}
+
+void SmpThreadPool::workerLoop(int threadId) {
+    pthread_setspecific(threadIdKey, &workerArgs[threadId]);
+    pinThread(threadId);
+    pthread_mutex_lock(&poolMutex);
+    pluint currentGeneration = workerArgs[threadId].initialGeneration;
+    while (true) {
+        while (!shutDown && generation==currentGeneration) {
+            pthread_cond_wait(&startCondition, &poolMutex);
+        }
+        if (shutDown) {
+            break;
+        }
+        currentGeneration = generation;
+        pthread_mutex_unlock(&poolMutex);
+
+        runQueues(threadId);
+
+        pthread_mutex_lock(&poolMutex);
+        ++numFinishedWorkers;
+        pthread_cond_signal(&doneCondition);
+    }
+    pthread_mutex_unlock(&poolMutex);
+}
+
+void SmpThreadPool::pinThread(int threadId) {
+    if (!memoryPolicy().isThreadPinningOn()) {
+        return;
+    }
+#ifdef __linux__
+    // The processors available to the process are recorded by the main
+    //   thread before it is pinned, as pinning restricts its mask.
+    if (processors.empty() && threadId==0) {
+        cpu_set_t available;
+        CPU_ZERO(&available);
+        if (sched_getaffinity(0, sizeof(available), &available) == 0) {
+            for (int iCpu=0; iCpu<CPU_SETSIZE; ++iCpu) {
+                if (CPU_ISSET(iCpu, &available)) {
+                    processors.push_back(iCpu);
+                }
+            }
+        }
+    }
+    if (processors.empty()) {
+        return;
+    }
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(processors[threadId % (int)processors.size()], &cpuSet);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#endif
+}
+
+void* SmpThreadPool::workerEntry(void* arg) {
+    WorkerArg* workerArg = static_cast<WorkerArg*>(arg);
+    workerArg->pool->workerLoop(workerArg->threadId);
+    return 0;
+}
+
+}  // namespace global
+
+}  // namespace plb
+
+#endif  // PLB_SMP_PARALLEL
@@ -0,0 +1,178 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2013 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Pool of shared-memory threads which executes the local atomic blocks
+ * of a multi-block concurrently -- header file.
+ */
+
+#ifndef SMP_THREAD_POOL_H
+#define SMP_THREAD_POOL_H
+
+#include "core/globalDefs.h"
+#include <vector>
+#include <string>
+
+#ifdef PLB_SMP_PARALLEL
+#include <pthread.h>
+#endif
+
+namespace plb {
+
+/// A unit of work, typically the treatment of one atomic block, which
+///   is executed by the shared-memory thread pool.
+class SmpTask {
+public:
+    virtual ~SmpTask() { }
+    virtual void execute() =0;
+};
+
+namespace global {
+
+#ifdef PLB_SMP_PARALLEL
+
+/// Pool of shared-memory threads, used to process the atomic blocks
+///   which are local to an MPI process in parallel.
+/** The calling (main) thread takes part in the execution as thread 0.
+ *  Each task is initially queued on the thread proposed by the
+ *  ThreadAttribution of the multi-block (getLocalThreadId), and every
+ *  queue is processed by decreasing cost. A thread which runs out of
+ *  work steals the cheapest remaining tasks of the other threads.
+ *  Only the main thread may communicate through MPI. If thread pinning
+ *  is on in the memory policy, thread i is pinned to the i-th processor
+ *  available to the process when the threads are started.
+ */
+class SmpThreadPool {
+public:
+    ~SmpThreadPool();
+    /// Number of threads, including the main thread.
+    int getNumThreads() const;
+    /// Start or stop worker threads so that numThreads threads, including
+    ///   the main thread, are available. Must be called by the main thread,
+    ///   outside of a parallel region.
+    void setNumThreads(int numThreads_);
+    /// Id of the calling thread: 0 for the main thread, 1 to numThreads-1
+    ///   for the worker threads.
+    int getThreadId() const;
+    /// Tells whether the calling thread is the main thread.
+    bool isMainThread() const;
+    /// Tells whether a parallel region is currently being executed.
+    bool inParallelRegion() const;
+    /// Execute all tasks and return when they are completed. The task
+    ///   tasks[iTask] is proposed to the thread threadIds[iTask] (modulo the
+    ///   number of threads), and costs[iTask] is an estimate of its
+    ///   execution time. Without stealing, every task is executed by the
+    ///   thread to which it is proposed, as needed for first-touch memory
+    ///   allocation. Nested calls, and calls with a single thread, are
+    ///   executed sequentially in the order of the tasks.
+    void execute( std::vector<SmpTask*> const& tasks,
+                  std::vector<int> const& threadIds,
+                  std::vector<plint> const& costs,
+                  bool allowStealing=true );
+    /// Enter a critical section, shared by all threads of the pool.
+    void lock();
+    /// Leave the critical section.
+    void unlock();
+private:
+    SmpThreadPool();
+    void runQueues(int threadId);
+    bool popOwnTask(int threadId, plint& iTask);
+    bool stealTask(int threadId, plint& iTask);
+    void executeTask(plint iTask);
+    void workerLoop(int threadId);
+    static void* workerEntry(void* arg);
+    /// Pin the calling thread to a processor, if thread pinning is on.
+    void pinThread(int threadId);
+private:
+    /// Task queue of one thread: the owner takes tasks from the front,
+    ///   thieves take them from the back.
+    struct TaskQueue {
+        std::vector<plint> tasks;
+        pluint front, back;
+        pthread_mutex_t mutex;
+    };
+    struct WorkerArg {
+        SmpThreadPool* pool;
+        int threadId;
+        /// Generation of the tasks at the creation of the worker, which
+        ///   may start running only after the next tasks are submitted.
+        pluint initialGeneration;
+    };
+    int numThreads;
+    std::vector<pthread_t> workers;
+    std::vector<WorkerArg> workerArgs;
+    std::vector<TaskQueue> queues;
+    std::vector<SmpTask*> const* currentTasks;
+    bool stealingFlag;
+    /// Processors available to the process, to which the threads are pinned.
+    std::vector<int> processors;
+    pthread_key_t threadIdKey;
+    pthread_mutex_t poolMutex;
+    pthread_mutex_t criticalMutex;
+    pthread_cond_t startCondition;
+    pthread_cond_t doneCondition;
+    pluint generation;
+    int numFinishedWorkers;
+    bool shutDown;
+    bool parallelRegion;
+    bool taskFailed;
+    std::string failureMessage;
+friend SmpThreadPool& smpThreadPool();
+};
+
+#else  // PLB_SMP_PARALLEL
+
+class SmpThreadPool {
+public:
+    int getNumThreads() const { return 1; }
+    void setNumThreads(int numThreads_) { }
+    int getThreadId() const { return 0; }
+    bool isMainThread() const { return true; }
+    bool inParallelRegion() const { return false; }
+    void execute( std::vector<SmpTask*> const& tasks,
+                  std::vector<int> const& threadIds,
+                  std::vector<plint> const& costs,
+                  bool allowStealing=true )
+    {
+        for (pluint iTask=0; iTask<tasks.size(); ++iTask) {
+            tasks[iTask]->execute();
+        }
+    }
+    void lock() { }
+    void unlock() { }
+friend SmpThreadPool& smpThreadPool();
+};
+
+#endif  // PLB_SMP_PARALLEL
+
+inline SmpThreadPool& smpThreadPool() {
+    static SmpThreadPool instance;
+    return instance;
+}
+
+}  // namespace global
+
+}  // namespace plb
+
+#endif  // SMP_THREAD_POOL_H